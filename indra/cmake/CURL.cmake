@@ -12,3 +12,17 @@ else (WINDOWS)
   target_link_libraries(ll::libcurl INTERFACE libcurl.a)
 endif (WINDOWS)
 target_include_directories( ll::libcurl SYSTEM INTERFACE ${LIBS_PREBUILT_DIR}/include)
+
+# curl_multi_poll() and curl_multi_wakeup() came with libcurl 7.68.0.
+# llcorehttp's service thread waits on its transfers with them and
+# is woken up by new requests, older libcurls get a loopback socket
+# added to curl_multi_wait() for the wakeups.
+file(STRINGS ${LIBS_PREBUILT_DIR}/include/curl/curlver.h LIBCURL_VERSION
+     REGEX "^#define LIBCURL_VERSION \"[^\"]*\"")
+string(REGEX REPLACE "^#define LIBCURL_VERSION \"([0-9.]*).*\"$" "\\1" LIBCURL_VERSION "${LIBCURL_VERSION}")
+if (LIBCURL_VERSION VERSION_GREATER_EQUAL 7.68.0)
+  target_compile_definitions( ll::libcurl INTERFACE LLCORE_CURL_MULTI_POLL=1 )
+else ()
+  message(STATUS "libcurl ${LIBCURL_VERSION} has no curl_multi_poll(), llcorehttp wakes curl_multi_wait() through a loopback socket")
+  target_compile_definitions( ll::libcurl INTERFACE LLCORE_CURL_MULTI_POLL=0 )
+endif ()
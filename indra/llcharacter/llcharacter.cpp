@@ -191,22 +191,39 @@ void LLCharacter::requestStopMotion( LLMotion* motion)
 void LLCharacter::updateMotions(e_update_t update_type)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	if (beginMotionUpdate(update_type))
+	{
+		evaluateMotions(update_type);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// beginMotionUpdate()
+//-----------------------------------------------------------------------------
+bool LLCharacter::beginMotionUpdate(e_update_t update_type)
+{
 	if (update_type == HIDDEN_UPDATE)
 	{
 		mMotionController.updateMotionsMinimal();
+		return false;
 	}
-	else
+
+	// unpause if the number of outstanding pause requests has dropped to the initial one
+	if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
 	{
-		// unpause if the number of outstanding pause requests has dropped to the initial one
-		if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
-		{
-			mMotionController.unpauseAllMotions();
-		}
-		bool force_update = (update_type == FORCE_UPDATE);
-		{
-			mMotionController.updateMotions(force_update);
-		}
+		mMotionController.unpauseAllMotions();
 	}
+	return mMotionController.prepareUpdate();
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLCharacter::evaluateMotions(e_update_t update_type)
+{
+	llassert(update_type != HIDDEN_UPDATE);
+	bool force_update = (update_type == FORCE_UPDATE);
+	mMotionController.evaluateMotions(force_update);
 }
 
 
@@ -155,6 +155,13 @@ public:
 	enum e_update_t { NORMAL_UPDATE, HIDDEN_UPDATE, FORCE_UPDATE };
 	void updateMotions(e_update_t update_type);
 
+	// updateMotions() split for characters updated in parallel: call
+	// beginMotionUpdate() on the main thread and, if it returns true,
+	// evaluateMotions() with the same update type from any one thread.
+	// Evaluation only touches this character's motions and joints.
+	bool beginMotionUpdate(e_update_t update_type);
+	void evaluateMotions(e_update_t update_type);
+
 	LLAnimPauseRequest requestPause();
 	BOOL areAnimationsPaused() const { return mMotionController.isPaused(); }
 	void setAnimTimeFactor(F32 factor) { mMotionController.setTimeFactor(factor); }
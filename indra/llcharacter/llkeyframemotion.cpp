@@ -47,6 +47,7 @@
 // Static Definitions
 //-----------------------------------------------------------------------------
 LLKeyframeDataCache::keyframe_data_map_t	LLKeyframeDataCache::sKeyframeDataMap;
+bool LLKeyframeMotion::sBakeKeyframes = false;
 
 //-----------------------------------------------------------------------------
 // Globals
@@ -61,6 +62,9 @@ static F32 MIN_ACCELERATION_SQUARED = 0.0005f * 0.0005f;
 
 static F32 MAX_CONSTRAINTS = 10;
 
+// full scale of a baked S16 component
+static const F32 BAKED_SAMPLE_SCALE = 32767.f;
+
 //-----------------------------------------------------------------------------
 // JointMotionList
 //-----------------------------------------------------------------------------
@@ -116,11 +120,97 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 			total_size += joint_motion_p->mPositionCurve.mNumKeys * sizeof(PositionKey);
 		}
 	}
+	if (!mBakedSamples.empty())
+	{
+		LL_INFOS() << "\t" << mBakedSamples.size() / 4 << " baked samples at "
+		<< mBakedSamples.size() * sizeof(S16) << " bytes" << LL_ENDL;
+
+		total_size += mBakedSamples.size() * sizeof(S16);
+	}
 	LL_INFOS() << "Size: " << total_size << " bytes" << LL_ENDL;
 
 	return total_size;
 }
 
+//-----------------------------------------------------------------------------
+// bakeKeyframes()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::JointMotionList::bakeKeyframes()
+{
+	S32 num_samples = ll_round(mDuration * BAKED_SAMPLES_PER_SECOND) + 1;
+	if (mDuration <= 0.f || num_samples > MAX_BAKED_SAMPLES)
+	{
+		return;
+	}
+	num_samples = llmax(num_samples, 2);
+	const F32 sample_rate = (F32)(num_samples - 1) / mDuration;
+
+	// Curves with a single key cost next to nothing to search, and step
+	// curves don't survive resampling.
+	std::vector<RotationCurve*> rot_curves;
+	std::vector<PositionCurve*> pos_curves;
+	for (JointMotion* joint_motion : mJointMotionArray)
+	{
+		RotationCurve& rot_curve = joint_motion->mRotationCurve;
+		if (rot_curve.mNumKeys > 1 && rot_curve.mInterpolationType != IT_STEP)
+		{
+			rot_curves.push_back(&rot_curve);
+		}
+		PositionCurve& pos_curve = joint_motion->mPositionCurve;
+		if (pos_curve.mNumKeys > 1 && pos_curve.mInterpolationType != IT_STEP)
+		{
+			pos_curves.push_back(&pos_curve);
+		}
+	}
+
+	// curves point into the buffer, so size it once up front
+	mBakedSamples.resize((rot_curves.size() + pos_curves.size()) * num_samples * 4);
+	S16* samples = mBakedSamples.data();
+
+	for (RotationCurve* curve : rot_curves)
+	{
+		curve->mBaked.mSamples = samples;
+		curve->mBaked.mNumSamples = num_samples;
+		curve->mBaked.mSampleRate = sample_rate;
+
+		LLQuaternion prev;
+		for (S32 i = 0; i < num_samples; ++i)
+		{
+			F32 time = llmin((F32) i / sample_rate, mDuration);
+			LLQuaternion rot = curve->getValue(time, mDuration);
+			// keep neighbours in the same hemisphere so that lerping
+			// between them takes the short way round, as nlerp() does
+			if (i && dot(rot, prev) < 0.f)
+			{
+				rot = -rot;
+			}
+			prev = rot;
+			for (S32 c = 0; c < 4; ++c)
+			{
+				*samples++ = (S16) ll_round(llclamp(rot.mQ[c], -1.f, 1.f) * BAKED_SAMPLE_SCALE);
+			}
+		}
+	}
+
+	for (PositionCurve* curve : pos_curves)
+	{
+		curve->mBaked.mSamples = samples;
+		curve->mBaked.mNumSamples = num_samples;
+		curve->mBaked.mSampleRate = sample_rate;
+
+		for (S32 i = 0; i < num_samples; ++i)
+		{
+			F32 time = llmin((F32) i / sample_rate, mDuration);
+			LLVector3 pos = curve->getValue(time, mDuration) / LL_MAX_PELVIS_OFFSET;
+			for (S32 c = 0; c < 3; ++c)
+			{
+				*samples++ = (S16) ll_round(llclamp(pos.mV[c], -1.f, 1.f) * BAKED_SAMPLE_SCALE);
+			}
+			*samples++ = 0;
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 // ****Curve classes
@@ -128,6 +218,24 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 //-----------------------------------------------------------------------------
 
 
+//-----------------------------------------------------------------------------
+// BakedCurve::sample()
+//-----------------------------------------------------------------------------
+LLVector4a LLKeyframeMotion::BakedCurve::sample(F32 time) const
+{
+	F32 position = llclamp(time * mSampleRate, 0.f, (F32)(mNumSamples - 1));
+	S32 index = llmin((S32) position, mNumSamples - 2);
+	F32 u = position - (F32) index;
+
+	// both samples in one load, sign extended to 32 bits
+	__m128i pair = _mm_loadu_si128((const __m128i*) (mSamples + index * 4));
+	__m128 before = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(pair, pair), 16));
+	__m128 after = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(pair, pair), 16));
+
+	__m128 value = _mm_add_ps(before, _mm_mul_ps(_mm_sub_ps(after, before), _mm_set1_ps(u)));
+	return LLVector4a(_mm_mul_ps(value, _mm_set1_ps(1.f / BAKED_SAMPLE_SCALE)));
+}
+
 //-----------------------------------------------------------------------------
 // ScaleCurve::ScaleCurve()
 //-----------------------------------------------------------------------------
@@ -271,6 +379,19 @@ LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
 	return value;
 }
 
+//-----------------------------------------------------------------------------
+// RotationCurve::getBakedValue()
+//-----------------------------------------------------------------------------
+LLQuaternion LLKeyframeMotion::RotationCurve::getBakedValue(F32 time) const
+{
+	LLVector4a value = mBaked.sample(time);
+	value.normalize4();
+
+	LLQuaternion rot;
+	_mm_storeu_ps(rot.mQ, value);
+	return rot;
+}
+
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
@@ -355,6 +476,16 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 	return value;
 }
 
+//-----------------------------------------------------------------------------
+// PositionCurve::getBakedValue()
+//-----------------------------------------------------------------------------
+LLVector3 LLKeyframeMotion::PositionCurve::getBakedValue(F32 time) const
+{
+	LLVector4a value = mBaked.sample(time);
+	value.mul(LL_MAX_PELVIS_OFFSET);
+	return LLVector3(value.getF32ptr());
+}
+
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
@@ -405,7 +536,14 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
 	{
-		joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+		if (sBakeKeyframes && mRotationCurve.mBaked.isBaked())
+		{
+			joint_state->setRotation( mRotationCurve.getBakedValue( time ) );
+		}
+		else
+		{
+			joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+		}
 	}
 
 	//-------------------------------------------------------------------------
@@ -413,7 +551,14 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
 	{
-		joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+		if (sBakeKeyframes && mPositionCurve.mBaked.isBaked())
+		{
+			joint_state->setPosition( mPositionCurve.getBakedValue( time ) );
+		}
+		else
+		{
+			joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+		}
 	}
 }
 
@@ -1986,6 +2131,11 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp, const LLUUID& asset_id, boo
 	}
 
 	// *FIX: support cleanup of old keyframe data
+	if (sBakeKeyframes)
+	{
+		joint_motion_list->bakeKeyframes();
+	}
+
     mJointMotionList = joint_motion_list.release(); // release from unique_ptr to member;
 	LLKeyframeDataCache::addKeyframeData(getID(),  mJointMotionList);
 	mAssetStatus = ASSET_LOADED;
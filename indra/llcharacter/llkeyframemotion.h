@@ -198,6 +198,17 @@ public:
 
 	static void flushKeyframeCache();
 
+	// Resample the rotation and position curves of animations loaded from
+	// now on at a fixed rate, and play those back instead of searching the
+	// keys. The samples are part of the JointMotionList that
+	// LLKeyframeDataCache shares between everyone playing the animation.
+	static void setBakeKeyframes(bool bake) { sBakeKeyframes = bake; }
+	static bool getBakeKeyframes() { return sBakeKeyframes; }
+
+	static constexpr F32 BAKED_SAMPLES_PER_SECOND = 60.f;
+	// longer animations keep searching their keys
+	static constexpr S32 MAX_BAKED_SAMPLES = 3601;
+
 protected:
 	//-------------------------------------------------------------------------
 	// JointConstraintSharedData
@@ -317,6 +328,27 @@ public:
 		LLVector3	mPosition;
 	};
 
+	//-------------------------------------------------------------------------
+	// BakedCurve
+	// A curve sampled at uniform intervals over the animation, quantized
+	// to 4 S16 components per sample in a buffer owned by JointMotionList.
+	//-------------------------------------------------------------------------
+	class BakedCurve
+	{
+	public:
+		BakedCurve() : mSamples(NULL), mNumSamples(0), mSampleRate(0.f) {}
+
+		bool isBaked() const { return mSamples != NULL; }
+		// components lerped between the samples either side of time,
+		// in [-1, 1]
+		LLVector4a sample(F32 time) const;
+
+		const S16*	mSamples;
+		S32			mNumSamples;
+		// samples per second
+		F32			mSampleRate;
+	};
+
 	//-------------------------------------------------------------------------
 	// ScaleCurve
 	//-------------------------------------------------------------------------
@@ -345,6 +377,7 @@ public:
 		RotationCurve();
 		~RotationCurve();
 		LLQuaternion getValue(F32 time, F32 duration);
+		LLQuaternion getBakedValue(F32 time) const;
 		LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
 
 		InterpolationType	mInterpolationType;
@@ -353,6 +386,7 @@ public:
 		key_map_t		mKeys;
 		RotationKey		mLoopInKey;
 		RotationKey		mLoopOutKey;
+		BakedCurve		mBaked;
 	};
 
 	//-------------------------------------------------------------------------
@@ -364,6 +398,7 @@ public:
 		PositionCurve();
 		~PositionCurve();
 		LLVector3 getValue(F32 time, F32 duration);
+		LLVector3 getBakedValue(F32 time) const;
 		LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
 
 		InterpolationType	mInterpolationType;
@@ -372,6 +407,7 @@ public:
 		key_map_t		mKeys;
 		PositionKey		mLoopInKey;
 		PositionKey		mLoopOutKey;
+		BakedCurve		mBaked;
 	};
 
 	//-------------------------------------------------------------------------
@@ -413,10 +449,14 @@ public:
 		// TODO: LLKeyframeDataCache::getKeyframeData should probably return a class containing 
 		// JointMotionList and mEmoteName, see LLKeyframeMotion::onInitialize.
 		std::string				mEmoteName; 
+		// storage for every BakedCurve of the list
+		std::vector<S16>		mBakedSamples;
 	public:
 		JointMotionList();
 		~JointMotionList();
 		U32 dumpDiagInfo();
+		// fill in the curves' BakedCurves, once all keys are loaded
+		void bakeKeyframes();
 		JointMotion* getJointMotion(U32 index) const { llassert(index < mJointMotionArray.size()); return mJointMotionArray[index]; }
 		U32 getNumJointMotions() const { return mJointMotionArray.size(); }
 	};
@@ -433,6 +473,8 @@ protected:
 	F32								mLastLoopedTime;
 	AssetStatus						mAssetStatus;
 
+	static bool						sBakeKeyframes;
+
 public:
 	void setCharacter(LLCharacter* character) { mCharacter = character; }
 };
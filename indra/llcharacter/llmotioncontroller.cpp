@@ -809,6 +809,18 @@ void LLMotionController::updateLoadingMotions()
 // updateMotion()
 //-----------------------------------------------------------------------------
 void LLMotionController::updateMotions(bool force_update)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	if (prepareUpdate())
+	{
+		evaluateMotions(force_update);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// prepareUpdate()
+//-----------------------------------------------------------------------------
+BOOL LLMotionController::prepareUpdate()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
     // SL-763: "Distant animated objects run at super fast speed"
@@ -848,7 +860,7 @@ void LLMotionController::updateMotions(bool force_update)
 
 				updateLoadingMotions();
 				
-				return;
+				return FALSE;
 			}
 			
 			// is calculating a new keyframe pose, make sure the last one gets applied
@@ -866,7 +878,18 @@ void LLMotionController::updateMotions(bool force_update)
 	}
 
 	updateLoadingMotions();
-	
+
+	return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::evaluateMotions(bool force_update)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	BOOL use_quantum = (mTimeStep != 0.f);
+
 	resetJointSignatures();
 
 	if (mPaused && !force_update)
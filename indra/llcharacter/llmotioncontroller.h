@@ -132,6 +132,16 @@ public:
 	// deactivates terminated motions`
 	void updateMotions(bool force_update = false);
 
+	// updateMotions() in two stages, for characters updated in parallel.
+	// prepareUpdate() advances the animation clock and brings in motions
+	// that finished loading, which touches state shared with other
+	// characters, and returns false if there is nothing to evaluate this
+	// step. evaluateMotions() then runs the motions and blends their poses
+	// into the joints, touching only this character, so controllers of
+	// different characters may evaluate concurrently.
+	BOOL prepareUpdate();
+	void evaluateMotions(bool force_update = false);
+
 	// minimal update (e.g. while hidden)
 	void updateMotionsMinimal();
 
@@ -0,0 +1,341 @@
+/**
+ * @file llcharacter_test.cpp
+ * @brief Staged character update tests and benchmark
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llcharacter.h"
+#include "../llmotion.h"
+#include "v3dmath.h"
+#include "../test/lltut.h"
+
+#include "parallelfor.h"
+#include "workqueue.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace
+{
+    const LLUUID SWING_MOTION("8f4bdbb5-73a2-4a9e-8a58-3c0e7a3f4f01");
+    const LLUUID SWAY_MOTION("8f4bdbb5-73a2-4a9e-8a58-3c0e7a3f4f02");
+
+    // A skeleton of a few joint chains hanging off a root, roughly the size
+    // of an avatar's, with no meshes, visual params or assets.
+    class LLTestCharacter : public LLCharacter
+    {
+    public:
+        LLTestCharacter(S32 chains, S32 length, F32 phase)
+            : mPhase(phase)
+        {
+            mID.generate();
+            addJoint("mRoot", NULL);
+            for (S32 c = 0; c < chains; ++c)
+            {
+                LLJoint* parent = mJoints[0];
+                for (S32 j = 0; j < length; ++j)
+                {
+                    parent = addJoint(llformat("chain%d_%d", c, j), parent);
+                    parent->setPosition(LLVector3(0.f, 0.f, 0.1f));
+                }
+            }
+        }
+
+        ~LLTestCharacter()
+        {
+            // motions hold joint states pointing at the joints
+            flushAllMotions();
+            for (auto it = mJoints.rbegin(); it != mJoints.rend(); ++it)
+            {
+                delete *it;
+            }
+        }
+
+        const char* getAnimationPrefix() override { return "test"; }
+        LLJoint* getRootJoint() override { return mJoints[0]; }
+        LLVector3 getCharacterPosition() override { return LLVector3::zero; }
+        LLQuaternion getCharacterRotation() override { return LLQuaternion::DEFAULT; }
+        LLVector3 getCharacterVelocity() override { return LLVector3::zero; }
+        LLVector3 getCharacterAngularVelocity() override { return LLVector3::zero; }
+        void getGround(const LLVector3& inPos, LLVector3& outPos, LLVector3& outNorm) override
+        {
+            outPos = inPos;
+            outPos.mV[VZ] = 0.f;
+            outNorm = LLVector3::z_axis;
+        }
+        LLJoint* getCharacterJoint(U32 i) override { return i < mJoints.size() ? mJoints[i] : NULL; }
+        F32 getTimeDilation() override { return 1.f; }
+        F32 getPixelArea() const override { return 1000000.f; }
+        LLPolyMesh* getHeadMesh() override { return NULL; }
+        LLPolyMesh* getUpperBodyMesh() override { return NULL; }
+        LLVector3d getPosGlobalFromAgent(const LLVector3& position) override { return LLVector3d(position); }
+        LLVector3 getPosAgentFromGlobal(const LLVector3d& position) override { return LLVector3(position); }
+        void addDebugText(const std::string& text) override {}
+        const LLUUID& getID() const override { return mID; }
+
+        // the named constructor makes joints that are left out of
+        // updateWorldMatrixChildren(), build them the way avatars do
+        LLJoint* addJoint(const std::string& name, LLJoint* parent)
+        {
+            LLJoint* joint = new LLJoint((S32) mJoints.size());
+            joint->setName(name);
+            if (parent)
+            {
+                parent->addChild(joint);
+            }
+            mJoints.push_back(joint);
+            return joint;
+        }
+
+        // same thing the viewer does for a visible avatar
+        void update()
+        {
+            updateMotions(NORMAL_UPDATE);
+            getRootJoint()->updateWorldMatrixChildren();
+        }
+
+        std::vector<LLJoint*> mJoints;
+        F32 mPhase;
+        LLUUID mID;
+    };
+
+    // Rotates joints by a function of the frame count rather than of the
+    // animation clock, so two characters updated the same number of times
+    // end up in the same pose however long the updates took.
+    class LLTestMotion : public LLMotion
+    {
+    public:
+        LLTestMotion(const LLUUID& id, LLMotionBlendType blend, LLJoint::JointPriority priority, S32 stride)
+            : LLMotion(id),
+              mBlend(blend),
+              mPriority(priority),
+              mStride(stride),
+              mPhase(0.f),
+              mFrame(0)
+        {
+            setName("test_motion");
+        }
+
+        static LLMotion* createSwing(const LLUUID& id)
+        {
+            return new LLTestMotion(id, NORMAL_BLEND, LLJoint::MEDIUM_PRIORITY, 1);
+        }
+        static LLMotion* createSway(const LLUUID& id)
+        {
+            return new LLTestMotion(id, ADDITIVE_BLEND, LLJoint::HIGH_PRIORITY, 3);
+        }
+
+        BOOL getLoop() override { return TRUE; }
+        F32 getDuration() override { return 0.f; }
+        F32 getEaseInDuration() override { return 0.f; }
+        F32 getEaseOutDuration() override { return 0.f; }
+        LLJoint::JointPriority getPriority() override { return mPriority; }
+        LLMotionBlendType getBlendType() override { return mBlend; }
+        F32 getMinPixelArea() override { return 0.f; }
+
+        LLMotionInitStatus onInitialize(LLCharacter* character) override
+        {
+            LLTestCharacter* test_character = static_cast<LLTestCharacter*>(character);
+            mPhase = test_character->mPhase;
+            for (size_t i = 1; i < test_character->mJoints.size(); i += mStride)
+            {
+                LLPointer<LLJointState> state = new LLJointState(test_character->mJoints[i]);
+                state->setUsage(LLJointState::ROT);
+                addJointState(state);
+                mStates.push_back(state);
+            }
+            return STATUS_SUCCESS;
+        }
+
+        BOOL onActivate() override { return TRUE; }
+
+        BOOL onUpdate(F32 activeTime, U8* joint_mask) override
+        {
+            F32 t = (F32) mFrame++ * 0.05f + mPhase;
+            for (size_t i = 0; i < mStates.size(); ++i)
+            {
+                F32 angle = 0.3f * sinf(t + (F32) i * 0.4f);
+                mStates[i]->setRotation(LLQuaternion(angle, (i & 1) ? LLVector3::x_axis : LLVector3::y_axis));
+            }
+            return TRUE;
+        }
+
+        void onDeactivate() override {}
+
+    private:
+        LLMotionBlendType mBlend;
+        LLJoint::JointPriority mPriority;
+        S32 mStride;
+        F32 mPhase;
+        U32 mFrame;
+        std::vector<LLPointer<LLJointState> > mStates;
+    };
+
+    typedef std::vector<std::unique_ptr<LLTestCharacter> > characters_t;
+
+    void make_characters(characters_t& characters, S32 count)
+    {
+        for (S32 i = 0; i < count; ++i)
+        {
+            characters.emplace_back(new LLTestCharacter(5, 26, (F32) i));
+            LLTestCharacter* character = characters.back().get();
+            character->registerMotion(SWING_MOTION, LLTestMotion::createSwing);
+            character->registerMotion(SWAY_MOTION, LLTestMotion::createSway);
+            character->startMotion(SWING_MOTION);
+            character->startMotion(SWAY_MOTION);
+        }
+    }
+
+    // the staged update the viewer runs over its avatar list
+    void update_staged(characters_t& characters, const std::string& queue, size_t helpers)
+    {
+        std::vector<LLTestCharacter*> due;
+        for (auto& character : characters)
+        {
+            if (character->beginMotionUpdate(LLCharacter::NORMAL_UPDATE))
+            {
+                due.push_back(character.get());
+            }
+        }
+        LL::parallelFor(queue, due.size(), helpers,
+            [&due](size_t i)
+            {
+                due[i]->evaluateMotions(LLCharacter::NORMAL_UPDATE);
+                due[i]->getRootJoint()->updateWorldMatrixChildren();
+            });
+    }
+}
+
+namespace tut
+{
+    struct LLCharacterTest
+    {
+        LLCharacterTest()
+            : mHelpers("character_helpers")
+        {
+            for (S32 i = 0; i < HELPER_THREADS; ++i)
+            {
+                mWorkers.emplace_back([this](){ mHelpers.runUntilClose(); });
+            }
+        }
+
+        ~LLCharacterTest()
+        {
+            mHelpers.close();
+            for (auto& worker : mWorkers)
+            {
+                worker.join();
+            }
+        }
+
+        static bool samePose(LLTestCharacter* a, LLTestCharacter* b)
+        {
+            for (size_t i = 0; i < a->mJoints.size(); ++i)
+            {
+                if (memcmp(a->mJoints[i]->getWorldMatrix().mMatrix,
+                           b->mJoints[i]->getWorldMatrix().mMatrix, sizeof(LLMatrix4)) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static constexpr S32 HELPER_THREADS = 3;
+        LL::WorkQueue mHelpers;
+        std::vector<std::thread> mWorkers;
+    };
+    typedef test_group<LLCharacterTest> LLCharacterTest_factory;
+    typedef LLCharacterTest_factory::object LLCharacterTest_t;
+    LLCharacterTest_factory tf("LLCharacter");
+
+    template<> template<>
+    void LLCharacterTest_t::test<1>()
+    {
+        set_test_name("staged update matches updateMotions()");
+
+        const S32 CHARACTERS = 16;
+        characters_t serial;
+        characters_t staged;
+        make_characters(serial, CHARACTERS);
+        make_characters(staged, CHARACTERS);
+
+        for (S32 frame = 0; frame < 20; ++frame)
+        {
+            for (auto& character : serial)
+            {
+                character->update();
+            }
+            update_staged(staged, "character_helpers", HELPER_THREADS);
+        }
+
+        for (S32 i = 0; i < CHARACTERS; ++i)
+        {
+            ensure("same pose", samePose(serial[i].get(), staged[i].get()));
+        }
+        ensure("characters animated independently", !samePose(serial[0].get(), serial[1].get()));
+        LLVector3 tip = serial[0]->mJoints.back()->getWorldPosition();
+        ensure("pose applied", tip != LLVector3(0.f, 0.f, 2.6f));
+    }
+
+    template<> template<>
+    void LLCharacterTest_t::test<2>()
+    {
+        set_test_name("animate N characters, serial vs staged");
+
+        const S32 CHARACTERS = 64;
+        const S32 FRAMES = 100;
+        characters_t characters;
+        make_characters(characters, CHARACTERS);
+
+        typedef std::chrono::duration<double, std::milli> ms_t;
+        auto start = std::chrono::steady_clock::now();
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            for (auto& character : characters)
+            {
+                character->update();
+            }
+        }
+        ms_t serial = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (S32 frame = 0; frame < FRAMES; ++frame)
+        {
+            update_staged(characters, "character_helpers", HELPER_THREADS);
+        }
+        ms_t staged = std::chrono::steady_clock::now() - start;
+
+        LL_INFOS() << CHARACTERS << " characters of " << characters[0]->mJoints.size() << " joints: "
+                   << serial.count() / FRAMES << " ms per frame serial, "
+                   << staged.count() / FRAMES << " ms per frame staged on "
+                   << HELPER_THREADS << " helper threads" << LL_ENDL;
+
+        for (auto& character : characters)
+        {
+            ensure_equals("skeleton propagated", character->mJoints.back()->mDirtyFlags, 0u);
+        }
+    }
+}
@@ -0,0 +1,200 @@
+/**
+ * @file llkeyframemotion_test.cpp
+ * @brief Baked keyframe curve tests and sampling benchmark
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llkeyframemotion.h"
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <memory>
+
+namespace
+{
+    typedef LLKeyframeMotion::JointMotionList JointMotionList;
+    typedef LLKeyframeMotion::JointMotion JointMotion;
+
+    // Something like an uploaded dance: keys every 1/30s, jittered the
+    // way quantized key times come out, swinging each joint back and
+    // forth with a little noise in it.
+    JointMotionList* make_motion_list(F32 duration, S32 joints)
+    {
+        JointMotionList* list = new JointMotionList();
+        list->mDuration = duration;
+        for (S32 j = 0; j < joints; ++j)
+        {
+            JointMotion* joint_motion = new JointMotion();
+            joint_motion->mJointName = llformat("joint%d", j);
+            joint_motion->mUsage = LLJointState::POS | LLJointState::ROT;
+            joint_motion->mPriority = LLJoint::MEDIUM_PRIORITY;
+
+            S32 keys = (S32) (duration * 30.f);
+            for (S32 k = 0; k <= keys; ++k)
+            {
+                F32 time = llclamp(((F32) k + 0.2f * sinf((F32) (k * 7 + j))) / 30.f, 0.f, duration);
+                F32 angle = 1.2f * sinf(time * 2.f + (F32) j) + 0.05f * sinf((F32) (k * 13 + j));
+                LLVector3 axis((F32) (j % 3), 1.f, (F32) (j % 5));
+                axis.normVec();
+                joint_motion->mRotationCurve.mKeys[time] =
+                    LLKeyframeMotion::RotationKey(time, LLQuaternion(angle, axis));
+                joint_motion->mRotationCurve.mNumKeys++;
+
+                LLVector3 pos(0.1f * sinf(time * 3.f + (F32) j), 0.05f * cosf(time), 0.2f);
+                joint_motion->mPositionCurve.mKeys[time] = LLKeyframeMotion::PositionKey(time, pos);
+                joint_motion->mPositionCurve.mNumKeys++;
+            }
+            list->mJointMotionArray.push_back(joint_motion);
+        }
+        return list;
+    }
+
+    F32 angle_between(const LLQuaternion& a, const LLQuaternion& b)
+    {
+        F32 d = llmin(fabsf(dot(a, b)), 1.f);
+        return 2.f * acosf(d);
+    }
+}
+
+namespace tut
+{
+    struct LLKeyframeMotionTest
+    {
+    };
+    typedef test_group<LLKeyframeMotionTest> LLKeyframeMotionTest_factory;
+    typedef LLKeyframeMotionTest_factory::object LLKeyframeMotionTest_t;
+    LLKeyframeMotionTest_factory tf("LLKeyframeMotion");
+
+    template<> template<>
+    void LLKeyframeMotionTest_t::test<1>()
+    {
+        set_test_name("baked curves follow the keys");
+
+        const F32 DURATION = 5.f;
+        std::unique_ptr<JointMotionList> list(make_motion_list(DURATION, 8));
+        list->bakeKeyframes();
+
+        ensure_equals("samples stored once for the list", list->mBakedSamples.size(),
+                      (size_t) (8 * 2 * (DURATION * LLKeyframeMotion::BAKED_SAMPLES_PER_SECOND + 1) * 4));
+
+        F32 max_angle = 0.f;
+        F32 max_distance = 0.f;
+        for (U32 j = 0; j < list->getNumJointMotions(); ++j)
+        {
+            JointMotion* joint_motion = list->getJointMotion(j);
+            ensure("rotation baked", joint_motion->mRotationCurve.mBaked.isBaked());
+            ensure("position baked", joint_motion->mPositionCurve.mBaked.isBaked());
+
+            // past both ends too, where the keys hold their first and last values
+            for (F32 time = -0.1f; time < DURATION + 0.1f; time += 0.0037f)
+            {
+                LLQuaternion rot = joint_motion->mRotationCurve.getBakedValue(time);
+                ensure("normalized", fabsf(dot(rot, rot) - 1.f) < 0.0001f);
+                max_angle = llmax(max_angle,
+                                  angle_between(rot, joint_motion->mRotationCurve.getValue(time, DURATION)));
+
+                LLVector3 pos = joint_motion->mPositionCurve.getBakedValue(time);
+                max_distance = llmax(max_distance,
+                                     dist_vec(pos, joint_motion->mPositionCurve.getValue(time, DURATION)));
+            }
+        }
+
+        LL_INFOS() << "baked error: " << max_angle * RAD_TO_DEG << " degrees, "
+                   << max_distance * 1000.f << " mm" << LL_ENDL;
+        ensure("rotations within a degree", max_angle < DEG_TO_RAD);
+        ensure("positions within two millimeters", max_distance < 0.002f);
+    }
+
+    template<> template<>
+    void LLKeyframeMotionTest_t::test<2>()
+    {
+        set_test_name("curves left to key search");
+
+        // too long to bake
+        F32 long_duration = (F32) LLKeyframeMotion::MAX_BAKED_SAMPLES / LLKeyframeMotion::BAKED_SAMPLES_PER_SECOND + 1.f;
+        std::unique_ptr<JointMotionList> list(make_motion_list(long_duration, 1));
+        list->bakeKeyframes();
+        ensure("long animation", list->mBakedSamples.empty());
+        ensure("long animation curve", !list->getJointMotion(0)->mRotationCurve.mBaked.isBaked());
+
+        // a constant curve and a stepped one
+        list.reset(make_motion_list(2.f, 2));
+        JointMotion* constant = list->getJointMotion(0);
+        LLKeyframeMotion::RotationKey key = constant->mRotationCurve.mKeys.begin()->second;
+        constant->mRotationCurve.mKeys.clear();
+        constant->mRotationCurve.mKeys[key.mTime] = key;
+        constant->mRotationCurve.mNumKeys = 1;
+        list->getJointMotion(1)->mPositionCurve.mInterpolationType = LLKeyframeMotion::IT_STEP;
+        list->bakeKeyframes();
+
+        ensure("single key", !constant->mRotationCurve.mBaked.isBaked());
+        ensure("stepped", !list->getJointMotion(1)->mPositionCurve.mBaked.isBaked());
+        ensure("the rest", constant->mPositionCurve.mBaked.isBaked() &&
+                           list->getJointMotion(1)->mRotationCurve.mBaked.isBaked());
+    }
+
+    template<> template<>
+    void LLKeyframeMotionTest_t::test<3>()
+    {
+        set_test_name("sample one dance on a crowd, keys vs baked");
+
+        // 50 avatars a frame apart in the same 20 second, 60 joint dance
+        const S32 AVATARS = 50;
+        const S32 FRAMES = 100;
+        const F32 DURATION = 20.f;
+        std::unique_ptr<JointMotionList> list(make_motion_list(DURATION, 60));
+        list->bakeKeyframes();
+
+        typedef std::chrono::duration<double, std::milli> ms_t;
+        F32 checksum[2] = { 0.f, 0.f };
+        ms_t elapsed[2];
+        for (S32 baked = 0; baked < 2; ++baked)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (S32 frame = 0; frame < FRAMES; ++frame)
+            {
+                for (S32 avatar = 0; avatar < AVATARS; ++avatar)
+                {
+                    F32 time = fmodf((F32) (frame + avatar * 7) / 45.f, DURATION);
+                    for (U32 j = 0; j < list->getNumJointMotions(); ++j)
+                    {
+                        JointMotion* joint_motion = list->getJointMotion(j);
+                        LLQuaternion rot = baked ? joint_motion->mRotationCurve.getBakedValue(time)
+                                                 : joint_motion->mRotationCurve.getValue(time, DURATION);
+                        LLVector3 pos = baked ? joint_motion->mPositionCurve.getBakedValue(time)
+                                              : joint_motion->mPositionCurve.getValue(time, DURATION);
+                        checksum[baked] += rot.mQ[VW] + pos.mV[VX];
+                    }
+                }
+            }
+            elapsed[baked] = std::chrono::steady_clock::now() - start;
+        }
+
+        LL_INFOS() << AVATARS << " avatars, " << list->getNumJointMotions() << " joints: "
+                   << elapsed[0].count() / FRAMES << " ms per frame from keys, "
+                   << elapsed[1].count() / FRAMES << " ms per frame baked, "
+                   << list->mBakedSamples.size() * sizeof(S16) / 1024 << " KB of samples" << LL_ENDL;
+        ensure_distance("same poses", checksum[1], checksum[0], fabsf(checksum[0]) * 0.001f + 1.f);
+    }
+}
@@ -0,0 +1,146 @@
+/**
+ * @file llcharscan.h
+ * @brief SSE2 helpers to find interesting characters in text buffers.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLCHARSCAN_H
+#define LL_LLCHARSCAN_H
+
+#include "stdtypes.h"
+
+#include <emmintrin.h>
+#if LL_WINDOWS
+#include <intrin.h>
+#endif
+
+// The text parsers spend most of their time looking for the next delimiter
+// in runs of plain characters. These helpers test 16 bytes per step and
+// finish the tail one byte at a time. Every function returns end when
+// nothing is found.
+namespace LL
+{
+    // index of the lowest set bit, mask must not be 0
+    inline U32 lowest_bit(U32 mask)
+    {
+#if LL_WINDOWS
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (U32)index;
+#else
+        return (U32)__builtin_ctz(mask);
+#endif
+    }
+
+    // First occurrence of a or b.
+    inline const char* find_either(const char* begin, const char* end, char a, char b)
+    {
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        while (end - begin >= 16)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)begin);
+            U32 mask = (U32)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                                                          _mm_cmpeq_epi8(chunk, vb)));
+            if (mask)
+            {
+                return begin + lowest_bit(mask);
+            }
+            begin += 16;
+        }
+        while (begin < end && *begin != a && *begin != b)
+        {
+            ++begin;
+        }
+        return begin;
+    }
+
+    // First character that isspace() rejects in the "C" locale, i.e. not
+    // one of ' ', '\t', '\n', '\v', '\f' or '\r'.
+    inline const char* skip_space(const char* begin, const char* end)
+    {
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i four = _mm_set1_epi8(4);
+        while (end - begin >= 16)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)begin);
+            // '\t' to '\r' are contiguous: (unsigned)(c - '\t') <= 4
+            __m128i rel = _mm_sub_epi8(chunk, tab);
+            __m128i is_ctrl = _mm_cmpeq_epi8(_mm_min_epu8(rel, four), rel);
+            __m128i is_space = _mm_or_si128(is_ctrl, _mm_cmpeq_epi8(chunk, space));
+            U32 mask = ~(U32)_mm_movemask_epi8(is_space) & 0xffff;
+            if (mask)
+            {
+                return begin + lowest_bit(mask);
+            }
+            begin += 16;
+        }
+        while (begin < end && (*begin == ' ' || (U8)(*begin - '\t') <= 4))
+        {
+            ++begin;
+        }
+        return begin;
+    }
+
+    // First character that XML character data cannot simply be copied
+    // through: markup ('<', '&'), a possible "]]>", a control character
+    // other than tab and newline (this includes '\r', which XML parsers
+    // normalize) or any non-ASCII byte, which needs UTF-8 validation.
+    inline const char* find_xml_special(const char* begin, const char* end)
+    {
+        const __m128i lt = _mm_set1_epi8('<');
+        const __m128i amp = _mm_set1_epi8('&');
+        const __m128i bracket = _mm_set1_epi8(']');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i max_ctrl = _mm_set1_epi8(0x1f);
+        while (end - begin >= 16)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)begin);
+            __m128i markup = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, lt), _mm_cmpeq_epi8(chunk, amp)),
+                                          _mm_cmpeq_epi8(chunk, bracket));
+            __m128i ctrl = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, tab), _mm_cmpeq_epi8(chunk, newline)),
+                                            _mm_cmpeq_epi8(_mm_min_epu8(chunk, max_ctrl), chunk));
+            // movemask picks up the high bit, which flags non-ASCII bytes
+            U32 mask = (U32)_mm_movemask_epi8(_mm_or_si128(markup, ctrl)) | (U32)_mm_movemask_epi8(chunk);
+            if (mask)
+            {
+                return begin + lowest_bit(mask);
+            }
+            begin += 16;
+        }
+        while (begin < end)
+        {
+            U8 c = (U8)*begin;
+            if (c == '<' || c == '&' || c == ']' || c >= 0x80 || (c < 0x20 && c != '\t' && c != '\n'))
+            {
+                break;
+            }
+            ++begin;
+        }
+        return begin;
+    }
+}
+
+#endif // LL_LLCHARSCAN_H
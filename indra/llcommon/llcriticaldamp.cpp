@@ -27,6 +27,7 @@
 #include "linden_common.h"
 
 #include "llcriticaldamp.h"
+#include "llthread.h"
 #include <algorithm>
 
 //-----------------------------------------------------------------------------
@@ -88,7 +89,9 @@ F32 LLSmoothInterpolation::getInterpolant(F32SecondsImplicit time_constant, bool
 		return 1.f;
 	}
 
-	if (use_cache)
+	// The cache is shared, so only the main thread may grow it. Motions
+	// evaluated on worker threads compute the same value directly.
+	if (use_cache && on_main_thread())
 	{
 		interpolant_vec_t::iterator find_it = std::lower_bound(sInterpolants.begin(), sInterpolants.end(), time_constant.value(), CompareTimeConstants());
 		if (find_it != sInterpolants.end() && find_it->mTimeScale == time_constant) 
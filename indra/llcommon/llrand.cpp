@@ -29,6 +29,8 @@
 #include "llrand.h"
 #include "lluuid.h"
 
+#include <atomic>
+
 /**
  * Through analysis, we have decided that we want to take values which
  * are close enough to 1.0 to map back to 0.0.  We came to this
@@ -58,7 +60,16 @@
  * to restore uniform distribution.
  */
 
-static LLRandLagFib2281 gRandomGenerator(LLUUID::getRandomSeed());
+static const U32 sRandomSeed(LLUUID::getRandomSeed());
+static std::atomic<U32> sRandomThreads(0);
+
+// The generator's state can't be shared between threads, and callers such as
+// avatar motions run on worker threads, so each thread gets its own.
+static LLRandLagFib2281& random_generator()
+{
+	static thread_local LLRandLagFib2281 sGenerator(sRandomSeed + sRandomThreads++);
+	return sGenerator;
+}
 
 // no default implementation, only specific F64 and F32 specializations
 template <typename REAL>
@@ -71,7 +82,7 @@ inline F64 ll_internal_random<F64>()
 	// CPUs (or at least multi-threaded processes) seem to
 	// occasionally give an obviously incorrect random number -- like
 	// 5^15 or something. Sooooo, clamp it as described above.
-	F64 rv = gRandomGenerator();
+	F64 rv = random_generator()();
 	if(!((rv >= 0.0) && (rv < 1.0))) return fmod(rv, 1.0);
 	return rv;
 }
@@ -32,8 +32,15 @@
 #include "llsdjson.h"
 
 #include "llerror.h"
+#include "llcharscan.h"
 #include "../llmath/llmath.h"
 
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <istream>
+#include <ostream>
+
 //=========================================================================
 LLSD LlsdFromJson(const Json::Value &val)
 {
@@ -124,3 +131,657 @@ Json::Value LlsdToJson(const LLSD &val)
 
     return result;
 }
+
+//=========================================================================
+// Direct conversion between JSON text and LLSD.
+namespace
+{
+    // Same nesting limit as Json::Reader
+    const S32 MAX_JSON_DEPTH = 1000;
+
+    // Input from a contiguous buffer
+    class JsonMemorySource
+    {
+    public:
+        JsonMemorySource(const char *data, size_t size) :
+            mCur(data),
+            mEnd(data + size)
+        {}
+
+        int peek() const { return (mCur < mEnd) ? (U8)*mCur : EOF; }
+        int get() { return (mCur < mEnd) ? (U8)*mCur++ : EOF; }
+
+        // Appends characters up to the next quote or backslash
+        void appendPlain(std::string &out)
+        {
+            const char *stop = LL::find_either(mCur, mEnd, '"', '\\');
+            out.append(mCur, stop);
+            mCur = stop;
+        }
+
+    private:
+        const char *mCur;
+        const char *mEnd;
+    };
+
+    // Input from a stream, consuming nothing past the end of the value
+    class JsonStreamSource
+    {
+    public:
+        JsonStreamSource(std::streambuf *buf) :
+            mBuf(buf)
+        {}
+
+        int peek() { return mBuf ? mBuf->sgetc() : EOF; }
+        int get() { return mBuf ? mBuf->sbumpc() : EOF; }
+
+        void appendPlain(std::string &out)
+        {
+            int c;
+            while ((c = peek()) != EOF && c != '"' && c != '\\')
+            {
+                out += (char)get();
+            }
+        }
+
+    private:
+        std::streambuf *mBuf;
+    };
+
+    template <class SOURCE>
+    class JsonParser
+    {
+    public:
+        JsonParser(SOURCE &source) :
+            mSource(source),
+            mDepth(0)
+        {}
+
+        bool parse(LLSD &result)
+        {
+            result.clear();
+            return skipSpace() && parseValue(result);
+        }
+
+        const std::string &getError() const { return mError; }
+
+    private:
+        bool fail(const std::string &error)
+        {
+            mError = error;
+            return false;
+        }
+
+        // White space and comments, which Json::Reader allows
+        bool skipSpace()
+        {
+            while (true)
+            {
+                int c = mSource.peek();
+                if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+                {
+                    mSource.get();
+                }
+                else if (c == '/')
+                {
+                    mSource.get();
+                    c = mSource.get();
+                    if (c == '/')
+                    {
+                        while ((c = mSource.get()) != EOF && c != '\n')
+                            ;
+                    }
+                    else if (c == '*')
+                    {
+                        int prev = 0;
+                        while ((c = mSource.get()) != EOF && !(prev == '*' && c == '/'))
+                        {
+                            prev = c;
+                        }
+                        if (c == EOF)
+                        {
+                            return fail("Unterminated comment");
+                        }
+                    }
+                    else
+                    {
+                        return fail("Syntax error: '/' does not start a comment");
+                    }
+                }
+                else
+                {
+                    return true;
+                }
+            }
+        }
+
+        bool parseValue(LLSD &result)
+        {
+            switch (mSource.peek())
+            {
+            case '{':
+                return parseObject(result);
+            case '[':
+                return parseArray(result);
+            case '"':
+            {
+                std::string str;
+                if (!parseString(str))
+                {
+                    return false;
+                }
+                result = str;
+                return true;
+            }
+            case 't':
+                result = true;
+                return parseLiteral("true");
+            case 'f':
+                result = false;
+                return parseLiteral("false");
+            case 'n':
+                result.clear();
+                return parseLiteral("null");
+            case EOF:
+                return fail("Unexpected end of input");
+            default:
+                return parseNumber(result);
+            }
+        }
+
+        bool parseLiteral(const char *literal)
+        {
+            for (const char *c = literal; *c; ++c)
+            {
+                if (mSource.get() != *c)
+                {
+                    return fail(std::string("Syntax error: expected ") + literal);
+                }
+            }
+            return true;
+        }
+
+        bool parseObject(LLSD &result)
+        {
+            if (++mDepth > MAX_JSON_DEPTH)
+            {
+                return fail("Exceeded nesting limit");
+            }
+            mSource.get(); // '{'
+            result = LLSD::emptyMap();
+            if (!skipSpace())
+            {
+                return false;
+            }
+            if (mSource.peek() == '}')
+            {
+                mSource.get();
+                --mDepth;
+                return true;
+            }
+
+            std::string key;
+            while (true)
+            {
+                if (mSource.peek() != '"')
+                {
+                    return fail("Missing '\"' or '}' in object");
+                }
+                key.clear();
+                if (!parseString(key) || !skipSpace())
+                {
+                    return false;
+                }
+                if (mSource.get() != ':')
+                {
+                    return fail("Missing ':' after object member name");
+                }
+                // later duplicates replace earlier ones, as in Json::Value
+                if (!skipSpace() || !parseValue(result[key]) || !skipSpace())
+                {
+                    return false;
+                }
+
+                int c = mSource.get();
+                if (c == '}')
+                {
+                    break;
+                }
+                if (c != ',' || !skipSpace())
+                {
+                    return (c != ',') ? fail("Missing ',' or '}' in object") : false;
+                }
+            }
+            --mDepth;
+            return true;
+        }
+
+        bool parseArray(LLSD &result)
+        {
+            if (++mDepth > MAX_JSON_DEPTH)
+            {
+                return fail("Exceeded nesting limit");
+            }
+            mSource.get(); // '['
+            result = LLSD::emptyArray();
+            if (!skipSpace())
+            {
+                return false;
+            }
+            if (mSource.peek() == ']')
+            {
+                mSource.get();
+                --mDepth;
+                return true;
+            }
+
+            while (true)
+            {
+                if (!parseValue(result.append(LLSD())) || !skipSpace())
+                {
+                    return false;
+                }
+
+                int c = mSource.get();
+                if (c == ']')
+                {
+                    break;
+                }
+                if (c != ',' || !skipSpace())
+                {
+                    return (c != ',') ? fail("Missing ',' or ']' in array") : false;
+                }
+            }
+            --mDepth;
+            return true;
+        }
+
+        bool parseHex4(U32 &code)
+        {
+            code = 0;
+            for (S32 i = 0; i < 4; ++i)
+            {
+                int c = mSource.get();
+                if (c == EOF || !isxdigit(c))
+                {
+                    return fail("Bad unicode escape sequence in string");
+                }
+                code = (code << 4) | hex_as_nybble((char)c);
+            }
+            return true;
+        }
+
+        bool parseString(std::string &out)
+        {
+            mSource.get(); // '"'
+            while (true)
+            {
+                mSource.appendPlain(out);
+                int c = mSource.get();
+                if (c == '"')
+                {
+                    return true;
+                }
+                if (c == EOF)
+                {
+                    return fail("Missing '\"' at end of string");
+                }
+
+                // escape sequence
+                switch (mSource.get())
+                {
+                case '"':   out += '"';     break;
+                case '\\':  out += '\\';    break;
+                case '/':   out += '/';     break;
+                case 'b':   out += '\b';    break;
+                case 'f':   out += '\f';    break;
+                case 'n':   out += '\n';    break;
+                case 'r':   out += '\r';    break;
+                case 't':   out += '\t';    break;
+                case 'u':
+                {
+                    U32 code;
+                    if (!parseHex4(code))
+                    {
+                        return false;
+                    }
+                    if (code >= 0xDC00 && code <= 0xDFFF)
+                    {
+                        return fail("Unpaired surrogate in string");
+                    }
+                    if (code >= 0xD800 && code <= 0xDBFF)
+                    {
+                        U32 low;
+                        if (mSource.get() != '\\' || mSource.get() != 'u' || !parseHex4(low) ||
+                            low < 0xDC00 || low > 0xDFFF)
+                        {
+                            return fail("Unpaired surrogate in string");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUTF8(code, out);
+                    break;
+                }
+                default:
+                    return fail("Bad escape sequence in string");
+                }
+            }
+        }
+
+        static void appendUTF8(U32 code, std::string &out)
+        {
+            if (code < 0x80)
+            {
+                out += (char)code;
+            }
+            else if (code < 0x800)
+            {
+                out += (char)(0xC0 | (code >> 6));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                out += (char)(0xE0 | (code >> 12));
+                out += (char)(0x80 | ((code >> 6) & 0x3F));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                out += (char)(0xF0 | (code >> 18));
+                out += (char)(0x80 | ((code >> 12) & 0x3F));
+                out += (char)(0x80 | ((code >> 6) & 0x3F));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+        }
+
+        // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+        bool parseNumber(LLSD &result)
+        {
+            mNumber.clear();
+            bool integral = true;
+            size_t first_digit = 0;
+            if (mSource.peek() == '-')
+            {
+                mNumber += (char)mSource.get();
+                first_digit = 1;
+            }
+            if (!appendDigits())
+            {
+                return fail("Syntax error: value, object or array expected");
+            }
+            if (mNumber[first_digit] == '0' && mNumber.size() > first_digit + 1)
+            {
+                return fail("Syntax error: leading zeros in number");
+            }
+            if (mSource.peek() == '.')
+            {
+                integral = false;
+                mNumber += (char)mSource.get();
+                if (!appendDigits())
+                {
+                    return fail("Syntax error: digits expected after '.'");
+                }
+            }
+            if (mSource.peek() == 'e' || mSource.peek() == 'E')
+            {
+                integral = false;
+                mNumber += (char)mSource.get();
+                if (mSource.peek() == '+' || mSource.peek() == '-')
+                {
+                    mNumber += (char)mSource.get();
+                }
+                if (!appendDigits())
+                {
+                    return fail("Syntax error: digits expected in exponent");
+                }
+            }
+
+            if (integral && mNumber.size() <= 11)
+            {
+                S64 value = strtoll(mNumber.c_str(), NULL, 10);
+                if (value >= S32_MIN && value <= S32_MAX)
+                {
+                    result = (LLSD::Integer)value;
+                    return true;
+                }
+            }
+
+            // strtod() honors the locale's decimal point
+            const char *point = localeconv()->decimal_point;
+            if (point && point[0] && point[0] != '.')
+            {
+                std::replace(mNumber.begin(), mNumber.end(), '.', point[0]);
+            }
+            result = (LLSD::Real)strtod(mNumber.c_str(), NULL);
+            return true;
+        }
+
+        bool appendDigits()
+        {
+            size_t start = mNumber.size();
+            int c;
+            while ((c = mSource.peek()) != EOF && c >= '0' && c <= '9')
+            {
+                mNumber += (char)mSource.get();
+            }
+            return mNumber.size() > start;
+        }
+
+        SOURCE &mSource;
+        S32 mDepth;
+        std::string mNumber;
+        std::string mError;
+    };
+
+    // Buffers output and writes it to the stream in large chunks
+    class JsonWriter
+    {
+    public:
+        JsonWriter(std::ostream &output) :
+            mOutput(output)
+        {
+            mBuffer.reserve(FLUSH_SIZE + 256);
+        }
+
+        ~JsonWriter()
+        {
+            flush();
+        }
+
+        void write(const LLSD &val)
+        {
+            switch (val.type())
+            {
+            case LLSD::TypeUndefined:
+                mBuffer += "null";
+                break;
+            case LLSD::TypeBoolean:
+                mBuffer += val.asBoolean() ? "true" : "false";
+                break;
+            case LLSD::TypeInteger:
+                mBuffer += std::to_string(val.asInteger());
+                break;
+            case LLSD::TypeReal:
+                writeReal(val.asReal());
+                break;
+            case LLSD::TypeURI:
+            case LLSD::TypeDate:
+            case LLSD::TypeUUID:
+            case LLSD::TypeString:
+                writeString(val.asString());
+                break;
+            case LLSD::TypeMap:
+            {
+                mBuffer += '{';
+                bool first = true;
+                for (LLSD::map_const_iterator it = val.beginMap(); it != val.endMap(); ++it)
+                {
+                    if (!first)
+                    {
+                        mBuffer += ',';
+                    }
+                    first = false;
+                    writeString(it->first);
+                    mBuffer += ':';
+                    write(it->second);
+                }
+                mBuffer += '}';
+                break;
+            }
+            case LLSD::TypeArray:
+            {
+                mBuffer += '[';
+                bool first = true;
+                for (LLSD::array_const_iterator it = val.beginArray(); it != val.endArray(); ++it)
+                {
+                    if (!first)
+                    {
+                        mBuffer += ',';
+                    }
+                    first = false;
+                    write(*it);
+                }
+                mBuffer += ']';
+                break;
+            }
+            case LLSD::TypeBinary:
+            default:
+                LL_ERRS("LlsdToJson") << "Unsupported conversion to JSON from LLSD type (" << val.type() << ")." << LL_ENDL;
+                break;
+            }
+
+            if (mBuffer.size() >= FLUSH_SIZE)
+            {
+                flush();
+            }
+        }
+
+        void flush()
+        {
+            mOutput.write(mBuffer.data(), mBuffer.size());
+            mBuffer.clear();
+        }
+
+    private:
+        void writeReal(F64 value)
+        {
+            if (!std::isfinite(value))
+            {
+                // JSON has no representation for these
+                mBuffer += "null";
+                return;
+            }
+
+            // shortest of 15 or 17 digits that reads back exactly
+            char buffer[32];        /* Flawfinder: ignore */
+            snprintf(buffer, sizeof(buffer), "%.15g", value);
+            if (strtod(buffer, NULL) != value)
+            {
+                snprintf(buffer, sizeof(buffer), "%.17g", value);
+            }
+
+            bool integral = true;
+            const char *point = localeconv()->decimal_point;
+            for (char *c = buffer; *c; ++c)
+            {
+                if (point && *c == point[0])
+                {
+                    *c = '.';
+                    integral = false;
+                }
+                else if (*c == 'e')
+                {
+                    integral = false;
+                }
+            }
+            mBuffer += buffer;
+            if (integral)
+            {
+                // keep it a real when read back
+                mBuffer += ".0";
+            }
+        }
+
+        void writeString(const std::string &str)
+        {
+            static const char HEX[] = "0123456789abcdef";
+
+            mBuffer += '"';
+            const char *run = str.data();
+            const char *end = run + str.size();
+            for (const char *c = run; c < end; ++c)
+            {
+                U8 ch = (U8)*c;
+                if (ch >= 0x20 && ch != '"' && ch != '\\')
+                {
+                    continue;
+                }
+                mBuffer.append(run, c);
+                run = c + 1;
+                switch (ch)
+                {
+                case '"':   mBuffer += "\\\"";  break;
+                case '\\':  mBuffer += "\\\\";  break;
+                case '\b':  mBuffer += "\\b";   break;
+                case '\f':  mBuffer += "\\f";   break;
+                case '\n':  mBuffer += "\\n";   break;
+                case '\r':  mBuffer += "\\r";   break;
+                case '\t':  mBuffer += "\\t";   break;
+                default:
+                    mBuffer += "\\u00";
+                    mBuffer += HEX[ch >> 4];
+                    mBuffer += HEX[ch & 0xF];
+                    break;
+                }
+            }
+            mBuffer.append(run, end);
+            mBuffer += '"';
+        }
+
+        static const size_t FLUSH_SIZE = 64 * 1024;
+
+        std::ostream &mOutput;
+        std::string mBuffer;
+    };
+}
+
+//=========================================================================
+bool LlsdFromJson(const char *data, size_t size, LLSD &result, std::string *error)
+{
+    JsonMemorySource source(data, size);
+    JsonParser<JsonMemorySource> parser(source);
+    if (!parser.parse(result))
+    {
+        result.clear();
+        if (error)
+        {
+            *error = parser.getError();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool LlsdFromJson(std::istream &input, LLSD &result, std::string *error)
+{
+    JsonStreamSource source(input.rdbuf());
+    JsonParser<JsonStreamSource> parser(source);
+    if (!parser.parse(result))
+    {
+        result.clear();
+        input.setstate(std::ios::failbit);
+        if (error)
+        {
+            *error = parser.getError();
+        }
+        return false;
+    }
+    return true;
+}
+
+//=========================================================================
+void LlsdToJson(const LLSD &val, std::ostream &output)
+{
+    JsonWriter writer(output);
+    writer.write(val);
+}
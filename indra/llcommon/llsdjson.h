@@ -27,6 +27,7 @@
 #ifndef LL_LLSDJSON_H
 #define LL_LLSDJSON_H
 
+#include <iosfwd>
 #include <map>
 #include <string>
 #include <vector>
@@ -74,4 +75,19 @@ LLSD LlsdFromJson(const Json::Value &val);
 /// TypeBinary    | unsupported 
 Json::Value LlsdToJson(const LLSD &val);
 
+/// Parse JSON text directly into LLSD, without building a Json::Value tree
+/// first. Types are converted as for LlsdFromJson(), except that integers
+/// outside the LLSD::Integer range become LLSD::Real. Comments are allowed
+/// and parsing stops after the first complete value.
+/// Returns false on malformed input, with a description in error if given.
+bool LlsdFromJson(const char *data, size_t size, LLSD &result, std::string *error = NULL);
+
+/// As above, reading from a stream as far as the end of the JSON value.
+/// Sets failbit on malformed input.
+bool LlsdFromJson(std::istream &input, LLSD &result, std::string *error = NULL);
+
+/// Write an LLSD object as compact JSON text, without building a Json::Value
+/// tree first. Types are converted as for LlsdToJson().
+void LlsdToJson(const LLSD &val, std::ostream &output);
+
 #endif // LL_LLSDJSON_H
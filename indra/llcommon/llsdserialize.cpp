@@ -30,13 +30,13 @@
 #include "llsdserialize.h"
 #include "llpointer.h"
 #include "llstreamtools.h" // for fullread
+#include "llcharscan.h"
 
+#include <cerrno>
+#include <clocale>
 #include <iostream>
 #include "apr_base64.h"
 
-#include <boost/iostreams/device/array.hpp>
-#include <boost/iostreams/stream.hpp>
-
 #ifdef LL_USESYSTEMLIBS
 # include <zlib.h>
 #else
@@ -908,7 +908,7 @@ bool LLSDNotationParser::parseBinary(std::istream& istr, LLSD& data) const
 		U8* write;
 		std::vector<U8> value;
 		c = get(istr);
-		while(c != '"')
+		while((c != '"') && istr.good())
 		{
 			putback(istr, c);
 			read = buf;
@@ -925,6 +925,11 @@ bool LLSDNotationParser::parseBinary(std::istream& istr, LLSD& data) const
 			// copy the data out of the byte buffer
 			value.insert(value.end(), byte_buffer, write);
 		}
+		if(c != '"')
+		{
+			// ran out of data before the closing quote
+			return false;
+		}
 		data = value;
 	}
 	else
@@ -1296,6 +1301,860 @@ bool LLSDBinaryParser::parseString(
 }
 
 
+/**
+ * LLSDBinaryBufferParser
+ *
+ * Parses the binary format straight out of a contiguous buffer. Unlike
+ * LLSDBinaryParser it never goes through a streambuf, so there is no
+ * per-byte virtual get() and strings and binaries are copied once from
+ * the buffer into the resulting LLSD instead of through a temporary.
+ */
+namespace
+{
+class LLSDBinaryBufferParser
+{
+public:
+	LLSDBinaryBufferParser(const U8* data, size_t size) :
+		mCur(data),
+		mEnd(data + size)
+	{
+	}
+
+	S32 doParse(LLSD& data, S32 max_depth);
+
+	size_t bytesLeft() const { return mEnd - mCur; }
+	const U8* position() const { return mCur; }
+
+private:
+	S32 parseMap(LLSD& map, S32 max_depth);
+	S32 parseArray(LLSD& array, S32 max_depth);
+
+	bool readU32(U32& value)
+	{
+		if (bytesLeft() < sizeof(U32)) return false;
+		U32 value_nbo;
+		memcpy(&value_nbo, mCur, sizeof(U32));		/*Flawfinder: ignore*/
+		mCur += sizeof(U32);
+		value = ntohl(value_nbo);
+		return true;
+	}
+
+	bool readF64(F64& value)
+	{
+		if (bytesLeft() < sizeof(F64)) return false;
+		memcpy(&value, mCur, sizeof(F64));		/*Flawfinder: ignore*/
+		mCur += sizeof(F64);
+		return true;
+	}
+
+	// Sized string: 4 byte integer size + string
+	bool parseString(std::string& value)
+	{
+		U32 size = 0;
+		if (!readU32(size) || (S32)size < 0 || size > bytesLeft()) return false;
+		value.assign((const char*)mCur, size);
+		mCur += size;
+		return true;
+	}
+
+	// Notation-style quoted string, same escapes as deserialize_string_delim()
+	bool parseDelimString(std::string& value, char delim);
+
+private:
+	const U8* mCur;
+	const U8* mEnd;
+	std::string mScratch;
+};
+
+bool LLSDBinaryBufferParser::parseDelimString(std::string& value, char delim)
+{
+	value.clear();
+	while (mCur < mEnd)
+	{
+		char c = (char)*mCur++;
+		if (c == delim)
+		{
+			return true;
+		}
+		if (c != '\\')
+		{
+			value += c;
+			continue;
+		}
+		if (mCur == mEnd) break;
+		c = (char)*mCur++;
+		switch (c)
+		{
+		case 'x':
+		{
+			if (bytesLeft() < 2) return false;
+			U8 byte = hex_as_nybble((char)mCur[0]) << 4;
+			byte |= hex_as_nybble((char)mCur[1]);
+			mCur += 2;
+			value += (char)byte;
+			break;
+		}
+		case 'a': value += '\a'; break;
+		case 'b': value += '\b'; break;
+		case 'f': value += '\f'; break;
+		case 'n': value += '\n'; break;
+		case 'r': value += '\r'; break;
+		case 't': value += '\t'; break;
+		case 'v': value += '\v'; break;
+		default: value += c; break;
+		}
+	}
+	return false;
+}
+
+S32 LLSDBinaryBufferParser::doParse(LLSD& data, S32 max_depth)
+{
+	if (mCur == mEnd)
+	{
+		return 0;
+	}
+	if (max_depth == 0)
+	{
+		return LLSDParser::PARSE_FAILURE;
+	}
+	char c = (char)*mCur++;
+	S32 parse_count = 1;
+	switch (c)
+	{
+	case '{':
+	{
+		S32 child_count = parseMap(data, max_depth - 1);
+		parse_count = (child_count == LLSDParser::PARSE_FAILURE) ? LLSDParser::PARSE_FAILURE : parse_count + child_count;
+		break;
+	}
+
+	case '[':
+	{
+		S32 child_count = parseArray(data, max_depth - 1);
+		parse_count = (child_count == LLSDParser::PARSE_FAILURE) ? LLSDParser::PARSE_FAILURE : parse_count + child_count;
+		break;
+	}
+
+	case '!':
+		data.clear();
+		break;
+
+	case '0':
+		data = false;
+		break;
+
+	case '1':
+		data = true;
+		break;
+
+	case 'i':
+	{
+		U32 value = 0;
+		if (readU32(value))
+		{
+			data = (S32)value;
+		}
+		else
+		{
+			parse_count = LLSDParser::PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 'r':
+	{
+		F64 real_nbo = 0.0;
+		if (readF64(real_nbo))
+		{
+			data = ll_ntohd(real_nbo);
+		}
+		else
+		{
+			parse_count = LLSDParser::PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 'u':
+	{
+		if (bytesLeft() < UUID_BYTES)
+		{
+			parse_count = LLSDParser::PARSE_FAILURE;
+			break;
+		}
+		LLUUID id;
+		memcpy(id.mData, mCur, UUID_BYTES);		/*Flawfinder: ignore*/
+		mCur += UUID_BYTES;
+		data = id;
+		break;
+	}
+
+	case '\'':
+	case '"':
+		if (parseDelimString(mScratch, c))
+		{
+			data = mScratch;
+		}
+		else
+		{
+			parse_count = LLSDParser::PARSE_FAILURE;
+		}
+		break;
+
+	case 's':
+		if (parseString(mScratch))
+		{
+			data = mScratch;
+		}
+		else
+		{
+			parse_count = LLSDParser::PARSE_FAILURE;
+		}
+		break;
+
+	case 'l':
+		if (parseString(mScratch))
+		{
+			data = LLURI(mScratch);
+		}
+		else
+		{
+			parse_count = LLSDParser::PARSE_FAILURE;
+		}
+		break;
+
+	case 'd':
+	{
+		F64 real = 0.0;
+		if (readF64(real))
+		{
+			data = LLDate(real);
+		}
+		else
+		{
+			parse_count = LLSDParser::PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 'b':
+	{
+		U32 size = 0;
+		if (!readU32(size) || (S32)size < 0 || size > bytesLeft())
+		{
+			parse_count = LLSDParser::PARSE_FAILURE;
+			break;
+		}
+		// Construct the binary in place from the buffer, the only copy
+		data = LLSD::Binary(mCur, mCur + size);
+		mCur += size;
+		break;
+	}
+
+	default:
+		parse_count = LLSDParser::PARSE_FAILURE;
+		LL_INFOS() << "Unrecognized character while parsing: int(" << int(c)
+			<< ")" << LL_ENDL;
+		break;
+	}
+	if (LLSDParser::PARSE_FAILURE == parse_count)
+	{
+		data.clear();
+	}
+	return parse_count;
+}
+
+S32 LLSDBinaryBufferParser::parseMap(LLSD& map, S32 max_depth)
+{
+	map = LLSD::emptyMap();
+	U32 size = 0;
+	if (!readU32(size))
+	{
+		return LLSDParser::PARSE_FAILURE;
+	}
+	S32 parse_count = 0;
+	U32 count = 0;
+	std::string name;
+	while (mCur < mEnd && *mCur != '}' && count < size)
+	{
+		char c = (char)*mCur++;
+		switch (c)
+		{
+		case 'k':
+			if (!parseString(name))
+			{
+				return LLSDParser::PARSE_FAILURE;
+			}
+			break;
+		case '\'':
+		case '"':
+			if (!parseDelimString(name, c))
+			{
+				return LLSDParser::PARSE_FAILURE;
+			}
+			break;
+		default:
+			name.clear();
+			break;
+		}
+		LLSD child;
+		S32 child_count = doParse(child, max_depth);
+		if (child_count <= 0)
+		{
+			// There must be a value for every key
+			return LLSDParser::PARSE_FAILURE;
+		}
+		parse_count += child_count;
+		map.insert(name, child);
+		++count;
+	}
+	if (mCur == mEnd || *mCur++ != '}' || count < size)
+	{
+		// Make sure it is correctly terminated and we parsed as many
+		// as were said to be there.
+		return LLSDParser::PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
+S32 LLSDBinaryBufferParser::parseArray(LLSD& array, S32 max_depth)
+{
+	array = LLSD::emptyArray();
+	U32 size = 0;
+	if (!readU32(size))
+	{
+		return LLSDParser::PARSE_FAILURE;
+	}
+	S32 parse_count = 0;
+	U32 count = 0;
+	while (mCur < mEnd && *mCur != ']' && count < size)
+	{
+		LLSD child;
+		S32 child_count = doParse(child, max_depth);
+		if (LLSDParser::PARSE_FAILURE == child_count)
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		parse_count += child_count;
+		array.append(child);
+		++count;
+	}
+	if (mCur == mEnd || *mCur++ != ']' || count < size)
+	{
+		return LLSDParser::PARSE_FAILURE;
+	}
+	return parse_count;
+}
+} // anonymous namespace
+
+// static
+S32 LLSDSerialize::fromBinary(LLSD& sd, const U8* data, size_t size, S32 max_depth, size_t* bytes_read)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+	LLSDBinaryBufferParser parser(data, size);
+	S32 parse_count = parser.doParse(sd, max_depth);
+	if (bytes_read)
+	{
+		*bytes_read = parser.position() - data;
+	}
+	return parse_count;
+}
+
+/**
+ * LLSDNotationBufferParser
+ *
+ * Fast path for notation held in memory. It accepts well formed input
+ * exactly as LLSDNotationParser would, using LL::find_either() and
+ * LL::skip_space() to cross strings and whitespace 16 bytes at a time.
+ * Whenever it meets something it does not handle, or malformed data, it
+ * gives up with PARSE_UNSUPPORTED and fromNotation() reruns the stream
+ * parser, which stays the reference for odd input and error reporting.
+ */
+namespace
+{
+const S32 PARSE_UNSUPPORTED = -2;
+
+class LLSDNotationBufferParser
+{
+public:
+	LLSDNotationBufferParser(const char* data, size_t size) :
+		mCur(data),
+		mEnd(data + size),
+		// strtod() follows LC_NUMERIC, the stream parser does not
+		mCanParseReals(*localeconv()->decimal_point == '.')
+	{
+	}
+
+	S32 doParse(LLSD& data, S32 max_depth);
+
+private:
+	S32 parseMap(LLSD& map, S32 max_depth);
+	S32 parseArray(LLSD& array, S32 max_depth);
+	bool parseBoolean(LLSD& data, const char* word, bool value);
+	bool parseInteger(S32& value);
+	bool parseReal(F64& value);
+	bool parseString(std::string& value);
+	bool parseDelimString(std::string& value, char delim);
+	bool parseRawString(std::string& value);
+	bool parseLength(size_t& len);
+	bool parseBinary(LLSD& data);
+
+	size_t bytesLeft() const { return mEnd - mCur; }
+
+	bool startsWith(const char* prefix) const
+	{
+		size_t len = strlen(prefix);
+		return bytesLeft() >= len && !memcmp(mCur, prefix, len);
+	}
+
+private:
+	const char* mCur;
+	const char* mEnd;
+	bool mCanParseReals;
+	std::string mScratch;
+};
+
+S32 LLSDNotationBufferParser::doParse(LLSD& data, S32 max_depth)
+{
+	if (max_depth == 0)
+	{
+		return PARSE_UNSUPPORTED;
+	}
+	mCur = LL::skip_space(mCur, mEnd);
+	if (mCur == mEnd)
+	{
+		return 0;
+	}
+
+	S32 parse_count = 1;
+	switch (*mCur)
+	{
+	case '{':
+	{
+		S32 child_count = parseMap(data, max_depth - 1);
+		if (child_count < 0) return PARSE_UNSUPPORTED;
+		parse_count += child_count;
+		break;
+	}
+
+	case '[':
+	{
+		S32 child_count = parseArray(data, max_depth - 1);
+		if (child_count < 0) return PARSE_UNSUPPORTED;
+		parse_count += child_count;
+		break;
+	}
+
+	case '!':
+		++mCur;
+		data.clear();
+		break;
+
+	case '0':
+		++mCur;
+		data = false;
+		break;
+
+	case '1':
+		++mCur;
+		data = true;
+		break;
+
+	case 'F':
+	case 'f':
+		if (!parseBoolean(data, "false", false)) return PARSE_UNSUPPORTED;
+		break;
+
+	case 'T':
+	case 't':
+		if (!parseBoolean(data, "true", true)) return PARSE_UNSUPPORTED;
+		break;
+
+	case 'i':
+	{
+		++mCur;
+		S32 integer = 0;
+		if (!parseInteger(integer)) return PARSE_UNSUPPORTED;
+		data = integer;
+		break;
+	}
+
+	case 'r':
+	{
+		++mCur;
+		F64 real = 0.0;
+		if (!parseReal(real)) return PARSE_UNSUPPORTED;
+		data = real;
+		break;
+	}
+
+	case 'u':
+	{
+		++mCur;
+		// only the canonical 8-4-4-4-12 hex form
+		const size_t UUID_CHARS = UUID_STR_LENGTH - 1;
+		if (bytesLeft() < UUID_CHARS) return PARSE_UNSUPPORTED;
+		for (size_t i = 0; i < UUID_CHARS; ++i)
+		{
+			bool dash = (i == 8 || i == 13 || i == 18 || i == 23);
+			if (dash ? (mCur[i] != '-') : !isxdigit((unsigned char)mCur[i])) return PARSE_UNSUPPORTED;
+		}
+		mScratch.assign(mCur, UUID_CHARS);
+		data = LLUUID(mScratch);
+		mCur += UUID_CHARS;
+		break;
+	}
+
+	case '\"':
+	case '\'':
+	case 's':
+		if (!parseString(mScratch)) return PARSE_UNSUPPORTED;
+		data = mScratch;
+		break;
+
+	case 'l':
+	case 'd':
+	{
+		// type, then any delimiter
+		char type = *mCur++;
+		if (mCur == mEnd) return PARSE_UNSUPPORTED;
+		char delim = *mCur++;
+		if (!parseDelimString(mScratch, delim)) return PARSE_UNSUPPORTED;
+		if (type == 'l')
+		{
+			data = LLURI(mScratch);
+		}
+		else
+		{
+			data = LLDate(mScratch);
+		}
+		break;
+	}
+
+	case 'b':
+		if (!parseBinary(data)) return PARSE_UNSUPPORTED;
+		break;
+
+	default:
+		return PARSE_UNSUPPORTED;
+	}
+	return parse_count;
+}
+
+S32 LLSDNotationBufferParser::parseMap(LLSD& map, S32 max_depth)
+{
+	// map: { string:object, string:object }
+	map = LLSD::emptyMap();
+	++mCur;
+	S32 parse_count = 0;
+	bool found_name = false;
+	std::string name;
+	while (mCur < mEnd)
+	{
+		char c = *mCur;
+		if (c == '}')
+		{
+			++mCur;
+			return parse_count;
+		}
+		if (isspace((unsigned char)c))
+		{
+			mCur = LL::skip_space(mCur, mEnd);
+		}
+		else if (!found_name)
+		{
+			// like the stream parser, anything that is not a key is skipped
+			if ((c == '\"') || (c == '\'') || (c == 's'))
+			{
+				if (!parseString(name)) return PARSE_UNSUPPORTED;
+				found_name = true;
+			}
+			else
+			{
+				++mCur;
+			}
+		}
+		else if (c == ':')
+		{
+			++mCur;
+		}
+		else
+		{
+			LLSD child;
+			S32 child_count = doParse(child, max_depth);
+			if (child_count <= 0) return PARSE_UNSUPPORTED;
+			parse_count += child_count;
+			map.insert(name, child);
+			found_name = false;
+		}
+	}
+	return PARSE_UNSUPPORTED;
+}
+
+S32 LLSDNotationBufferParser::parseArray(LLSD& array, S32 max_depth)
+{
+	// array: [ object, object, object ]
+	array = LLSD::emptyArray();
+	++mCur;
+	S32 parse_count = 0;
+	while (true)
+	{
+		mCur = LL::skip_space(mCur, mEnd);
+		if (mCur == mEnd) return PARSE_UNSUPPORTED;
+		char c = *mCur;
+		if (c == ']')
+		{
+			++mCur;
+			return parse_count;
+		}
+		if (c == ',')
+		{
+			++mCur;
+			continue;
+		}
+		LLSD child;
+		S32 child_count = doParse(child, max_depth);
+		if (child_count < 0) return PARSE_UNSUPPORTED;
+		parse_count += child_count;
+		array.append(child);
+	}
+}
+
+bool LLSDNotationBufferParser::parseBoolean(LLSD& data, const char* word, bool value)
+{
+	// the first letter may stand alone, otherwise the whole word must
+	// follow in any case
+	++mCur;
+	if (mCur < mEnd && isalpha((unsigned char)*mCur))
+	{
+		for (const char* expected = word + 1; *expected; ++expected, ++mCur)
+		{
+			if (mCur == mEnd || tolower((unsigned char)*mCur) != *expected) return false;
+		}
+	}
+	data = value;
+	return true;
+}
+
+bool LLSDNotationBufferParser::parseInteger(S32& value)
+{
+	const char* p = mCur;
+	bool negative = false;
+	if (p < mEnd && (*p == '-' || *p == '+'))
+	{
+		negative = (*p++ == '-');
+	}
+	const char* digits = p;
+	S64 result = 0;
+	while (p < mEnd && *p >= '0' && *p <= '9')
+	{
+		result = result * 10 + (*p++ - '0');
+		if (result > (S64)S32_MAX + 1) return false;
+	}
+	if (p == digits) return false;
+	if (negative)
+	{
+		result = -result;
+	}
+	if (result > S32_MAX) return false;
+	value = (S32)result;
+	mCur = p;
+	return true;
+}
+
+bool LLSDNotationBufferParser::parseReal(F64& value)
+{
+	if (!mCanParseReals) return false;
+
+	// [+-]digits[.digits][(e|E)[+-]digits], what istream >> double reads
+	const char* p = mCur;
+	if (p < mEnd && (*p == '-' || *p == '+')) ++p;
+	size_t mantissa_digits = 0;
+	while (p < mEnd && isdigit((unsigned char)*p)) { ++p; ++mantissa_digits; }
+	if (p < mEnd && *p == '.')
+	{
+		++p;
+		while (p < mEnd && isdigit((unsigned char)*p)) { ++p; ++mantissa_digits; }
+	}
+	if (!mantissa_digits) return false;
+	if (p < mEnd && (*p == 'e' || *p == 'E'))
+	{
+		++p;
+		if (p < mEnd && (*p == '-' || *p == '+')) ++p;
+		const char* exponent = p;
+		while (p < mEnd && isdigit((unsigned char)*p)) ++p;
+		if (p == exponent) return false;
+	}
+
+	char buf[64];		/* Flawfinder: ignore */
+	size_t len = p - mCur;
+	if (len >= sizeof(buf)) return false;
+	memcpy(buf, mCur, len);		/* Flawfinder: ignore */
+	buf[len] = '\0';
+	errno = 0;
+	value = strtod(buf, NULL);
+	if (errno == ERANGE) return false;
+	mCur = p;
+	return true;
+}
+
+bool LLSDNotationBufferParser::parseString(std::string& value)
+{
+	// string: "g'day" | 'have a "nice" day' | s(size)"raw data"
+	char c = *mCur++;
+	if (c == 's')
+	{
+		return parseRawString(value);
+	}
+	return parseDelimString(value, c);
+}
+
+bool LLSDNotationBufferParser::parseDelimString(std::string& value, char delim)
+{
+	// same escapes as deserialize_string_delim(), where a backslash can
+	// only ever start an escape
+	if (delim == '\\') return false;
+	value.clear();
+	while (true)
+	{
+		const char* stop = LL::find_either(mCur, mEnd, delim, '\\');
+		value.append(mCur, stop);
+		mCur = stop;
+		if (mCur == mEnd) return false;
+		if (*mCur++ == delim) return true;
+
+		if (mCur == mEnd) return false;
+		char c = *mCur++;
+		switch (c)
+		{
+		case 'x':
+		{
+			if (bytesLeft() < 2) return false;
+			U8 byte = hex_as_nybble(mCur[0]) << 4;
+			byte |= hex_as_nybble(mCur[1]);
+			mCur += 2;
+			value += (char)byte;
+			break;
+		}
+		case 'a': value += '\a'; break;
+		case 'b': value += '\b'; break;
+		case 'f': value += '\f'; break;
+		case 'n': value += '\n'; break;
+		case 'r': value += '\r'; break;
+		case 't': value += '\t'; break;
+		case 'v': value += '\v'; break;
+		default: value += c; break;
+		}
+	}
+}
+
+bool LLSDNotationBufferParser::parseLength(size_t& len)
+{
+	// (decimal length), strtol() would also take octal and hex, leave
+	// those to the stream parser
+	if (mCur == mEnd || *mCur++ != '(') return false;
+	const char* digits = mCur;
+	len = 0;
+	while (mCur < mEnd && *mCur >= '0' && *mCur <= '9')
+	{
+		len = len * 10 + (*mCur++ - '0');
+		if (len > (size_t)S32_MAX) return false;
+	}
+	size_t num_digits = mCur - digits;
+	if (!num_digits || (num_digits > 1 && *digits == '0')) return false;
+	return mCur < mEnd && *mCur++ == ')';
+}
+
+bool LLSDNotationBufferParser::parseRawString(std::string& value)
+{
+	// s(size)"raw data", either quote may be used
+	size_t len = 0;
+	if (!parseLength(len)) return false;
+	if (mCur == mEnd || (*mCur != '\"' && *mCur != '\'')) return false;
+	++mCur;
+	if (bytesLeft() < len + 1) return false;
+	value.assign(mCur, len);
+	mCur += len;
+	char c = *mCur++;
+	return (c == '\"') || (c == '\'');
+}
+
+bool LLSDNotationBufferParser::parseBinary(LLSD& data)
+{
+	// binary: b64"base64" | b16"hex" | b(len)"raw data"
+	if (startsWith("b64\""))
+	{
+		mCur += 4;
+		const char* end = LL::find_either(mCur, mEnd, '\"', '\"');
+		if (end == mEnd) return false;
+		mScratch.assign(mCur, end);
+		mCur = end + 1;
+		LLSD::Binary value;
+		S32 len = apr_base64_decode_len(mScratch.c_str());
+		if (len)
+		{
+			value.resize(len);
+			len = apr_base64_decode_binary(&value[0], mScratch.c_str());
+			value.resize(len);
+		}
+		data = value;
+		return true;
+	}
+	if (startsWith("b16\""))
+	{
+		mCur += 4;
+		const char* end = LL::find_either(mCur, mEnd, '\"', '\"');
+		if (end == mEnd || ((end - mCur) & 1)) return false;
+		LLSD::Binary value((end - mCur) / 2);
+		for (U8& byte : value)
+		{
+			if (!isxdigit((unsigned char)mCur[0]) || !isxdigit((unsigned char)mCur[1])) return false;
+			byte = (hex_as_nybble(mCur[0]) << 4) | hex_as_nybble(mCur[1]);
+			mCur += 2;
+		}
+		++mCur;
+		data = value;
+		return true;
+	}
+	if (startsWith("b("))
+	{
+		++mCur;
+		size_t len = 0;
+		if (!parseLength(len)) return false;
+		if (mCur == mEnd || *mCur++ != '\"') return false;
+		if (bytesLeft() < len + 1) return false;
+		data = LLSD::Binary(mCur, mCur + len);
+		mCur += len;
+		return *mCur++ == '\"';
+	}
+	return false;
+}
+} // anonymous namespace
+
+// static
+S32 LLSDSerialize::fromNotation(LLSD& sd, const char* data, size_t size, S32 max_depth)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+	{
+		LLSDNotationBufferParser parser(data, size);
+		S32 parse_count = parser.doParse(sd, max_depth);
+		if (parse_count != PARSE_UNSUPPORTED)
+		{
+			return parse_count;
+		}
+	}
+	LLMemoryStream istr((const U8*)data, (S32)size);
+	LLPointer<LLSDNotationParser> p = new LLSDNotationParser;
+	return p->parse(istr, sd, size, max_depth);
+}
+
+// static
+S32 LLSDSerialize::fromXML(LLSD& sd, const char* data, size_t size, bool emit_errors)
+{
+	LLPointer<LLSDXMLParser> p = new LLSDXMLParser(emit_errors);
+	return p->parseBuffer(data, size, sd);
+}
+
 /**
  * LLSDFormatter
  */
@@ -2333,9 +3192,7 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
 	{
 		char* result_ptr = strip_deprecated_header((char*)result, cur_size);
 
-		boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
-		
-		if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
+		if (!LLSDSerialize::fromBinary(data, (const U8*)result_ptr, cur_size, UNZIP_LLSD_MAX_DEPTH))
 		{
 			free(result);
 			return ZR_PARSE_ERROR;
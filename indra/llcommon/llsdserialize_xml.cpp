@@ -31,6 +31,8 @@
 #include <deque>
 
 #include "apr_base64.h"
+#include "llcharscan.h"
+#include "llmemorystream.h"
 #include <boost/regex.hpp>
 
 extern "C"
@@ -259,6 +261,7 @@ public:
 	
 	S32 parse(std::istream& input, LLSD& data);
 	S32 parseLines(std::istream& input, LLSD& data);
+	S32 parseBuffer(const char* begin, const char* end, LLSD& data);
 
 	void parsePart(const char *buf, llssize len);
 	
@@ -297,6 +300,14 @@ private:
 	static Element readElement(const XML_Char* name);
 	
 	static const XML_Char* findAttribute(const XML_Char* name, const XML_Char** pairs);
+
+	static void assignValue(Element element, const std::string& content, LLSD& value);
+
+	// parseBuffer() helpers, false means the input needs expat
+	bool readText(const char*& cur, const char* end, std::string* content);
+	bool readTag(const char*& cur, const char* end, bool& done);
+	bool startElement(Element element);
+	void endElement(Element element, bool& done);
 	
 	bool mEmitErrors;
 
@@ -317,6 +328,8 @@ private:
 	
 	std::string mCurrentKey;		// Current XML <tag>
 	std::string mCurrentContent;	// String data between <tag> and </tag>
+
+	std::vector<Element> mOpenElements;	// parseBuffer() element stack
 };
 
 
@@ -499,6 +512,460 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 }
 
 
+/*
+	parseBuffer() is a fast path for complete documents held in memory, such
+	as capability replies. It scans character data with LL::find_xml_special()
+	instead of feeding expat, and builds the result exactly as the expat
+	handlers below would. It only accepts the subset of XML that LLSD
+	formatters produce (utf-8, no comments, CDATA, DOCTYPE or unknown
+	elements) and returns PARSE_UNSUPPORTED for anything else, including
+	errors, so that the caller can reparse with expat and get the same
+	result and error reporting as before.
+*/
+namespace
+{
+const S32 PARSE_UNSUPPORTED = -2;
+
+inline const char* skip_xml_space(const char* cur, const char* end)
+{
+	while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r'))
+	{
+		++cur;
+	}
+	return cur;
+}
+
+inline bool is_name_char(char c)
+{
+	return isalnum((unsigned char)c) || c == '_' || c == ':' || c == '-' || c == '.';
+}
+
+// Reads name="value" or name='value' from a tag. The value may not need
+// any normalization.
+bool read_attribute(const char*& cur, const char* end,
+					const char*& name, size_t& name_len,
+					const char*& value, size_t& value_len)
+{
+	name = cur;
+	if (cur == end || !(isalpha((unsigned char)*cur) || *cur == '_' || *cur == ':')) return false;
+	while (cur < end && is_name_char(*cur)) ++cur;
+	name_len = cur - name;
+	cur = skip_xml_space(cur, end);
+	if (cur == end || *cur++ != '=') return false;
+	cur = skip_xml_space(cur, end);
+	if (cur == end || (*cur != '"' && *cur != '\'')) return false;
+	char quote = *cur++;
+	value = cur;
+	while (cur < end && *cur != quote)
+	{
+		U8 c = (U8)*cur++;
+		if (c == '<' || c == '&' || c < 0x20 || c >= 0x80) return false;
+	}
+	if (cur == end) return false;
+	value_len = cur++ - value;
+	return true;
+}
+
+// <?xml version="1.0" encoding="utf-8" standalone="yes"?>
+bool read_declaration(const char*& cur, const char* end)
+{
+	static const char* const NAMES[] = { "version", "encoding", "standalone" };
+	cur += 5;
+	size_t next = 0;
+	while (true)
+	{
+		const char* before = cur;
+		cur = skip_xml_space(cur, end);
+		if (end - cur >= 2 && cur[0] == '?' && cur[1] == '>')
+		{
+			cur += 2;
+			return next > 0;
+		}
+		if (cur == before) return false;
+
+		const char* name;
+		const char* value;
+		size_t name_len, value_len;
+		if (!read_attribute(cur, end, name, name_len, value, value_len)) return false;
+		std::string attr(name, name_len);
+		std::string attr_value(value, value_len);
+		size_t index = 0;
+		while (index < 3 && attr != NAMES[index]) ++index;
+		// version comes first, then the others in order
+		if (index == 3 || index < next || (next == 0 && index != 0)) return false;
+		next = index + 1;
+		if ((index == 0 && attr_value != "1.0")
+			|| (index == 1 && LLStringUtil::compareInsensitive(attr_value, "utf-8") != 0)
+			|| (index == 2 && attr_value != "yes" && attr_value != "no"))
+		{
+			return false;
+		}
+	}
+}
+
+// Length of the UTF-8 sequence at cur, 0 if it is not a valid XML character
+size_t utf8_char_length(const U8* cur, const U8* end)
+{
+	U8 c = cur[0];
+	U8 lo = 0x80;
+	U8 hi = 0xBF;
+	size_t len;
+	if (c >= 0xC2 && c <= 0xDF)
+	{
+		len = 2;
+	}
+	else if (c >= 0xE0 && c <= 0xEF)
+	{
+		len = 3;
+		if (c == 0xE0) lo = 0xA0;			// overlong
+		else if (c == 0xED) hi = 0x9F;		// surrogates
+	}
+	else if (c >= 0xF0 && c <= 0xF4)
+	{
+		len = 4;
+		if (c == 0xF0) lo = 0x90;			// overlong
+		else if (c == 0xF4) hi = 0x8F;		// above U+10FFFF
+	}
+	else
+	{
+		return 0;
+	}
+	if ((size_t)(end - cur) < len || cur[1] < lo || cur[1] > hi) return 0;
+	for (size_t i = 2; i < len; ++i)
+	{
+		if ((cur[i] & 0xC0) != 0x80) return 0;
+	}
+	// U+FFFE and U+FFFF are not characters
+	if (c == 0xEF && cur[1] == 0xBF && cur[2] >= 0xBE) return 0;
+	return len;
+}
+
+// Appends the UTF-8 encoding of a character reference
+bool append_char_ref(U32 code, std::string* content)
+{
+	bool valid = (code < 0x20) ? (code == 0x9 || code == 0xA || code == 0xD)
+		: !((code >= 0xD800 && code <= 0xDFFF) || code == 0xFFFE || code == 0xFFFF || code > 0x10FFFF);
+	if (!valid) return false;
+	if (!content) return true;
+	if (code < 0x80)
+	{
+		*content += (char)code;
+	}
+	else if (code < 0x800)
+	{
+		*content += (char)(0xC0 | (code >> 6));
+		*content += (char)(0x80 | (code & 0x3F));
+	}
+	else if (code < 0x10000)
+	{
+		*content += (char)(0xE0 | (code >> 12));
+		*content += (char)(0x80 | ((code >> 6) & 0x3F));
+		*content += (char)(0x80 | (code & 0x3F));
+	}
+	else
+	{
+		*content += (char)(0xF0 | (code >> 18));
+		*content += (char)(0x80 | ((code >> 12) & 0x3F));
+		*content += (char)(0x80 | ((code >> 6) & 0x3F));
+		*content += (char)(0x80 | (code & 0x3F));
+	}
+	return true;
+}
+
+// Decodes the entity or character reference starting at cur ('&')
+bool read_reference(const char*& cur, const char* end, std::string* content)
+{
+	const char* semi = (const char*)memchr(cur, ';', llmin((size_t)(end - cur), (size_t)16));
+	if (!semi) return false;
+	const char* name = cur + 1;
+	size_t len = semi - name;
+	cur = semi + 1;
+
+	char c = 0;
+	if (len == 2 && !strncmp(name, "lt", 2)) c = '<';
+	else if (len == 2 && !strncmp(name, "gt", 2)) c = '>';
+	else if (len == 3 && !strncmp(name, "amp", 3)) c = '&';
+	else if (len == 4 && !strncmp(name, "quot", 4)) c = '"';
+	else if (len == 4 && !strncmp(name, "apos", 4)) c = '\'';
+	if (c)
+	{
+		if (content) *content += c;
+		return true;
+	}
+
+	// &#ddd; or &#xhhh;
+	if (len < 2 || name[0] != '#') return false;
+	const char* digit = name + 1;
+	bool hex = (*digit == 'x');
+	if (hex) ++digit;
+	if (digit == semi) return false;
+	U32 code = 0;
+	for (; digit < semi; ++digit)
+	{
+		unsigned char d = (unsigned char)*digit;
+		if (hex ? !isxdigit(d) : !isdigit(d)) return false;
+		code = code * (hex ? 16 : 10) + (hex ? hex_as_nybble(d) : d - '0');
+		if (code > 0x10FFFF) return false;
+	}
+	return append_char_ref(code, content);
+}
+} // anonymous namespace
+
+S32 LLSDXMLParser::Impl::parseBuffer(const char* cur, const char* end, LLSD& data)
+{
+	mOpenElements.clear();
+
+	// the declaration, if any, must be at the very start
+	if (end - cur >= 5 && !strncmp(cur, "<?xml", 5) && !read_declaration(cur, end))
+	{
+		return PARSE_UNSUPPORTED;
+	}
+	cur = skip_xml_space(cur, end);
+
+	// the document element has to be <llsd>, otherwise leave it to expat
+	bool done = false;
+	if (end - cur < 5 || strncmp(cur, "<llsd", 5) || !readTag(cur, end, done))
+	{
+		return PARSE_UNSUPPORTED;
+	}
+	while (!done)
+	{
+		// only keys and simple values keep their character data
+		Element open = mOpenElements.back();
+		bool keep = (open != ELEMENT_LLSD && open != ELEMENT_MAP && open != ELEMENT_ARRAY);
+		if (!readText(cur, end, keep ? &mCurrentContent : NULL) || !readTag(cur, end, done))
+		{
+			return PARSE_UNSUPPORTED;
+		}
+	}
+
+	data = mResult;
+	return mParseCount;
+}
+
+bool LLSDXMLParser::Impl::readText(const char*& cur, const char* end, std::string* content)
+{
+	while (true)
+	{
+		const char* special = LL::find_xml_special(cur, end);
+		if (content)
+		{
+			content->append(cur, special);
+		}
+		cur = special;
+		if (cur == end)
+		{
+			// the document is not complete
+			return false;
+		}
+
+		switch (*cur)
+		{
+		case '<':
+			return true;
+
+		case '&':
+			if (!read_reference(cur, end, content)) return false;
+			break;
+
+		case ']':
+			// "]]>" is not allowed in character data
+			if (end - cur >= 3 && cur[1] == ']' && cur[2] == '>') return false;
+			if (content) *content += ']';
+			++cur;
+			break;
+
+		default:
+		{
+			// '\r' (which expat would normalize), other control
+			// characters and multi-byte characters
+			size_t len = ((U8)*cur >= 0x80) ? utf8_char_length((const U8*)cur, (const U8*)end) : 0;
+			if (!len) return false;
+			if (content) content->append(cur, len);
+			cur += len;
+			break;
+		}
+		}
+	}
+}
+
+bool LLSDXMLParser::Impl::readTag(const char*& cur, const char* end, bool& done)
+{
+	// cur is on '<'
+	++cur;
+	bool closing = (cur < end && *cur == '/');
+	if (closing) ++cur;
+
+	// every LLSD element name is lower case ASCII, anything else
+	// (comments, processing instructions, CDATA...) goes to expat
+	const char* name = cur;
+	while (cur < end && *cur >= 'a' && *cur <= 'z') ++cur;
+	char name_buf[16];		/* Flawfinder: ignore */
+	size_t name_len = cur - name;
+	if (!name_len || name_len >= sizeof(name_buf)) return false;
+	memcpy(name_buf, name, name_len);		/* Flawfinder: ignore */
+	name_buf[name_len] = '\0';
+	Element element = readElement(name_buf);
+	if (element == ELEMENT_UNKNOWN) return false;
+
+	if (closing)
+	{
+		cur = skip_xml_space(cur, end);
+		if (cur == end || *cur++ != '>') return false;
+		if (mOpenElements.empty() || mOpenElements.back() != element) return false;
+		mOpenElements.pop_back();
+		endElement(element, done);
+		return true;
+	}
+
+	// attributes, only encoding on <binary> means anything to us
+	const size_t MAX_ATTRIBUTES = 8;
+	const char* attr_names[MAX_ATTRIBUTES];
+	size_t attr_lens[MAX_ATTRIBUTES];
+	size_t num_attributes = 0;
+	bool base64 = true;
+	bool self_closing = false;
+	while (true)
+	{
+		const char* before = cur;
+		cur = skip_xml_space(cur, end);
+		if (cur == end) return false;
+		if (*cur == '>')
+		{
+			++cur;
+			break;
+		}
+		if (*cur == '/')
+		{
+			++cur;
+			if (cur == end || *cur++ != '>') return false;
+			self_closing = true;
+			break;
+		}
+		if (cur == before || num_attributes == MAX_ATTRIBUTES) return false;
+
+		const char* attr;
+		const char* value;
+		size_t attr_len, value_len;
+		if (!read_attribute(cur, end, attr, attr_len, value, value_len)) return false;
+		for (size_t i = 0; i < num_attributes; ++i)
+		{
+			if (attr_lens[i] == attr_len && !strncmp(attr_names[i], attr, attr_len)) return false;
+		}
+		attr_names[num_attributes] = attr;
+		attr_lens[num_attributes++] = attr_len;
+		if (attr_len == 8 && !strncmp(attr, "encoding", 8))
+		{
+			base64 = (value_len == 6 && !strncmp(value, "base64", 6));
+		}
+	}
+
+	if ((element == ELEMENT_BINARY && !base64) || !startElement(element))
+	{
+		return false;
+	}
+	if (self_closing)
+	{
+		endElement(element, done);
+	}
+	else
+	{
+		mOpenElements.push_back(element);
+	}
+	return true;
+}
+
+// Same as startElementHandler(), but refuses whatever expat would skip
+bool LLSDXMLParser::Impl::startElement(Element element)
+{
+	// keys and simple values cannot contain elements
+	if (!mOpenElements.empty())
+	{
+		Element parent = mOpenElements.back();
+		if (parent != ELEMENT_LLSD && parent != ELEMENT_MAP && parent != ELEMENT_ARRAY) return false;
+	}
+
+	mCurrentContent.clear();
+
+	switch (element)
+	{
+		case ELEMENT_LLSD:
+			if (mInLLSDElement) { return false; }
+			mInLLSDElement = true;
+			return true;
+
+		case ELEMENT_KEY:
+			return !mStack.empty() && mStack.back()->isMap();
+
+		default:
+			;
+	}
+
+	if (!mInLLSDElement) { return false; }
+
+	if (mStack.empty())
+	{
+		mStack.push_back(&mResult);
+	}
+	else if (mStack.back()->isMap())
+	{
+		if (mCurrentKey.empty()) { return false; }
+		LLSD& map = *mStack.back();
+		mStack.push_back(&map[mCurrentKey]);
+		mCurrentKey.clear();
+	}
+	else if (mStack.back()->isArray())
+	{
+		LLSD& array = *mStack.back();
+		mStack.push_back(&array.append(LLSD()));
+	}
+	else
+	{
+		return false;
+	}
+
+	++mParseCount;
+	switch (element)
+	{
+		case ELEMENT_MAP:
+			*mStack.back() = LLSD::emptyMap();
+			break;
+
+		case ELEMENT_ARRAY:
+			*mStack.back() = LLSD::emptyArray();
+			break;
+
+		default:
+			;
+	}
+	return true;
+}
+
+// Same as endElementHandler()
+void LLSDXMLParser::Impl::endElement(Element element, bool& done)
+{
+	switch (element)
+	{
+		case ELEMENT_LLSD:
+			mInLLSDElement = false;
+			done = true;
+			return;
+
+		case ELEMENT_KEY:
+			mCurrentKey = mCurrentContent;
+			return;
+
+		default:
+			;
+	}
+
+	LLSD& value = *mStack.back();
+	mStack.pop_back();
+	assignValue(element, mCurrentContent, value);
+
+	mCurrentContent.clear();
+}
+
 void LLSDXMLParser::Impl::reset()
 {
 	mResult.clear();
@@ -714,7 +1181,14 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 
 	LLSD& value = *mStack.back();
 	mStack.pop_back();
-	
+	assignValue(element, mCurrentContent, value);
+
+	mCurrentContent.clear();
+}
+
+// static
+void LLSDXMLParser::Impl::assignValue(Element element, const std::string& content, LLSD& value)
+{
 	switch (element)
 	{
 		case ELEMENT_UNDEF:
@@ -722,56 +1196,56 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 			break;
 		
 		case ELEMENT_BOOL:
-			value = (mCurrentContent == "true" || mCurrentContent == "1");
+			value = (content == "true" || content == "1");
 			break;
 		
 		case ELEMENT_INTEGER:
 			{
 				S32 i;
 				// sscanf okay here with different locales - ints don't change for different locale settings like floats do.
-				if ( sscanf(mCurrentContent.c_str(), "%d", &i ) == 1 )
+				if ( sscanf(content.c_str(), "%d", &i ) == 1 )
 				{	// See if sscanf works - it's faster
 					value = i;
 				}
 				else
 				{
-					value = LLSD(mCurrentContent).asInteger();
+					value = LLSD(content).asInteger();
 				}
 			}
 			break;
 		
 		case ELEMENT_REAL:
 			{
-				value = LLSD(mCurrentContent).asReal();
+				value = LLSD(content).asReal();
 				// removed since this breaks when locale has decimal separator that isn't '.'
 				// investigated changing local to something compatible each time but deemed higher
 				// risk that just using LLSD.asReal() each time.
 				//F64 r;
-				//if ( sscanf(mCurrentContent.c_str(), "%lf", &r ) == 1 )
+				//if ( sscanf(content.c_str(), "%lf", &r ) == 1 )
 				//{	// See if sscanf works - it's faster
 				//	value = r;
 				//}
 				//else
 				//{
-				//	value = LLSD(mCurrentContent).asReal();
+				//	value = LLSD(content).asReal();
 				//}
 			}
 			break;
 		
 		case ELEMENT_STRING:
-			value = mCurrentContent;
+			value = content;
 			break;
 		
 		case ELEMENT_UUID:
-			value = LLSD(mCurrentContent).asUUID();
+			value = LLSD(content).asUUID();
 			break;
 		
 		case ELEMENT_DATE:
-			value = LLSD(mCurrentContent).asDate();
+			value = LLSD(content).asDate();
 			break;
 		
 		case ELEMENT_URI:
-			value = LLSD(mCurrentContent).asURI();
+			value = LLSD(content).asURI();
 			break;
 		
 		case ELEMENT_BINARY:
@@ -782,7 +1256,7 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 			// so performance impact shold be negligible. + poppy 2009-09-04
 			boost::regex r;
 			r.assign("\\s");
-			std::string stripped = boost::regex_replace(mCurrentContent, r, "");
+			std::string stripped = boost::regex_replace(content, r, "");
 			S32 len = apr_base64_decode_len(stripped.c_str());
 			std::vector<U8> data;
 			data.resize(len);
@@ -800,8 +1274,6 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 			// other values, map and array, have already been set
 			break;
 	}
-
-	mCurrentContent.clear();
 }
 
 void LLSDXMLParser::Impl::characterDataHandler(const XML_Char* data, int length)
@@ -938,6 +1410,21 @@ S32 LLSDXMLParser::doParse(std::istream& input, LLSD& data, S32 max_depth) const
 	return impl.parse(input, data);
 }
 
+S32 LLSDXMLParser::parseBuffer(const char* buf, size_t len, LLSD& data)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+
+	impl.reset();
+	S32 parse_count = impl.parseBuffer(buf, buf + len, data);
+	if (parse_count == PARSE_UNSUPPORTED)
+	{
+		impl.reset();
+		LLMemoryStream input((const U8*)buf, (S32)len);
+		parse_count = impl.parse(input, data);
+	}
+	return parse_count;
+}
+
 //	virtual 
 void LLSDXMLParser::doReset()
 {
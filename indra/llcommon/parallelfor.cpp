@@ -0,0 +1,97 @@
+/**
+ * @file   parallelfor.cpp
+ * @date   2024-06-03
+ * @brief  Implementation for parallelFor().
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "parallelfor.h"
+// STL headers
+#include <algorithm>                // std::min
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+// other Linden headers
+#include "workqueue.h"
+
+namespace
+{
+    // Shared between the caller and its helpers. Helpers hold it by
+    // shared_ptr since they may run long after parallelFor() has returned.
+    class ParallelForState
+    {
+    public:
+        ParallelForState(size_t count, const std::function<void(size_t)>& func):
+            mCount(count),
+            mFunc(&func)
+        {}
+
+        // claim and run indices until none are left
+        void run()
+        {
+            size_t finished = 0;
+            for (size_t i = mNext++; i < mCount; i = mNext++)
+            {
+                (*mFunc)(i);
+                ++finished;
+            }
+            if (finished && (mDone += finished) == mCount)
+            {
+                // lock so the notification can't slip in between wait()'s
+                // test and its sleep
+                std::lock_guard<std::mutex> lock(mMutex);
+                mCond.notify_all();
+            }
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [this](){ return mDone == mCount; });
+        }
+
+    private:
+        const size_t mCount;
+        // Only dereferenced for a claimed index, and the caller doesn't
+        // return before every claimed index is done.
+        const std::function<void(size_t)>* mFunc;
+        std::atomic<size_t> mNext{ 0 };
+        std::atomic<size_t> mDone{ 0 };
+        std::mutex mMutex;
+        std::condition_variable mCond;
+    };
+} // anonymous namespace
+
+void LL::parallelFor(const std::string& queue, size_t count, size_t helpers,
+                     const std::function<void(size_t)>& func)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    if (! count)
+    {
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>(count, func);
+    // no point in more helpers than there are indices left for them
+    helpers = std::min(helpers, count - 1);
+    auto target = helpers? WorkQueueBase::getInstance(queue) : WorkQueueBase::ptr_t();
+    for (size_t h = 0; target && h < helpers; ++h)
+    {
+        // tryPost() rather than post(): a full queue means its workers
+        // won't get to us in time anyway
+        if (! target->tryPost([state](){ state->run(); }))
+        {
+            break;
+        }
+    }
+
+    state->run();
+    state->wait();
+}
@@ -0,0 +1,42 @@
+/**
+ * @file   parallelfor.h
+ * @date   2024-06-03
+ * @brief  parallelFor() spreads a loop over the calling thread and a
+ *         WorkQueue's worker threads.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_PARALLELFOR_H)
+#define LL_PARALLELFOR_H
+
+#include <cstddef>                  // size_t
+#include <functional>
+#include <string>
+
+namespace LL
+{
+
+    /**
+     * Call func(i) for every i in [0, count) and return once every call has
+     * finished.
+     *
+     * The calling thread works through the range itself, and up to 'helpers'
+     * tasks posted to the WorkQueue named 'queue' claim indices alongside
+     * it. A helper that only gets to run after the range is exhausted does
+     * nothing, so a busy, closed or missing queue costs parallelism but never
+     * stalls the caller: parallelFor() only ever waits for calls that have
+     * already started.
+     *
+     * func is called concurrently for distinct indices and must not throw.
+     * Indices are handed out one at a time, so each call should be worth a
+     * few microseconds of work.
+     */
+    void parallelFor(const std::string& queue, size_t count, size_t helpers,
+                     const std::function<void(size_t)>& func);
+
+} // namespace LL
+
+#endif /* ! defined(LL_PARALLELFOR_H) */
@@ -0,0 +1,216 @@
+/**
+ * @file   llsdjson_test.cpp
+ * @brief  Tests for direct JSON <-> LLSD conversion
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llsdjson.h"
+#include "../llsdutil.h"
+#include "../stringize.h"
+#include "json/reader.h"
+#include "json/writer.h"
+
+#include <chrono>
+#include <sstream>
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+    struct llsdjson_data
+    {
+        LLSD parse(const std::string& text, bool expect_success = true)
+        {
+            LLSD result;
+            std::string error;
+            bool success = LlsdFromJson(text.data(), text.size(), result, &error);
+            ensure_equals(text + ": " + error, success, expect_success);
+            ensure(text + " sets an error", success || !error.empty());
+            return result;
+        }
+
+        std::string write(const LLSD& val)
+        {
+            std::ostringstream out;
+            LlsdToJson(val, out);
+            return out.str();
+        }
+
+        // what LlsdFromJson(Json::Value) makes of the same text
+        LLSD parseWithJsonValue(const std::string& text)
+        {
+            std::istringstream in(text);
+            Json::Value root;
+            in >> root;
+            return LlsdFromJson(root);
+        }
+    };
+    typedef test_group<llsdjson_data> llsdjson_group;
+    typedef llsdjson_group::object object;
+    llsdjson_group llsdjsongrp("llsdjson");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("scalar values");
+
+        ensure("null", parse("null").isUndefined());
+        ensure_equals("true", parse("true").asBoolean(), true);
+        ensure_equals("false", parse(" false ").asBoolean(), false);
+        ensure("integer type", parse("-42").isInteger());
+        ensure_equals("integer", parse("-42").asInteger(), -42);
+        ensure("real type", parse("42.0").isReal());
+        ensure_equals("real", parse("1.5e3").asReal(), 1500.0);
+        // too big for LLSD::Integer
+        ensure("big integer type", parse("4294967296").isReal());
+        ensure_equals("big integer", parse("4294967296").asReal(), 4294967296.0);
+        ensure_equals("string", parse("\"a\\\"b\\\\c\\/d\\n\"").asString(), "a\"b\\c/d\n");
+        ensure_equals("unicode", parse("\"\\u00e9\\ud83d\\ude00\"").asString(), "\xc3\xa9\xf0\x9f\x98\x80");
+        ensure_equals("raw utf-8", parse("\"caf\xc3\xa9\"").asString(), "caf\xc3\xa9");
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("containers and comments");
+
+        LLSD result = parse("// listing\n"
+                            "{ \"id\": 7, /* inline */ \"tags\": [\"a\", [], {}],\n"
+                            "  \"id\": 8, \"empty\": \"\" } and then some");
+        ensure_equals("duplicate key, last wins", result["id"].asInteger(), 8);
+        ensure_equals("array size", result["tags"].size(), 3);
+        ensure_equals("array element", result["tags"][0].asString(), "a");
+        ensure("empty array", result["tags"][1].isArray());
+        ensure("empty map", result["tags"][2].isMap());
+        ensure("empty string", result.has("empty"));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("malformed input");
+
+        const char* malformed[] = {
+            "", "{", "[1,]", "[1 2]", "{\"a\" 1}", "{a:1}", "01", "-", "1.", "1e",
+            "tru", "\"open", "\"\\x\"", "\"\\ud800\"", "\"\\u12\"", "/* open", "/ 1"
+        };
+        for (const char* text : malformed)
+        {
+            ensure(std::string("result cleared for ") + text, parse(text, false).isUndefined());
+        }
+
+        std::string deep(2000, '[');
+        parse(deep, false);
+
+        std::istringstream in("{\"a\":");
+        LLSD result;
+        ensure("stream fails", !LlsdFromJson(in, result));
+        ensure("stream failbit", in.fail());
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("stream parse stops after the value");
+
+        std::istringstream in("{\"a\":[1,2]}\n{\"b\":true}");
+        LLSD first;
+        LLSD second;
+        ensure("first", LlsdFromJson(in, first));
+        ensure("second", LlsdFromJson(in, second));
+        ensure_equals("first value", first["a"][1].asInteger(), 2);
+        ensure_equals("second value", second["b"].asBoolean(), true);
+    }
+
+    template<> template<>
+    void object::test<5>()
+    {
+        set_test_name("writer output");
+
+        LLSD val;
+        val["str"] = "quote\" slash\\ tab\t bell\x07";
+        val["int"] = 3;
+        val["real"] = 0.1;
+        val["whole"] = 2.0;
+        val["list"] = llsd::array(true, LLSD(), "x");
+        val["uuid"] = LLUUID("01234567-89ab-cdef-0123-456789abcdef");
+        ensure_equals(write(val),
+                      "{\"int\":3,\"list\":[true,null,\"x\"],\"real\":0.1,"
+                      "\"str\":\"quote\\\" slash\\\\ tab\\t bell\\u0007\","
+                      "\"uuid\":\"01234567-89ab-cdef-0123-456789abcdef\",\"whole\":2.0}");
+
+        // reals come back exactly and stay reals
+        LLSD reals = llsd::array(1.0 / 3.0, -1e300, 5e-324, 123456789.0);
+        ensure("reals round trip", llsd_equals(parse(write(reals)), reals));
+    }
+
+    template<> template<>
+    void object::test<6>()
+    {
+        set_test_name("matches the Json::Value conversion");
+
+        LLSD listings = LLSD::emptyArray();
+        for (S32 i = 0; i < 20000; ++i)
+        {
+            LLSD item;
+            item["listing_id"] = i;
+            item["name"] = STRINGIZE("Marketplace \"listing\" " << i);
+            item["price"] = 10.25 + i;
+            item["active"] = (i % 3) == 0;
+            item["folder_id"] = LLUUID::generateNewID().asString();
+            item["tags"] = llsd::array("one", "two");
+            listings.append(item);
+        }
+        LLSD payload;
+        payload["listings"] = listings;
+
+        typedef std::chrono::duration<F64, std::milli> ms_t;
+        auto start = std::chrono::steady_clock::now();
+        Json::FastWriter writer;
+        std::string old_text = writer.write(LlsdToJson(payload));
+        auto old_write = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        std::string text = write(payload);
+        auto new_write = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        LLSD old_result = parseWithJsonValue(text);
+        auto old_read = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        LLSD new_result = parse(text);
+        auto new_read = std::chrono::steady_clock::now() - start;
+
+        ensure("Json::Value reads direct output", llsd_equals(old_result, payload));
+        ensure("direct parse", llsd_equals(new_result, payload));
+        ensure("direct parse of Json::FastWriter output", llsd_equals(parse(old_text), payload));
+
+        LL_INFOS() << text.size() << " bytes of JSON: write " << ms_t(old_write).count()
+                   << " ms via Json::Value, " << ms_t(new_write).count() << " ms direct; read "
+                   << ms_t(old_read).count() << " ms via Json::Value, "
+                   << ms_t(new_read).count() << " ms direct" << LL_ENDL;
+    }
+} // namespace tut
@@ -58,6 +58,9 @@ typedef U32 uint32_t;
 #include "stringize.h"
 #include "StringVec.h"
 #include <functional>
+#include <chrono>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
 
 typedef std::function<void(const LLSD& data, std::ostream& str)> FormatterFunction;
 typedef std::function<bool(std::istream& istr, LLSD& data, llssize max_bytes)> ParserFunction;
@@ -585,6 +588,51 @@ namespace tut
 		doRoundTripTests("LLSDXMLFormatter -> deserialize");
 	};
 
+	template<> template<>
+	void TestLLSDSerializeObject::test<11>()
+	{
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::toBinary(sd, str);
+		};
+		mParser = [](std::istream& istr, LLSD& data, llssize max_bytes)
+		{
+			std::string buffer(std::istreambuf_iterator<char>(istr), {});
+			return (LLSDSerialize::fromBinary(data, (const U8*)buffer.data(), buffer.size()) > 0);
+		};
+		doRoundTripTests("binary serialization from buffer");
+	};
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<12>()
+	{
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::toXML(sd, str);
+		};
+		mParser = [](std::istream& istr, LLSD& data, llssize max_bytes)
+		{
+			std::string buffer(std::istreambuf_iterator<char>(istr), {});
+			return (LLSDSerialize::fromXML(data, buffer.data(), buffer.size()) > 0);
+		};
+		doRoundTripTests("xml serialization from buffer");
+	};
+
+	template<> template<>
+	void TestLLSDSerializeObject::test<13>()
+	{
+		mFormatter = [](const LLSD& sd, std::ostream& str)
+		{
+			LLSDSerialize::toNotation(sd, str);
+		};
+		mParser = [](std::istream& istr, LLSD& data, llssize max_bytes)
+		{
+			std::string buffer(std::istreambuf_iterator<char>(istr), {});
+			return (LLSDSerialize::fromNotation(data, buffer.data(), buffer.size()) > 0);
+		};
+		doRoundTripTests("notation serialization from buffer");
+	};
+
 /*==========================================================================*|
 	// We do not expect this test to succeed. Without a header, neither
 	// notation LLSD nor binary LLSD reliably start with a distinct character,
@@ -1790,6 +1838,219 @@ namespace tut
 		ensureBinaryAndXML("map", test);
 	}
 
+	// Compare the buffer parser against the stream parser on one payload
+	// and log how long each takes, returns the binary blob
+	static std::string compareBinaryParsers(const std::string& desc, const LLSD& input, S32 iterations)
+	{
+		std::ostringstream ostr;
+		LLSDSerialize::toBinary(input, ostr);
+		std::string buffer(ostr.str());
+
+		LLSD from_stream;
+		LLSD from_buffer;
+		auto start = std::chrono::steady_clock::now();
+		for (S32 i = 0; i < iterations; ++i)
+		{
+			boost::iostreams::stream<boost::iostreams::array_source> istr(buffer.data(), buffer.size());
+			LLSDSerialize::fromBinary(from_stream, istr, buffer.size());
+		}
+		auto stream_time = std::chrono::steady_clock::now() - start;
+
+		size_t bytes_read = 0;
+		start = std::chrono::steady_clock::now();
+		for (S32 i = 0; i < iterations; ++i)
+		{
+			LLSDSerialize::fromBinary(from_buffer, (const U8*)buffer.data(), buffer.size(), -1, &bytes_read);
+		}
+		auto buffer_time = std::chrono::steady_clock::now() - start;
+
+		ensure_equals(desc + " stream parse", from_stream, input);
+		ensure_equals(desc + " buffer parse", from_buffer, input);
+		ensure_equals(desc + " bytes read", bytes_read, buffer.size());
+
+		typedef std::chrono::duration<F64, std::milli> ms_t;
+		LL_INFOS() << desc << ": " << buffer.size() << " bytes x " << iterations
+				   << ", stream parser " << ms_t(stream_time).count() << " ms"
+				   << ", buffer parser " << ms_t(buffer_time).count() << " ms" << LL_ENDL;
+		return buffer;
+	}
+
+	template<> template<>
+	void TestLLSDCompatibleObject::test<9>()
+	{
+		set_test_name("binary buffer parser matches stream parser");
+
+		// mesh asset: a header map followed by a few large blobs
+		LLSD mesh;
+		for (const char* lod : { "lowest_lod", "low_lod", "medium_lod", "high_lod", "physics_convex" })
+		{
+			LLSD::Binary blob(256 * 1024);
+			for (size_t i = 0; i < blob.size(); ++i)
+			{
+				blob[i] = (U8)(i * 7);
+			}
+			mesh[lod]["offset"] = 0;
+			mesh[lod]["size"] = (S32)blob.size();
+			mesh[lod]["data"] = blob;
+		}
+		mesh["version"] = 1;
+		compareBinaryParsers("mesh-like", mesh, 20);
+
+		// inventory: lots of small maps of short strings and ids
+		LLSD inventory = LLSD::emptyArray();
+		for (S32 i = 0; i < 5000; ++i)
+		{
+			LLSD item;
+			item["item_id"] = LLUUID::generateNewID();
+			item["parent_id"] = LLUUID::generateNewID();
+			item["name"] = STRINGIZE("Inventory item " << i);
+			item["desc"] = "(No Description)";
+			item["type"] = i % 20;
+			item["flags"] = i;
+			item["created_at"] = LLDate(1700000000.0 + i);
+			item["sale_price"] = 10.5;
+			item["for_sale"] = (i % 3) == 0;
+			inventory.append(item);
+		}
+		std::string buffer = compareBinaryParsers("inventory-like", inventory, 5);
+
+		// truncating the buffer anywhere must fail cleanly, never read past the end
+		for (size_t len : { (size_t)0, (size_t)1, (size_t)5, buffer.size() / 2, buffer.size() - 1 })
+		{
+			std::vector<U8> truncated(buffer.begin(), buffer.begin() + len);
+			LLSD result;
+			S32 count = LLSDSerialize::fromBinary(result, truncated.data(), truncated.size());
+			ensure(STRINGIZE("truncated at " << len), count <= 0);
+			ensure(STRINGIZE("truncated at " << len << " result"), result.isUndefined());
+		}
+
+		// trailing data after the LLSD is left alone, like the mesh header
+		std::ostringstream ostr;
+		LLSDSerialize::toBinary(LLSD().with("version", 1), ostr);
+		std::string header(ostr.str());
+		std::string asset = header + std::string(64, 'x');
+		LLSD result;
+		size_t bytes_read = 0;
+		ensure("header parsed", LLSDSerialize::fromBinary(result, (const U8*)asset.data(), asset.size(), -1, &bytes_read) > 0);
+		ensure_equals("header bytes", bytes_read, header.size());
+		ensure_equals("header version", result["version"].asInteger(), 1);
+	}
+
+	template<> template<>
+	void TestLLSDCompatibleObject::test<10>()
+	{
+		set_test_name("xml and notation buffer parsers match stream parsers");
+
+		LLSD inventory = LLSD::emptyArray();
+		for (S32 i = 0; i < 5000; ++i)
+		{
+			LLSD item;
+			item["item_id"] = LLUUID::generateNewID();
+			item["name"] = STRINGIZE("Inventory item <" << i << "> & \"more\"");
+			item["desc"] = "caf\xc3\xa9 \xe2\x82\xac";
+			item["type"] = i % 20;
+			item["created_at"] = LLDate(1700000000.0 + i);
+			item["sale_price"] = 10.5;
+			item["for_sale"] = (i % 3) == 0;
+			item["data"] = LLSD::Binary(i % 7, (U8)i);
+			inventory.append(item);
+		}
+
+		typedef std::chrono::duration<F64, std::milli> ms_t;
+		for (S32 format = 0; format < 2; ++format)
+		{
+			std::ostringstream ostr;
+			if (format == 0)
+			{
+				LLSDSerialize::toPrettyXML(inventory, ostr);
+			}
+			else
+			{
+				LLSDSerialize::toNotation(inventory, ostr);
+			}
+			std::string buffer(ostr.str());
+			std::string desc(format == 0 ? "xml" : "notation");
+
+			LLSD from_stream;
+			auto start = std::chrono::steady_clock::now();
+			std::istringstream istr(buffer);
+			if (format == 0)
+			{
+				LLSDSerialize::fromXML(from_stream, istr);
+			}
+			else
+			{
+				LLSDSerialize::fromNotation(from_stream, istr, buffer.size());
+			}
+			auto stream_time = std::chrono::steady_clock::now() - start;
+
+			LLSD from_buffer;
+			start = std::chrono::steady_clock::now();
+			if (format == 0)
+			{
+				LLSDSerialize::fromXML(from_buffer, buffer.data(), buffer.size());
+			}
+			else
+			{
+				LLSDSerialize::fromNotation(from_buffer, buffer.data(), buffer.size());
+			}
+			auto buffer_time = std::chrono::steady_clock::now() - start;
+
+			ensure_equals(desc + " stream parse", from_stream, inventory);
+			ensure_equals(desc + " buffer parse", from_buffer, inventory);
+			LL_INFOS() << desc << ": " << buffer.size() << " bytes"
+					   << ", stream parser " << ms_t(stream_time).count() << " ms"
+					   << ", buffer parser " << ms_t(buffer_time).count() << " ms" << LL_ENDL;
+		}
+
+		// documents the buffer parser leaves to expat must still parse the same
+		const char* xml[] = {
+			"<?xml version=\"1.0\" ?><llsd><string>a&amp;b&#x41;&#66;</string></llsd>",
+			"<llsd><!-- comment --><string>x</string></llsd>",
+			"<llsd><string><![CDATA[<x>]]></string></llsd>",
+			"<!DOCTYPE llsd><llsd><integer>3</integer></llsd>",
+			"<llsd><map><key>a</key><unknown>1</unknown><key>b</key><real>2</real></map></llsd>",
+			"<llsd><binary encoding=\"base16\">00</binary></llsd>",
+			"<llsd><string>line\r\nbreak</string></llsd>",
+			"<llsd><string>&bogus;</string></llsd>",
+			"<llsd><array><integer>1</integer>",
+			"<llsd><string>bad \xff utf-8</string></llsd>",
+			"<llsd><integer>1</integer></llsd>trailing",
+		};
+		for (const char* doc : xml)
+		{
+			std::string text(doc);
+			LLSD from_stream;
+			LLSD from_buffer;
+			std::istringstream istr(text);
+			S32 stream_count = LLSDSerialize::fromXML(from_stream, istr, false);
+			S32 buffer_count = LLSDSerialize::fromXML(from_buffer, text.data(), text.size(), false);
+			ensure_equals(text + " count", buffer_count, stream_count);
+			ensure_equals(text, from_buffer, from_stream);
+		}
+
+		const char* notation[] = {
+			"{'a':i1,\"b\":r2.5,'c':[u00000000-0000-0000-0000-000000000000,d\"2024-01-01T00:00:00Z\"]}",
+			"[s(3)\"abc\",b64\"AAEC\",b16\"0001\",b(2)\"xy\",l\"http://example.com/\"]",
+			"{'a':i1,'b'",
+			"[r1e999]",
+			"[i12x]",
+			"'unterminated",
+			"[b16\"00",
+		};
+		for (const char* doc : notation)
+		{
+			std::string text(doc);
+			LLSD from_stream;
+			LLSD from_buffer;
+			std::istringstream istr(text);
+			S32 stream_count = LLSDSerialize::fromNotation(from_stream, istr, text.size());
+			S32 buffer_count = LLSDSerialize::fromNotation(from_buffer, text.data(), text.size());
+			ensure_equals(text + " count", buffer_count, stream_count);
+			ensure_equals(text, from_buffer, from_stream);
+		}
+	}
+
     // helper for TestPythonCompatible
     static std::string import_llsd("import os.path\n"
                                    "import sys\n"
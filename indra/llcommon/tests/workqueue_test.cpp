@@ -15,11 +15,15 @@
 #include "workqueue.h"
 // STL headers
 // std headers
+#include <atomic>
 #include <chrono>
 #include <deque>
+#include <thread>
+#include <vector>
 // external library headers
 // other Linden headers
 #include "../test/lltut.h"
+#include "../parallelfor.h"
 #include "../test/catch_and_store_what_in.h"
 #include "llcond.h"
 #include "llcoros.h"
@@ -236,4 +240,119 @@ namespace tut
         ensure_equals("didn't run coroutine", stored, "ran");
         ensure("void waitForResult() didn't return", done);
     }
+
+    template<> template<>
+    void object::test<7>()
+    {
+        set_test_name("WorkStealingQueue");
+        WorkStealingQueue stealing("stealing", 4);
+        ensure("not findable as WorkQueue",
+               WorkQueue::getInstance("stealing") == stealing.getWeak().lock());
+
+        std::atomic<int> count{ 0 };
+        std::vector<std::thread> workers;
+        for (int i = 0; i < 4; ++i)
+        {
+            workers.emplace_back([&stealing](){ stealing.runUntilClose(); });
+        }
+        // work posted from outside the pool, half of which posts more work
+        // from a worker thread to its own lane
+        for (int i = 0; i < 1000; ++i)
+        {
+            stealing.post([&stealing, &count, i]()
+                          {
+                              ++count;
+                              if (i % 2)
+                              {
+                                  stealing.post([&count](){ ++count; });
+                              }
+                          });
+        }
+        // wait for the workers to drain the queue before closing it, else
+        // the nested posts could be refused
+        while (count < 1500)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        stealing.close();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        ensure_equals("didn't run all work", count.load(), 1500);
+        ensure("not done", stealing.done());
+        ensure("post after close", ! stealing.post([](){}));
+    }
+
+    template<> template<>
+    void object::test<8>()
+    {
+        set_test_name("WorkPriorityQueue");
+        WorkPriorityQueue prioq("prioq");
+        std::string order;
+        WorkPriorityQueue::Handle a, b, c, d;
+        prioq.post([&order](){ order += "a"; }, 1.f, &a);
+        prioq.post([&order](){ order += "b"; }, 3.f, &b);
+        prioq.post([&order](){ order += "c"; }, 2.f, &c);
+        prioq.post([&order](){ order += "d"; }, 2.f, &d);
+        prioq.post([&order](){ order += "e"; });
+        ensure("zero handle", a && b && c && d);
+        ensure_equals("size", prioq.size(), 5u);
+
+        ensure("cancel b", prioq.cancel(b));
+        ensure("cancel b twice", ! prioq.cancel(b));
+        ensure("reprioritize a", prioq.setPriority(a, 5.f));
+        ensure_equals("size after cancel", prioq.size(), 4u);
+
+        prioq.close();
+        prioq.runUntilClose();
+        // a first after its boost, c before d since it was posted first
+        ensure_equals("order", order, "acde");
+        ensure("reprioritize after run", ! prioq.setPriority(c, 1.f));
+    }
+
+    template<> template<>
+    void object::test<9>()
+    {
+        set_test_name("parallelFor");
+        std::vector<std::atomic<int>> visits(1000);
+        auto visit = [&visits](size_t i){ ++visits[i]; };
+
+        // no such queue: the caller does all the work
+        parallelFor("nonexistent", visits.size(), 4, visit);
+        for (auto& v : visits)
+        {
+            ensure_equals("missed or repeated index without helpers", v.load(), 1);
+        }
+
+        WorkQueue helpers("helpers");
+        std::vector<std::thread> workers;
+        for (int i = 0; i < 3; ++i)
+        {
+            workers.emplace_back([&helpers](){ helpers.runUntilClose(); });
+        }
+        for (int pass = 0; pass < 20; ++pass)
+        {
+            parallelFor("helpers", visits.size(), 3,
+                        [&visits](size_t i)
+                        {
+                            ++visits[i];
+                            std::this_thread::yield();
+                        });
+        }
+        helpers.close();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        for (auto& v : visits)
+        {
+            ensure_equals("missed or repeated index with helpers", v.load(), 21);
+        }
+
+        parallelFor("helpers", 0, 3, [](size_t){ ensure("called for empty range", false); });
+        // closed queue: refuses helpers, the caller still finishes
+        parallelFor("helpers", visits.size(), 3, visit);
+        ensure_equals("closed queue", visits[999].load(), 22);
+    }
 } // namespace tut
@@ -187,3 +187,23 @@ size_t LL::ThreadPoolBase::getWidth(const std::string& name, size_t dft)
         return getConfiguredWidth(name, dft);
     }
 }
+
+//static
+bool LL::ThreadPoolBase::getConfiguredWorkStealing(const std::string& name)
+{
+    LLSD workStealing;
+    try
+    {
+        workStealing = LL::CommonControl::get("Global", "ThreadPoolWorkStealing");
+    }
+    catch (const LL::CommonControl::Error& exc)
+    {
+        // As with "ThreadPoolSizes", don't require LLViewerControlListener:
+        // without the setting, every pool uses a plain WorkQueue.
+        LL_DEBUGS("ThreadPool") << "Can't check 'ThreadPoolWorkStealing': " << exc.what() << LL_ENDL;
+        return false;
+    }
+
+    LL_DEBUGS("ThreadPool") << "ThreadPoolWorkStealing = " << workStealing << LL_ENDL;
+    return workStealing[name].asBoolean();
+}
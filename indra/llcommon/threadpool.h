@@ -18,6 +18,7 @@
 #include <memory>                   // std::unique_ptr
 #include <string>
 #include <thread>
+#include <type_traits>              // std::is_same
 #include <utility>                  // std::pair
 #include <vector>
 
@@ -85,6 +86,14 @@ namespace LL
         static
         size_t getWidth(const std::string& name, size_t dft);
 
+        /**
+         * getConfiguredWorkStealing() returns true if the "ThreadPoolWorkStealing"
+         * map setting enables a WorkStealingQueue for the specified
+         * ThreadPool name.
+         */
+        static
+        bool getConfiguredWorkStealing(const std::string& name);
+
     protected:
         std::unique_ptr<WorkQueueBase> mQueue;
 
@@ -116,9 +125,13 @@ namespace LL
          * Pass an explicit capacity to limit the size of the queue.
          * Constraining the queue can cause a submitter to block. Do not
          * constrain any ThreadPool accepting work from the main thread.
+         *
+         * A plain ThreadPool gets a WorkStealingQueue instead of a single
+         * WorkQueue if the "ThreadPoolWorkStealing" setting says so for this
+         * name.
          */
         ThreadPoolUsing(const std::string& name, size_t threads=1, size_t capacity=1024*1024):
-            ThreadPoolBase(name, threads, new queue_t(name, capacity))
+            ThreadPoolBase(name, threads, makeQueue(name, threads, capacity))
         {}
         ~ThreadPoolUsing() override {}
 
@@ -127,6 +140,20 @@ namespace LL
          * post work to it
          */
         queue_t& getQueue() { return static_cast<queue_t&>(*mQueue); }
+
+    private:
+        static queue_t* makeQueue(const std::string& name, size_t threads, size_t capacity)
+        {
+            if constexpr (std::is_same<queue_t, WorkQueue>::value)
+            {
+                if (getConfiguredWorkStealing(name))
+                {
+                    // one lane per worker
+                    return new WorkStealingQueue(name, getConfiguredWidth(name, threads), capacity);
+                }
+            }
+            return new queue_t(name, capacity);
+        }
     };
 
     /// ThreadPool is shorthand for using the simpler WorkQueue
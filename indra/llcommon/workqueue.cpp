@@ -14,6 +14,7 @@
 // associated header
 #include "workqueue.h"
 // STL headers
+#include <algorithm>                // std::push_heap
 // std headers
 // external library headers
 // other Linden headers
@@ -181,6 +182,377 @@ bool LL::WorkQueue::tryPop_(Work& work)
     return mQueue.tryPop(work);
 }
 
+/*****************************************************************************
+*   WorkStealingQueue
+*****************************************************************************/
+namespace
+{
+    // The WorkStealingQueue whose lane the current thread owns, if any. A
+    // pool's worker threads only ever serve that one pool's queue.
+    thread_local const LL::WorkStealingQueue* sLaneOwner = nullptr;
+    thread_local size_t sLane = 0;
+}
+
+LL::WorkStealingQueue::WorkStealingQueue(const std::string& name, size_t lanes, size_t capacity):
+    // the WorkQueue's own queue is never used
+    WorkQueue(name, 1),
+    mCapacity(capacity)
+{
+    lanes = llmax(lanes, size_t(1));
+    mLanes.reserve(lanes);
+    for (size_t i = 0; i < lanes; ++i)
+    {
+        // separate allocations keep the lane mutexes off each other's cache lines
+        mLanes.emplace_back(std::make_unique<Lane>());
+    }
+}
+
+void LL::WorkStealingQueue::close()
+{
+    mClosed = true;
+    Lock lk(mSleepMutex);
+    mWorkCond.notify_all();
+    mSpaceCond.notify_all();
+}
+
+size_t LL::WorkStealingQueue::size()
+{
+    return mSize;
+}
+
+bool LL::WorkStealingQueue::isClosed()
+{
+    return mClosed;
+}
+
+bool LL::WorkStealingQueue::done()
+{
+    return mClosed && mSize == 0;
+}
+
+bool LL::WorkStealingQueue::post(const Work& callable)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    if (mSize >= mCapacity && ! mClosed)
+    {
+        Lock lk(mSleepMutex);
+        mSpaceCond.wait(lk, [this](){ return mSize < mCapacity || mClosed; });
+    }
+    if (mClosed)
+    {
+        return false;
+    }
+    push(callable);
+    return true;
+}
+
+bool LL::WorkStealingQueue::tryPost(const Work& callable)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    if (mClosed || mSize >= mCapacity)
+    {
+        return false;
+    }
+    push(callable);
+    return true;
+}
+
+void LL::WorkStealingQueue::push(const Work& work)
+{
+    size_t lane = ownLane();
+    if (lane == mLanes.size())
+    {
+        lane = mNextLane++ % mLanes.size();
+    }
+    // Count the item before it becomes visible so that a thief can never
+    // take mSize below zero, and before checking for sleepers: a worker
+    // about to sleep checks mSize while holding mSleepMutex, so either it
+    // sees this item or we see it sleeping.
+    ++mSize;
+    {
+        Lock lk(mLanes[lane]->mMutex);
+        mLanes[lane]->mWork.push_back(work);
+    }
+    Lock lk(mSleepMutex);
+    if (mSleepers)
+    {
+        mWorkCond.notify_one();
+    }
+}
+
+bool LL::WorkStealingQueue::take(size_t own, Work& work)
+{
+    const size_t lanes = mLanes.size();
+    // 'work' may still hold the previous item (see runPending())
+    Work found;
+    if (own < lanes)
+    {
+        Lane& lane = *mLanes[own];
+        Lock lk(lane.mMutex);
+        if (! lane.mWork.empty())
+        {
+            found = std::move(lane.mWork.front());
+            lane.mWork.pop_front();
+        }
+    }
+    if (! found)
+    {
+        // Steal from the back, away from where the owner is working. Start
+        // after our own lane so that thieves spread over the victims.
+        size_t start = (own < lanes) ? own + 1 : mNextLane.load();
+        for (size_t i = 0; i < lanes && ! found; ++i)
+        {
+            Lane& lane = *mLanes[(start + i) % lanes];
+            Lock lk(lane.mMutex);
+            if (! lane.mWork.empty())
+            {
+                found = std::move(lane.mWork.back());
+                lane.mWork.pop_back();
+            }
+        }
+    }
+    if (! found)
+    {
+        return false;
+    }
+    work = std::move(found);
+
+    if (mSize-- >= mCapacity)
+    {
+        Lock lk(mSleepMutex);
+        mSpaceCond.notify_all();
+    }
+    return true;
+}
+
+size_t LL::WorkStealingQueue::ownLane() const
+{
+    return (sLaneOwner == this) ? sLane : mLanes.size();
+}
+
+size_t LL::WorkStealingQueue::claimLane()
+{
+    if (sLaneOwner != this)
+    {
+        size_t lane = mClaimedLanes++;
+        if (lane >= mLanes.size())
+        {
+            // more consumers than lanes: this one only steals
+            return mLanes.size();
+        }
+        sLaneOwner = this;
+        sLane = lane;
+    }
+    return sLane;
+}
+
+LL::WorkStealingQueue::Work LL::WorkStealingQueue::pop_()
+{
+    const size_t own = claimLane();
+    for (;;)
+    {
+        Work work;
+        if (take(own, work))
+        {
+            return work;
+        }
+
+        Lock lk(mSleepMutex);
+        // recheck with the lock held, see push()
+        if (mSize > 0)
+        {
+            continue;
+        }
+        if (mClosed)
+        {
+            LLTHROW(Closed());
+        }
+        ++mSleepers;
+        mWorkCond.wait(lk);
+        --mSleepers;
+    }
+}
+
+bool LL::WorkStealingQueue::tryPop_(Work& work)
+{
+    return take(ownLane(), work);
+}
+
+/*****************************************************************************
+*   WorkPriorityQueue
+*****************************************************************************/
+LL::WorkPriorityQueue::WorkPriorityQueue(const std::string& name, size_t capacity):
+    // the WorkQueue's own queue is never used
+    WorkQueue(name, 1),
+    mCapacity(capacity)
+{
+}
+
+void LL::WorkPriorityQueue::close()
+{
+    Lock lk(mMutex);
+    mClosed = true;
+    mWorkCond.notify_all();
+    mSpaceCond.notify_all();
+}
+
+size_t LL::WorkPriorityQueue::size()
+{
+    Lock lk(mMutex);
+    return mItems.size();
+}
+
+bool LL::WorkPriorityQueue::isClosed()
+{
+    Lock lk(mMutex);
+    return mClosed;
+}
+
+bool LL::WorkPriorityQueue::done()
+{
+    Lock lk(mMutex);
+    return mClosed && mItems.empty();
+}
+
+bool LL::WorkPriorityQueue::post(const Work& callable)
+{
+    return post(callable, 0.f);
+}
+
+bool LL::WorkPriorityQueue::tryPost(const Work& callable)
+{
+    return tryPost(callable, 0.f);
+}
+
+bool LL::WorkPriorityQueue::post(const Work& callable, F32 priority, Handle* handle)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    Lock lk(mMutex);
+    mSpaceCond.wait(lk, [this](){ return mItems.size() < mCapacity || mClosed; });
+    Handle posted = mClosed ? 0 : pushLocked(callable, priority);
+    if (handle)
+    {
+        *handle = posted;
+    }
+    return posted != 0;
+}
+
+bool LL::WorkPriorityQueue::tryPost(const Work& callable, F32 priority, Handle* handle)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    Lock lk(mMutex);
+    Handle posted = (mClosed || mItems.size() >= mCapacity) ? 0 : pushLocked(callable, priority);
+    if (handle)
+    {
+        *handle = posted;
+    }
+    return posted != 0;
+}
+
+bool LL::WorkPriorityQueue::setPriority(Handle handle, F32 priority)
+{
+    Lock lk(mMutex);
+    auto found = mItems.find(handle);
+    if (found == mItems.end())
+    {
+        return false;
+    }
+    if (found->second.mPriority != priority)
+    {
+        found->second.mPriority = priority;
+        pushNode(priority, handle);
+    }
+    return true;
+}
+
+bool LL::WorkPriorityQueue::cancel(Handle handle)
+{
+    Work cancelled;
+    {
+        Lock lk(mMutex);
+        auto found = mItems.find(handle);
+        if (found == mItems.end())
+        {
+            return false;
+        }
+        // destroy whatever the work binds outside the lock
+        cancelled = std::move(found->second.mWork);
+        mItems.erase(found);
+        mSpaceCond.notify_one();
+    }
+    return true;
+}
+
+LL::WorkPriorityQueue::Handle LL::WorkPriorityQueue::pushLocked(const Work& work, F32 priority)
+{
+    Handle handle = mNextHandle++;
+    mItems.emplace(handle, Item{ work, priority });
+    pushNode(priority, handle);
+    mWorkCond.notify_one();
+    return handle;
+}
+
+void LL::WorkPriorityQueue::pushNode(F32 priority, Handle handle)
+{
+    // Drop the superseded nodes once they outnumber the live ones
+    if (mHeap.size() > 2 * mItems.size() + 64)
+    {
+        mHeap.clear();
+        for (const auto& item : mItems)
+        {
+            mHeap.push_back(Node{ item.second.mPriority, item.first });
+        }
+        std::make_heap(mHeap.begin(), mHeap.end());
+    }
+    mHeap.push_back(Node{ priority, handle });
+    std::push_heap(mHeap.begin(), mHeap.end());
+}
+
+bool LL::WorkPriorityQueue::popLocked(Work& work)
+{
+    while (! mHeap.empty())
+    {
+        Node top = mHeap.front();
+        std::pop_heap(mHeap.begin(), mHeap.end());
+        mHeap.pop_back();
+
+        auto found = mItems.find(top.mHandle);
+        // skip cancelled items and superseded priorities
+        if (found != mItems.end() && found->second.mPriority == top.mPriority)
+        {
+            work = std::move(found->second.mWork);
+            mItems.erase(found);
+            mSpaceCond.notify_one();
+            return true;
+        }
+    }
+    return false;
+}
+
+LL::WorkPriorityQueue::Work LL::WorkPriorityQueue::pop_()
+{
+    Lock lk(mMutex);
+    for (;;)
+    {
+        Work work;
+        if (popLocked(work))
+        {
+            return work;
+        }
+        if (mClosed)
+        {
+            LLTHROW(Closed());
+        }
+        mWorkCond.wait(lk);
+    }
+}
+
+bool LL::WorkPriorityQueue::tryPop_(Work& work)
+{
+    Lock lk(mMutex);
+    return popLocked(work);
+}
+
 /*****************************************************************************
 *   WorkSchedule
 *****************************************************************************/
@@ -17,10 +17,17 @@
 #include "llinstancetracker.h"
 #include "llinstancetrackersubclass.h"
 #include "threadsafeschedule.h"
+#include LLCOROS_MUTEX_HEADER
+#include LLCOROS_CONDVAR_HEADER
+#include <atomic>
 #include <chrono>
+#include <deque>
 #include <exception>                // std::current_exception
 #include <functional>               // std::function
+#include <memory>                   // std::unique_ptr
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace LL
 {
@@ -262,6 +269,171 @@ namespace LL
         bool tryPop_(Work&) override;
     };
 
+/*****************************************************************************
+*   WorkStealingQueue: per-worker queues for wide thread pools
+*****************************************************************************/
+    /**
+     * WorkStealingQueue is a drop-in WorkQueue for a ThreadPool with many
+     * workers. Instead of a single queue whose lock every producer and every
+     * worker contends on, it keeps one lane (a locked deque) per worker.
+     *
+     * * Work posted from outside the pool is dealt round robin across the
+     *   lanes. Work posted by one of the pool's own workers goes to that
+     *   worker's lane.
+     * * A worker takes work from the front of its own lane. When its lane is
+     *   empty it steals from the back of the other lanes, and only sleeps
+     *   once every lane is empty.
+     *
+     * Each thread calling runUntilClose() (i.e. pop_()) claims a lane of its
+     * own, up to the number of lanes; runPending() and friends only steal.
+     * Ordering is FIFO per lane, not across the whole queue.
+     *
+     * Because it is-a WorkQueue, WorkQueue::getInstance() still finds it, and
+     * post(), postTo() and waitForResult() are unchanged. ThreadPool selects
+     * it for the pools named in the "ThreadPoolWorkStealing" setting.
+     */
+    class WorkStealingQueue: public WorkQueue
+    {
+    public:
+        WorkStealingQueue(const std::string& name, size_t lanes, size_t capacity=1024);
+
+        void close() override;
+        size_t size() override;
+        bool isClosed() override;
+        bool done() override;
+
+        bool post(const Work&) override;
+        bool tryPost(const Work&) override;
+
+    private:
+        using Mutex = LLCoros::Mutex;
+        using Lock = LLCoros::LockType;
+
+        struct Lane
+        {
+            Mutex mMutex;
+            std::deque<Work> mWork;
+        };
+
+        Work pop_() override;
+        bool tryPop_(Work&) override;
+
+        void push(const Work& work);
+        // take from the front of lane 'own' if any, then steal from the others
+        bool take(size_t own, Work& work);
+        // lane owned by the calling thread, or mLanes.size() if none
+        size_t ownLane() const;
+        size_t claimLane();
+
+        std::vector<std::unique_ptr<Lane>> mLanes;
+        const size_t mCapacity;
+        std::atomic<size_t> mSize{ 0 };
+        std::atomic<bool> mClosed{ false };
+        std::atomic<size_t> mNextLane{ 0 };
+        std::atomic<size_t> mClaimedLanes{ 0 };
+
+        // idle workers and producers blocked on a full queue wait here
+        Mutex mSleepMutex;
+        LLCoros::ConditionVariable mWorkCond;
+        LLCoros::ConditionVariable mSpaceCond;
+        size_t mSleepers{ 0 };
+    };
+
+/*****************************************************************************
+*   WorkPriorityQueue: prioritized, cancellable work
+*****************************************************************************/
+    /**
+     * WorkPriorityQueue runs the pending item with the highest priority
+     * first (FIFO among equal priorities). Posting with a Handle lets the
+     * producer change the priority of the item, or cancel it, for as long as
+     * no worker has picked it up. A cancelled item is destroyed without
+     * being run.
+     *
+     * Like WorkStealingQueue it is-a WorkQueue: the plain post() and
+     * tryPost() post at priority 0.
+     */
+    class WorkPriorityQueue: public WorkQueue
+    {
+    public:
+        /// 0 is never a valid handle
+        using Handle = U64;
+
+        WorkPriorityQueue(const std::string& name = std::string(), size_t capacity=1024);
+
+        void close() override;
+        size_t size() override;
+        bool isClosed() override;
+        bool done() override;
+
+        bool post(const Work&) override;
+        bool tryPost(const Work&) override;
+
+        /**
+         * post work with the given priority (larger runs first), unless the
+         * queue is closed before we can post. If handle is not null it
+         * receives the handle of the new item, or 0.
+         */
+        bool post(const Work& callable, F32 priority, Handle* handle=nullptr);
+
+        /**
+         * post work with the given priority, unless the queue is full
+         */
+        bool tryPost(const Work& callable, F32 priority, Handle* handle=nullptr);
+
+        /**
+         * Change the priority of a pending item. Returns false if the item
+         * already ran, is running or was cancelled.
+         */
+        bool setPriority(Handle handle, F32 priority);
+
+        /**
+         * Drop a pending item. Returns false if the item already ran, is
+         * running or was cancelled.
+         */
+        bool cancel(Handle handle);
+
+    private:
+        using Mutex = LLCoros::Mutex;
+        using Lock = LLCoros::LockType;
+
+        struct Item
+        {
+            Work mWork;
+            F32 mPriority;
+        };
+        // Reprioritizing pushes a new Node rather than searching the heap,
+        // the superseded one is skipped when it reaches the top. Handles
+        // increase monotonically, which gives FIFO order among equal
+        // priorities.
+        struct Node
+        {
+            F32 mPriority;
+            Handle mHandle;
+            bool operator<(const Node& other) const
+            {
+                return mPriority < other.mPriority ||
+                    (mPriority == other.mPriority && mHandle > other.mHandle);
+            }
+        };
+
+        Work pop_() override;
+        bool tryPop_(Work&) override;
+
+        // mMutex must be held for these
+        Handle pushLocked(const Work& work, F32 priority);
+        bool popLocked(Work& work);
+        void pushNode(F32 priority, Handle handle);
+
+        Mutex mMutex;
+        LLCoros::ConditionVariable mWorkCond;
+        LLCoros::ConditionVariable mSpaceCond;
+        std::unordered_map<Handle, Item> mItems;
+        std::vector<Node> mHeap;
+        const size_t mCapacity;
+        Handle mNextHandle{ 1 };
+        bool mClosed{ false };
+    };
+
 /*****************************************************************************
 *   WorkSchedule: add support for timestamped tasks
 *****************************************************************************/
@@ -153,16 +153,30 @@ const int HTTP_CONNECTION_LIMIT_MAX = 256;
 const long HTTP_PIPELINING_DEFAULT = 0L;
 const long HTTP_PIPELINING_MAX = 20L;
 
+// HTTP/2 multiplexing limits
+const long HTTP_STREAMS_DEFAULT = 0L;
+const long HTTP_STREAMS_MAX = 128L;
+const long HTTP_STREAM_WEIGHT_DEFAULT = 16L;
+const long HTTP_STREAM_WEIGHT_MIN = 1L;
+const long HTTP_STREAM_WEIGHT_MAX = 256L;
+
 // Miscellaneous defaults
 const bool HTTP_USE_RETRY_AFTER_DEFAULT = true;
 const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
 
 // Tuning parameters
 
-// Time worker thread sleeps after a pass through the
-// request, ready and active queues.
+// Longest the worker thread waits on the transport after a pass
+// through the request, ready and active queues when retries or
+// throttles are pending.  Sockets becoming ready and new requests
+// end the wait early.
 const int HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS = 2;
 
+// Longest the worker thread waits on the transport when only libcurl
+// has work in hand.  libcurl's own timers shorten it, this is only a
+// backstop for sockets it can't report.
+const int HTTP_SERVICE_LOOP_WAIT_MAX_MS = 50;
+
 // Block allocation size (a tuning parameter) is found
 // in bufferarray.h.
 
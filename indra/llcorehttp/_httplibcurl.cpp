@@ -32,6 +32,15 @@
 #include "_httppolicy.h"
 
 #include "llhttpconstants.h"
+#include "lltimer.h"
+
+#if ! LL_WINDOWS
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 namespace
 {
@@ -51,6 +60,90 @@ void check_curl_multi_setopt(CURLM* handle, CURLMoption option, ARG argument)
 
 static const char * const LOG_CORE("CoreHttp");
 
+// curl_multi_poll() and curl_multi_wakeup() came with 7.68.0,
+// CURL.cmake checks the version we build against.  Without them
+// curl_multi_wait() does the waiting and a socket of our own,
+// added to its wait list, cuts it short.
+#ifndef LLCORE_CURL_MULTI_POLL
+#define LLCORE_CURL_MULTI_POLL 0
+#endif
+
+#if ! LLCORE_CURL_MULTI_POLL
+
+void close_wake_socket(curl_socket_t sock)
+{
+#if LL_WINDOWS
+	closesocket(sock);
+#else
+	close(sock);
+#endif
+}
+
+// A loopback UDP socket connected to itself.  Sending it a byte
+// makes it readable, which ends a curl_multi_wait() watching it.
+// That's what curl_multi_wakeup() does internally in newer libcurls.
+curl_socket_t open_wake_socket()
+{
+	curl_socket_t sock(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+	if (CURL_SOCKET_BAD == sock)
+	{
+		return CURL_SOCKET_BAD;
+	}
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+#if LL_WINDOWS
+	int addr_len(sizeof(addr));
+	u_long non_blocking(1);
+	bool ok(0 == bind(sock, (sockaddr *) &addr, sizeof(addr))
+			&& 0 == getsockname(sock, (sockaddr *) &addr, &addr_len)
+			&& 0 == connect(sock, (sockaddr *) &addr, sizeof(addr))
+			&& 0 == ioctlsocket(sock, FIONBIO, &non_blocking));
+#else
+	socklen_t addr_len(sizeof(addr));
+	bool ok(0 == bind(sock, (sockaddr *) &addr, sizeof(addr))
+			&& 0 == getsockname(sock, (sockaddr *) &addr, &addr_len)
+			&& 0 == connect(sock, (sockaddr *) &addr, sizeof(addr))
+			&& 0 == fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK));
+#endif
+	if (! ok)
+	{
+		LL_WARNS(LOG_CORE) << "Could not set up the transport wakeup socket, "
+						   << "new requests will wait for the next poll" << LL_ENDL;
+		close_wake_socket(sock);
+		return CURL_SOCKET_BAD;
+	}
+	return sock;
+}
+
+#endif // ! LLCORE_CURL_MULTI_POLL
+
+// Add the sockets of an fd_set filled by curl_multi_fdset() to
+// a wait list for curl_multi_wait()/curl_multi_poll().
+void append_wait_fds(std::vector<curl_waitfd> & fds, const fd_set & fdset, short events, int max_fd)
+{
+#if LL_WINDOWS
+	// Winsock's fd_set is a list, not a bitmap
+	for (u_int i(0); i < fdset.fd_count; ++i)
+	{
+		curl_waitfd fd = { fdset.fd_array[i], events, 0 };
+		fds.push_back(fd);
+	}
+#else
+	for (int sock(0); sock <= max_fd; ++sock)
+	{
+		if (FD_ISSET(sock, &fdset))
+		{
+			curl_waitfd fd = { sock, events, 0 };
+			fds.push_back(fd);
+		}
+	}
+#endif
+}
+
 } // end anonymous namespace
 
 
@@ -64,14 +157,34 @@ HttpLibcurl::HttpLibcurl(HttpService * service)
 	  mPolicyCount(0),
 	  mMultiHandles(NULL),
 	  mActiveHandles(NULL),
-	  mDirtyPolicy(NULL)
-{}
+	  mDirtyPolicy(NULL),
+	  mWaitHandle(curl_multi_init()),
+	  mWakeSocket(CURL_SOCKET_BAD)
+{
+#if ! LLCORE_CURL_MULTI_POLL
+	mWakeSocket = open_wake_socket();
+#endif
+}
 
 
 HttpLibcurl::~HttpLibcurl()
 {
 	shutdown();
 
+	if (mWaitHandle)
+	{
+		curl_multi_cleanup(mWaitHandle);
+		mWaitHandle = NULL;
+	}
+
+#if ! LLCORE_CURL_MULTI_POLL
+	if (CURL_SOCKET_BAD != mWakeSocket)
+	{
+		close_wake_socket(mWakeSocket);
+		mWakeSocket = CURL_SOCKET_BAD;
+	}
+#endif
+
 	mService = NULL;
 }
 
@@ -141,7 +254,7 @@ void HttpLibcurl::start(int policy_count)
 //
 // If active list goes empty *and* we didn't queue any
 // requests for retry, we return a request for a hard
-// sleep otherwise ask for a normal polling interval.
+// sleep otherwise ask to wait on the transport.
 HttpService::ELoopSpeed HttpLibcurl::processTransport()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
@@ -188,10 +301,10 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
                     CURL* handle(msg->easy_handle);
                     CURLcode result(msg->data.result);
 
+                    // The ready queue is processed right after this, so
+                    // any slot freed here is refilled without a wait.
                     completeRequest(mMultiHandles[policy_class], handle, result);
                     handle = NULL;					// No longer valid on return
-                    ret = HttpService::NORMAL;		// If anything completes, we may have a free slot.
-                                                    // Turning around quickly reduces connection gap by 7-10mS.
                 }
                 else if (CURLMSG_NONE == msg->msg)
                 {
@@ -211,12 +324,104 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
 
 	if (! mActiveOps.empty())
 	{
-		ret = HttpService::NORMAL;
+		ret = HttpService::TRANSPORT_WAIT;
 	}
 	return ret;
 }
 
 
+void HttpLibcurl::waitTransport(long max_ms)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+#if ! LLCORE_CURL_MULTI_POLL
+	if (CURL_SOCKET_BAD == mWakeSocket)
+	{
+		// Nothing can end the wait early, keep to the polling interval
+		max_ms = (std::min)(max_ms, long(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS));
+	}
+#endif
+
+	long timeout_ms(max_ms);
+	mWaitFds.clear();
+	for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
+	{
+		if (! mMultiHandles[policy_class] || ! mActiveHandles[policy_class])
+		{
+			continue;
+		}
+
+		long curl_timeout_ms(-1);
+		curl_multi_timeout(mMultiHandles[policy_class], &curl_timeout_ms);
+		if (curl_timeout_ms >= 0)
+		{
+			timeout_ms = (std::min)(timeout_ms, curl_timeout_ms);
+		}
+
+		fd_set read_fds, write_fds, except_fds;
+		FD_ZERO(&read_fds);
+		FD_ZERO(&write_fds);
+		FD_ZERO(&except_fds);
+		int max_fd(-1);
+		curl_multi_fdset(mMultiHandles[policy_class], &read_fds, &write_fds, &except_fds, &max_fd);
+		append_wait_fds(mWaitFds, read_fds, CURL_WAIT_POLLIN, max_fd);
+		append_wait_fds(mWaitFds, write_fds, CURL_WAIT_POLLOUT, max_fd);
+		append_wait_fds(mWaitFds, except_fds, CURL_WAIT_POLLPRI, max_fd);
+	}
+
+	if (timeout_ms <= 0)
+	{
+		// libcurl wants to run now
+		return;
+	}
+
+#if LLCORE_CURL_MULTI_POLL
+	curl_waitfd * fds(mWaitFds.empty() ? NULL : &mWaitFds[0]);
+	curl_multi_poll(mWaitHandle, fds, unsigned(mWaitFds.size()), int(timeout_ms), NULL);
+#else
+	if (CURL_SOCKET_BAD != mWakeSocket)
+	{
+		curl_waitfd wake = { mWakeSocket, CURL_WAIT_POLLIN, 0 };
+		mWaitFds.push_back(wake);
+	}
+	if (! mWaitFds.empty())
+	{
+		curl_multi_wait(mWaitHandle, &mWaitFds[0], unsigned(mWaitFds.size()), int(timeout_ms), NULL);
+	}
+	else
+	{
+		// Older curl_multi_wait() returns at once with nothing to wait on
+		ms_sleep(timeout_ms);
+	}
+
+	if (CURL_SOCKET_BAD != mWakeSocket)
+	{
+		// Swallow the wakeups that ended this wait, or came before it
+		char buffer[64];
+		while (recv(mWakeSocket, buffer, sizeof(buffer), 0) > 0)
+		{
+		}
+	}
+#endif
+}
+
+
+void HttpLibcurl::wakeTransport()
+{
+#if LLCORE_CURL_MULTI_POLL
+	if (mWaitHandle)
+	{
+		curl_multi_wakeup(mWaitHandle);
+	}
+#else
+	if (CURL_SOCKET_BAD != mWakeSocket)
+	{
+		static const char wakeup('w');
+		send(mWakeSocket, &wakeup, 1, 0);
+	}
+#endif
+}
+
+
 // Caller has provided us with a ref count on op.
 void HttpLibcurl::addOp(const HttpOpRequest::ptr_t &op)
 {
@@ -487,7 +692,27 @@ void HttpLibcurl::policyUpdated(int policy_class)
 		policy.stallPolicy(policy_class, false);
 		mDirtyPolicy[policy_class] = false;
 
-		if (options.mPipelining > 1)
+		if (options.mStreams > 1)
+		{
+			// HTTP/2 multiplexing.  Connections are shared by up
+			// to mStreams requests each and libcurl decides when
+			// a new one is needed.
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_PIPELINING,
+									 long(CURLPIPE_MULTIPLEX));
+#if LIBCURL_VERSION_NUM >= 0x074300
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_CONCURRENT_STREAMS,
+									 long(options.mStreams));
+#endif
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_HOST_CONNECTIONS,
+									 long(options.mPerHostConnectionLimit));
+			check_curl_multi_setopt(multi_handle,
+									 CURLMOPT_MAX_TOTAL_CONNECTIONS,
+									 long(options.mConnectionLimit));
+		}
+		else if (options.mPipelining > 1)
 		{
 			// We'll try to do pipelining on this multihandle
 			check_curl_multi_setopt(multi_handle,
@@ -33,6 +33,7 @@
 #include <curl/multi.h>
 
 #include <set>
+#include <vector>
 
 #include "httprequest.h"
 #include "_httpservice.h"
@@ -77,6 +78,20 @@ public:
 	/// Threading:  called by worker thread.
 	HttpService::ELoopSpeed processTransport();
 
+	/// Block until a socket of an active request is ready, one
+	/// of libcurl's timers is due, wakeTransport() is called or
+	/// @max_ms pass.  libcurls without curl_multi_wakeup() are
+	/// woken up through a loopback socket of our own.
+	///
+	/// Threading:  called by worker thread.
+	void waitTransport(long max_ms);
+
+	/// End a waitTransport() in progress, or the next one if
+	/// none is.
+	///
+	/// Threading:  callable by any thread.
+	void wakeTransport();
+
 	/// Add request to the active list.  Caller is expected to have
 	/// provided us with a reference count on the op to hold the
 	/// request.  (No additional references will be added.)
@@ -215,6 +230,9 @@ protected:
 	CURLM **			mMultiHandles;		// One handle per policy class
 	int *				mActiveHandles;		// Active count per policy class
 	bool *				mDirtyPolicy;		// Dirty policy update waiting for stall (per pc)
+	CURLM *				mWaitHandle;		// No requests, waits on the others' sockets and takes wakeups
+	std::vector<curl_waitfd> mWaitFds;		// Sockets of the policy classes' handles for waitTransport()
+	curl_socket_t		mWakeSocket;		// Wakes curl_multi_wait() up when there's no curl_multi_wakeup()
 	
 }; // end class HttpLibcurl
 
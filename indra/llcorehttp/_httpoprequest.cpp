@@ -277,6 +277,8 @@ void HttpOpRequest::visitNotifier(HttpRequest * request)
 		curl_easy_getinfo(mCurlHandle, CURLINFO_SIZE_DOWNLOAD, &stats->mSizeDownload);
 		curl_easy_getinfo(mCurlHandle, CURLINFO_TOTAL_TIME, &stats->mTotalTime);
 		curl_easy_getinfo(mCurlHandle, CURLINFO_SPEED_DOWNLOAD, &stats->mSpeedDownload);
+		curl_easy_getinfo(mCurlHandle, CURLINFO_HTTP_VERSION, &stats->mHttpVersion);
+		curl_easy_getinfo(mCurlHandle, CURLINFO_NUM_CONNECTS, &stats->mNewConnects);
 
 		response->setTransferStats(stats);
 
@@ -709,7 +711,21 @@ HttpStatus HttpOpRequest::prepareRequest(HttpService * service)
 	{
 		xfer_timeout = timeout;
 	}
-	if (cpolicy.mPipelining > 1L)
+	if (cpolicy.mStreams > 1L)
+	{
+		// Multiplexed streams share the connection's bandwidth so
+		// transfers take longer once many are in flight.  Same
+		// allowance as pipelining below.
+		xfer_timeout *= 2L;
+
+		// Ask for HTTP/2 where TLS lets us negotiate it and wait
+		// for a stream on a connection already open or opening
+		// rather than starting another.
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_PIPEWAIT, 1L);
+		check_curl_easy_setopt(mCurlHandle, CURLOPT_STREAM_WEIGHT, cpolicy.mStreamWeight);
+	}
+	else if (cpolicy.mPipelining > 1L)
 	{
 		// Pipelining affects both connection and transfer timeout values.
 		// Requests that are added to a pipeling immediately have completed
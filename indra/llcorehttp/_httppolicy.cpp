@@ -248,10 +248,15 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 		}
 
 		int active(transport.getActiveCountInClass(policy_class));
-		int active_limit(state.mOptions.mPipelining > 1L
-						 ? (state.mOptions.mPerHostConnectionLimit
-							* state.mOptions.mPipelining)
-						 : state.mOptions.mConnectionLimit);
+		int active_limit(state.mOptions.mConnectionLimit);
+		if (state.mOptions.mStreams > 1L)
+		{
+			active_limit = state.mOptions.mPerHostConnectionLimit * state.mOptions.mStreams;
+		}
+		else if (state.mOptions.mPipelining > 1L)
+		{
+			active_limit = state.mOptions.mPerHostConnectionLimit * state.mOptions.mPipelining;
+		}
 		int needed(active_limit - active);		// Expect negatives here
 
 		if (needed > 0)
@@ -320,11 +325,17 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 
 	throttle_on:
 		
-		if (! readyq.empty() || ! retryq.empty())
+		if (! retryq.empty() || (throttle_enabled && state.mThrottleLeft <= 0))
 		{
-			// If anything is ready, continue looping...
+			// Retries and throttles run on the clock, keep looping...
 			result = HttpService::NORMAL;
 		}
+		else if (! readyq.empty())
+		{
+			// ...but requests waiting for a connection slot only
+			// get one when the transport completes something.
+			result = (std::min)(result, HttpService::TRANSPORT_WAIT);
+		}
 	} // end foreach policy_class
 
 	return result;
@@ -37,7 +37,9 @@ HttpPolicyClass::HttpPolicyClass()
 	: mConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mPerHostConnectionLimit(HTTP_CONNECTION_LIMIT_DEFAULT),
 	  mPipelining(HTTP_PIPELINING_DEFAULT),
-	  mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT)
+	  mThrottleRate(HTTP_THROTTLE_RATE_DEFAULT),
+	  mStreams(HTTP_STREAMS_DEFAULT),
+	  mStreamWeight(HTTP_STREAM_WEIGHT_DEFAULT)
 {}
 
 
@@ -53,6 +55,8 @@ HttpPolicyClass & HttpPolicyClass::operator=(const HttpPolicyClass & other)
 		mPerHostConnectionLimit = other.mPerHostConnectionLimit;
 		mPipelining = other.mPipelining;
 		mThrottleRate = other.mThrottleRate;
+		mStreams = other.mStreams;
+		mStreamWeight = other.mStreamWeight;
 	}
 	return *this;
 }
@@ -62,7 +66,9 @@ HttpPolicyClass::HttpPolicyClass(const HttpPolicyClass & other)
 	: mConnectionLimit(other.mConnectionLimit),
 	  mPerHostConnectionLimit(other.mPerHostConnectionLimit),
 	  mPipelining(other.mPipelining),
-	  mThrottleRate(other.mThrottleRate)
+	  mThrottleRate(other.mThrottleRate),
+	  mStreams(other.mStreams),
+	  mStreamWeight(other.mStreamWeight)
 {}
 
 
@@ -86,6 +92,14 @@ HttpStatus HttpPolicyClass::set(HttpRequest::EPolicyOption opt, long value)
 		mThrottleRate = llclamp(value, 0L, 1000000L);
 		break;
 
+	case HttpRequest::PO_HTTP2_STREAMS:
+		mStreams = llclamp(value, 0L, HTTP_STREAMS_MAX);
+		break;
+
+	case HttpRequest::PO_HTTP2_STREAM_WEIGHT:
+		mStreamWeight = llclamp(value, HTTP_STREAM_WEIGHT_MIN, HTTP_STREAM_WEIGHT_MAX);
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
@@ -114,6 +128,14 @@ HttpStatus HttpPolicyClass::get(HttpRequest::EPolicyOption opt, long * value) co
 		*value = mThrottleRate;
 		break;
 
+	case HttpRequest::PO_HTTP2_STREAMS:
+		*value = mStreams;
+		break;
+
+	case HttpRequest::PO_HTTP2_STREAM_WEIGHT:
+		*value = mStreamWeight;
+		break;
+
 	default:
 		return HttpStatus(HttpStatus::LLCORE, HE_INVALID_ARG);
 	}
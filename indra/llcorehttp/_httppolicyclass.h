@@ -64,6 +64,8 @@ public:
 	long						mPerHostConnectionLimit;
 	long						mPipelining;
 	long						mThrottleRate;
+	long						mStreams;
+	long						mStreamWeight;
 };  // end class HttpPolicyClass
 
 }  // end namespace LLCore
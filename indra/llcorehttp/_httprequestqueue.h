@@ -30,6 +30,8 @@
 
 #include <vector>
 
+#include <boost/function.hpp>
+
 #include "httpcommon.h"
 #include "_refcounted.h"
 #include "_mutex.h"
@@ -74,6 +76,7 @@ public:
 	
 public:
     typedef std::vector<opPtr_t> OpContainer;
+	typedef boost::function<void ()> wakeup_t;
 
 	/// Insert an object at the back of the request queue.
 	///
@@ -116,6 +119,16 @@ public:
 	/// Threading:  callable by any thread.
 	void wakeAll();
 
+	/// Set a function to call, in addition to waking sleepers,
+	/// when a request lands on an empty queue or the queue is
+	/// stopped.  Used to interrupt a consumer waiting
+	/// on something other than the queue.  It's called with the
+	/// queue locked so must be quick and must not call back into
+	/// the queue.  Pass an empty function to clear.
+	///
+	/// Threading:  callable by any thread.
+	void setWakeup(const wakeup_t & wakeup);
+
 	/// Disallow further request queuing.  Callers to @addOp will
 	/// get a failure status (LLCORE, HE_SHUTTING_DOWN).  Callers
 	/// to @fetchAll or @fetchOp will get requests that are on the
@@ -134,6 +147,7 @@ protected:
 	LLCoreInt::HttpMutex				mQueueMutex;
 	LLCoreInt::HttpConditionVariable	mQueueCV;
 	bool								mQueueStopped;
+	wakeup_t							mWakeup;
 	
 }; // end class HttpRequestQueue
 
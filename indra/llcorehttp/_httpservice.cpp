@@ -63,7 +63,9 @@ const HttpService::OptionDescriptor HttpService::sOptionDesc[] =
 	{	true,		true,		true,		false,		false	},		// PO_TRACE
 	{	true,		true,		false,		true,		false	},		// PO_ENABLE_PIPELINING
 	{	true,		true,		false,		true,		false	},		// PO_THROTTLE_RATE
-	{   false,		false,		true,		false,		true	}		// PO_SSL_VERIFY_CALLBACK
+	{   false,		false,		true,		false,		true	},		// PO_SSL_VERIFY_CALLBACK
+	{	true,		true,		false,		true,		false	},		// PO_HTTP2_STREAMS
+	{	true,		true,		false,		true,		false	}		// PO_HTTP2_STREAM_WEIGHT
 };
 HttpService * HttpService::sInstance(NULL);
 volatile HttpService::EState HttpService::sState(NOT_INITIALIZED);
@@ -112,6 +114,7 @@ HttpService::~HttpService()
 	
 	if (mRequestQueue)
 	{
+		mRequestQueue->setWakeup(HttpRequestQueue::wakeup_t());
 		mRequestQueue->release();
 		mRequestQueue = NULL;
 	}
@@ -141,6 +144,8 @@ void HttpService::init(HttpRequestQueue * queue)
 	sInstance->mRequestQueue = queue;
 	sInstance->mPolicy = new HttpPolicy(sInstance);
 	sInstance->mTransport = new HttpLibcurl(sInstance);
+	// New requests end the worker's waits on the transport
+	queue->setWakeup(boost::bind(&HttpLibcurl::wakeTransport, sInstance->mTransport));
 	sState = INITIALIZED;
 }
 
@@ -277,9 +282,10 @@ void HttpService::shutdown()
 
 
 // Working thread loop-forever method.  Gives time to
-// each of the request queue, policy layer and transport
-// layer pieces and then either sleeps for a small time
-// or waits for a request to come in.  Repeats until
+// each of the request queue, transport and policy layer
+// pieces and then either waits on the transport for
+// socket activity, a libcurl timer or a new request, or
+// sleeps until a request comes in.  Repeats until
 // requested to stop.
 void HttpService::threadRun(LLCoreInt::HttpThread * thread)
 {
@@ -297,18 +303,24 @@ void HttpService::threadRun(LLCoreInt::HttpThread * thread)
         {
 		    loop = processRequestQueue(loop);
 
-		    // Process ready queue issuing new requests as needed
-		    ELoopSpeed new_loop = mPolicy->processReadyQueue();
+		    // Give libcurl some cycles.  Completions free up
+		    // connection slots...
+		    ELoopSpeed new_loop = mTransport->processTransport();
 		    loop = (std::min)(loop, new_loop);
-		
-		    // Give libcurl some cycles
-		    new_loop = mTransport->processTransport();
+
+		    // ...which the ready queue fills straight away, issuing
+		    // new requests as needed
+		    new_loop = mPolicy->processReadyQueue();
 		    loop = (std::min)(loop, new_loop);
 		
-		    // Determine whether to spin, sleep briefly or sleep for next request
+		    // Determine whether to wait on the transport or sleep for
+		    // next request.  Retries and throttles are timed so they
+		    // keep waits short.
 		    if (REQUEST_SLEEP != loop)
 		    {
-			    ms_sleep(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+			    mTransport->waitTransport(NORMAL == loop
+										  ? HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS
+										  : HTTP_SERVICE_LOOP_WAIT_MAX_MS);
 		    }
         }
         catch (const LLContinueError&)
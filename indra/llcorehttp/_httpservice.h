@@ -105,6 +105,7 @@ public:
 	enum ELoopSpeed
 	{
 		NORMAL,					///< continuous polling of request, ready, active queues
+		TRANSPORT_WAIT,			///< can wait for libcurl's sockets and timers or a request queue write
 		REQUEST_SLEEP			///< can sleep indefinitely waiting for request queue write
 	};
 
@@ -232,6 +232,31 @@ public:
 		/// Global only
 		PO_SSL_VERIFY_CALLBACK,
 
+		/// If greater than 1, requests in the class ask for HTTP/2
+		/// over TLS and are multiplexed as streams over shared
+		/// connections.  Value gives the maximum number of
+		/// concurrent streams on a connection.  Hosts that don't
+		/// offer HTTP/2 fall back to HTTP/1.1 without pipelining.
+		///
+		/// As with PO_PIPELINING_DEPTH, libcurl manages connections
+		/// and both PO_CONNECTION_LIMIT and PO_PER_HOST_CONNECTION_LIMIT
+		/// should be set and non-zero.  Requests wait for a stream on
+		/// an existing connection in preference to opening a new one,
+		/// so in practice a class keeps one connection per host until
+		/// the server's own stream limit is reached.  Takes precedence
+		/// over PO_PIPELINING_DEPTH when both are set.
+		///
+		/// Per-class only
+		PO_HTTP2_STREAMS,
+
+		/// HTTP/2 priority weight, 1 to 256, sent with each stream
+		/// the class opens.  Servers give streams sharing a
+		/// connection bandwidth in proportion to their weights.
+		/// Default is 16, the HTTP/2 default.
+		///
+		/// Per-class only
+		PO_HTTP2_STREAM_WEIGHT,
+
 		PO_LAST  // Always at end
 	};
 
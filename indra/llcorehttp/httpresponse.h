@@ -74,10 +74,13 @@ public:
 	{
 		typedef boost::shared_ptr<TransferStats> ptr_t;
 
-		TransferStats() : mSizeDownload(0.0), mTotalTime(0.0), mSpeedDownload(0.0) {}
+		TransferStats() : mSizeDownload(0.0), mTotalTime(0.0), mSpeedDownload(0.0),
+						  mHttpVersion(0L), mNewConnects(0L) {}
 		F64 mSizeDownload;
 		F64 mTotalTime;
 		F64 mSpeedDownload;
+		long mHttpVersion;			// CURL_HTTP_VERSION_* the reply came back with
+		long mNewConnects;			// Connections opened for this request, 0 if one was reused
 	};
 
 
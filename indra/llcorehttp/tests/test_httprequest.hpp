@@ -34,11 +34,16 @@
 #include "httpoptions.h"
 #include "_httpservice.h"
 #include "_httprequestqueue.h"
+#include "_httpinternal.h"
 
 #include <curl/curl.h>
 #include <boost/regex.hpp>
 #include <sstream>
+#include <algorithm>
+#include <map>
+#include <vector>
 
+#include "lltimer.h"
 #include "llcorehttp_test.h"
 
 
@@ -185,6 +190,75 @@ public:
 	regex_container_t mHeadersDisallowed;
 };
 
+// Times every request it's handed from issue to completion.
+class LatencyHandler : public LLCore::HttpHandler
+{
+public:
+	LatencyHandler()
+		: mFailures(0)
+		{}
+
+	void issued(HttpHandle handle)
+		{
+			mIssued[handle] = totalTime();
+		}
+
+	virtual void onCompleted(HttpHandle handle, HttpResponse * response)
+		{
+			std::map<HttpHandle, U64>::iterator it(mIssued.find(handle));
+			if (mIssued.end() != it)
+			{
+				mLatencies.push_back(totalTime() - it->second);
+				mIssued.erase(it);
+			}
+			if (! response || ! response->getStatus())
+			{
+				++mFailures;
+			}
+		}
+
+	std::map<HttpHandle, U64> mIssued;
+	std::vector<U64> mLatencies;
+	int mFailures;
+};
+
+// Counts the replies that came back over HTTP/2 and the connections
+// opened to get them.
+class Http2Handler : public LLCore::HttpHandler
+{
+public:
+	Http2Handler()
+		: mCompleted(0),
+		  mFailures(0),
+		  mHttp2Replies(0),
+		  mNewConnects(0L)
+		{}
+
+	virtual void onCompleted(HttpHandle, HttpResponse * response)
+		{
+			++mCompleted;
+			if (! response || ! response->getStatus())
+			{
+				++mFailures;
+				return;
+			}
+			HttpResponse::TransferStats::ptr_t stats(response->getTransferStats());
+			if (stats)
+			{
+				if (CURL_HTTP_VERSION_2_0 == stats->mHttpVersion)
+				{
+					++mHttp2Replies;
+				}
+				mNewConnects += stats->mNewConnects;
+			}
+		}
+
+	int mCompleted;
+	int mFailures;
+	int mHttp2Replies;
+	long mNewConnects;
+};
+
 typedef test_group<HttpRequestTestData> HttpRequestTestGroupType;
 typedef HttpRequestTestGroupType::object HttpRequestTestObjectType;
 HttpRequestTestGroupType HttpRequestTestGroup("HttpRequest Tests");
@@ -3036,6 +3110,357 @@ void HttpRequestTestObjectType::test<23>()
 }
 
 
+
+template <> template <>
+void HttpRequestTestObjectType::test<24>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest GET latency");
+
+	// Keeps a fixed number of GETs in flight against the local server
+	// and checks that new requests wake the service thread rather than
+	// waiting on the transport until it times out.
+	static const int request_count(400);
+	static const int in_flight(8);
+
+	LatencyHandler handler;
+	LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	TestHandler2 stop_handler(this, "handler");
+	LLCore::HttpHandler::ptr_t stop_handlerp(&stop_handler, NoOpDeletor);
+	std::string url_base(get_base_url());
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+
+		// Start threading early so that thread memory is invariant
+		// over the test.
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// Issue and pump until everything has come back.  The pump
+		// interval is kept short so it doesn't dominate the latencies.
+		int issued(0);
+		int count(0);
+		int limit(LOOP_COUNT_LONG * 10);
+		while (count++ < limit && int(handler.mLatencies.size()) < request_count)
+		{
+			while (issued < request_count
+				   && issued - int(handler.mLatencies.size()) < in_flight)
+			{
+				HttpHandle handle = req->requestGet(HttpRequest::DEFAULT_POLICY_ID,
+													url_base,
+													HttpOptions::ptr_t(),
+													HttpHeaders::ptr_t(),
+													handlerp);
+				ensure("Valid handle returned for get request", handle != LLCORE_HTTP_HANDLE_INVALID);
+				handler.issued(handle);
+				++issued;
+			}
+			req->update(0);
+			usleep(LOOP_SLEEP_INTERVAL / 100);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure("All requests completed", int(handler.mLatencies.size()) == request_count);
+		ensure("No requests failed", handler.mFailures == 0);
+
+		std::sort(handler.mLatencies.begin(), handler.mLatencies.end());
+		// A request the service thread isn't woken up for sits out
+		// the longest transport wait before it's issued.
+		ensure("Median request latency is under the transport wait",
+			   handler.mLatencies[request_count / 2] < U64(LLCore::HTTP_SERVICE_LOOP_WAIT_MAX_MS) * 1000);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		HttpHandle handle = req->requestStopThread(stop_handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+
+template <> template <>
+void HttpRequestTestObjectType::test<25>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest GET in an HTTP/2 multiplexing class");
+
+	// The test server only speaks HTTP/1.x over plain sockets so this
+	// checks the class options and that requests in a multiplexing
+	// class still go through when the server can't multiplex.
+	static const int request_count(64);
+
+	LatencyHandler handler;
+	LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	TestHandler2 stop_handler(this, "handler");
+	LLCore::HttpHandler::ptr_t stop_handlerp(&stop_handler, NoOpDeletor);
+	std::string url_base(get_base_url());
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+
+		HttpRequest::policy_t pclass(HttpRequest::createPolicyClass());
+		ensure("Policy class created", pclass != HttpRequest::INVALID_POLICY_ID);
+
+		long value(0);
+		HttpStatus status;
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_CONNECTION_LIMIT, pclass, 4, NULL);
+		ensure("Connection limit set", bool(status));
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_PER_HOST_CONNECTION_LIMIT, pclass, 2, NULL);
+		ensure("Per-host connection limit set", bool(status));
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS, pclass, 1000, &value);
+		ensure("Stream count set", bool(status));
+		ensure("Stream count clamped to maximum", value == 128);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS, pclass, 16, &value);
+		ensure("Stream count reset", bool(status) && value == 16);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAM_WEIGHT, pclass, 0, &value);
+		ensure("Stream weight clamped to minimum", bool(status) && value == 1);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAM_WEIGHT, pclass, 32, &value);
+		ensure("Stream weight set", bool(status) && value == 32);
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS,
+													HttpRequest::GLOBAL_POLICY_ID, 16, NULL);
+		ensure("Stream count is not a global option", ! status);
+
+		// Start threading early so that thread memory is invariant
+		// over the test.
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		for (int i(0); i < request_count; ++i)
+		{
+			HttpHandle handle = req->requestGet(pclass,
+												url_base,
+												HttpOptions::ptr_t(),
+												HttpHeaders::ptr_t(),
+												handlerp);
+			ensure("Valid handle returned for get request", handle != LLCORE_HTTP_HANDLE_INVALID);
+			handler.issued(handle);
+		}
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && int(handler.mLatencies.size()) < request_count)
+		{
+			req->update(0);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure("All requests completed", int(handler.mLatencies.size()) == request_count);
+		ensure("No requests failed", handler.mFailures == 0);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		HttpHandle handle = req->requestStopThread(stop_handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
+
+template <> template <>
+void HttpRequestTestObjectType::test<26>()
+{
+	ScopedCurlInit ready;
+
+	set_test_name("HttpRequest GET multiplexed over HTTP/2");
+
+	// test_llcorehttp_peer.py only speaks HTTP/1.x so this one needs
+	// an HTTP/2 server over TLS (nghttpd, h2o, ...) handed to it in
+	// LL_TEST_HTTP2_URL.  Every reply should come back over HTTP/2
+	// and the requests should share the class's few connections.
+	const char * url_env(getenv("LL_TEST_HTTP2_URL"));
+	if (! url_env || ! *url_env)
+	{
+		skip("LL_TEST_HTTP2_URL not set, no HTTP/2 test server");
+	}
+	const std::string url_base(url_env);
+
+	static const int request_count(256);
+	static const long connection_limit(2);
+
+	Http2Handler handler;
+	LLCore::HttpHandler::ptr_t handlerp(&handler, NoOpDeletor);
+	TestHandler2 stop_handler(this, "handler");
+	LLCore::HttpHandler::ptr_t stop_handlerp(&stop_handler, NoOpDeletor);
+	mHandlerCalls = 0;
+
+	HttpRequest * req = NULL;
+
+	try
+	{
+		// Get singletons created
+		HttpRequest::createService();
+
+		HttpRequest::policy_t pclass(HttpRequest::createPolicyClass());
+		ensure("Policy class created", pclass != HttpRequest::INVALID_POLICY_ID);
+
+		HttpStatus status;
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_CONNECTION_LIMIT, pclass, connection_limit, NULL);
+		ensure("Connection limit set", bool(status));
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_PER_HOST_CONNECTION_LIMIT, pclass, connection_limit, NULL);
+		ensure("Per-host connection limit set", bool(status));
+		status = HttpRequest::setStaticPolicyOption(HttpRequest::PO_HTTP2_STREAMS, pclass, 64, NULL);
+		ensure("Stream count set", bool(status));
+
+		// Start threading early so that thread memory is invariant
+		// over the test.
+		HttpRequest::startThread();
+
+		// create a new ref counted object with an implicit reference
+		req = new HttpRequest();
+
+		// Test servers come with self-signed certificates
+		HttpOptions::ptr_t opts(new HttpOptions());
+		opts->setSSLVerifyPeer(false);
+		opts->setSSLVerifyHost(false);
+
+		for (int i(0); i < request_count; ++i)
+		{
+			HttpHandle handle = req->requestGet(pclass,
+												url_base,
+												opts,
+												HttpHeaders::ptr_t(),
+												handlerp);
+			ensure("Valid handle returned for get request", handle != LLCORE_HTTP_HANDLE_INVALID);
+		}
+
+		// Run the notification pump.
+		int count(0);
+		int limit(LOOP_COUNT_LONG);
+		while (count++ < limit && handler.mCompleted < request_count)
+		{
+			req->update(0);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Requests executed in reasonable time", count < limit);
+		ensure_equals("All requests completed", handler.mCompleted, request_count);
+		ensure_equals("No requests failed", handler.mFailures, 0);
+		ensure_equals("All replies came back over HTTP/2", handler.mHttp2Replies, request_count);
+		ensure("Requests shared the class's connections", handler.mNewConnects <= connection_limit);
+
+		// Okay, request a shutdown of the servicing thread
+		mStatus = HttpStatus();
+		HttpHandle handle = req->requestStopThread(stop_handlerp);
+		ensure("Valid handle returned for second request", handle != LLCORE_HTTP_HANDLE_INVALID);
+
+		// Run the notification pump again
+		count = 0;
+		limit = LOOP_COUNT_LONG;
+		while (count++ < limit && mHandlerCalls < 1)
+		{
+			req->update(1000000);
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Second request executed in reasonable time", count < limit);
+		ensure("Second handler invocation", mHandlerCalls == 1);
+
+		// See that we actually shutdown the thread
+		count = 0;
+		limit = LOOP_COUNT_SHORT;
+		while (count++ < limit && ! HttpService::isStopped())
+		{
+			usleep(LOOP_SLEEP_INTERVAL);
+		}
+		ensure("Thread actually stopped running", HttpService::isStopped());
+
+		// release the request object
+		delete req;
+		req = NULL;
+
+		// Shut down service
+		HttpRequest::destroyService();
+	}
+	catch (...)
+	{
+		stop_thread(req);
+		delete req;
+		HttpRequest::destroyService();
+		throw;
+	}
+}
+
 }  // end namespace tut
 
 namespace
@@ -151,6 +151,47 @@ void HttpRequestqueueTestObjectType::test<4>()
 	}
 }
 
+template <> template <>
+void HttpRequestqueueTestObjectType::test<5>()
+{
+	set_test_name("HttpRequestQueue wakeup calls");
+
+	// create a new ref counted object with an implicit reference
+	HttpRequestQueue::init();
+
+	HttpRequestQueue * rq = HttpRequestQueue::instanceOf();
+
+	int wakeups(0);
+	rq->setWakeup([&wakeups]() { ++wakeups; });
+
+	HttpOperation::ptr_t op (new HttpOpNull());
+	rq->addOp(op);
+	ensure("First op onto an empty queue wakes", 1 == wakeups);
+
+	op.reset(new HttpOpNull());
+	rq->addOp(op);
+	ensure("Queue already had work, no wakeup", 1 == wakeups);
+
+	{
+		HttpRequestQueue::OpContainer ops;
+		rq->fetchAll(false, ops);
+		ensure("Two go in, two come out", 2 == ops.size());
+	}
+
+	op.reset(new HttpOpNull());
+	rq->addOp(op);
+	ensure("Emptied queue wakes again", 2 == wakeups);
+
+	rq->stopQueue();
+	ensure("Stopping the queue wakes", 3 == wakeups);
+
+	rq->setWakeup(HttpRequestQueue::wakeup_t());
+	op.reset();
+
+	// release the singleton
+	HttpRequestQueue::term();
+}
+
 }  // end namespace tut
 
 
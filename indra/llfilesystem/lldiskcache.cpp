@@ -39,16 +39,82 @@
 
 #include "lldiskcache.h"
 
+namespace
+{
+    // Journal layout: a JOURNAL_MAGIC, JOURNAL_VERSION header followed by
+    // records made of a one byte opcode, a 16 bit name length and the name,
+    // then for JOURNAL_SET the file size (64 bits) and access time (64 bits).
+    const char JOURNAL_FILENAME[] = "diskcache.journal";
+    const U32 JOURNAL_MAGIC = 0x4a44534c; // "LSDJ"
+    const U32 JOURNAL_VERSION = 1;
+
+    enum EJournalOp : U8
+    {
+        JOURNAL_SET = 1,
+        JOURNAL_REMOVE = 2,
+        JOURNAL_CLEAN = 3   // normal shutdown, the journal is complete
+    };
+
+    // The journal is rewritten from the index once it holds this many
+    // superseded records
+    const U32 JOURNAL_MIN_GARBAGE = 4096;
+
+    template <typename T>
+    void journal_put(std::string& buffer, T value)
+    {
+        buffer.append((const char*)&value, sizeof(T));
+    }
+
+    template <typename T>
+    bool journal_get(const std::string& buffer, size_t& pos, T& value)
+    {
+        if (pos + sizeof(T) > buffer.size())
+        {
+            return false;
+        }
+        memcpy(&value, buffer.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    void journal_put_record(std::string& buffer, EJournalOp op, const std::string& name,
+                            uintmax_t file_size = 0, std::time_t access_time = 0)
+    {
+        journal_put<U8>(buffer, op);
+        if (op == JOURNAL_CLEAN)
+        {
+            return;
+        }
+        journal_put<U16>(buffer, (U16)name.size());
+        buffer.append(name);
+        if (op == JOURNAL_SET)
+        {
+            journal_put<U64>(buffer, (U64)file_size);
+            journal_put<S64>(buffer, (S64)access_time);
+        }
+    }
+}
+
 LLDiskCache::LLDiskCache(const std::string cache_dir,
                          const uintmax_t max_size_bytes,
                          const bool enable_cache_debug_info) :
     mCacheDir(cache_dir),
     mMaxSizeBytes(max_size_bytes),
-    mEnableCacheDebugInfo(enable_cache_debug_info)
+    mEnableCacheDebugInfo(enable_cache_debug_info),
+    mTotalSize(0),
+    mJournalRecords(0)
 {
     mCacheFilenamePrefix = "sl_cache";
 
     LLFile::mkdir(cache_dir);
+
+    mJournalPath = gDirUtilp->add(mCacheDir, JOURNAL_FILENAME);
+    loadIndex();
+}
+
+LLDiskCache::~LLDiskCache()
+{
+    flushJournal(true);
 }
 
 // WARNING: purge() is called by LLPurgeDiskCacheThread. As such it must
@@ -86,77 +152,69 @@ void LLDiskCache::purge()
         LL_INFOS() << "Total dir size before purge is " << dirFileSize(mCacheDir) << LL_ENDL;
     }
 
-    boost::system::error_code ec;
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    typedef std::pair<std::time_t, std::pair<uintmax_t, std::string>> file_info_t;
-    std::vector<file_info_t> file_info;
+    struct victim_t
+    {
+        std::string mKey;
+        uintmax_t mSize;
+        std::time_t mAccessTime;
+    };
+    std::vector<victim_t> victims;
+    uintmax_t file_size_total = 0;
 
-#if LL_WINDOWS
-    std::wstring cache_path(utf8str_to_utf16str(mCacheDir));
-#else
-    std::string cache_path(mCacheDir);
-#endif
-    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
     {
-        boost::filesystem::directory_iterator iter(cache_path, ec);
-        while (iter != boost::filesystem::directory_iterator() && !ec.failed())
+        LLMutexLock lock(&mIndexMutex);
+        while (mTotalSize > mMaxSizeBytes && !mLRU.empty())
         {
-            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
-            {
-                if ((*iter).path().string().find(mCacheFilenamePrefix) != std::string::npos)
-                {
-                    uintmax_t file_size = boost::filesystem::file_size(*iter, ec);
-                    if (ec.failed())
-                    {
-                        continue;
-                    }
-                    const std::string file_path = (*iter).path().string();
-                    const std::time_t file_time = boost::filesystem::last_write_time(*iter, ec);
-                    if (ec.failed())
-                    {
-                        continue;
-                    }
-
-                    file_info.push_back(file_info_t(file_time, { file_size, file_path }));
-                }
-            }
-            iter.increment(ec);
+            const std::string key = mLRU.front();
+            const IndexEntry& entry = mIndex[key];
+            victims.push_back({ key, entry.mSize, entry.mAccessTime });
+            mDirty.insert(key);
+            indexErase(key);
         }
+        file_size_total = mTotalSize;
     }
 
-    std::sort(file_info.begin(), file_info.end(), [](file_info_t& x, file_info_t& y)
+    if (!victims.empty())
     {
-        return x.first > y.first;
-    });
-
-    LL_INFOS() << "Purging cache to a maximum of " << mMaxSizeBytes << " bytes" << LL_ENDL;
-
-    std::vector<bool> file_removed;
-    if (mEnableCacheDebugInfo)
-    {
-        file_removed.reserve(file_info.size());
+        LL_INFOS() << "Purging cache to a maximum of " << mMaxSizeBytes << " bytes, removing " << victims.size() << " files" << LL_ENDL;
     }
-    uintmax_t file_size_total = 0;
-    for (file_info_t& entry : file_info)
-    {
-        file_size_total += entry.second.first;
 
-        bool should_remove = file_size_total > mMaxSizeBytes;
-        if (mEnableCacheDebugInfo)
+    // The files are deleted outside of the index lock so that other threads
+    // can keep on using the cache meanwhile
+    std::vector<victim_t> failed;
+    boost::system::error_code ec;
+    for (const victim_t& victim : victims)
+    {
+        const std::string file_path = gDirUtilp->add(mCacheDir, victim.mKey);
+#if LL_WINDOWS
+        boost::filesystem::remove(utf8str_to_utf16str(file_path), ec);
+#else
+        boost::filesystem::remove(file_path, ec);
+#endif
+        if (ec.failed())
         {
-            file_removed.push_back(should_remove);
+            LL_WARNS() << "Failed to delete cache file " << file_path << ": " << ec.message() << LL_ENDL;
+            failed.push_back(victim);
         }
-        if (should_remove)
+    }
+
+    if (!failed.empty())
+    {
+        // Most likely in use: keep them first in line for the next purge
+        LLMutexLock lock(&mIndexMutex);
+        for (auto iter = failed.rbegin(); iter != failed.rend(); ++iter)
         {
-            boost::filesystem::remove(entry.second.second, ec);
-            if (ec.failed())
+            if (mIndex.find(iter->mKey) == mIndex.end())
             {
-                LL_WARNS() << "Failed to delete cache file " << entry.second.second << ": " << ec.message() << LL_ENDL;
+                indexSet(iter->mKey, iter->mSize, iter->mAccessTime, true);
             }
         }
     }
 
+    flushJournal();
+
     if (mEnableCacheDebugInfo)
     {
         auto end_time = std::chrono::high_resolution_clock::now();
@@ -164,25 +222,21 @@ void LLDiskCache::purge()
 
         // Log afterward so it doesn't affect the time measurement
         // Logging thousands of file results can take hundreds of milliseconds
-        for (size_t i = 0; i < file_info.size(); ++i)
+        for (const victim_t& victim : victims)
         {
-            const file_info_t& entry = file_info[i];
-            const bool removed = file_removed[i];
-            const std::string action = removed ? "DELETE:" : "KEEP:";
-
             // have to do this because of LL_INFO/LL_END weirdness
             std::ostringstream line;
 
-            line << action << "  ";
-            line << entry.first << "  ";
-            line << entry.second.first << "  ";
-            line << entry.second.second;
+            line << "DELETE:  ";
+            line << victim.mAccessTime << "  ";
+            line << victim.mSize << "  ";
+            line << victim.mKey;
             line << " (" << file_size_total << "/" << mMaxSizeBytes << ")";
             LL_INFOS() << line.str() << LL_ENDL;
         }
 
         LL_INFOS() << "Total dir size after purge is " << dirFileSize(mCacheDir) << LL_ENDL;
-        LL_INFOS() << "Cache purge took " << execute_time << " ms to execute for " << file_info.size() << " files" << LL_ENDL;
+        LL_INFOS() << "Cache purge took " << execute_time << " ms to execute for " << victims.size() << " files" << LL_ENDL;
     }
 }
 
@@ -261,70 +315,451 @@ const std::string LLDiskCache::metaDataToFilepath(const std::string id,
 void LLDiskCache::updateFileAccessTime(const std::string file_path)
 {
     /**
-     * Threshold in time_t units that is used to decide if the last access time
-     * time of the file is updated or not. Added as a precaution for the concern
-     * outlined in SL-14582  about frequent writes on older SSDs reducing their
-     * lifespan. I think this is the right place for the threshold value - rather
-     * than it being a pref - do comment on that Jira if you disagree...
-     *
-     * Let's start with 1 hour in time_t units and see how that unfolds
+     * Only the index is updated, the journal record is written by the next
+     * flushJournal() and coalesces all the reads in between. This replaces the
+     * one hour threshold on touching the file itself that was added for the
+     * concern outlined in SL-14582 about frequent writes on older SSDs
+     * reducing their lifespan.
      */
-    const std::time_t time_threshold = 1 * 60 * 60;
-
-    // current time
     const std::time_t cur_time = std::time(nullptr);
+    const std::string key = indexKey(file_path);
+
+    LLMutexLock lock(&mIndexMutex);
+    index_map_t::iterator iter = mIndex.find(key);
+    if (iter != mIndex.end())
+    {
+        iter->second.mAccessTime = cur_time;
+        mLRU.splice(mLRU.end(), mLRU, iter->second.mLRUPos);
+        mDirty.insert(key);
+    }
+}
+
+void LLDiskCache::notifyFileWritten(const std::string& file_path, uintmax_t file_size)
+{
+    const std::string key = indexKey(file_path);
+
+    LLMutexLock lock(&mIndexMutex);
+    indexSet(key, file_size, std::time(nullptr));
+    mDirty.insert(key);
+}
+
+void LLDiskCache::notifyFileRemoved(const std::string& file_path)
+{
+    const std::string key = indexKey(file_path);
+
+    LLMutexLock lock(&mIndexMutex);
+    if (mIndex.find(key) != mIndex.end())
+    {
+        indexErase(key);
+        mDirty.insert(key);
+    }
+}
+
+void LLDiskCache::notifyFileRenamed(const std::string& old_file_path, const std::string& new_file_path)
+{
+    const std::string old_key = indexKey(old_file_path);
+    const std::string new_key = indexKey(new_file_path);
+
+    LLMutexLock lock(&mIndexMutex);
+    index_map_t::iterator iter = mIndex.find(old_key);
+    if (iter != mIndex.end())
+    {
+        uintmax_t file_size = iter->second.mSize;
+        indexErase(old_key);
+        indexSet(new_key, file_size, std::time(nullptr));
+        mDirty.insert(old_key);
+        mDirty.insert(new_key);
+    }
+}
+
+bool LLDiskCache::getFileSize(const std::string& file_path, uintmax_t& file_size)
+{
+    const std::string key = indexKey(file_path);
+
+    {
+        LLMutexLock lock(&mIndexMutex);
+        index_map_t::const_iterator iter = mIndex.find(key);
+        if (iter != mIndex.end())
+        {
+            file_size = iter->second.mSize;
+            return true;
+        }
+    }
 
+    // Not indexed, but another viewer instance sharing the cache folder may
+    // have written it since the index was loaded: ask the disk and adopt it
     boost::system::error_code ec;
 #if LL_WINDOWS
-    // file last write time
-    const std::time_t last_write_time = boost::filesystem::last_write_time(utf8str_to_utf16str(file_path), ec);
+    std::wstring path(utf8str_to_utf16str(file_path));
+#else
+    std::string path(file_path);
+#endif
+    const uintmax_t disk_size = boost::filesystem::file_size(path, ec);
     if (ec.failed())
     {
-        LL_WARNS() << "Failed to read last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
-        return;
+        return false;
+    }
+
+    LLMutexLock lock(&mIndexMutex);
+    index_map_t::const_iterator iter = mIndex.find(key);
+    if (iter == mIndex.end())
+    {
+        indexSet(key, disk_size, std::time(nullptr));
+        mDirty.insert(key);
+        iter = mIndex.find(key);
+    }
+    file_size = iter->second.mSize;
+    return true;
+}
+
+std::string LLDiskCache::indexKey(const std::string& file_path) const
+{
+    // Paths normally come from metaDataToFilepath()
+    if (file_path.size() > mCacheDir.size() && file_path.compare(0, mCacheDir.size(), mCacheDir) == 0)
+    {
+        return file_path.substr(mCacheDir.size() + 1);
+    }
+    return gDirUtilp->getBaseFileName(file_path);
+}
+
+void LLDiskCache::indexSet(const std::string& key, uintmax_t file_size, std::time_t access_time, bool least_recent)
+{
+    index_map_t::iterator iter = mIndex.find(key);
+    if (iter == mIndex.end())
+    {
+        IndexEntry entry;
+        entry.mSize = 0;
+        entry.mLRUPos = mLRU.insert(least_recent ? mLRU.begin() : mLRU.end(), key);
+        iter = mIndex.emplace(key, entry).first;
+    }
+    else
+    {
+        mLRU.splice(least_recent ? mLRU.begin() : mLRU.end(), mLRU, iter->second.mLRUPos);
+    }
+    mTotalSize -= iter->second.mSize;
+    mTotalSize += file_size;
+    iter->second.mSize = file_size;
+    iter->second.mAccessTime = access_time;
+}
+
+void LLDiskCache::indexErase(const std::string& key)
+{
+    index_map_t::iterator iter = mIndex.find(key);
+    if (iter != mIndex.end())
+    {
+        mTotalSize -= iter->second.mSize;
+        mLRU.erase(iter->second.mLRUPos);
+        mIndex.erase(iter);
+    }
+}
+
+void LLDiskCache::indexClear()
+{
+    mIndex.clear();
+    mLRU.clear();
+    mTotalSize = 0;
+}
+
+void LLDiskCache::loadIndex()
+{
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    journal_records_t records;
+    bool clean = false;
+    bool valid = readJournal(records, clean);
+
+    LLMutexLock journal_lock(&mJournalMutex);
+    if (valid && clean)
+    {
+        // The records of the journal are in no particular order, the access
+        // times give back the least recently used order
+        std::vector<std::pair<std::time_t, const std::string*>> order;
+        order.reserve(records.size());
+        for (const auto& record : records)
+        {
+            order.push_back(std::make_pair(record.second.second, &record.first));
+        }
+        std::sort(order.begin(), order.end());
+
+        LLMutexLock lock(&mIndexMutex);
+        indexClear();
+        for (const auto& item : order)
+        {
+            indexSet(*item.second, records[*item.second].first, item.first);
+        }
+
+        // Drop the clean marker: if the viewer crashes from now on, changes
+        // that did not reach the journal yet require a rescan on next start
+        boost::system::error_code ec;
+#if LL_WINDOWS
+        std::wstring journal_path(utf8str_to_utf16str(mJournalPath));
+#else
+        std::string journal_path(mJournalPath);
+#endif
+        uintmax_t journal_size = boost::filesystem::file_size(journal_path, ec);
+        if (!ec.failed())
+        {
+            boost::filesystem::resize_file(journal_path, journal_size - 1, ec);
+        }
+        if (ec.failed())
+        {
+            rewriteJournal(false);
+        }
     }
+    else
+    {
+        LL_INFOS() << "Disk cache journal " << (valid ? "not closed cleanly" : "missing or invalid") << ", scanning " << mCacheDir << LL_ENDL;
+        rebuildIndex(records);
+        rewriteJournal(false);
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+    LL_INFOS() << "Disk cache index loaded with " << mIndex.size() << " files, " << mTotalSize << " bytes in " << execute_time << " ms" << LL_ENDL;
+}
 
-    // delta between cur time and last time the file was written
-    const std::time_t delta_time = cur_time - last_write_time;
+bool LLDiskCache::readJournal(journal_records_t& records, bool& clean)
+{
+    clean = false;
+    mJournalRecords = 0;
+
+    std::string buffer;
+    {
+        llifstream file(mJournalPath, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        buffer = contents.str();
+    }
 
-    // we only write the new value if the time in time_threshold has elapsed
-    // before the last one
-    if (delta_time > time_threshold)
+    size_t pos = 0;
+    U32 magic = 0;
+    U32 version = 0;
+    if (!journal_get(buffer, pos, magic) || !journal_get(buffer, pos, version)
+        || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION)
     {
-        boost::filesystem::last_write_time(utf8str_to_utf16str(file_path), cur_time, ec);
+        return false;
     }
+
+    // A truncated last record is the sign of a crash while appending and is
+    // simply dropped
+    U8 op;
+    while (journal_get(buffer, pos, op))
+    {
+        clean = false;
+        if (op == JOURNAL_CLEAN)
+        {
+            clean = true;
+            continue;
+        }
+
+        U16 name_size;
+        if (!journal_get(buffer, pos, name_size) || pos + name_size > buffer.size())
+        {
+            break;
+        }
+        std::string name(buffer, pos, name_size);
+        pos += name_size;
+
+        if (op == JOURNAL_SET)
+        {
+            U64 file_size;
+            S64 access_time;
+            if (!journal_get(buffer, pos, file_size) || !journal_get(buffer, pos, access_time))
+            {
+                break;
+            }
+            records[name] = std::make_pair((uintmax_t)file_size, (std::time_t)access_time);
+        }
+        else if (op == JOURNAL_REMOVE)
+        {
+            records.erase(name);
+        }
+        else
+        {
+            LL_WARNS() << "Corrupted disk cache journal " << mJournalPath << LL_ENDL;
+            records.clear();
+            return false;
+        }
+        ++mJournalRecords;
+    }
+    // Anything after the clean marker means it is stale
+    clean = clean && pos == buffer.size();
+
+    return true;
+}
+
+void LLDiskCache::rebuildIndex(const journal_records_t& known)
+{
+    typedef std::pair<std::time_t, std::pair<uintmax_t, std::string>> file_info_t;
+    std::vector<file_info_t> file_info;
+
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    std::wstring cache_path(utf8str_to_utf16str(mCacheDir));
 #else
-    // file last write time
-    const std::time_t last_write_time = boost::filesystem::last_write_time(file_path, ec);
-    if (ec.failed())
+    std::string cache_path(mCacheDir);
+#endif
+    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
     {
-        LL_WARNS() << "Failed to read last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
+        boost::filesystem::directory_iterator iter(cache_path, ec);
+        while (iter != boost::filesystem::directory_iterator() && !ec.failed())
+        {
+            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
+            {
+                const std::string file_name = (*iter).path().filename().string();
+                if (file_name.compare(0, mCacheFilenamePrefix.size(), mCacheFilenamePrefix) == 0)
+                {
+                    uintmax_t file_size = boost::filesystem::file_size(*iter, ec);
+                    if (!ec.failed())
+                    {
+                        // Prefer the access time the journal knows about, the
+                        // file time is only updated on writes
+                        journal_records_t::const_iterator record = known.find(file_name);
+                        std::time_t file_time = 0;
+                        if (record != known.end())
+                        {
+                            file_time = record->second.second;
+                        }
+                        else
+                        {
+                            file_time = boost::filesystem::last_write_time(*iter, ec);
+                        }
+                        if (!ec.failed())
+                        {
+                            file_info.push_back(file_info_t(file_time, { file_size, file_name }));
+                        }
+                    }
+                }
+            }
+            iter.increment(ec);
+        }
+    }
+
+    std::sort(file_info.begin(), file_info.end());
+
+    LLMutexLock lock(&mIndexMutex);
+    indexClear();
+    mDirty.clear();
+    for (const file_info_t& entry : file_info)
+    {
+        indexSet(entry.second.second, entry.second.first, entry.first);
+    }
+}
+
+void LLDiskCache::flushJournal(bool clean)
+{
+    LLMutexLock journal_lock(&mJournalMutex);
+
+    if (clean)
+    {
+        rewriteJournal(true);
+        return;
+    }
+
+    std::string buffer;
+    U32 num_records = 0;
+    bool rewrite = false;
+    {
+        LLMutexLock lock(&mIndexMutex);
+        if (mDirty.empty())
+        {
+            return;
+        }
+        rewrite = mJournalRecords + mDirty.size() > 2 * mIndex.size() + JOURNAL_MIN_GARBAGE;
+        if (!rewrite)
+        {
+            for (const std::string& key : mDirty)
+            {
+                index_map_t::const_iterator iter = mIndex.find(key);
+                if (iter != mIndex.end())
+                {
+                    journal_put_record(buffer, JOURNAL_SET, key, iter->second.mSize, iter->second.mAccessTime);
+                }
+                else
+                {
+                    journal_put_record(buffer, JOURNAL_REMOVE, key);
+                }
+                ++num_records;
+            }
+            mDirty.clear();
+        }
+    }
+
+    if (rewrite)
+    {
+        rewriteJournal(false);
         return;
     }
 
-    // delta between cur time and last time the file was written
-    const std::time_t delta_time = cur_time - last_write_time;
+    llofstream file(mJournalPath, std::ios::app | std::ios::binary);
+    if (file.is_open())
+    {
+        file.write(buffer.data(), buffer.size());
+        mJournalRecords += num_records;
+    }
+    else
+    {
+        LL_WARNS() << "Failed to append to disk cache journal " << mJournalPath << LL_ENDL;
+    }
+}
 
-    // we only write the new value if the time in time_threshold has elapsed
-    // before the last one
-    if (delta_time > time_threshold)
+void LLDiskCache::rewriteJournal(bool clean)
+{
+    std::string buffer;
+    journal_put<U32>(buffer, JOURNAL_MAGIC);
+    journal_put<U32>(buffer, JOURNAL_VERSION);
+    U32 num_records = 0;
     {
-        boost::filesystem::last_write_time(file_path, cur_time, ec);
+        LLMutexLock lock(&mIndexMutex);
+        buffer.reserve(buffer.size() + mIndex.size() * (mCacheFilenamePrefix.size() + 64));
+        for (const std::string& key : mLRU)
+        {
+            const IndexEntry& entry = mIndex[key];
+            journal_put_record(buffer, JOURNAL_SET, key, entry.mSize, entry.mAccessTime);
+            ++num_records;
+        }
+        mDirty.clear();
+    }
+    if (clean)
+    {
+        journal_put_record(buffer, JOURNAL_CLEAN, std::string());
     }
-#endif
 
-    if (ec.failed())
+    const std::string tmp_path = mJournalPath + ".tmp";
     {
-        LL_WARNS() << "Failed to update last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
+        llofstream file(tmp_path, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!file.is_open())
+        {
+            LL_WARNS() << "Failed to write disk cache journal " << tmp_path << LL_ENDL;
+            return;
+        }
+        file.write(buffer.data(), buffer.size());
     }
+    LLFile::remove(mJournalPath, ENOENT);
+    if (LLFile::rename(tmp_path, mJournalPath) != 0)
+    {
+        LL_WARNS() << "Failed to replace disk cache journal " << mJournalPath << LL_ENDL;
+        return;
+    }
+    mJournalRecords = num_records;
 }
 
 const std::string LLDiskCache::getCacheInfo()
 {
     std::ostringstream cache_info;
 
+    uintmax_t total_size = 0;
+    {
+        LLMutexLock lock(&mIndexMutex);
+        total_size = mTotalSize;
+    }
+
     F32 max_in_mb = (F32)mMaxSizeBytes / (1024.0 * 1024.0);
-    F32 percent_used = ((F32)dirFileSize(mCacheDir) / (F32)mMaxSizeBytes) * 100.0;
+    F32 percent_used = ((F32)total_size / (F32)mMaxSizeBytes) * 100.0;
 
     cache_info << std::fixed;
     cache_info << std::setprecision(1);
@@ -367,6 +802,13 @@ void LLDiskCache::clearCache()
             iter.increment(ec);
         }
     }
+
+    LLMutexLock journal_lock(&mJournalMutex);
+    {
+        LLMutexLock lock(&mIndexMutex);
+        indexClear();
+    }
+    rewriteJournal(false);
 }
 
 void LLDiskCache::removeOldVFSFiles()
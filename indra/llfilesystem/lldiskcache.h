@@ -22,15 +22,24 @@
                     that identifies the type of asset being stored.
         .asset      A file extension of .asset is used to help
                     identify this as a Viewer asset file
- * 2/ The time of last access for a file can be updated instantly
- *    for file reads and automatically as part of the file writes.
- * 3/ The purge algorithm collects a list of all files in the
- *    directory, sorts them by date of last access (write) and then
- *    deletes any files based on age until the total size of all
- *    the files is less than the maximum size specified.
- * 4/ An LLSingleton idiom is used since there will only ever be
+ * 2/ The size and time of last access of every file are kept in an
+ *    in-memory index, ordered from least to most recently used.
+ *    LLFileSystem reports writes, removals and renames to it and
+ *    reads only move the file to the recent end of the index, so
+ *    no file is touched on disk to record an access.
+ * 3/ The index is persisted in a journal file in the cache folder.
+ *    Changes are coalesced in memory and appended to the journal in
+ *    batches by the purge thread.  The journal is rewritten when it
+ *    grows much larger than the index and ends with a 'clean' marker
+ *    after a normal shutdown; when that marker is missing the index
+ *    is rebuilt once by scanning the cache folder.
+ * 4/ The purge algorithm pops the least recently used files off the
+ *    index until the total size of all the files is less than the
+ *    maximum size specified, so its cost depends on the number of
+ *    files evicted rather than on the number of files in the cache.
+ * 5/ An LLSingleton idiom is used since there will only ever be
  *    a single cache and we want to access it from numerous places.
- * 5/ Performance on my modest system seems very acceptable. For
+ * 6/ Performance on my modest system seems very acceptable. For
  *    example, in testing, I was able to purge a directory of
  *    10,000 files, deleting about half of them in ~ 1700ms. For
  *    the same sized directory of files, writing the last updated
@@ -62,8 +71,14 @@
 #ifndef _LLDISKCACHE
 #define _LLDISKCACHE
 
+#include "llmutex.h"
 #include "llsingleton.h"
 
+#include <ctime>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+
 class LLDiskCache :
     public LLParamSingleton<LLDiskCache>
 {
@@ -94,7 +109,7 @@ class LLDiskCache :
                      */
                     const bool enable_cache_debug_info);
 
-        virtual ~LLDiskCache() = default;
+        virtual ~LLDiskCache();
 
     public:
         /**
@@ -115,6 +130,31 @@ class LLDiskCache :
          */
         void updateFileAccessTime(const std::string file_path);
 
+        /**
+         * Keep the index in step with the files in the cache. These must be
+         * called by whatever creates, grows, deletes or renames a cache file
+         * (LLFileSystem) and only update the index, not the files themselves.
+         */
+        void notifyFileWritten(const std::string& file_path, uintmax_t file_size);
+        void notifyFileRemoved(const std::string& file_path);
+        void notifyFileRenamed(const std::string& old_file_path, const std::string& new_file_path);
+
+        /**
+         * Look up the size of a cache file in the index. Files the index does
+         * not know about are looked for on disk and added to the index if
+         * found. Returns false if the file does not exist. A file deleted
+         * behind the index's back stays indexed until LLFileSystem fails to
+         * open it.
+         */
+        bool getFileSize(const std::string& file_path, uintmax_t& file_size);
+
+        /**
+         * Append the index changes made since the last call to the journal.
+         * Called periodically by LLPurgeDiskCacheThread, and with clean set
+         * on shutdown to compact the journal and mark it as complete.
+         */
+        void flushJournal(bool clean = false);
+
         /**
          * Purge the oldest items in the cache so that the combined size of all files
          * is no bigger than mMaxSizeBytes.
@@ -156,6 +196,30 @@ class LLDiskCache :
          */
         const std::string assetTypeToString(LLAssetType::EType at);
 
+        /**
+         * Index maintenance. mIndexMutex must be held by the caller of
+         * every function in this group.
+         */
+        std::string indexKey(const std::string& file_path) const;
+        void indexSet(const std::string& key, uintmax_t file_size, std::time_t access_time, bool least_recent = false);
+        void indexErase(const std::string& key);
+        void indexClear();
+
+        /**
+         * Load the index from the journal, falling back on a scan of the cache
+         * folder when the journal is missing or was not closed cleanly.
+         */
+        typedef std::unordered_map<std::string, std::pair<uintmax_t, std::time_t>> journal_records_t;
+        void loadIndex();
+        bool readJournal(journal_records_t& records, bool& clean);
+        void rebuildIndex(const journal_records_t& known);
+
+        /**
+         * Rewrite the journal from the index (oldest entries first), which
+         * drops every superseded record. mJournalMutex must be held.
+         */
+        void rewriteJournal(bool clean);
+
     private:
         /**
          * The maximum size of the cache in bytes. After purge is called, the
@@ -187,6 +251,43 @@ class LLDiskCache :
          * various parts of the code
          */
         bool mEnableCacheDebugInfo;
+
+        /**
+         * Least recently used files first. A list rather than a container
+         * sorted on the access time so that a read moves its file to the end
+         * in constant time.
+         */
+        typedef std::list<std::string> lru_list_t;
+        struct IndexEntry
+        {
+            uintmax_t mSize;
+            std::time_t mAccessTime;
+            lru_list_t::iterator mLRUPos;
+        };
+        typedef std::unordered_map<std::string, IndexEntry> index_map_t;
+
+        /**
+         * The index proper, keyed on the file name relative to mCacheDir.
+         * Accessed from any thread using LLFileSystem and from the purge
+         * thread, so guarded by mIndexMutex, as are mTotalSize and mDirty.
+         */
+        LLMutex mIndexMutex;
+        index_map_t mIndex;
+        lru_list_t mLRU;
+        uintmax_t mTotalSize;
+
+        /**
+         * Files changed since the last journal flush. A file read many times
+         * between two flushes only gets one journal record.
+         */
+        std::unordered_set<std::string> mDirty;
+
+        /**
+         * Serializes writes to the journal, which happen outside mIndexMutex.
+         */
+        LLMutex mJournalMutex;
+        std::string mJournalPath;
+        U32 mJournalRecords;
 };
 
 class LLPurgeDiskCacheThread : public LLThread
@@ -63,12 +63,10 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
         // update the last access time for the file if it exists - this is required
         // even though we are reading and not writing because this is the
         // way the cache works - it relies on a valid "last accessed time" for
-        // each file so it knows how to remove the oldest, unused files
-        bool exists = gDirUtilp->fileExists(filename);
-        if (exists)
-        {
-            LLDiskCache::getInstance()->updateFileAccessTime(filename);
-        }
+        // each file so it knows how to remove the oldest, unused files.
+        // Files the disk cache index does not know about are ignored, so
+        // there is no need to check the file exists first.
+        LLDiskCache::getInstance()->updateFileAccessTime(filename);
     }
 }
 
@@ -84,13 +82,10 @@ bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType fil
     const std::string extra_info = "";
     const std::string filename = LLDiskCache::getInstance()->metaDataToFilepath(id_str, file_type, extra_info);
 
-    llifstream file(filename, std::ios::binary);
-    if (file.is_open())
-    {
-        file.seekg(0, std::ios::end);
-        return file.tellg() > 0;
-    }
-    return false;
+    // answered from the disk cache index, which only goes to the disk for
+    // files it does not know about
+    uintmax_t file_size = 0;
+    return LLDiskCache::getInstance()->getFileSize(filename, file_size) && file_size > 0;
 }
 
 // static
@@ -102,6 +97,7 @@ bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType fi
     const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id_str, file_type, extra_info);
 
     LLFile::remove(filename.c_str(), suppress_error);
+    LLDiskCache::getInstance()->notifyFileRemoved(filename);
 
     return true;
 }
@@ -130,6 +126,10 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
         //return FALSE;
         LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_id_str << " reason: "  << strerror(errno) << LL_ENDL;
     }
+    else
+    {
+        LLDiskCache::getInstance()->notifyFileRenamed(old_filename, new_filename);
+    }
 
     return TRUE;
 }
@@ -142,15 +142,13 @@ S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType fi
     const std::string extra_info = "";
     const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id_str, file_type, extra_info);
 
-    S32 file_size = 0;
-    llifstream file(filename, std::ios::binary);
-    if (file.is_open())
-    {
-        file.seekg(0, std::ios::end);
-        file_size = file.tellg();
-    }
+    // answered from the disk cache index rather than by opening the file,
+    // this gets called for every seek() and eof(). Files not in the index
+    // are looked up on disk.
+    uintmax_t file_size = 0;
+    LLDiskCache::getInstance()->getFileSize(filename, file_size);
 
-    return file_size;
+    return (S32)llmin(file_size, (uintmax_t)INT_MAX);
 }
 
 BOOL LLFileSystem::read(U8* buffer, S32 bytes)
@@ -186,6 +184,11 @@ BOOL LLFileSystem::read(U8* buffer, S32 bytes)
             success = TRUE;
         }
     }
+    else
+    {
+        // deleted behind our back, stop advertising it
+        LLDiskCache::getInstance()->notifyFileRemoved(filename);
+    }
 
     return success;
 }
@@ -219,6 +222,7 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
             mPosition = ofs.tellp(); // <FS:Ansariel> Fix asset caching
 
             success = TRUE;
+            LLDiskCache::getInstance()->notifyFileWritten(filename, mPosition);
         }
     }
     // <FS:Ansariel> Fix asset caching
@@ -232,6 +236,9 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
             ofs.write((const char*)buffer, bytes);
             mPosition += bytes;
             success = TRUE;
+
+            ofs.seekp(0, std::ios::end);
+            LLDiskCache::getInstance()->notifyFileWritten(filename, ofs.tellp());
         }
         else
         {
@@ -242,6 +249,7 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
                 ofs.write((const char*)buffer, bytes);
                 mPosition += bytes;
                 success = TRUE;
+                LLDiskCache::getInstance()->notifyFileWritten(filename, ofs.tellp());
             }
         }
     }
@@ -256,6 +264,7 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
             mPosition += bytes;
 
             success = TRUE;
+            LLDiskCache::getInstance()->notifyFileWritten(filename, ofs.tellp());
         }
     }
 
@@ -0,0 +1,286 @@
+/**
+ * @file llmappedfile.cpp
+ * @brief Memory-mapped view over a local cache file.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmappedfile.h"
+#include "llstring.h"
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LLMappedFile::LLMappedFile()
+:   mData(nullptr),
+    mSize(0),
+    mWritable(false),
+#if LL_WINDOWS
+    mFileHandle(INVALID_HANDLE_VALUE),
+    mMappingHandle(NULL)
+#else
+    mFD(-1)
+#endif
+{
+}
+
+LLMappedFile::~LLMappedFile()
+{
+    close();
+}
+
+#if LL_WINDOWS
+
+bool LLMappedFile::open(const std::string& filename, size_t min_size, bool writable)
+{
+    close();
+
+    mFilename = filename;
+    mWritable = writable;
+
+    llutf16string utf16filename = utf8str_to_utf16str(filename);
+    DWORD access = writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+    DWORD disposition = writable ? OPEN_ALWAYS : OPEN_EXISTING;
+    HANDLE file = CreateFileW((LPCWSTR)utf16filename.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LL_DEBUGS("MappedFile") << "Could not open " << filename << " error: " << GetLastError() << LL_ENDL;
+        return false;
+    }
+    mFileHandle = file;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        close();
+        return false;
+    }
+    mSize = llmax((size_t)file_size.QuadPart, writable ? min_size : 0);
+
+    if (!map())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool LLMappedFile::map()
+{
+    if (!mSize)
+    {
+        // Windows refuses to map an empty file
+        return false;
+    }
+
+    ULARGE_INTEGER size;
+    size.QuadPart = mSize;
+    // For writable mappings a size larger than the file grows the file
+    mMappingHandle = CreateFileMappingW((HANDLE)mFileHandle, NULL, mWritable ? PAGE_READWRITE : PAGE_READONLY,
+                                        size.HighPart, size.LowPart, NULL);
+    if (!mMappingHandle)
+    {
+        LL_WARNS("MappedFile") << "CreateFileMapping failed for " << mFilename << " error: " << GetLastError() << LL_ENDL;
+        return false;
+    }
+
+    mData = (U8*)MapViewOfFile((HANDLE)mMappingHandle, mWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, mSize);
+    if (!mData)
+    {
+        LL_WARNS("MappedFile") << "MapViewOfFile failed for " << mFilename << " error: " << GetLastError() << LL_ENDL;
+        CloseHandle((HANDLE)mMappingHandle);
+        mMappingHandle = NULL;
+        return false;
+    }
+    return true;
+}
+
+void LLMappedFile::unmap()
+{
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+        mData = nullptr;
+    }
+    if (mMappingHandle)
+    {
+        CloseHandle((HANDLE)mMappingHandle);
+        mMappingHandle = NULL;
+    }
+}
+
+void LLMappedFile::close()
+{
+    unmap();
+    if (mFileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle((HANDLE)mFileHandle);
+        mFileHandle = INVALID_HANDLE_VALUE;
+    }
+    mSize = 0;
+}
+
+void LLMappedFile::flush(bool sync)
+{
+    if (mData && mWritable)
+    {
+        FlushViewOfFile(mData, 0);
+        if (sync)
+        {
+            FlushFileBuffers((HANDLE)mFileHandle);
+        }
+    }
+}
+
+#else // LL_WINDOWS
+
+bool LLMappedFile::open(const std::string& filename, size_t min_size, bool writable)
+{
+    close();
+
+    mFilename = filename;
+    mWritable = writable;
+
+    int flags = writable ? (O_RDWR | O_CREAT) : O_RDONLY;
+    mFD = ::open(filename.c_str(), flags, 0644);
+    if (mFD == -1)
+    {
+        LL_DEBUGS("MappedFile") << "Could not open " << filename << " errno: " << errno << LL_ENDL;
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(mFD, &file_stat) != 0)
+    {
+        close();
+        return false;
+    }
+    mSize = (size_t)file_stat.st_size;
+
+    if (writable && mSize < min_size)
+    {
+        if (ftruncate(mFD, (off_t)min_size) != 0)
+        {
+            LL_WARNS("MappedFile") << "Could not grow " << filename << " to " << min_size << " bytes, errno: " << errno << LL_ENDL;
+            close();
+            return false;
+        }
+        mSize = min_size;
+    }
+
+    if (!map())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool LLMappedFile::map()
+{
+    if (!mSize)
+    {
+        return false;
+    }
+
+    int prot = mWritable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* data = ::mmap(NULL, mSize, prot, MAP_SHARED, mFD, 0);
+    if (data == MAP_FAILED)
+    {
+        LL_WARNS("MappedFile") << "mmap failed for " << mFilename << " errno: " << errno << LL_ENDL;
+        return false;
+    }
+    mData = (U8*)data;
+    return true;
+}
+
+void LLMappedFile::unmap()
+{
+    if (mData)
+    {
+        ::munmap(mData, mSize);
+        mData = nullptr;
+    }
+}
+
+void LLMappedFile::close()
+{
+    unmap();
+    if (mFD != -1)
+    {
+        ::close(mFD);
+        mFD = -1;
+    }
+    mSize = 0;
+}
+
+void LLMappedFile::flush(bool sync)
+{
+    if (mData && mWritable)
+    {
+        ::msync(mData, mSize, sync ? MS_SYNC : MS_ASYNC);
+    }
+}
+
+#endif // LL_WINDOWS
+
+bool LLMappedFile::resize(size_t new_size)
+{
+    if (!mWritable || !isOpen())
+    {
+        return false;
+    }
+    if (new_size <= mSize)
+    {
+        return true;
+    }
+
+    unmap();
+#if !LL_WINDOWS
+    if (ftruncate(mFD, (off_t)new_size) != 0)
+    {
+        LL_WARNS("MappedFile") << "Could not grow " << mFilename << " to " << new_size << " bytes, errno: " << errno << LL_ENDL;
+        // try to restore the previous mapping
+        map();
+        return false;
+    }
+#endif
+    size_t old_size = mSize;
+    mSize = new_size;
+    if (!map())
+    {
+        mSize = old_size;
+        map();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file llmappedfile.h
+ * @brief Memory-mapped view over a local cache file.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMAPPEDFILE_H
+#define LL_LLMAPPEDFILE_H
+
+#include <string>
+
+// Maps a whole file into the address space of the process.
+//
+// Cache files that are accessed at random offsets by several threads (the
+// texture cache entries, the object cache container...) used to go through
+// an open/seek/read/close cycle per access under a lock.  Once mapped, such
+// an access becomes a memcpy and the OS takes care of paging and write back.
+//
+// Not thread safe by itself: callers are expected to serialize open(),
+// resize() and close() against any access to getData().
+class LLMappedFile
+{
+public:
+    LLMappedFile();
+    ~LLMappedFile();
+
+    // Maps filename.  When writable, the file is created if missing and
+    // grown (zero filled) to at least min_size bytes.  When read only, the
+    // file must exist and is mapped at its current size.
+    bool open(const std::string& filename, size_t min_size, bool writable);
+    void close();
+
+    // Grows the file and remaps it.  Pointers previously obtained from
+    // getData() are invalidated.
+    bool resize(size_t new_size);
+
+    // Schedules dirty pages for write back; returns immediately unless sync.
+    void flush(bool sync = false);
+
+    bool isOpen() const         { return mData != nullptr; }
+    bool isWritable() const     { return mWritable; }
+    size_t getSize() const      { return mSize; }
+    U8* getData()               { return mData; }
+    const U8* getData() const   { return mData; }
+    const std::string& getFilename() const { return mFilename; }
+
+private:
+    bool map();
+    void unmap();
+
+private:
+    std::string mFilename;
+    U8*         mData;
+    size_t      mSize;
+    bool        mWritable;
+#if LL_WINDOWS
+    void*       mFileHandle;
+    void*       mMappingHandle;
+#else
+    int         mFD;
+#endif
+};
+
+#endif // LL_LLMAPPEDFILE_H
@@ -0,0 +1,221 @@
+/**
+ * @file llsegmentpack.cpp
+ * @brief Append only container of keyed segments over a mapped file.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llsegmentpack.h"
+#include "llfile.h"
+
+static const U32 PACK_MAGIC = 0x4b504c53; // "SLPK"
+static const U32 PACK_SEGMENT_MAGIC = 0x47534c53; // "SLSG"
+static const U64 PACK_MIN_GROWTH = 1024 * 1024;
+
+LLSegmentPack::LLSegmentPack()
+:   mVersion(0)
+{
+}
+
+LLSegmentPack::~LLSegmentPack()
+{
+    close();
+}
+
+bool LLSegmentPack::open(const std::string& filename, U32 version, bool writable)
+{
+    if (isOpen())
+    {
+        return true;
+    }
+    if (!writable && !LLFile::isfile(filename))
+    {
+        return false;
+    }
+    if (!mFile.open(filename, sizeof(MetaInfo), writable))
+    {
+        LL_WARNS() << "Could not map segment pack " << filename << LL_ENDL;
+        return false;
+    }
+    mVersion = version;
+
+    MetaInfo* meta = (MetaInfo*)mFile.getData();
+    if (meta->mMagic == 0 && mFile.isWritable())
+    {
+        // brand new, zero filled pack
+        meta->mMagic = PACK_MAGIC;
+        meta->mVersion = version;
+        meta->mEndOffset = sizeof(MetaInfo);
+    }
+
+    if (meta->mMagic != PACK_MAGIC
+        || meta->mVersion != version
+        || meta->mEndOffset < sizeof(MetaInfo)
+        || meta->mEndOffset > mFile.getSize())
+    {
+        LL_WARNS() << "Segment pack " << filename << " does not match the version or is corrupted" << LL_ENDL;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LLSegmentPack::close()
+{
+    mFile.flush();
+    mFile.close();
+}
+
+bool LLSegmentPack::append(U64 key, const U8* data, U32 size, U64& offset)
+{
+    if (!mFile.isOpen() || !mFile.isWritable())
+    {
+        return false;
+    }
+
+    U64 end = ((MetaInfo*)mFile.getData())->mEndOffset;
+    U64 needed = end + sizeof(SegmentHeader) + size;
+    if (needed > mFile.getSize())
+    {
+        // grow geometrically so that rewriting segments does not remap every time
+        U64 new_size = llmax(needed, (U64)mFile.getSize() + llmax((U64)mFile.getSize() / 2, PACK_MIN_GROWTH));
+        if (!mFile.resize((size_t)new_size))
+        {
+            LL_WARNS() << "Failed to grow segment pack to " << new_size << " bytes" << LL_ENDL;
+            return false;
+        }
+    }
+
+    SegmentHeader header;
+    header.mMagic = PACK_SEGMENT_MAGIC;
+    header.mSize = size;
+    header.mKey = key;
+
+    U8* base = mFile.getData();
+    memcpy(base + end, &header, sizeof(SegmentHeader));
+    memcpy(base + end + sizeof(SegmentHeader), data, size);
+    ((MetaInfo*)base)->mEndOffset = needed;
+
+    offset = end;
+    return true;
+}
+
+const U8* LLSegmentPack::get(U64 key, U64 offset, U32 size) const
+{
+    if (!size || !mFile.isOpen())
+    {
+        return NULL;
+    }
+
+    const U8* base = mFile.getData();
+    U64 end = ((const MetaInfo*)base)->mEndOffset;
+    if (offset < sizeof(MetaInfo) || offset + sizeof(SegmentHeader) + size > end)
+    {
+        return NULL;
+    }
+
+    SegmentHeader header;
+    memcpy(&header, base + offset, sizeof(SegmentHeader));
+    if (header.mMagic != PACK_SEGMENT_MAGIC || header.mSize != size || header.mKey != key)
+    {
+        return NULL;
+    }
+    return base + offset + sizeof(SegmentHeader);
+}
+
+U64 LLSegmentPack::getUsedSize() const
+{
+    return mFile.isOpen() ? ((const MetaInfo*)mFile.getData())->mEndOffset : 0;
+}
+
+// static
+U64 LLSegmentPack::getPackedSize(const segment_list_t& live)
+{
+    U64 size = sizeof(MetaInfo);
+    for (const Segment& segment : live)
+    {
+        if (segment.mSize)
+        {
+            size += sizeof(SegmentHeader) + segment.mSize;
+        }
+    }
+    return size;
+}
+
+bool LLSegmentPack::compact(segment_list_t& live)
+{
+    if (!mFile.isOpen() || !mFile.isWritable())
+    {
+        return isOpen();
+    }
+
+    const std::string filename = mFile.getFilename();
+    std::string tmp_filename = filename + ".tmp";
+    LLFile::remove(tmp_filename, ENOENT);
+    LLMappedFile new_file;
+    if (!new_file.open(tmp_filename, (size_t)getPackedSize(live), true))
+    {
+        // keep going with the old one
+        return true;
+    }
+
+    U8* out = new_file.getData();
+    MetaInfo new_meta = *(const MetaInfo*)mFile.getData();
+    U64 out_offset = sizeof(MetaInfo);
+
+    // new offsets are only applied once the new pack replaced the old one
+    std::vector<U64> new_offsets(live.size(), 0);
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        const Segment& segment = live[i];
+        const U8* data = get(segment.mKey, segment.mOffset, segment.mSize);
+        if (data)
+        {
+            new_offsets[i] = out_offset;
+            memcpy(out + out_offset, data - sizeof(SegmentHeader), sizeof(SegmentHeader) + segment.mSize);
+            out_offset += sizeof(SegmentHeader) + segment.mSize;
+        }
+    }
+    new_meta.mEndOffset = out_offset;
+    memcpy(out, &new_meta, sizeof(MetaInfo));
+    new_file.flush(true);
+    new_file.close();
+
+    close();
+    LLFile::remove(filename);
+    if (LLFile::rename(tmp_filename, filename) != 0 || !open(filename, mVersion, true))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        live[i].mOffset = new_offsets[i];
+        if (!new_offsets[i])
+        {
+            live[i].mSize = 0;
+        }
+    }
+    return true;
+}
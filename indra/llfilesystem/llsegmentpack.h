@@ -0,0 +1,101 @@
+/**
+ * @file llsegmentpack.h
+ * @brief Append only container of keyed segments over a mapped file.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSEGMENTPACK_H
+#define LL_LLSEGMENTPACK_H
+
+#include <string>
+#include <vector>
+
+#include "llmappedfile.h"
+
+// A cache file made of segments appended one after the other, each tagged
+// with the key of whoever owns it (a region handle for the object cache).
+//
+// Owners keep track of where their segments are.  Rewriting an owner's
+// data appends a new segment and leaves the previous one dead until
+// compact() copies the segments still in use to a new file.
+//
+// Not thread safe: like LLMappedFile, callers serialize all access.
+class LLSegmentPack
+{
+public:
+    struct Segment
+    {
+        U64 mKey;
+        U64 mOffset;
+        U32 mSize;      // payload size, 0 for no segment
+    };
+    typedef std::vector<Segment> segment_list_t;
+
+    LLSegmentPack();
+    ~LLSegmentPack();
+
+    // Maps filename.  A writable pack is created if missing.  Fails if the
+    // pack was written with another version or is corrupted.
+    bool open(const std::string& filename, U32 version, bool writable);
+    void close();
+
+    bool isOpen() const         { return mFile.isOpen(); }
+
+    // Appends size bytes of data for key and returns its offset.
+    bool append(U64 key, const U8* data, U32 size, U64& offset);
+
+    // Payload of the segment at offset, or NULL if it is not a valid segment
+    // of size bytes for key.  Only valid until the next append() or compact().
+    const U8* get(U64 key, U64 offset, U32 size) const;
+
+    // Bytes taken by all segments, dead or alive.
+    U64 getUsedSize() const;
+
+    // Bytes the pack would take with only these segments in it.
+    static U64 getPackedSize(const segment_list_t& live);
+
+    // Rewrites the pack with only the live segments and updates their
+    // offsets.  Segments that are not valid are dropped and get a size of 0.
+    // When false is returned the pack could not be reopened and is closed.
+    bool compact(segment_list_t& live);
+
+private:
+    struct MetaInfo
+    {
+        U32 mMagic;
+        U32 mVersion;
+        U64 mEndOffset; // end of the last segment
+    };
+
+    struct SegmentHeader
+    {
+        U32 mMagic;
+        U32 mSize; // payload size, not counting this header
+        U64 mKey;
+    };
+
+    LLMappedFile mFile;
+    U32 mVersion;
+};
+
+#endif // LL_LLSEGMENTPACK_H
@@ -0,0 +1,153 @@
+/**
+ * @file lldiskcache_test.cpp
+ * @brief LLDiskCache index and purge tests
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llassettype.h"
+#include "../lldir.h"
+#include "../lldiskcache.h"
+
+#include "../test/lltut.h"
+#include <boost/filesystem.hpp>
+
+namespace tut
+{
+    // the cache is a param singleton that can only be initialized once
+    static const uintmax_t TEST_CACHE_MAX_SIZE = 1000;
+
+    struct LLDiskCacheFixture
+    {
+        LLDiskCacheFixture()
+        {
+            if (!LLDiskCache::instanceExists())
+            {
+                boost::filesystem::path dir = boost::filesystem::temp_directory_path() /
+                    boost::filesystem::unique_path("lldiskcache_test_%%%%%%%%");
+                LLDiskCache::initParamSingleton(dir.string(), TEST_CACHE_MAX_SIZE, false);
+            }
+            mCache = LLDiskCache::getInstance();
+            mCache->clearCache();
+        }
+
+        std::string writeFile(const std::string& id, size_t size)
+        {
+            std::string path = mCache->metaDataToFilepath(id, LLAssetType::AT_TEXTURE, "");
+            llofstream out(path, std::ios::binary);
+            out << std::string(size, 'x');
+            out.close();
+            mCache->notifyFileWritten(path, size);
+            return path;
+        }
+
+        uintmax_t indexedSize(const std::string& path)
+        {
+            uintmax_t size = 0;
+            return mCache->getFileSize(path, size) ? size : 0;
+        }
+
+        LLDiskCache* mCache;
+    };
+    typedef test_group<LLDiskCacheFixture> LLDiskCacheTest_factory;
+    typedef LLDiskCacheTest_factory::object LLDiskCacheTest_t;
+    LLDiskCacheTest_factory tf("LLDiskCache");
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<1>()
+    {
+        set_test_name("purge evicts least recently used files first");
+
+        std::string a = writeFile("a", 400);
+        std::string b = writeFile("b", 400);
+        std::string c = writeFile("c", 400);
+        // a becomes the most recently used file
+        mCache->updateFileAccessTime(a);
+
+        mCache->purge();
+
+        ensure("a kept", LLFile::isfile(a));
+        ensure("b purged", !LLFile::isfile(b));
+        ensure("c kept", LLFile::isfile(c));
+        ensure_equals("a indexed", indexedSize(a), 400u);
+        ensure_equals("b no longer indexed", indexedSize(b), 0u);
+    }
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<2>()
+    {
+        set_test_name("index follows writes, renames and removals");
+
+        std::string a = writeFile("a", 100);
+        ensure_equals("written", indexedSize(a), 100u);
+
+        mCache->notifyFileWritten(a, 300);
+        ensure_equals("rewritten", indexedSize(a), 300u);
+
+        std::string b = mCache->metaDataToFilepath("b", LLAssetType::AT_TEXTURE, "");
+        LLFile::rename(a, b);
+        mCache->notifyFileRenamed(a, b);
+        ensure_equals("old name gone", indexedSize(a), 0u);
+        ensure_equals("new name indexed", indexedSize(b), 300u);
+
+        LLFile::remove(b);
+        mCache->notifyFileRemoved(b);
+        uintmax_t size = 0;
+        ensure("removed", !mCache->getFileSize(b, size));
+    }
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<3>()
+    {
+        set_test_name("purge within budget keeps everything");
+
+        std::string a = writeFile("a", 200);
+        std::string b = writeFile("b", 200);
+
+        mCache->purge();
+
+        ensure("a kept", LLFile::isfile(a));
+        ensure("b kept", LLFile::isfile(b));
+    }
+
+    template<> template<>
+    void LLDiskCacheTest_t::test<4>()
+    {
+        set_test_name("files written behind the index are found on disk");
+
+        // as another viewer instance sharing the cache would leave them
+        std::string path = mCache->metaDataToFilepath("d", LLAssetType::AT_TEXTURE, "");
+        llofstream out(path, std::ios::binary);
+        out << std::string(250, 'x');
+        out.close();
+
+        ensure_equals("found", indexedSize(path), 250u);
+
+        // and purged like any other once adopted
+        writeFile("e", 400);
+        writeFile("f", 400);
+        mCache->purge();
+        ensure("d purged", !LLFile::isfile(path));
+        ensure_equals("d no longer indexed", indexedSize(path), 0u);
+    }
+}
@@ -0,0 +1,157 @@
+/**
+ * @file llsegmentpack_test.cpp
+ * @brief LLSegmentPack append, lookup and compaction tests
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llsegmentpack.h"
+#include "llfile.h"
+
+#include "../test/lltut.h"
+#include <boost/filesystem.hpp>
+
+namespace tut
+{
+    static const U32 TEST_PACK_VERSION = 3;
+
+    struct LLSegmentPackFixture
+    {
+        LLSegmentPackFixture()
+        {
+            boost::filesystem::path path = boost::filesystem::temp_directory_path() /
+                boost::filesystem::unique_path("llsegmentpack_test_%%%%%%%%");
+            mFilename = path.string();
+        }
+
+        ~LLSegmentPackFixture()
+        {
+            mPack.close();
+            LLFile::remove(mFilename, ENOENT);
+        }
+
+        LLSegmentPack::Segment write(U64 key, U8 fill, U32 size)
+        {
+            std::vector<U8> data(size, fill);
+            LLSegmentPack::Segment segment = { key, 0, size };
+            ensure("appended", mPack.append(key, data.data(), size, segment.mOffset));
+            return segment;
+        }
+
+        bool holds(const LLSegmentPack::Segment& segment, U8 fill)
+        {
+            const U8* data = mPack.get(segment.mKey, segment.mOffset, segment.mSize);
+            if (!data)
+            {
+                return false;
+            }
+            for (U32 i = 0; i < segment.mSize; ++i)
+            {
+                if (data[i] != fill)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::string mFilename;
+        LLSegmentPack mPack;
+    };
+    typedef test_group<LLSegmentPackFixture> LLSegmentPackTest_factory;
+    typedef LLSegmentPackTest_factory::object LLSegmentPackTest_t;
+    LLSegmentPackTest_factory tf("LLSegmentPack");
+
+    template<> template<>
+    void LLSegmentPackTest_t::test<1>()
+    {
+        set_test_name("segments are found by key, offset and size only");
+
+        ensure("created", mPack.open(mFilename, TEST_PACK_VERSION, true));
+        LLSegmentPack::Segment a = write(1, 0xaa, 100);
+        LLSegmentPack::Segment b = write(2, 0xbb, 5000);
+
+        ensure("a", holds(a, 0xaa));
+        ensure("b", holds(b, 0xbb));
+        ensure("wrong key", !mPack.get(2, a.mOffset, a.mSize));
+        ensure("wrong size", !mPack.get(1, a.mOffset, a.mSize + 1));
+        ensure("past the end", !mPack.get(2, b.mOffset + 1, b.mSize));
+        ensure("no segment", !mPack.get(1, 0, 0));
+    }
+
+    template<> template<>
+    void LLSegmentPackTest_t::test<2>()
+    {
+        set_test_name("segments survive reopening, other versions do not");
+
+        ensure("created", mPack.open(mFilename, TEST_PACK_VERSION, true));
+        LLSegmentPack::Segment a = write(1, 0xaa, 300);
+        mPack.close();
+
+        ensure("reopened read only", mPack.open(mFilename, TEST_PACK_VERSION, false));
+        ensure("a", holds(a, 0xaa));
+        U64 offset = 0;
+        ensure("read only", !mPack.append(1, (const U8*)"x", 1, offset));
+        mPack.close();
+
+        ensure("other version", !mPack.open(mFilename, TEST_PACK_VERSION + 1, true));
+        ensure("closed", !mPack.isOpen());
+    }
+
+    template<> template<>
+    void LLSegmentPackTest_t::test<3>()
+    {
+        set_test_name("compaction keeps only live segments");
+
+        ensure("created", mPack.open(mFilename, TEST_PACK_VERSION, true));
+
+        // rewrite two keys many times, as regions are when revisited
+        const U32 SIZE = 64 * 1024;
+        LLSegmentPack::segment_list_t live(2);
+        for (U8 i = 0; i < 128; ++i)
+        {
+            live[0] = write(1, i, SIZE);
+            live[1] = write(2, i + 1, SIZE / 2);
+        }
+        // and one that is no longer valid
+        live.push_back({ 3, live[0].mOffset, 10 });
+
+        U64 packed_size = LLSegmentPack::getPackedSize(live);
+        ensure("mostly dead", mPack.getUsedSize() > packed_size * 64);
+
+        ensure("compacted", mPack.compact(live));
+        ensure("live size", mPack.getUsedSize() < packed_size);
+        ensure("last 1 kept", holds(live[0], 127));
+        ensure("last 2 kept", holds(live[1], 128));
+        ensure_equals("invalid dropped", live[2].mSize, 0u);
+
+        llstat pack_stat;
+        ensure("pack exists", LLFile::stat(mFilename, &pack_stat) == 0);
+        ensure("file shrunk", (U64)pack_stat.st_size < packed_size * 2);
+
+        // and it can still grow
+        LLSegmentPack::Segment c = write(3, 0xcc, SIZE);
+        ensure("appended after", holds(c, 0xcc));
+        ensure("1 still there", holds(live[0], 127));
+    }
+}
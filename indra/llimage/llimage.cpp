@@ -1971,7 +1971,8 @@ LLImageFormatted::LLImageFormatted(S8 codec)
 	  mDecoding(0),
 	  mDecoded(0),
 	  mDiscardLevel(-1),
-	  mLevels(0)
+	  mLevels(0),
+	  mDecodeThreads(1)
 {
 }
 
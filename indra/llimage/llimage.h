@@ -342,6 +342,9 @@ public:
 	S8 getDiscardLevel() const { return mDiscardLevel; }
 	S8 getLevels() const { return mLevels; }
 	void setLevels(S8 nlevels) { mLevels = nlevels; }
+	// Threads a decoder may use within this one image, if it supports that
+	void setDecodeThreads(S32 threads) { mDecodeThreads = threads; }
+	S32 getDecodeThreads() const { return mDecodeThreads; }
 
 	// setLastError needs to be deferred for J2C images since it may be called from a DLL
 	virtual void resetLastError();
@@ -356,6 +359,7 @@ protected:
 	S8 mDecoded;  // unused, but changing LLImage layout requires recompiling static Mac/Linux libs. 2009-01-30 JC
 	S8 mDiscardLevel;	// Current resolution level worked on. 0 = full res, 1 = half res, 2 = quarter res, etc...
 	S8 mLevels;			// Number of resolution levels in that image. Min is 1. 0 means unknown.
+	S32 mDecodeThreads;
 	
 public:
 	static S32 sGlobalFormattedMemory;
@@ -30,13 +30,19 @@
 #include "llimagedxt.h"
 #include "threadpool.h"
 
+// Large images are decoded by several threads when decode workers are idle,
+// so that one big texture does not hold up the rest after a teleport.
+static const S32 MIN_PARALLEL_DECODE_PIXELS = 1024 * 1024;
+static const S32 MAX_THREADS_PER_DECODE = 4;
+
 /*--------------------------------------------------------------------------*/
 class ImageRequest
 {
 public:
 	ImageRequest(const LLPointer<LLImageFormatted>& image,
 				 S32 discard, BOOL needs_aux,
-				 const LLPointer<LLImageDecodeThread::Responder>& responder);
+				 const LLPointer<LLImageDecodeThread::Responder>& responder,
+				 LLImageDecodeThread* thread = NULL);
 	virtual ~ImageRequest();
 
 	/*virtual*/ bool processRequest();
@@ -55,6 +61,8 @@ private:
 	BOOL mDecodedRaw;
 	BOOL mDecodedAux;
 	LLPointer<LLImageDecodeThread::Responder> mResponder;
+	// pool this request runs on, if any, to borrow idle workers from
+	LLImageDecodeThread* mThread;
 };
 
 
@@ -63,7 +71,7 @@ private:
 // MAIN THREAD
 LLImageDecodeThread::LLImageDecodeThread(bool /*threaded*/)
 {
-    mThreadPool.reset(new LL::ThreadPool("ImageDecode", 8));
+    mThreadPool.reset(new LL::ThreadPoolUsing<LL::WorkPriorityQueue>("ImageDecode", 8));
     mThreadPool->start();
 }
 
@@ -88,28 +96,59 @@ LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(
     const LLPointer<LLImageFormatted>& image, 
     S32 discard,
     BOOL needs_aux,
-    const LLPointer<LLImageDecodeThread::Responder>& responder)
+    const LLPointer<LLImageDecodeThread::Responder>& responder,
+    F32 priority)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
 
     // Instantiate the ImageRequest right in the lambda, why not?
+    handle_t handle = 0;
     bool posted = mThreadPool->getQueue().post(
-        [req = ImageRequest(image, discard, needs_aux, responder)]
+        [this, req = ImageRequest(image, discard, needs_aux, responder, this)]
         () mutable
         {
+            ++mBusyThreads;
             auto done = req.processRequest();
+            --mBusyThreads;
             req.finishRequest(done);
-        });
+        },
+        priority, &handle);
     if (! posted)
     {
         LL_DEBUGS() << "Tried to start decoding on shutdown" << LL_ENDL;
-        // should this return 0?
     }
 
-    // It's important to our consumer (LLTextureFetchWorker) that we return a
-    // nonzero handle. It is NOT important that the nonzero handle be unique:
-    // nothing is ever done with it except to compare it to zero, or zero it.
-    return 17;
+    return handle;
+}
+
+S32 LLImageDecodeThread::reserveDecodeThreads()
+{
+    // Queued decodes will want the idle workers soon, leave them be.
+    // The calling worker is already counted in mBusyThreads.
+    S32 pending = (S32)getPending();
+    S32 busy = mBusyThreads;
+    S32 extra;
+    do
+    {
+        S32 idle = (S32)mThreadPool->getWidth() - busy - pending;
+        extra = llclamp(idle, 0, MAX_THREADS_PER_DECODE - 1);
+    } while (extra > 0 && !mBusyThreads.compare_exchange_weak(busy, busy + extra));
+    return 1 + extra;
+}
+
+void LLImageDecodeThread::releaseDecodeThreads(S32 threads)
+{
+    mBusyThreads -= threads - 1;
+}
+
+bool LLImageDecodeThread::setPriority(handle_t handle, F32 priority)
+{
+    return handle && mThreadPool->getQueue().setPriority(handle, priority);
+}
+
+bool LLImageDecodeThread::cancel(handle_t handle)
+{
+    return handle && mThreadPool->getQueue().cancel(handle);
 }
 
 void LLImageDecodeThread::shutdown()
@@ -125,13 +164,15 @@ LLImageDecodeThread::Responder::~Responder()
 
 ImageRequest::ImageRequest(const LLPointer<LLImageFormatted>& image, 
 							S32 discard, BOOL needs_aux,
-							const LLPointer<LLImageDecodeThread::Responder>& responder)
+							const LLPointer<LLImageDecodeThread::Responder>& responder,
+							LLImageDecodeThread* thread)
 	: mFormattedImage(image),
 	  mDiscardLevel(discard),
 	  mNeedsAux(needs_aux),
 	  mDecodedRaw(FALSE),
 	  mDecodedAux(FALSE),
-	  mResponder(responder)
+	  mResponder(responder),
+	  mThread(thread)
 {
 }
 
@@ -151,6 +192,7 @@ bool ImageRequest::processRequest()
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
 	const F32 decode_time_slice = 0.f; //disable time slicing
 	bool done = true;
+	S32 threads = 1;
 	if (!mDecodedRaw && mFormattedImage.notNull())
 	{
 		// Decode primary channels
@@ -173,6 +215,14 @@ bool ImageRequest::processRequest()
 											  mFormattedImage->getHeight(),
 											  mFormattedImage->getComponents());
 		}
+		// only big decodes are worth spreading over several threads
+		S32 discard = llmax(0, (S32)mFormattedImage->getDiscardLevel());
+		S32 pixels = (mFormattedImage->getWidth() >> discard) * (mFormattedImage->getHeight() >> discard);
+		if (mThread && pixels >= MIN_PARALLEL_DECODE_PIXELS)
+		{
+			threads = mThread->reserveDecodeThreads();
+		}
+		mFormattedImage->setDecodeThreads(threads);
 		done = mFormattedImage->decode(mDecodedImageRaw, decode_time_slice);
 		// some decoders are removing data when task is complete and there were errors
 		mDecodedRaw = done && mDecodedImageRaw->getData();
@@ -190,6 +240,10 @@ bool ImageRequest::processRequest()
 		mDecodedAux = done && mDecodedImageAux->getData();
 	}
 
+	if (threads > 1)
+	{
+		mThread->releaseDecodeThreads(threads);
+	}
 	return done;
 }
 
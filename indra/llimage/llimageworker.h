@@ -31,6 +31,8 @@
 #include "llpointer.h"
 #include "threadpool_fwd.h"
 
+#include <atomic>
+
 class LLImageDecodeThread
 {
 public:
@@ -46,20 +48,37 @@ public:
 	LLImageDecodeThread(bool threaded = true);
 	virtual ~LLImageDecodeThread();
 
-	// meant to resemble LLQueuedThread::handle_t
-	typedef U32 handle_t;
+	// meant to resemble LLQueuedThread::handle_t, 0 is never a valid handle
+	typedef LL::WorkPriorityQueue::Handle handle_t;
+	// decodes with a higher priority are started first
 	handle_t decodeImage(const LLPointer<LLImageFormatted>& image,
 						 S32 discard, BOOL needs_aux,
-						 const LLPointer<Responder>& responder);
+						 const LLPointer<Responder>& responder,
+						 F32 priority = 0.f);
+	// Only affect decodes that have not started yet, return false otherwise.
+	// A cancelled decode never calls its responder.
+	bool setPriority(handle_t handle, F32 priority);
+	bool cancel(handle_t handle);
 	size_t getPending();
 	size_t update(F32 max_time_ms);
 	void shutdown();
 
 private:
+	friend class ImageRequest;
+
+	// Called by a worker about to decode a large image.  Claims the
+	// workers that have nothing to do right now, up to a limit, and
+	// returns how many threads the decode may use, including its own.
+	S32 reserveDecodeThreads();
+	void releaseDecodeThreads(S32 threads);
+
+	// workers running a decode plus the extra threads those decodes
+	// claimed, declared first so it outlives the workers
+	std::atomic<S32> mBusyThreads{ 0 };
 	// As of SL-17483, LLImageDecodeThread is no longer itself an
 	// LLQueuedThread - instead this is the API by which we submit work to the
 	// "ImageDecode" ThreadPool.
-	std::unique_ptr<LL::ThreadPool> mThreadPool;
+	std::unique_ptr<LL::ThreadPoolUsing<LL::WorkPriorityQueue>> mThreadPool;
 };
 
 #endif
@@ -333,13 +333,22 @@ public:
         return true;
     }
 
-    bool decode(U8* data, U32 dataSize, U32* channels, U8 discard_level)
+    // Decodes components first_comp to first_comp + max_comps - 1 when
+    // first_comp is past the color components, all of them otherwise.
+    // With threads > 1, code blocks are decoded in parallel.
+    bool decode(U8* data, U32 dataSize, U32* channels, U8 discard_level,
+                S32 first_comp = 0, S32 max_comps = 0, S32 threads = 1)
     {
         parameters.flags &= ~OPJ_DPARAMETERS_DUMP_FLAG;
 
         decoder = opj_create_decompress(OPJ_CODEC_J2K);
         opj_setup_decoder(decoder, &parameters);
 
+        if (threads > 1 && opj_has_thread_support())
+        {
+            opj_codec_set_threads(decoder, threads);
+        }
+
         opj_set_info_handler(decoder, opj_info, this);
         opj_set_warning_handler(decoder, opj_warn, this);
         opj_set_error_handler(decoder, opj_error, this);
@@ -389,6 +398,23 @@ public:
             *channels = image->numcomps;
         }
 
+        // Skip the components nobody asked for, e.g. the color channels
+        // when only the aux channel is wanted.  Only safe past the first
+        // three, which a multi-component transform may combine.
+        if (first_comp >= 3 && (U32)first_comp < image->numcomps && max_comps > 0)
+        {
+            OPJ_UINT32 comps[4];
+            OPJ_UINT32 num_comps = llmin((U32)max_comps, image->numcomps - (U32)first_comp, (U32)(sizeof(comps) / sizeof(comps[0])));
+            for (OPJ_UINT32 i = 0; i < num_comps; ++i)
+            {
+                comps[i] = first_comp + i;
+            }
+            if (opj_set_decoded_components(decoder, num_comps, comps, OPJ_FALSE))
+            {
+                decoded_first_comp = first_comp;
+            }
+        }
+
         OPJ_BOOL decoded = opj_decode(decoder, stream, image);
 
         // count was zero.  The latter is just a sanity check before we
@@ -405,8 +431,11 @@ public:
     }
 
     opj_image_t* getImage() { return image; }
+    // Index of the image's first component in the original codestream
+    S32 getFirstComponent() const { return decoded_first_comp; }
 
 private:
+    S32                       decoded_first_comp = 0;
     opj_dparameters_t         parameters;
     opj_event_mgr_t           event_mgr;
     opj_image_t*              image = nullptr;
@@ -738,7 +767,8 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     U32 image_channels = 0;
     S32 data_size = base.getDataSize();
     S32 max_bytes = (base.getMaxBytes() ? base.getMaxBytes() : data_size);
-    bool decoded = decoder.decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel);
+    bool decoded = decoder.decode(base.getData(), max_bytes, &image_channels, base.mDiscardLevel,
+                                  first_channel, max_channel_count, base.getDecodeThreads());
 
     // set correct channel count early so failed decodes don't miss it...
     S32 channels = (S32)image_channels - first_channel;
@@ -779,7 +809,9 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     // first_channel is what channel to start copying from
     // dest is what channel to copy to.  first_channel comes from the
     // argument, dest always starts writing at channel zero.
-    for (S32 comp = first_channel, dest = 0; comp < first_channel + channels; comp++, dest++)
+    // When only some components were decoded the image starts with
+    // getFirstComponent().
+    for (S32 comp = first_channel - decoder.getFirstComponent(), dest = 0; dest < channels; comp++, dest++)
     {
         llassert(image->comps[comp].data);
         if (image->comps[comp].data)
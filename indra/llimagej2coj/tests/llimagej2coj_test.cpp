@@ -0,0 +1,229 @@
+/**
+ * @file llimagej2coj_test.cpp
+ * @brief Decode tests and benchmark for LLImageJ2COJ
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagej2c.h"
+#include "llimageworker.h"
+#include "llrand.h"
+#include "lltimer.h"
+#include "threadpool.h"
+
+#include <atomic>
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+    struct imagej2coj_data
+    {
+        imagej2coj_data()
+        {
+            LLImage::initClass();
+        }
+
+        ~imagej2coj_data()
+        {
+            LLImage::cleanupClass();
+        }
+
+        // Smooth gradients with some noise, closer to a photo than to a
+        // flat color so that decoding has real work to do
+        LLPointer<LLImageJ2C> encodeTestImage(S32 width, S32 height, S8 components)
+        {
+            LLPointer<LLImageRaw> raw = new LLImageRaw(width, height, components);
+            U8* data = raw->getData();
+            for (S32 y = 0; y < height; ++y)
+            {
+                for (S32 x = 0; x < width; ++x)
+                {
+                    for (S32 c = 0; c < components; ++c)
+                    {
+                        *data++ = (U8)((x * (c + 1) + y * (3 - c) + ll_rand(16)) & 0xff);
+                    }
+                }
+            }
+
+            LLPointer<LLImageJ2C> j2c = new LLImageJ2C();
+            ensure("encoded", j2c->encode(raw, 0.f));
+            return j2c;
+        }
+
+        // A fresh image with its own copy of the codestream, header parsed
+        LLPointer<LLImageJ2C> copy(const LLImageJ2C* encoded)
+        {
+            LLPointer<LLImageJ2C> j2c = new LLImageJ2C();
+            memcpy(j2c->allocateData(encoded->getDataSize()), encoded->getData(), encoded->getDataSize());
+            ensure("header", j2c->updateData());
+            return j2c;
+        }
+
+        // Decodes a copy of encoded the way LLImageDecodeThread does
+        LLPointer<LLImageRaw> decode(const LLImageJ2C* encoded, S32 discard, S32 threads = 1)
+        {
+            LLPointer<LLImageJ2C> j2c = copy(encoded);
+            j2c->setDiscardLevel(discard);
+            j2c->setDecodeThreads(threads);
+            LLPointer<LLImageRaw> raw = new LLImageRaw(j2c->getWidth(), j2c->getHeight(), j2c->getComponents());
+            if (!j2c->decode(raw, 0.f) || !raw->getData())
+            {
+                return NULL;
+            }
+            return raw;
+        }
+
+        bool same(const LLImageRaw* a, const LLImageRaw* b)
+        {
+            return a && b
+                && a->getWidth() == b->getWidth()
+                && a->getHeight() == b->getHeight()
+                && a->getComponents() == b->getComponents()
+                && !memcmp(a->getData(), b->getData(), a->getDataSize());
+        }
+    };
+    typedef test_group<imagej2coj_data> imagej2coj_test;
+    typedef imagej2coj_test::object imagej2coj_object;
+    tut::imagej2coj_test imagej2coj("LLImageJ2COJ");
+
+    template<> template<>
+    void imagej2coj_object::test<1>()
+    {
+        set_test_name("decodes at every discard level");
+
+        LLPointer<LLImageJ2C> encoded = encodeTestImage(256, 256, 3);
+        for (S32 discard = 0; discard < 4; ++discard)
+        {
+            LLPointer<LLImageRaw> raw = decode(encoded, discard);
+            ensure("decoded", raw.notNull());
+            ensure_equals("width", (S32)raw->getWidth(), 256 >> discard);
+            ensure_equals("height", (S32)raw->getHeight(), 256 >> discard);
+            ensure_equals("components", (S32)raw->getComponents(), 3);
+        }
+    }
+
+    template<> template<>
+    void imagej2coj_object::test<2>()
+    {
+        set_test_name("decode benchmark, serial and across pool workers");
+
+        // A teleport's worth of large textures, decoded one after the other
+        // and then spread over the workers of a pool the way the
+        // ImageDecode pool does it, one image per worker.
+        const S32 IMAGES = 16;
+        const size_t WORKERS = 4;
+        // every decode works from its own copy of the codestream
+        std::vector<LLPointer<LLImageJ2C> > encoded(IMAGES, encodeTestImage(1024, 1024, 4));
+
+        std::vector<LLPointer<LLImageRaw> > serial(IMAGES);
+        LLTimer timer;
+        for (S32 i = 0; i < IMAGES; ++i)
+        {
+            serial[i] = decode(encoded[i], 0);
+        }
+        const F64 serial_time = timer.getElapsedTimeAndResetF64();
+
+        LL::ThreadPool pool("ImageDecode", WORKERS);
+        pool.start();
+
+        std::vector<LLPointer<LLImageRaw> > pooled(IMAGES);
+        std::atomic<S32> remaining(IMAGES);
+        timer.reset();
+        for (S32 i = 0; i < IMAGES; ++i)
+        {
+            pool.getQueue().post(
+                [this, i, &encoded, &pooled, &remaining]()
+                {
+                    pooled[i] = decode(encoded[i], 0);
+                    --remaining;
+                });
+        }
+        while (remaining > 0)
+        {
+            ms_sleep(1);
+        }
+        const F64 pooled_time = timer.getElapsedTimeF64();
+        pool.close();
+
+        for (S32 i = 0; i < IMAGES; ++i)
+        {
+            ensure("serial decoded", serial[i].notNull());
+            ensure("same pixels", same(serial[i], pooled[i]));
+        }
+
+        LL_INFOS() << IMAGES << " 1024x1024 decodes. Serial: " << serial_time * 1000.0 / IMAGES
+                   << " ms each. On " << pool.getWidth() << " workers: " << pooled_time * 1000.0 / IMAGES
+                   << " ms each, " << (pooled_time > 0.0 ? serial_time / pooled_time : 0.0) << "x." << LL_ENDL;
+    }
+
+    // keeps the result of a decode run by LLImageDecodeThread
+    class DecodeResponder : public LLImageDecodeThread::Responder
+    {
+    public:
+        void completed(bool success, LLImageRaw* raw, LLImageRaw* aux) override
+        {
+            mRaw = success ? raw : NULL;
+            mDone = true;
+        }
+
+        LLPointer<LLImageRaw> mRaw;
+        std::atomic<bool> mDone{ false };
+    };
+
+    template<> template<>
+    void imagej2coj_object::test<3>()
+    {
+        set_test_name("decode benchmark, one large image on one thread and on idle workers");
+
+        // One 2048x2048 texture, alone in the ImageDecode pool so that the
+        // decode can borrow the idle workers for its code blocks.
+        LLPointer<LLImageJ2C> encoded = encodeTestImage(2048, 2048, 4);
+
+        LLTimer timer;
+        LLPointer<LLImageRaw> single = decode(encoded, 0);
+        const F64 single_time = timer.getElapsedTimeAndResetF64();
+
+        LLImageDecodeThread decode_thread;
+        LLPointer<DecodeResponder> responder = new DecodeResponder();
+        LLPointer<LLImageJ2C> j2c = copy(encoded);
+        timer.reset();
+        decode_thread.decodeImage(j2c, 0, FALSE, responder.get());
+        while (!responder->mDone)
+        {
+            ms_sleep(1);
+        }
+        const F64 parallel_time = timer.getElapsedTimeF64();
+        const S32 threads = j2c->getDecodeThreads();
+        decode_thread.shutdown();
+
+        ensure("decoded", single.notNull());
+        ensure("same pixels", same(single, responder->mRaw));
+        ensure("used idle workers", threads > 1);
+
+        LL_INFOS() << "2048x2048 decode. One thread: " << single_time * 1000.0
+                   << " ms. " << threads << " threads: " << parallel_time * 1000.0 << " ms, "
+                   << (parallel_time > 0.0 ? single_time / parallel_time : 0.0) << "x." << LL_ENDL;
+    }
+}
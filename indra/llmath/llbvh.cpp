@@ -0,0 +1,265 @@
+/**
+ * @file llbvh.cpp
+ * @brief Flattened bounding volume hierarchy over static element bounds
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llbvh.h"
+
+#include <algorithm>
+
+namespace
+{
+    // centroid bins a split is chosen from
+    const U32 SPLIT_BINS = 16;
+
+    // past this depth nodes are split at the median, which always halves
+    const U32 MEDIAN_SPLIT_DEPTH = LLLinearBVH::MAX_DEPTH - 32;
+
+    F32 half_area(const LLVector4a& min, const LLVector4a& max)
+    {
+        LLVector4a d;
+        d.setSub(max, min);
+        return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+    }
+
+    struct Bin
+    {
+        LLVector4a mMin;
+        LLVector4a mMax;
+        U32 mCount;
+    };
+}
+
+LLLinearBVH::LLLinearBVH()
+:   mDirty(false)
+{
+}
+
+void LLLinearBVH::clear()
+{
+    mNodes.clear();
+    mElements.clear();
+    mBounds.clear();
+    mDirty = false;
+}
+
+void LLLinearBVH::build(const LLVector4a* bounds, U32 count)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_OCTREE;
+
+    clear();
+    if (!count)
+    {
+        return;
+    }
+
+    // a binary tree with at most MAX_LEAF_ELEMENTS per leaf and no empty
+    // nodes has fewer than 2 * count nodes
+    mNodes.reserve(count * 2);
+    mElements.resize(count);
+    std::vector<LLVector4a> centers(count);
+    for (U32 i = 0; i < count; ++i)
+    {
+        mElements[i] = i;
+        centers[i].setAdd(bounds[i * 2], bounds[i * 2 + 1]);
+        centers[i].mul(0.5f);
+    }
+
+    // by element index while building, by tree order once done
+    mBounds.assign(bounds, bounds + count * 2);
+    buildNode(&centers[0], 0, count, 0);
+
+    std::vector<LLVector4a> sorted(count * 2);
+    for (U32 i = 0; i < count; ++i)
+    {
+        sorted[i * 2] = bounds[mElements[i] * 2];
+        sorted[i * 2 + 1] = bounds[mElements[i] * 2 + 1];
+    }
+    mBounds.swap(sorted);
+}
+
+U32 LLLinearBVH::buildNode(const LLVector4a* centers, U32 first, U32 count, U32 depth)
+{
+    U32 index = (U32) mNodes.size();
+    mNodes.push_back(Node());
+
+    LLVector4a min = mBounds[mElements[first] * 2];
+    LLVector4a max = mBounds[mElements[first] * 2 + 1];
+    LLVector4a center_min = centers[mElements[first]];
+    LLVector4a center_max = center_min;
+    for (U32 i = first + 1; i < first + count; ++i)
+    {
+        U32 e = mElements[i];
+        min.setMin(min, mBounds[e * 2]);
+        max.setMax(max, mBounds[e * 2 + 1]);
+        center_min.setMin(center_min, centers[e]);
+        center_max.setMax(center_max, centers[e]);
+    }
+
+    mNodes[index].mMin = min;
+    mNodes[index].mMax = max;
+    mNodes[index].mFirst = first;
+    mNodes[index].mCount = count;
+    mNodes[index].mRight = 0;
+
+    if (count <= MAX_LEAF_ELEMENTS)
+    {
+        return index;
+    }
+
+    // split across the widest spread of centers
+    LLVector4a spread;
+    spread.setSub(center_max, center_min);
+    U32 axis = 0;
+    if (spread[1] > spread[axis])
+    {
+        axis = 1;
+    }
+    if (spread[2] > spread[axis])
+    {
+        axis = 2;
+    }
+
+    U32* begin = &mElements[first];
+    U32* end = begin + count;
+    U32* mid = NULL;
+
+    if (spread[axis] > 0.f && depth < MEDIAN_SPLIT_DEPTH)
+    {
+        // binned surface area heuristic
+        const F32 offset = center_min[axis];
+        const F32 scale = (F32) SPLIT_BINS * 0.9999f / spread[axis];
+
+        Bin bins[SPLIT_BINS];
+        for (U32 b = 0; b < SPLIT_BINS; ++b)
+        {
+            bins[b].mCount = 0;
+        }
+        for (U32* e = begin; e != end; ++e)
+        {
+            Bin& bin = bins[(U32) ((centers[*e][axis] - offset) * scale)];
+            if (bin.mCount++)
+            {
+                bin.mMin.setMin(bin.mMin, mBounds[*e * 2]);
+                bin.mMax.setMax(bin.mMax, mBounds[*e * 2 + 1]);
+            }
+            else
+            {
+                bin.mMin = mBounds[*e * 2];
+                bin.mMax = mBounds[*e * 2 + 1];
+            }
+        }
+
+        // cost of everything right of each plane, swept from the right
+        F32 right_cost[SPLIT_BINS];
+        LLVector4a right_min, right_max;
+        U32 right_count = 0;
+        for (U32 b = SPLIT_BINS - 1; b > 0; --b)
+        {
+            if (bins[b].mCount)
+            {
+                if (right_count)
+                {
+                    right_min.setMin(right_min, bins[b].mMin);
+                    right_max.setMax(right_max, bins[b].mMax);
+                }
+                else
+                {
+                    right_min = bins[b].mMin;
+                    right_max = bins[b].mMax;
+                }
+                right_count += bins[b].mCount;
+            }
+            right_cost[b] = right_count ? half_area(right_min, right_max) * right_count : 0.f;
+        }
+
+        F32 best_cost = F32_MAX;
+        U32 best_plane = 0;
+        LLVector4a left_min, left_max;
+        U32 left_count = 0;
+        for (U32 b = 0; b < SPLIT_BINS - 1; ++b)
+        {
+            if (bins[b].mCount)
+            {
+                if (left_count)
+                {
+                    left_min.setMin(left_min, bins[b].mMin);
+                    left_max.setMax(left_max, bins[b].mMax);
+                }
+                else
+                {
+                    left_min = bins[b].mMin;
+                    left_max = bins[b].mMax;
+                }
+                left_count += bins[b].mCount;
+            }
+            if (left_count && left_count < count)
+            {
+                F32 cost = half_area(left_min, left_max) * left_count + right_cost[b + 1];
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_plane = b;
+                }
+            }
+        }
+
+        if (best_cost < F32_MAX)
+        {
+            mid = std::partition(begin, end, [&](U32 e)
+                {
+                    return (U32) ((centers[e][axis] - offset) * scale) <= best_plane;
+                });
+        }
+    }
+
+    if (!mid || mid == begin || mid == end)
+    {
+        mid = begin + count / 2;
+        std::nth_element(begin, mid, end, [&](U32 a, U32 b)
+            {
+                return centers[a][axis] < centers[b][axis];
+            });
+    }
+
+    U32 left_count = (U32) (mid - begin);
+    buildNode(centers, first, left_count, depth + 1);
+    U32 right = buildNode(centers, first + left_count, count - left_count, depth + 1);
+    mNodes[index].mRight = right;
+    return index;
+}
+
+void LLLinearBVH::traverse(Traveler& traveler) const
+{
+    cull([&traveler](const LLVector4a& center, const LLVector4a& size)
+        {
+            return traveler.check(center, size);
+        },
+        [&traveler](U32 element)
+        {
+            traveler.visit(element);
+        });
+}
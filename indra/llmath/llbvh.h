@@ -0,0 +1,391 @@
+/**
+ * @file llbvh.h
+ * @brief Flattened bounding volume hierarchy over static element bounds
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLBVH_H
+#define LL_LLBVH_H
+
+#include "llmath.h"
+#include "llvector4a.h"
+
+#include <vector>
+
+// Bounding volume hierarchy kept as one array of nodes in depth first
+// order, for content that is queried far more often than it moves. Unlike
+// LLOctreeNode there are no per-node element lists, listeners or pointers:
+// a node is its box and a range of the element array, the left child is
+// the next node, and every subtree's elements are contiguous, so a node
+// found wholly inside a cull hands over its whole range at once.
+//
+// Elements are referred to by their index in the bounds given to build().
+// The tree doesn't follow elements around; when one moves the owner calls
+// setDirty() and rebuilds before the next query.
+class LLLinearBVH
+{
+public:
+    // most elements a leaf is left holding
+    static constexpr U32 MAX_LEAF_ELEMENTS = 4;
+    // deepest a build goes, which bounds the traversal stacks
+    static constexpr U32 MAX_DEPTH = 96;
+
+    // Same contract as LLOctreeTraveler for culls: check() gets node and
+    // element boxes as center and half size and returns 0 for outside,
+    // 1 for partly inside and 2 for wholly inside, like
+    // LLCamera::AABBInFrustum(). visit() is called for every element found
+    // inside.
+    class Traveler
+    {
+    public:
+        virtual ~Traveler() {}
+        virtual S32 check(const LLVector4a& center, const LLVector4a& size) = 0;
+        virtual void visit(U32 element) = 0;
+    };
+
+    LLLinearBVH();
+
+    // bounds[i * 2] and bounds[i * 2 + 1] are the min and max of element i
+    void build(const LLVector4a* bounds, U32 count);
+    void clear();
+
+    void setDirty()             { mDirty = true; }
+    bool isDirty() const        { return mDirty; }
+    bool isEmpty() const        { return mNodes.empty(); }
+    U32 getNodeCount() const    { return (U32) mNodes.size(); }
+    U32 getElementCount() const { return (U32) mElements.size(); }
+
+    void traverse(Traveler& traveler) const;
+
+    // check(center, size) and visit(element) as in Traveler
+    template <typename CHECK, typename VISIT>
+    void cull(CHECK&& check, VISIT&& visit) const;
+
+    // Calls visit(element, closest) for every element whose box the
+    // segment from start to end crosses, nearest nodes first. closest is
+    // the fraction of the segment still being searched, starting at 1;
+    // visit() lowers it on a hit so nothing further away is looked at.
+    template <typename VISIT>
+    void raycast(const LLVector4a& start, const LLVector4a& end, VISIT&& visit) const;
+
+    // raycast() for up to 4 segments at once, one per SIMD lane: nodes are
+    // tested against all of them together and opened while any of them
+    // still crosses. visit(slot, closest, lanes) gets the position of an
+    // element in tree order (see getElement()), so data the caller keeps
+    // in that order is read front to back, closest as one lane per segment
+    // (segments past count start out at -1 and never cross anything), and
+    // the mask of segments crossing the leaf. closest comes in as how far
+    // along each segment to look (1 for all of it) and goes out as what
+    // visit() lowered it to.
+    template <typename VISIT>
+    void raycast4(const LLVector4a* start, const LLVector4a* end, U32 count, LLVector4a& closest, VISIT&& visit) const;
+
+    // element at a position in tree order, 0 to getElementCount() - 1
+    U32 getElement(U32 slot) const { return mElements[slot]; }
+
+private:
+    LL_ALIGN_PREFIX(16)
+    struct Node
+    {
+        LLVector4a mMin;
+        LLVector4a mMax;
+        U32 mFirst;  // first of this subtree's entries in mElements
+        U32 mCount;
+        U32 mRight;  // index of the right child, 0 for a leaf
+    } LL_ALIGN_POSTFIX(16);
+
+    U32 buildNode(const LLVector4a* centers, U32 first, U32 count, U32 depth);
+
+    static bool intersect(const LLVector4a& min, const LLVector4a& max, const LLVector4a& start,
+                          const LLVector4a& inv_dir, F32 closest, F32& enter);
+    static U32 countLanes(U32 lanes) { return (lanes & 1) + ((lanes >> 1) & 1) + ((lanes >> 2) & 1) + (lanes >> 3); }
+    // slab test of a box against 4 segments given as x, y, z of their
+    // starts and inverse directions, returns the mask of those crossing
+    static U32 intersect4(const LLVector4a& min, const LLVector4a& max, const LLVector4a* start,
+                          const LLVector4a* inv_dir, const LLVector4a& closest, LLVector4a& enter);
+
+    std::vector<Node> mNodes;
+    std::vector<U32> mElements;
+    // min, max of each entry of mElements, in the same order
+    std::vector<LLVector4a> mBounds;
+    bool mDirty;
+};
+
+inline bool LLLinearBVH::intersect(const LLVector4a& min, const LLVector4a& max, const LLVector4a& start,
+                                   const LLVector4a& inv_dir, F32 closest, F32& enter)
+{
+    // slab test
+    LLVector4a t0, t1;
+    t0.setSub(min, start);
+    t0.mul(inv_dir);
+    t1.setSub(max, start);
+    t1.mul(inv_dir);
+
+    LLVector4a near_t, far_t;
+    near_t.setMin(t0, t1);
+    far_t.setMax(t0, t1);
+
+    const F32* n = near_t.getF32ptr();
+    const F32* f = far_t.getF32ptr();
+    enter = llmax(llmax(n[0], n[1]), llmax(n[2], 0.f));
+    F32 exit = llmin(llmin(f[0], f[1]), llmin(f[2], closest));
+    return enter <= exit;
+}
+
+inline U32 LLLinearBVH::intersect4(const LLVector4a& min, const LLVector4a& max, const LLVector4a* start,
+                                   const LLVector4a* inv_dir, const LLVector4a& closest, LLVector4a& enter)
+{
+    LLVector4a near_t, far_t;
+    near_t.clear();
+    far_t = closest;
+    for (U32 axis = 0; axis < 3; ++axis)
+    {
+        LLVector4a lo, hi;
+        lo.splat(min, axis);
+        hi.splat(max, axis);
+        lo.sub(start[axis]);
+        lo.mul(inv_dir[axis]);
+        hi.sub(start[axis]);
+        hi.mul(inv_dir[axis]);
+
+        LLVector4a t0, t1;
+        t0.setMin(lo, hi);
+        t1.setMax(lo, hi);
+        near_t.setMax(near_t, t0);
+        far_t.setMin(far_t, t1);
+    }
+    enter = near_t;
+    return near_t.lessEqual(far_t).getGatheredBits();
+}
+
+template <typename CHECK, typename VISIT>
+void LLLinearBVH::cull(CHECK&& check, VISIT&& visit) const
+{
+    if (mNodes.empty())
+    {
+        return;
+    }
+
+    U32 stack[MAX_DEPTH + 2];
+    U32 depth = 0;
+    stack[depth++] = 0;
+
+    LLVector4a center, size;
+    while (depth)
+    {
+        const Node& node = mNodes[stack[--depth]];
+        center.setAdd(node.mMin, node.mMax);
+        center.mul(0.5f);
+        size.setSub(node.mMax, node.mMin);
+        size.mul(0.5f);
+
+        S32 res = check(center, size);
+        if (res == 2)
+        {
+            for (U32 i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+            {
+                visit(mElements[i]);
+            }
+        }
+        else if (res && node.mRight)
+        {
+            stack[depth++] = node.mRight;
+            stack[depth++] = (U32) (&node - &mNodes[0]) + 1;
+        }
+        else if (res)
+        {
+            for (U32 i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+            {
+                const LLVector4a* bounds = &mBounds[i * 2];
+                center.setAdd(bounds[0], bounds[1]);
+                center.mul(0.5f);
+                size.setSub(bounds[1], bounds[0]);
+                size.mul(0.5f);
+                if (check(center, size))
+                {
+                    visit(mElements[i]);
+                }
+            }
+        }
+    }
+}
+
+template <typename VISIT>
+void LLLinearBVH::raycast(const LLVector4a& start, const LLVector4a& end, VISIT&& visit) const
+{
+    if (mNodes.empty())
+    {
+        return;
+    }
+
+    LLVector4a dir;
+    dir.setSub(end, start);
+    LLVector4a inv_dir;
+    for (U32 i = 0; i < 4; ++i)
+    {
+        // keep axis aligned segments away from 0 * inf
+        F32 d = dir[i];
+        inv_dir.getF32ptr()[i] = 1.f / (fabsf(d) > 1.e-20f ? d : (d < 0.f ? -1.e-20f : 1.e-20f));
+    }
+
+    F32 closest = 1.f;
+    F32 enter;
+    if (!intersect(mNodes[0].mMin, mNodes[0].mMax, start, inv_dir, closest, enter))
+    {
+        return;
+    }
+
+    U32 stack[MAX_DEPTH + 2];
+    U32 depth = 0;
+    stack[depth++] = 0;
+
+    while (depth)
+    {
+        U32 index = stack[--depth];
+        const Node& node = mNodes[index];
+        if (!intersect(node.mMin, node.mMax, start, inv_dir, closest, enter))
+        {
+            // closest came in since this was pushed
+            continue;
+        }
+
+        if (!node.mRight)
+        {
+            for (U32 i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+            {
+                if (intersect(mBounds[i * 2], mBounds[i * 2 + 1], start, inv_dir, closest, enter))
+                {
+                    visit(mElements[i], closest);
+                }
+            }
+            continue;
+        }
+
+        U32 left = index + 1;
+        U32 right = node.mRight;
+        F32 left_enter, right_enter;
+        bool hit_left = intersect(mNodes[left].mMin, mNodes[left].mMax, start, inv_dir, closest, left_enter);
+        bool hit_right = intersect(mNodes[right].mMin, mNodes[right].mMax, start, inv_dir, closest, right_enter);
+        if (hit_left && hit_right)
+        {
+            // nearer child on top
+            if (left_enter > right_enter)
+            {
+                std::swap(left, right);
+            }
+            stack[depth++] = right;
+            stack[depth++] = left;
+        }
+        else if (hit_left)
+        {
+            stack[depth++] = left;
+        }
+        else if (hit_right)
+        {
+            stack[depth++] = right;
+        }
+    }
+}
+
+template <typename VISIT>
+void LLLinearBVH::raycast4(const LLVector4a* start, const LLVector4a* end, U32 count, LLVector4a& closest, VISIT&& visit) const
+{
+    if (mNodes.empty() || !count)
+    {
+        return;
+    }
+    count = llmin(count, 4U);
+
+    // segments across the lanes
+    LLVector4a origin[3];
+    LLVector4a inv_dir[3];
+    for (U32 lane = 0; lane < 4; ++lane)
+    {
+        const U32 i = llmin(lane, count - 1);
+        LLVector4a dir;
+        dir.setSub(end[i], start[i]);
+        for (U32 axis = 0; axis < 3; ++axis)
+        {
+            F32 d = dir[axis];
+            origin[axis].getF32ptr()[lane] = start[i][axis];
+            inv_dir[axis].getF32ptr()[lane] = 1.f / (fabsf(d) > 1.e-20f ? d : (d < 0.f ? -1.e-20f : 1.e-20f));
+        }
+        if (lane >= count)
+        {
+            closest.getF32ptr()[lane] = -1.f;
+        }
+    }
+
+    U32 stack[MAX_DEPTH + 2];
+    U32 depth = 0;
+    stack[depth++] = 0;
+
+    LLVector4a enter;
+    while (depth)
+    {
+        U32 index = stack[--depth];
+        const Node& node = mNodes[index];
+        U32 lanes = intersect4(node.mMin, node.mMax, origin, inv_dir, closest, enter);
+        if (!lanes)
+        {
+            continue;
+        }
+
+        if (!node.mRight)
+        {
+            for (U32 i = node.mFirst; i < node.mFirst + node.mCount; ++i)
+            {
+                visit(i, closest, lanes);
+            }
+            continue;
+        }
+
+        U32 left = index + 1;
+        U32 right = node.mRight;
+        LLVector4a left_enter, right_enter;
+        U32 left_lanes = intersect4(mNodes[left].mMin, mNodes[left].mMax, origin, inv_dir, closest, left_enter);
+        U32 right_lanes = intersect4(mNodes[right].mMin, mNodes[right].mMax, origin, inv_dir, closest, right_enter);
+        if (left_lanes && right_lanes)
+        {
+            // nearer child for most of the segments on top
+            U32 right_first = right_enter.lessThan(left_enter).getGatheredBits() & left_lanes & right_lanes;
+            U32 left_first = left_enter.lessThan(right_enter).getGatheredBits() & left_lanes & right_lanes;
+            if (countLanes(right_first) > countLanes(left_first))
+            {
+                std::swap(left, right);
+            }
+            stack[depth++] = right;
+            stack[depth++] = left;
+        }
+        else if (left_lanes)
+        {
+            stack[depth++] = left;
+        }
+        else if (right_lanes)
+        {
+            stack[depth++] = right;
+        }
+    }
+}
+
+#endif // LL_LLBVH_H
@@ -45,6 +45,7 @@
 #include "llmatrix3a.h"
 #include "lloctree.h"
 #include "llvolume.h"
+#include "llvolumearena.h"
 #include "llvolumeoctree.h"
 #include "llstl.h"
 #include "llsdserialize.h"
@@ -2440,11 +2441,10 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 				continue;
 			}
 
-			LLSD::Binary pos = mdl[i]["Position"];
-			LLSD::Binary norm = mdl[i]["Normal"];
-            LLSD::Binary tangent = mdl[i]["Tangent"];
-			LLSD::Binary tc = mdl[i]["TexCoord0"];
-			LLSD::Binary idx = mdl[i]["TriangleList"];
+			const LLSD::Binary& pos = mdl[i]["Position"].asBinary();
+			const LLSD::Binary& norm = mdl[i]["Normal"].asBinary();
+			const LLSD::Binary& tc = mdl[i]["TexCoord0"].asBinary();
+			const LLSD::Binary& idx = mdl[i]["TriangleList"].asBinary();
 
 			//copy out indices
             S32 num_indices = idx.size() / 2;
@@ -2562,6 +2562,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 
 #if 0 // keep this code for now in case we decide to add support for on-the-wire tangents
             {
+                const LLSD::Binary& tangent = mdl[i]["Tangent"].asBinary();
                 if (!tangent.empty())
                 {
                     face.allocateTangents(face.mNumVertices);
@@ -2633,7 +2634,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     continue;
                 }
 
-				LLSD::Binary weights = mdl[i]["Weights"];
+				const LLSD::Binary& weights = mdl[i]["Weights"].asBinary();
 
 				U32 idx = 0;
 
@@ -4249,6 +4250,86 @@ S32 LLVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& en
 	return hit_face;
 }
 
+void LLVolume::lineSegmentIntersect(const LLVector4a* start, const LLVector4a* end, U32 count,
+									S32 face, S32* hit_face, LLVector4a* intersection)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+	if (isUnique())
+	{ //flexi volumes move every frame, not worth a tree
+		for (U32 i = 0; i < count; ++i)
+		{
+			hit_face[i] = lineSegmentIntersect(start[i], end[i], face, intersection ? &intersection[i] : NULL);
+		}
+		return;
+	}
+
+	S32 start_face = face == -1 ? 0 : face;
+	S32 end_face = face == -1 ? getNumVolumeFaces() - 1 : llmin(face, getNumVolumeFaces() - 1);
+
+	const U32 PACKET_SIZE = LLVolumeTriangleBVH::PACKET_SIZE;
+	for (U32 first = 0; first < count; first += PACKET_SIZE)
+	{
+		const U32 packet = llmin(count - first, PACKET_SIZE);
+		LLVolumeTriangleBVH::Hit hits[PACKET_SIZE];
+		for (U32 i = 0; i < packet; ++i)
+		{
+			hits[i].mT = 1.f;
+			hit_face[first + i] = -1;
+		}
+
+		for (S32 f = start_face; f <= end_face; ++f)
+		{
+			LLVolumeFace& vol_face = mVolumeFaces[f];
+
+			LLVector4a box_center;
+			box_center.setAdd(vol_face.mExtents[0], vol_face.mExtents[1]);
+			box_center.mul(0.5f);
+
+			LLVector4a box_size;
+			box_size.setSub(vol_face.mExtents[1], vol_face.mExtents[0]);
+
+			bool crossed = false;
+			for (U32 i = 0; i < packet && !crossed; ++i)
+			{
+				crossed = LLLineSegmentBoxIntersect(start[first + i], end[first + i], box_center, box_size);
+			}
+			if (!crossed)
+			{
+				continue;
+			}
+
+			if (!vol_face.getTriangleBVH())
+			{
+				vol_face.createTriangleBVH();
+			}
+
+			U32 found = vol_face.getTriangleBVH()->intersect(start + first, end + first, packet, hits);
+			for (U32 i = 0; i < packet; ++i)
+			{
+				if (found & (1 << i))
+				{
+					hit_face[first + i] = f;
+				}
+			}
+		}
+
+		if (intersection)
+		{
+			for (U32 i = 0; i < packet; ++i)
+			{
+				if (hit_face[first + i] != -1)
+				{
+					LLVector4a& point = intersection[first + i];
+					point.setSub(end[first + i], start[first + i]);
+					point.mul(hits[i].mT);
+					point.add(start[first + i]);
+				}
+			}
+		}
+	}
+}
+
 class LLVertexIndexPair
 {
 public:
@@ -4792,6 +4873,7 @@ LLVolumeFace::LLVolumeFace() :
     mWeightsScrubbed(FALSE),
 	mOctree(NULL),
     mOctreeTriangles(NULL),
+    mTriangleBVH(NULL),
 	mOptimized(FALSE)
 {
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
@@ -4822,7 +4904,8 @@ LLVolumeFace::LLVolumeFace(const LLVolumeFace& src)
 #endif
     mWeightsScrubbed(FALSE),
     mOctree(NULL),
-    mOctreeTriangles(NULL)
+    mOctreeTriangles(NULL),
+    mTriangleBVH(NULL)
 {
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
 	mCenter = mExtents+2;
@@ -5449,16 +5532,20 @@ public:
 	}
 };
 
-// data structures for tangent generation
+// data structures for tangent generation, the unwelded streams live in the
+// thread's volume arena and must not outlive the caller's scope
 
 struct MikktData
 {
+    template <typename T>
+    using arena_vector = std::vector<T, LLVolumeArena::Allocator<T> >;
+
     LLVolumeFace* face;
-    std::vector<LLVector3> p;
-    std::vector<LLVector3> n;
-    std::vector<LLVector2> tc;
-    std::vector<LLVector4> w;
-    std::vector<LLVector4> t;
+    arena_vector<LLVector3> p;
+    arena_vector<LLVector3> n;
+    arena_vector<LLVector2> tc;
+    arena_vector<LLVector4> w;
+    arena_vector<LLVector4> t;
 
     MikktData(LLVolumeFace* f)
         : face(f)
@@ -5516,6 +5603,10 @@ bool LLVolumeFace::cacheOptimize(bool gen_tangents)
 	llassert(!mOptimized);
 	mOptimized = TRUE;
 
+    // all temporaries below come from this thread's volume arena
+    LLVolumeArena::Scope scratch;
+    LLVolumeArena& arena = LLVolumeArena::instance();
+
     if (gen_tangents && mNormals && mTexCoords)
     { // generate mikkt space tangents before cache optimizing since the index buffer may change
         // a bit of a hack to do this here, but this function gets called exactly once for the lifetime of a mesh
@@ -5587,18 +5678,14 @@ bool LLVolumeFace::cacheOptimize(bool gen_tangents)
             { data.w.empty() ? nullptr : &data.w[0], sizeof(LLVector4), sizeof(LLVector4) }
         };
 
-        std::vector<U32> remap;
-        remap.resize(data.p.size());
+        U32* remap = arena.allocate<U32>(data.p.size());
 
         U32 stream_count = data.w.empty() ? 4 : 5;
 
-        U32 vert_count = meshopt_generateVertexRemapMulti(&remap[0], nullptr, data.p.size(), data.p.size(), mos, stream_count);
+        U32 vert_count = meshopt_generateVertexRemapMulti(remap, nullptr, data.p.size(), data.p.size(), mos, stream_count);
 
         if (vert_count < 65535)
         {
-            std::vector<U32> indices;
-            indices.resize(mNumIndices);
-
             //copy results back into volume
             resizeVertices(vert_count);
 
@@ -5653,14 +5740,12 @@ bool LLVolumeFace::cacheOptimize(bool gen_tangents)
 
     // cache optimize index buffer
 
-    // meshopt needs scratch space, do some pointer shuffling to avoid an extra index buffer copy
-    U16* src_indices = mIndices;
-    mIndices = nullptr;
-    resizeIndices(mNumIndices);
+    // meshopt needs the source indices apart from the destination, optimize from
+    // a scratch copy rather than reallocating the face's index buffer
+    U16* src_indices = arena.allocate<U16>(mNumIndices);
+    memcpy(src_indices, mIndices, mNumIndices * sizeof(U16));
 
     meshopt_optimizeVertexCache<U16>(mIndices, src_indices, mNumIndices, mNumVertices);
-    
-    ll_aligned_free_16(src_indices);
 
 	return true;
 }
@@ -5748,6 +5833,14 @@ void LLVolumeFace::destroyOctree()
     mOctree = NULL;
     delete[] mOctreeTriangles;
     mOctreeTriangles = NULL;
+    delete mTriangleBVH;
+    mTriangleBVH = NULL;
+}
+
+void LLVolumeFace::createTriangleBVH()
+{
+    delete mTriangleBVH;
+    mTriangleBVH = new LLVolumeTriangleBVH(*this);
 }
 
 const LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* LLVolumeFace::getOctree() const
@@ -7200,9 +7293,8 @@ void CalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVe
 {
 	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
 
-    //LLVector4a *tan1 = new LLVector4a[vertexCount * 2];
-	LLVector4a* tan1 = (LLVector4a*) ll_aligned_malloc_16(vertexCount*2*sizeof(LLVector4a));
-	// new(tan1) LLVector4a;
+    LLVolumeArena::Scope scratch;
+	LLVector4a* tan1 = LLVolumeArena::instance().allocate<LLVector4a>(vertexCount * 2);
 
     LLVector4a* tan2 = tan1 + vertexCount;
 
@@ -7295,8 +7387,6 @@ void CalculateTangentArray(U32 vertexCount, const LLVector4a *vertex, const LLVe
 			tangent[a].set(0,0,1,1);
 		}
     }
-    
-	ll_aligned_free_16(tan1);
 }
 
 
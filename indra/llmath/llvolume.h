@@ -41,6 +41,7 @@ template <class T, typename T_PTR> class LLOctreeNode;
 class LLVolumeFace;
 class LLVolume;
 class LLVolumeTriangle;
+class LLVolumeTriangleBVH;
 
 #include "lluuid.h"
 #include "v4color.h"
@@ -915,6 +916,11 @@ public:
     // Get a reference to the octree, which may be null
     const LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* getOctree() const;
 
+    // Triangles in a flat hierarchy for tracing segments in packets of 4,
+    // see LLVolume::lineSegmentIntersect(). Freed with the octree.
+    void createTriangleBVH();
+    const LLVolumeTriangleBVH* getTriangleBVH() const { return mTriangleBVH; }
+
 	enum
 	{
 		SINGLE_MASK =	0x0001,
@@ -989,6 +995,7 @@ public:
 private:
     LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* mOctree;
     LLVolumeTriangle* mOctreeTriangles;
+    LLVolumeTriangleBVH* mTriangleBVH;
 
 	BOOL createUnCutCubeCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createCap(LLVolume* volume, BOOL partial_build = FALSE);
@@ -1067,6 +1074,13 @@ public:
 							 LLVector4a* tangent = NULL             // return the surface tangent at the intersection point
 		);
 
+	// As above for count segments at once, traced in packets of 4 against
+	// each face's triangle BVH. Sets hit_face[i] to the face segment i hits
+	// first or -1, and intersection[i] to where. No texture coordinates,
+	// normals or tangents; trace the segments that need them singly.
+	void lineSegmentIntersect(const LLVector4a* start, const LLVector4a* end, U32 count,
+							  S32 face, S32* hit_face, LLVector4a* intersection = NULL);
+
 	LLFaceID generateFaceMask();
 
 	BOOL isFaceMaskValid(LLFaceID face_mask);
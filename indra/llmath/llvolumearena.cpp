@@ -0,0 +1,128 @@
+/**
+ * @file llvolumearena.cpp
+ * @brief Per-thread scratch memory for volume face construction.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llvolumearena.h"
+
+#include "llmemory.h"
+
+#include <new>
+
+// static
+LLVolumeArena& LLVolumeArena::instance()
+{
+    static thread_local LLVolumeArena sArena;
+    return sArena;
+}
+
+LLVolumeArena::LLVolumeArena()
+    : mBlock(0),
+      mUsed(0),
+      mScopeDepth(0),
+      mHeapAllocations(0),
+      mReserved(0)
+{
+}
+
+LLVolumeArena::~LLVolumeArena()
+{
+    llassert(mScopeDepth == 0);
+    for (const Block& block : mBlocks)
+    {
+        ll_aligned_free<ALIGNMENT>(block.mData);
+    }
+}
+
+void* LLVolumeArena::allocate(size_t size)
+{
+    llassert(mScopeDepth > 0); // nothing would ever give this memory back
+
+    size = llmax((size + ALIGNMENT - 1) & ~(ALIGNMENT - 1), (size_t) ALIGNMENT);
+
+    // first block from the current one on with enough room left, the
+    // unused tail of the blocks skipped over comes back with the scope
+    while (mBlock < mBlocks.size())
+    {
+        if (mBlocks[mBlock].mSize - mUsed >= size)
+        {
+            void* ret = mBlocks[mBlock].mData + mUsed;
+            mUsed += size;
+            return ret;
+        }
+        ++mBlock;
+        mUsed = 0;
+    }
+
+    Block block;
+    block.mSize = llmax(size, (size_t) BLOCK_SIZE);
+    block.mData = (U8*) ll_aligned_malloc<ALIGNMENT>(block.mSize);
+    if (!block.mData)
+    {
+        LL_WARNS() << "Failed to allocate " << block.mSize << " bytes of volume scratch memory" << LL_ENDL;
+        throw std::bad_alloc();
+    }
+
+    mBlocks.push_back(block);
+    ++mHeapAllocations;
+    mReserved += block.mSize;
+
+    mBlock = mBlocks.size() - 1;
+    mUsed = size;
+    return block.mData;
+}
+
+void LLVolumeArena::trim()
+{
+    // free from the back, oversized one-off blocks are the most recent ones
+    while (mReserved > MAX_RETAINED && !mBlocks.empty())
+    {
+        Block& block = mBlocks.back();
+        ll_aligned_free<ALIGNMENT>(block.mData);
+        mReserved -= block.mSize;
+        mBlocks.pop_back();
+    }
+}
+
+LLVolumeArena::Scope::Scope()
+    : mArena(LLVolumeArena::instance()),
+      mBlock(mArena.mBlock),
+      mUsed(mArena.mUsed)
+{
+    ++mArena.mScopeDepth;
+}
+
+LLVolumeArena::Scope::~Scope()
+{
+    mArena.mBlock = mBlock;
+    mArena.mUsed = mUsed;
+    if (--mArena.mScopeDepth == 0)
+    {
+        mArena.trim();
+        mArena.mBlock = 0;
+        mArena.mUsed = 0;
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * @file llvolumearena.h
+ * @brief Per-thread scratch memory for volume face construction.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOLUMEARENA_H
+#define LL_LLVOLUMEARENA_H
+
+#include "stdtypes.h"
+
+#include <vector>
+
+// Bump allocator for the temporary buffers used while building volume
+// faces (tangent generation, welding, cache optimization). Every thread
+// has its own arena, so mesh decode threads never contend on the heap for
+// scratch space, and the blocks are kept between faces so a warmed up
+// thread builds a face without touching the heap for temporaries at all.
+//
+// Memory handed out is only valid until the innermost open Scope closes,
+// and is never freed individually. Usage:
+//
+//     LLVolumeArena::Scope scope;
+//     LLVector4a* tmp = LLVolumeArena::instance().allocate<LLVector4a>(count);
+//     std::vector<U32, LLVolumeArena::Allocator<U32> > remap(count);
+class LLVolumeArena
+{
+public:
+    // every allocation starts on a cache line
+    static constexpr size_t ALIGNMENT = 64;
+    // size of a regular block, larger requests get a block of their own
+    static constexpr size_t BLOCK_SIZE = 1024 * 1024;
+    // memory kept for reuse once the outermost scope closes
+    static constexpr size_t MAX_RETAINED = 8 * 1024 * 1024;
+
+    // the calling thread's arena
+    static LLVolumeArena& instance();
+
+    void* allocate(size_t size);
+
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        return (T*) allocate(sizeof(T) * count);
+    }
+
+    // number of blocks this arena has taken from the heap so far
+    U32 getHeapAllocations() const { return mHeapAllocations; }
+    // bytes currently reserved from the heap
+    size_t getReserved() const { return mReserved; }
+
+    // Releases everything allocated on this thread's arena while the scope
+    // was open. Scopes nest.
+    class Scope
+    {
+    public:
+        Scope();
+        ~Scope();
+
+    private:
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        LLVolumeArena& mArena;
+        size_t mBlock;
+        size_t mUsed;
+    };
+
+    // STL allocator over the calling thread's arena; containers using it
+    // must not outlive the Scope they were filled in.
+    template <typename T>
+    struct Allocator
+    {
+        typedef T value_type;
+
+        Allocator() {}
+        template <typename U> Allocator(const Allocator<U>&) {}
+
+        T* allocate(size_t count) { return instance().allocate<T>(count); }
+        void deallocate(T*, size_t) {}
+
+        template <typename U> bool operator==(const Allocator<U>&) const { return true; }
+        template <typename U> bool operator!=(const Allocator<U>&) const { return false; }
+    };
+
+private:
+    LLVolumeArena();
+    ~LLVolumeArena();
+    LLVolumeArena(const LLVolumeArena&) = delete;
+    LLVolumeArena& operator=(const LLVolumeArena&) = delete;
+
+    void trim();
+
+    struct Block
+    {
+        U8* mData;
+        size_t mSize;
+    };
+
+    std::vector<Block> mBlocks;
+    size_t mBlock;      // block currently being filled
+    size_t mUsed;       // bytes used in that block
+    S32 mScopeDepth;
+    U32 mHeapAllocations;
+    size_t mReserved;
+};
+
+#endif // LL_LLVOLUMEARENA_H
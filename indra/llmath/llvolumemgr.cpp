@@ -82,6 +82,8 @@ BOOL LLVolumeMgr::cleanup()
 	{
 		mDataMutex->unlock();
 	}
+	// anything still being built is dropped when it gets back
+	mPendingVolumes.clear();
 	return no_refs;
 }
 
@@ -172,6 +174,96 @@ void LLVolumeMgr::unrefVolume(LLVolume *volumep)
 
 }
 
+void LLVolumeMgr::useWorkQueues(const std::string& main_queue, const std::string& work_queue)
+{
+	mMainQueueName = main_queue;
+	mWorkQueueName = work_queue;
+}
+
+bool LLVolumeMgr::isVolumeReady(const LLVolumeParams& volume_params, const S32 detail) const
+{
+	LLVolumeLODGroup* volgroupp = getGroup(volume_params);
+	return volgroupp && volgroupp->hasLOD(detail);
+}
+
+bool LLVolumeMgr::requestVolume(const LLVolumeParams& volume_params, const S32 detail,
+								const volume_callback_t& callback, const volume_finish_t& finish)
+{
+	LLVolumeLODGroup* volgroupp = getGroup(volume_params);
+	if (!volgroupp || volgroupp->hasLOD(detail))
+	{
+		return false;
+	}
+
+	volume_key_t key(volume_params, detail);
+	pending_volume_map_t::iterator iter = mPendingVolumes.find(key);
+	if (iter != mPendingVolumes.end())
+	{
+		iter->second.push_back(callback);
+		return true;
+	}
+
+	if (mMainQueueName.empty())
+	{
+		return false;
+	}
+	LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance(mMainQueueName);
+	LL::WorkQueue::ptr_t work_queue = LL::WorkQueue::getInstance(mWorkQueueName);
+	if (!main_queue || !work_queue)
+	{
+		return false;
+	}
+
+	F32 scale = LLVolumeLODGroup::getVolumeScaleFromDetail(detail);
+	bool posted = main_queue->postTo(
+		work_queue,
+		[volume_params, scale, finish]() // on the work queue
+		{
+			LL_PROFILE_ZONE_NAMED_CATEGORY_VOLUME("generate volume");
+			LLPointer<LLVolume> volumep = new LLVolume(volume_params, scale);
+			if (finish)
+			{
+				finish(volumep);
+			}
+			return volumep;
+		},
+		[this, volume_params, detail](LLPointer<LLVolume> volumep) // back on the main queue
+		{
+			onVolumeGenerated(volume_params, detail, volumep);
+		});
+	if (posted)
+	{
+		mPendingVolumes[key].push_back(callback);
+	}
+	return posted;
+}
+
+// protected
+void LLVolumeMgr::onVolumeGenerated(const LLVolumeParams& volume_params, S32 detail, LLPointer<LLVolume> volumep)
+{
+	pending_volume_map_t::iterator iter = mPendingVolumes.find(volume_key_t(volume_params, detail));
+	if (iter == mPendingVolumes.end())
+	{ // cleaned up meanwhile
+		return;
+	}
+	std::vector<volume_callback_t> callbacks;
+	callbacks.swap(iter->second);
+	mPendingVolumes.erase(iter);
+
+	// if everybody let go of these params while it was being built there
+	// is nothing to keep it with, and the callbacks will find it missing
+	LLVolumeLODGroup* volgroupp = getGroup(volume_params);
+	if (volgroupp)
+	{
+		volgroupp->setLOD(detail, volumep);
+	}
+
+	for (const volume_callback_t& callback : callbacks)
+	{
+		callback();
+	}
+}
+
 // protected
 void LLVolumeMgr::insertGroup(LLVolumeLODGroup* volgroup)
 {
@@ -301,6 +393,15 @@ LLVolume* LLVolumeLODGroup::refLOD(const S32 lod)
 	return mVolumeLODs[lod];
 }
 
+void LLVolumeLODGroup::setLOD(const S32 lod, LLVolume* volumep)
+{
+	llassert(lod >=0 && lod < NUM_LODS);
+	if (mVolumeLODs[lod].isNull())
+	{
+		mVolumeLODs[lod] = volumep;
+	}
+}
+
 BOOL LLVolumeLODGroup::derefLOD(LLVolume *volumep)
 {
 	llassert_always(mRefs > 0);
@@ -27,11 +27,14 @@
 #ifndef LL_LLVOLUMEMGR_H
 #define LL_LLVOLUMEMGR_H
 
+#include <functional>
 #include <map>
+#include <vector>
 
 #include "llvolume.h"
 #include "llpointer.h"
 #include "llthread.h"
+#include "workqueue.h"
 
 class LLVolumeParams;
 class LLVolumeLODGroup;
@@ -57,6 +60,9 @@ public:
 
 	LLVolume* refLOD(const S32 detail);
 	BOOL derefLOD(LLVolume *volumep);
+	bool hasLOD(const S32 detail) const { return mVolumeLODs[detail].notNull(); }
+	// hand over a volume built elsewhere, unless one was built meanwhile
+	void setLOD(const S32 detail, LLVolume* volumep);
 	S32 getNumRefs() const { return mRefs; }
 	
 	const LLVolumeParams* getVolumeParams() const { return &mVolumeParams; };
@@ -95,18 +101,45 @@ public:
 	// manually call this for mutex magic
 	void useMutex();
 
+	// Background generation. Once given the names of the queues to work on
+	// and to report back on, requestVolume() builds the volume for params
+	// at detail on the former and calls callback on the latter when
+	// refVolume() can return it without generating anything. Requests for
+	// the same params and detail while one is being built share it.
+	// Returns false if there is nothing to wait for: the volume is built
+	// already, or nobody holds any detail of these params for it to be
+	// kept with, or there are no queues. finish, if given, runs on the
+	// worker on the new volume, e.g. to sculpt it.
+	// Main thread only, as are the callbacks.
+	typedef std::function<void()> volume_callback_t;
+	typedef std::function<void(LLVolume*)> volume_finish_t;
+	void useWorkQueues(const std::string& main_queue, const std::string& work_queue);
+	bool requestVolume(const LLVolumeParams& volume_params, const S32 detail,
+					   const volume_callback_t& callback, const volume_finish_t& finish = volume_finish_t());
+	bool isVolumeReady(const LLVolumeParams& volume_params, const S32 detail) const;
+	S32 getNumPendingVolumes() const { return (S32) mPendingVolumes.size(); }
+
 	friend std::ostream& operator<<(std::ostream& s, const LLVolumeMgr& volume_mgr);
 
 protected:
 	void insertGroup(LLVolumeLODGroup* volgroup);
 	// Overridden in llphysics/abstract/utils/llphysicsvolumemanager.h
 	virtual LLVolumeLODGroup* createNewGroup(const LLVolumeParams& volume_params);
+	void onVolumeGenerated(const LLVolumeParams& volume_params, S32 detail, LLPointer<LLVolume> volumep);
 
 protected:
 	typedef std::map<const LLVolumeParams*, LLVolumeLODGroup*, LLVolumeParams::compare> volume_lod_group_map_t;
 	volume_lod_group_map_t mVolumeLODGroups;
 
 	LLMutex* mDataMutex;
+
+	// volumes on their way from the work queue, with who's waiting for them
+	typedef std::pair<LLVolumeParams, S32> volume_key_t;
+	typedef std::map<volume_key_t, std::vector<volume_callback_t> > pending_volume_map_t;
+	pending_volume_map_t mPendingVolumes;
+	// looked up per request, the queues may come and go after useWorkQueues()
+	std::string mMainQueueName;
+	std::string mWorkQueueName;
 };
 
 #endif // LL_LLVOLUMEMGR_H
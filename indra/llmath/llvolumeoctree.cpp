@@ -272,3 +272,163 @@ void LLVolumeOctreeValidate::visit(const LLOctreeNode<LLVolumeTriangle, LLVolume
 	}
 }
 
+
+
+LLVolumeTriangleBVH::LLVolumeTriangleBVH(const LLVolumeFace& face)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+    const U32 num_triangles = face.mNumIndices / 3;
+    std::vector<LLVector4a> bounds(num_triangles * 2);
+    for (U32 t = 0; t < num_triangles; ++t)
+    {
+        const LLVector4a& v0 = face.mPositions[face.mIndices[t * 3]];
+        const LLVector4a& v1 = face.mPositions[face.mIndices[t * 3 + 1]];
+        const LLVector4a& v2 = face.mPositions[face.mIndices[t * 3 + 2]];
+        bounds[t * 2].setMin(v0, v1);
+        bounds[t * 2].setMin(bounds[t * 2], v2);
+        bounds[t * 2 + 1].setMax(v0, v1);
+        bounds[t * 2 + 1].setMax(bounds[t * 2 + 1], v2);
+    }
+    mBVH.build(num_triangles ? &bounds[0] : NULL, num_triangles);
+
+    mTriangles.resize(num_triangles * 3);
+    for (U32 slot = 0; slot < num_triangles; ++slot)
+    {
+        const U32 t = mBVH.getElement(slot);
+        const LLVector4a& v0 = face.mPositions[face.mIndices[t * 3]];
+        mTriangles[slot * 3] = v0;
+        mTriangles[slot * 3 + 1].setSub(face.mPositions[face.mIndices[t * 3 + 1]], v0);
+        mTriangles[slot * 3 + 2].setSub(face.mPositions[face.mIndices[t * 3 + 2]], v0);
+    }
+}
+
+U32 LLVolumeTriangleBVH::intersect(const LLVector4a* start, const LLVector4a* end, U32 count, Hit* hits) const
+{
+    count = llmin(count, PACKET_SIZE);
+    if (!count || mTriangles.empty())
+    {
+        return 0;
+    }
+
+    // segments across the lanes, as for LLLinearBVH::raycast4()
+    LLVector4a origin[3];
+    LLVector4a dir[3];
+    LLVector4a limit;
+    for (U32 lane = 0; lane < PACKET_SIZE; ++lane)
+    {
+        const U32 i = llmin(lane, count - 1);
+        for (U32 axis = 0; axis < 3; ++axis)
+        {
+            origin[axis].getF32ptr()[lane] = start[i][axis];
+            dir[axis].getF32ptr()[lane] = end[i][axis] - start[i][axis];
+        }
+        limit.getF32ptr()[lane] = lane < count ? hits[i].mT : -1.f;
+    }
+
+    LLVector4a best_a, best_b;
+    best_a.clear();
+    best_b.clear();
+    S32 best_triangle[PACKET_SIZE] = { -1, -1, -1, -1 };
+    U32 found = 0;
+
+    mBVH.raycast4(start, end, count, limit, [&](U32 slot, LLVector4a& closest, U32 lanes)
+        {
+            const LLVector4a* tri = &mTriangles[slot * 3];
+            LLVector4a v0[3], e1[3], e2[3];
+            for (U32 axis = 0; axis < 3; ++axis)
+            {
+                v0[axis].splat(tri[0], axis);
+                e1[axis].splat(tri[1], axis);
+                e2[axis].splat(tri[2], axis);
+            }
+
+            // Moller-Trumbore, the way LLTriangleRayIntersect() does it
+            LLVector4a tmp;
+            LLVector4a pvec[3];
+            pvec[0].setMul(dir[1], e2[2]); tmp.setMul(dir[2], e2[1]); pvec[0].sub(tmp);
+            pvec[1].setMul(dir[2], e2[0]); tmp.setMul(dir[0], e2[2]); pvec[1].sub(tmp);
+            pvec[2].setMul(dir[0], e2[1]); tmp.setMul(dir[1], e2[0]); pvec[2].sub(tmp);
+
+            LLVector4a det;
+            det.setMul(e1[0], pvec[0]);
+            tmp.setMul(e1[1], pvec[1]); det.add(tmp);
+            tmp.setMul(e1[2], pvec[2]); det.add(tmp);
+
+            // back facing or edge on
+            U32 mask = lanes & det.greaterEqual(LLVector4a::getEpsilon()).getGatheredBits();
+            if (!mask)
+            {
+                return;
+            }
+
+            LLVector4a tvec[3];
+            tvec[0].setSub(origin[0], v0[0]);
+            tvec[1].setSub(origin[1], v0[1]);
+            tvec[2].setSub(origin[2], v0[2]);
+
+            LLVector4a u;
+            u.setMul(tvec[0], pvec[0]);
+            tmp.setMul(tvec[1], pvec[1]); u.add(tmp);
+            tmp.setMul(tvec[2], pvec[2]); u.add(tmp);
+            mask &= u.greaterEqual(LLVector4a::getZero()).getGatheredBits() & u.lessEqual(det).getGatheredBits();
+            if (!mask)
+            {
+                return;
+            }
+
+            LLVector4a qvec[3];
+            qvec[0].setMul(tvec[1], e1[2]); tmp.setMul(tvec[2], e1[1]); qvec[0].sub(tmp);
+            qvec[1].setMul(tvec[2], e1[0]); tmp.setMul(tvec[0], e1[2]); qvec[1].sub(tmp);
+            qvec[2].setMul(tvec[0], e1[1]); tmp.setMul(tvec[1], e1[0]); qvec[2].sub(tmp);
+
+            LLVector4a v;
+            v.setMul(dir[0], qvec[0]);
+            tmp.setMul(dir[1], qvec[1]); v.add(tmp);
+            tmp.setMul(dir[2], qvec[2]); v.add(tmp);
+            LLVector4a sum_uv;
+            sum_uv.setAdd(u, v);
+            mask &= v.greaterEqual(LLVector4a::getZero()).getGatheredBits() & sum_uv.lessEqual(det).getGatheredBits();
+            if (!mask)
+            {
+                return;
+            }
+
+            LLVector4a t;
+            t.setMul(e2[0], qvec[0]);
+            tmp.setMul(e2[1], qvec[1]); t.add(tmp);
+            tmp.setMul(e2[2], qvec[2]); t.add(tmp);
+            t.div(det);
+            mask &= t.greaterEqual(LLVector4a::getZero()).getGatheredBits() & t.lessThan(closest).getGatheredBits();
+            if (!mask)
+            {
+                return;
+            }
+
+            u.div(det);
+            v.div(det);
+            for (U32 lane = 0; lane < PACKET_SIZE; ++lane)
+            {
+                if (mask & (1 << lane))
+                {
+                    closest.getF32ptr()[lane] = t[lane];
+                    best_a.getF32ptr()[lane] = u[lane];
+                    best_b.getF32ptr()[lane] = v[lane];
+                    best_triangle[lane] = (S32) mBVH.getElement(slot);
+                }
+            }
+            found |= mask;
+        });
+
+    for (U32 i = 0; i < count; ++i)
+    {
+        if (found & (1 << i))
+        {
+            hits[i].mT = limit[i];
+            hits[i].mA = best_a[i];
+            hits[i].mB = best_b[i];
+            hits[i].mTriangle = best_triangle[i];
+        }
+    }
+    return found;
+}
@@ -30,10 +30,13 @@
 #include "linden_common.h"
 #include "llmemory.h"
 
+#include "llbvh.h"
 #include "lloctree.h"
 #include "llvolume.h"
 #include "llvector4a.h"
 
+#include <vector>
+
 class alignas(16) LLVolumeTriangle : public LLRefCount
 {
     LL_ALIGN_NEW
@@ -132,6 +135,42 @@ public:
     virtual void visit(const LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* node);
 };
 
+// The triangles of a volume face in an LLLinearBVH, for tracing many
+// segments against one face (hover picks, scripted-tool style scans):
+// segments go through in packets of four, one per SIMD lane, and each
+// triangle is stored in tree order as its first vertex and the two edges
+// from it, so a leaf is a contiguous run tested against every segment of
+// the packet at once.
+class LLVolumeTriangleBVH
+{
+public:
+    static constexpr U32 PACKET_SIZE = 4;
+
+    struct Hit
+    {
+        F32 mT;         // along the segment, start is 0 and end is 1
+        F32 mA;         // barycentric weight of the triangle's second vertex
+        F32 mB;         // and of the third
+        S32 mTriangle;  // index of the triangle's first index in mIndices / 3
+    };
+
+    LLVolumeTriangleBVH(const LLVolumeFace& face);
+
+    // Front facing hits, as LLTriangleRayIntersect() finds them, of up to
+    // PACKET_SIZE segments from start[i] to end[i]. hits[i].mT comes in as
+    // the furthest to look (1, or a hit on another face); hits[i] is only
+    // written when something nearer is found. Returns the mask of segments
+    // that found something.
+    U32 intersect(const LLVector4a* start, const LLVector4a* end, U32 count, Hit* hits) const;
+
+    U32 getTriangleCount() const { return mBVH.getElementCount(); }
+
+private:
+    LLLinearBVH mBVH;
+    // vertex 0, edge 1 and edge 2 of each triangle, in tree order
+    std::vector<LLVector4a> mTriangles;
+};
+
 class LLVolumeOctreeValidate : public LLOctreeTraveler<LLVolumeTriangle, LLVolumeTriangle*>
 {
     virtual void visit(const LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* branch);
@@ -0,0 +1,612 @@
+/**
+ * @file llbvh_test.cpp
+ * @brief LLLinearBVH tests and cull/raycast benchmarks against LLOctreeNode,
+ *        and packet raycasts of volume faces against single ones
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llbvh.h"
+#include "../llcamera.h"
+#include "../llvolume.h"
+#include "../llvolumeoctree.h"
+#include "llrand.h"
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::duration<double, std::milli> ms_t;
+    typedef LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*> tri_node;
+
+    // looking down +x from origin, 90 degrees wide
+    void setup_camera(LLCamera& camera, const LLVector3& origin, F32 far_clip)
+    {
+        camera.setOrigin(origin);
+        camera.setAxes(LLVector3::x_axis, LLVector3::y_axis, LLVector3::z_axis);
+        camera.setFar(far_clip);
+
+        const F32 near_clip = camera.getNear();
+        LLVector3 frust[8];
+        for (U32 i = 0; i < 2; ++i)
+        {
+            const F32 dist = i ? far_clip : near_clip;
+            const LLVector3 at = origin + camera.getAtAxis() * dist;
+            const LLVector3 left = camera.getLeftAxis() * dist;
+            const LLVector3 up = camera.getUpAxis() * dist * 0.75f;
+            frust[i * 4 + 0] = at + left - up;
+            frust[i * 4 + 1] = at - left - up;
+            frust[i * 4 + 2] = at - left + up;
+            frust[i * 4 + 3] = at + left + up;
+        }
+        camera.calcAgentFrustumPlanes(frust);
+    }
+
+    // tight bounds for the listeners of the octree, depth first so children
+    // are done before their parents, as LLVolumeFace::createOctree() does
+    class OctreeRebound : public LLOctreeTravelerDepthFirst<LLVolumeTriangle, LLVolumeTriangle*>
+    {
+    public:
+        void visit(const tri_node* branch) override
+        {
+            LLVolumeOctreeListener* node = (LLVolumeOctreeListener*) branch->getListener(0);
+            LLVector4a& min = node->mExtents[0];
+            LLVector4a& max = node->mExtents[1];
+            bool empty = true;
+            for (auto iter = branch->getDataBegin(); iter != branch->getDataEnd(); ++iter)
+            {
+                for (U32 v = 0; v < 3; ++v)
+                {
+                    stretch(min, max, *(*iter)->mV[v], *(*iter)->mV[v], empty);
+                }
+            }
+            for (U32 i = 0; i < branch->getChildCount(); ++i)
+            {
+                LLVolumeOctreeListener* child = (LLVolumeOctreeListener*) branch->getChild(i)->getListener(0);
+                stretch(min, max, child->mExtents[0], child->mExtents[1], empty);
+            }
+            node->mBounds[0].setAdd(min, max);
+            node->mBounds[0].mul(0.5f);
+            node->mBounds[1].setSub(max, min);
+            node->mBounds[1].mul(0.5f);
+        }
+
+    private:
+        static void stretch(LLVector4a& min, LLVector4a& max, const LLVector4a& lo, const LLVector4a& hi, bool& empty)
+        {
+            if (empty)
+            {
+                min = lo;
+                max = hi;
+                empty = false;
+            }
+            else
+            {
+                min.setMin(min, lo);
+                max.setMax(max, hi);
+            }
+        }
+    };
+
+    // A region's worth of scattered triangles, up to a couple of meters
+    // across, in a triangle octree the way LLVolumeFace keeps one and in
+    // the bounds LLLinearBVH::build() takes.
+    struct Scene
+    {
+        Scene(U32 triangles)
+        :   mPositions(triangles * 3),
+            mBounds(triangles * 2),
+            mTriangles(new LLVolumeTriangle[triangles]),
+            mOctree(NULL),
+            mCount(triangles)
+        {
+            for (U32 t = 0; t < triangles; ++t)
+            {
+                LLVector4a center(ll_frand(256.f), ll_frand(256.f), ll_frand(64.f));
+                LLVector4a* v = &mPositions[t * 3];
+                for (U32 i = 0; i < 3; ++i)
+                {
+                    LLVector4a offset(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f);
+                    v[i].setAdd(center, offset);
+                }
+                mBounds[t * 2] = v[0];
+                mBounds[t * 2].setMin(mBounds[t * 2], v[1]);
+                mBounds[t * 2].setMin(mBounds[t * 2], v[2]);
+                mBounds[t * 2 + 1] = v[0];
+                mBounds[t * 2 + 1].setMax(mBounds[t * 2 + 1], v[1]);
+                mBounds[t * 2 + 1].setMax(mBounds[t * 2 + 1], v[2]);
+            }
+        }
+
+        ~Scene()
+        {
+            delete mOctree;
+            delete[] mTriangles;
+        }
+
+        void buildOctree()
+        {
+            mOctree = new LLOctreeRoot<LLVolumeTriangle, LLVolumeTriangle*>(LLVector4a(128.f, 128.f, 32.f),
+                                                                           LLVector4a(128.f, 128.f, 128.f), NULL);
+            new LLVolumeOctreeListener(mOctree);
+            for (U32 t = 0; t < mCount; ++t)
+            {
+                LLVolumeTriangle* tri = &mTriangles[t];
+                for (U32 i = 0; i < 3; ++i)
+                {
+                    tri->mV[i] = &mPositions[t * 3 + i];
+                    tri->mIndex[i] = 0;
+                }
+                tri->mPositionGroup.setAdd(mBounds[t * 2], mBounds[t * 2 + 1]);
+                tri->mPositionGroup.mul(0.5f);
+                LLVector4a size;
+                size.setSub(mBounds[t * 2 + 1], mBounds[t * 2]);
+                tri->mRadius = size.getLength3().getF32() * 0.25f;
+                mOctree->insert(tri);
+            }
+            while (!mOctree->balance()) { }
+
+            OctreeRebound rebound;
+            rebound.traverse(mOctree);
+        }
+
+        std::vector<LLVector4a> mPositions;
+        std::vector<LLVector4a> mBounds;
+        LLVolumeTriangle* mTriangles;
+        tri_node* mOctree;
+        U32 mCount;
+    };
+
+    S32 check_box(LLCamera& camera, const LLVector4a& min, const LLVector4a& max)
+    {
+        LLVector4a center, size;
+        center.setAdd(min, max);
+        center.mul(0.5f);
+        size.setSub(max, min);
+        size.mul(0.5f);
+        return camera.AABBInFrustum(center, size);
+    }
+
+    // what a spatial partition cull does with the octree: check the tight
+    // bounds the listeners keep, take whole subtrees that are all in, and
+    // check the elements of partly visible nodes one by one
+    class OctreeCull : public LLOctreeTraveler<LLVolumeTriangle, LLVolumeTriangle*>
+    {
+    public:
+        OctreeCull(LLCamera& camera) : mCamera(camera), mRes(0), mCount(0) {}
+
+        void traverse(const tri_node* node) override
+        {
+            LLVolumeOctreeListener* listener = (LLVolumeOctreeListener*) node->getListener(0);
+            S32 res = mRes == 2 ? 2 : mCamera.AABBInFrustum(listener->mBounds[0], listener->mBounds[1]);
+            if (res)
+            {
+                S32 parent_res = mRes;
+                mRes = res;
+                node->accept(this);
+                for (U32 i = 0; i < node->getChildCount(); ++i)
+                {
+                    traverse(node->getChild(i));
+                }
+                mRes = parent_res;
+            }
+        }
+
+        void visit(const tri_node* node) override
+        {
+            for (auto iter = node->getDataBegin(); iter != node->getDataEnd(); ++iter)
+            {
+                const LLVolumeTriangle* tri = *iter;
+                if (mRes == 2)
+                {
+                    ++mCount;
+                    continue;
+                }
+                LLVector4a min = *tri->mV[0];
+                min.setMin(min, *tri->mV[1]);
+                min.setMin(min, *tri->mV[2]);
+                LLVector4a max = *tri->mV[0];
+                max.setMax(max, *tri->mV[1]);
+                max.setMax(max, *tri->mV[2]);
+                if (check_box(mCamera, min, max))
+                {
+                    ++mCount;
+                }
+            }
+        }
+
+        LLCamera& mCamera;
+        S32 mRes;
+        U32 mCount;
+    };
+
+    class CountTraveler : public LLLinearBVH::Traveler
+    {
+    public:
+        CountTraveler(LLCamera& camera) : mCamera(camera), mCount(0) {}
+
+        S32 check(const LLVector4a& center, const LLVector4a& size) override
+        {
+            return mCamera.AABBInFrustum(center, size);
+        }
+
+        void visit(U32 element) override
+        {
+            ++mCount;
+        }
+
+        LLCamera& mCamera;
+        U32 mCount;
+    };
+
+    F32 raycast_bvh(const LLLinearBVH& bvh, const Scene& scene, const LLVector4a& start, const LLVector4a& end)
+    {
+        LLVector4a dir;
+        dir.setSub(end, start);
+        F32 hit = 2.f;
+        bvh.raycast(start, end, [&](U32 t, F32& closest)
+            {
+                const LLVector4a* v = &scene.mPositions[t * 3];
+                F32 a, b, dist;
+                if (LLTriangleRayIntersect(v[0], v[1], v[2], start, dir, a, b, dist) &&
+                    dist >= 0.f && dist <= closest)
+                {
+                    closest = dist;
+                    hit = dist;
+                }
+            });
+        return hit;
+    }
+
+    F32 raycast_octree(const Scene& scene, const LLVector4a& start, const LLVector4a& end)
+    {
+        LLVector4a dir;
+        dir.setSub(end, start);
+        F32 closest = 2.f;
+        // no face needed when no texture coordinates, normals or tangents
+        // are asked for
+        LLOctreeTriangleRayIntersect intersect(start, dir, NULL, &closest, NULL, NULL, NULL, NULL);
+        intersect.traverse(scene.mOctree);
+        return closest;
+    }
+
+    void random_segment(LLVector4a& start, LLVector4a& end)
+    {
+        start.set(ll_frand(256.f), ll_frand(256.f), ll_frand(64.f));
+        LLVector4a dir(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f);
+        dir.normalize3fast();
+        dir.mul(64.f);
+        end.setAdd(start, dir);
+    }
+
+    // sphere, torus and box at the highest detail the viewer builds them
+    LLVolume* make_prim(U32 shape)
+    {
+        LLVolumeParams params;
+        switch (shape)
+        {
+        case 0:
+            params.setType(LL_PCODE_PROFILE_CIRCLE_HALF, LL_PCODE_PATH_CIRCLE);
+            break;
+        case 1:
+            params.setType(LL_PCODE_PROFILE_CIRCLE, LL_PCODE_PATH_CIRCLE);
+            params.setRatio(1.f, 0.25f);
+            break;
+        default:
+            params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+            break;
+        }
+        return new LLVolume(params, 4.f);
+    }
+
+    // Segments at the unit prim as a picking pass sends them, a small
+    // grid of neighbouring pixels at a time from one eye point, so each
+    // packet of 4 goes through much the same part of the prim.
+    void prim_segments(std::vector<LLVector4a>& start, std::vector<LLVector4a>& end, U32 count)
+    {
+        start.resize(count);
+        end.resize(count);
+        for (U32 r = 0; r < count; r += 4)
+        {
+            LLVector4a eye(ll_frand(4.f) - 2.f, ll_frand(4.f) - 2.f, ll_frand(4.f) - 2.f);
+            eye.normalize3fast();
+            eye.mul(2.f);
+            LLVector4a target(ll_frand(1.f) - 0.5f, ll_frand(1.f) - 0.5f, ll_frand(1.f) - 0.5f);
+            for (U32 i = r; i < r + 4 && i < count; ++i)
+            {
+                LLVector4a offset(ll_frand(0.02f), ll_frand(0.02f), ll_frand(0.02f));
+                offset.add(target);
+                start[i] = eye;
+                end[i].setSub(offset, eye);
+                end[i].mul(2.f);
+                end[i].add(eye);
+            }
+        }
+    }
+}
+
+namespace tut
+{
+    struct LLLinearBVHTest
+    {
+    };
+    typedef test_group<LLLinearBVHTest> LLLinearBVHTest_factory;
+    typedef LLLinearBVHTest_factory::object LLLinearBVHTest_t;
+    LLLinearBVHTest_factory tf("LLLinearBVH");
+
+    template<> template<>
+    void LLLinearBVHTest_t::test<1>()
+    {
+        set_test_name("cull finds what checking every element finds");
+
+        const U32 TRIANGLES = 20000;
+        Scene scene(TRIANGLES);
+        LLLinearBVH bvh;
+        bvh.build(&scene.mBounds[0], TRIANGLES);
+        ensure_equals("elements", bvh.getElementCount(), TRIANGLES);
+        ensure("no more nodes than a binary tree needs", bvh.getNodeCount() < TRIANGLES * 2);
+
+        LLCamera camera;
+        setup_camera(camera, LLVector3(20.f, 128.f, 32.f), 128.f);
+
+        std::vector<U32> expected(TRIANGLES, 0);
+        U32 expected_count = 0;
+        for (U32 t = 0; t < TRIANGLES; ++t)
+        {
+            if (check_box(camera, scene.mBounds[t * 2], scene.mBounds[t * 2 + 1]))
+            {
+                expected[t] = 1;
+                ++expected_count;
+            }
+        }
+        ensure("some of the scene is in view", expected_count > 0 && expected_count < TRIANGLES);
+
+        std::vector<U32> found(TRIANGLES, 0);
+        bvh.cull([&camera](const LLVector4a& center, const LLVector4a& size)
+            {
+                return camera.AABBInFrustum(center, size);
+            },
+            [&found](U32 t)
+            {
+                ++found[t];
+            });
+        ensure("same elements, each once", found == expected);
+
+        CountTraveler traveler(camera);
+        bvh.traverse(traveler);
+        ensure_equals("traveler", traveler.mCount, expected_count);
+    }
+
+    template<> template<>
+    void LLLinearBVHTest_t::test<2>()
+    {
+        set_test_name("raycast finds the nearest hit");
+
+        const U32 TRIANGLES = 20000;
+        Scene scene(TRIANGLES);
+        LLLinearBVH bvh;
+        bvh.build(&scene.mBounds[0], TRIANGLES);
+
+        U32 hits = 0;
+        for (U32 r = 0; r < 500; ++r)
+        {
+            LLVector4a start, end, dir;
+            random_segment(start, end);
+            dir.setSub(end, start);
+
+            F32 expected = 2.f;
+            for (U32 t = 0; t < TRIANGLES; ++t)
+            {
+                const LLVector4a* v = &scene.mPositions[t * 3];
+                F32 a, b, dist;
+                if (LLTriangleRayIntersect(v[0], v[1], v[2], start, dir, a, b, dist) &&
+                    dist >= 0.f && dist <= 1.f)
+                {
+                    expected = llmin(expected, dist);
+                }
+            }
+
+            ensure_equals("ray " + std::to_string(r), raycast_bvh(bvh, scene, start, end), expected);
+            hits += expected <= 1.f ? 1 : 0;
+        }
+        ensure("some rays hit", hits > 0);
+
+        // axis aligned, through the middle of a box
+        LLVector4a box[2] = { LLVector4a(-1.f, -1.f, -1.f), LLVector4a(1.f, 1.f, 1.f) };
+        LLLinearBVH one;
+        one.build(box, 1);
+        U32 visits = 0;
+        one.raycast(LLVector4a(0.f, 0.f, -5.f), LLVector4a(0.f, 0.f, 5.f), [&visits](U32, F32&) { ++visits; });
+        ensure_equals("axis aligned ray", visits, (U32) 1);
+        one.raycast(LLVector4a(0.f, 0.f, 5.f), LLVector4a(0.f, 0.f, 10.f), [&visits](U32, F32&) { ++visits; });
+        ensure_equals("segment stops short", visits, (U32) 1);
+    }
+
+    template<> template<>
+    void LLLinearBVHTest_t::test<3>()
+    {
+        set_test_name("build, cull and raycast 200k elements against the octree");
+
+        const U32 TRIANGLES = 200000;
+        const U32 CULLS = 20;
+        const U32 RAYS = 20000;
+
+        Scene scene(TRIANGLES);
+
+        auto start_time = std::chrono::steady_clock::now();
+        scene.buildOctree();
+        ms_t octree_build = std::chrono::steady_clock::now() - start_time;
+
+        start_time = std::chrono::steady_clock::now();
+        LLLinearBVH bvh;
+        bvh.build(&scene.mBounds[0], TRIANGLES);
+        ms_t bvh_build = std::chrono::steady_clock::now() - start_time;
+
+        std::vector<LLCamera> cameras(CULLS);
+        for (U32 c = 0; c < CULLS; ++c)
+        {
+            setup_camera(cameras[c], LLVector3(ll_frand(64.f), ll_frand(256.f), ll_frand(64.f)), 64.f + ll_frand(128.f));
+        }
+
+        U32 octree_count = 0;
+        start_time = std::chrono::steady_clock::now();
+        for (U32 c = 0; c < CULLS; ++c)
+        {
+            OctreeCull cull(cameras[c]);
+            cull.traverse(scene.mOctree);
+            octree_count += cull.mCount;
+        }
+        ms_t octree_cull = std::chrono::steady_clock::now() - start_time;
+
+        U32 bvh_count = 0;
+        start_time = std::chrono::steady_clock::now();
+        for (U32 c = 0; c < CULLS; ++c)
+        {
+            LLCamera& camera = cameras[c];
+            bvh.cull([&camera](const LLVector4a& center, const LLVector4a& size)
+                {
+                    return camera.AABBInFrustum(center, size);
+                },
+                [&bvh_count](U32)
+                {
+                    ++bvh_count;
+                });
+        }
+        ms_t bvh_cull = std::chrono::steady_clock::now() - start_time;
+        ensure_equals("same elements culled", bvh_count, octree_count);
+
+        std::vector<LLVector4a> segments(RAYS * 2);
+        for (U32 r = 0; r < RAYS; ++r)
+        {
+            random_segment(segments[r * 2], segments[r * 2 + 1]);
+        }
+
+        std::vector<F32> octree_hits(RAYS);
+        start_time = std::chrono::steady_clock::now();
+        for (U32 r = 0; r < RAYS; ++r)
+        {
+            octree_hits[r] = raycast_octree(scene, segments[r * 2], segments[r * 2 + 1]);
+        }
+        ms_t octree_rays = std::chrono::steady_clock::now() - start_time;
+
+        std::vector<F32> bvh_hits(RAYS);
+        start_time = std::chrono::steady_clock::now();
+        for (U32 r = 0; r < RAYS; ++r)
+        {
+            bvh_hits[r] = raycast_bvh(bvh, scene, segments[r * 2], segments[r * 2 + 1]);
+        }
+        ms_t bvh_rays = std::chrono::steady_clock::now() - start_time;
+        ensure("same hits", bvh_hits == octree_hits);
+
+        LL_INFOS() << TRIANGLES << " triangles, octree vs linear BVH: build "
+                   << octree_build.count() << " / " << bvh_build.count() << " ms, cull "
+                   << octree_cull.count() / CULLS << " / " << bvh_cull.count() / CULLS << " ms, "
+                   << RAYS << " rays " << octree_rays.count() << " / " << bvh_rays.count() << " ms" << LL_ENDL;
+    }
+
+    template<> template<>
+    void LLLinearBVHTest_t::test<4>()
+    {
+        set_test_name("packet raycasts of a volume hit what single ones do");
+
+        const U32 RAYS = 4003; // not a whole number of packets
+        for (U32 shape = 0; shape < 3; ++shape)
+        {
+            LLPointer<LLVolume> volume = make_prim(shape);
+            std::vector<LLVector4a> start, end;
+            prim_segments(start, end, RAYS);
+
+            std::vector<S32> faces(RAYS);
+            std::vector<LLVector4a> points(RAYS);
+            volume->lineSegmentIntersect(&start[0], &end[0], RAYS, -1, &faces[0], &points[0]);
+
+            U32 hits = 0;
+            for (U32 r = 0; r < RAYS; ++r)
+            {
+                LLVector4a point;
+                S32 face = volume->lineSegmentIntersect(start[r], end[r], -1, &point);
+                ensure_equals("same face", faces[r], face);
+                if (face != -1)
+                {
+                    ++hits;
+                    LLVector4a delta;
+                    delta.setSub(point, points[r]);
+                    ensure("same point", delta.getLength3().getF32() < 1.e-4f);
+                }
+            }
+            ensure("prim was hit", hits > RAYS / 4);
+        }
+    }
+
+    template<> template<>
+    void LLLinearBVHTest_t::test<5>()
+    {
+        set_test_name("raycast prims singly through the octree and in packets");
+
+        const U32 RAYS = 100000;
+        const char* names[] = { "sphere", "torus", "box" };
+        for (U32 shape = 0; shape < 3; ++shape)
+        {
+            LLPointer<LLVolume> volume = make_prim(shape);
+            std::vector<LLVector4a> start, end;
+            prim_segments(start, end, RAYS);
+
+            U32 triangles = 0;
+            for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+            {
+                triangles += volume->getVolumeFace(f).mNumIndices / 3;
+            }
+
+            // trees built up front, both are kept with the volume
+            volume->lineSegmentIntersect(start[0], end[0]);
+            S32 face;
+            volume->lineSegmentIntersect(&start[0], &end[0], 1, -1, &face);
+
+            U32 single_hits = 0;
+            auto start_time = std::chrono::steady_clock::now();
+            for (U32 r = 0; r < RAYS; ++r)
+            {
+                single_hits += volume->lineSegmentIntersect(start[r], end[r]) != -1;
+            }
+            ms_t single = std::chrono::steady_clock::now() - start_time;
+
+            std::vector<S32> faces(RAYS);
+            start_time = std::chrono::steady_clock::now();
+            volume->lineSegmentIntersect(&start[0], &end[0], RAYS, -1, &faces[0]);
+            ms_t packets = std::chrono::steady_clock::now() - start_time;
+
+            U32 packet_hits = 0;
+            for (U32 r = 0; r < RAYS; ++r)
+            {
+                packet_hits += faces[r] != -1;
+            }
+            ensure_equals("same hits", packet_hits, single_hits);
+
+            LL_INFOS() << names[shape] << ", " << triangles << " triangles, " << RAYS
+                       << " rays, octree vs packets of 4: " << single.count() << " / "
+                       << packets.count() << " ms" << LL_ENDL;
+        }
+    }
+}
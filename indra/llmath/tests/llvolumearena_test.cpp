@@ -0,0 +1,264 @@
+/**
+ * @file llvolumearena_test.cpp
+ * @brief LLVolumeArena tests and volume face allocation benchmark
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llvolumearena.h"
+#include "../llvolume.h"
+#include "../test/lltut.h"
+
+#include "meshoptimizer/meshoptimizer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+// Count heap allocations made through operator new while sCountAllocations
+// is set, that is every std::vector or new'd temporary of the code under
+// test. meshoptimizer's own scratch memory is counted separately below.
+static std::atomic<bool> sCountAllocations(false);
+static std::atomic<U32> sNewCalls(0);
+static std::atomic<U32> sMeshoptCalls(0);
+
+void* operator new(std::size_t size)
+{
+    if (sCountAllocations)
+    {
+        ++sNewCalls;
+    }
+    void* ret = malloc(size ? size : 1);
+    if (!ret)
+    {
+        throw std::bad_alloc();
+    }
+    return ret;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+static void* meshopt_counting_allocate(size_t size)
+{
+    if (sCountAllocations)
+    {
+        ++sMeshoptCalls;
+    }
+    return malloc(size);
+}
+
+namespace tut
+{
+    struct LLVolumeArenaTest
+    {
+        // regular grid of size x size vertices, two triangles per cell
+        static void makeGrid(LLVolumeFace& face, S32 size)
+        {
+            face.resizeVertices(size * size);
+            face.resizeIndices((size - 1) * (size - 1) * 6);
+            for (S32 y = 0; y < size; ++y)
+            {
+                for (S32 x = 0; x < size; ++x)
+                {
+                    S32 i = y * size + x;
+                    F32 s = (F32) x / (size - 1);
+                    F32 t = (F32) y / (size - 1);
+                    face.mPositions[i].set(s - 0.5f, t - 0.5f, 0.1f * sinf(s * 6.f) * cosf(t * 6.f));
+                    face.mNormals[i].set(0.f, 0.f, 1.f);
+                    face.mTexCoords[i].set(s, t);
+                }
+            }
+
+            U16* idx = face.mIndices;
+            for (S32 y = 0; y < size - 1; ++y)
+            {
+                for (S32 x = 0; x < size - 1; ++x)
+                {
+                    U16 i = (U16) (y * size + x);
+                    *idx++ = i;
+                    *idx++ = i + 1;
+                    *idx++ = i + size;
+                    *idx++ = i + 1;
+                    *idx++ = i + size + 1;
+                    *idx++ = i + size;
+                }
+            }
+        }
+    };
+    typedef test_group<LLVolumeArenaTest> LLVolumeArenaTest_factory;
+    typedef LLVolumeArenaTest_factory::object LLVolumeArenaTest_t;
+    LLVolumeArenaTest_factory tf("LLVolumeArena");
+
+    template<> template<>
+    void LLVolumeArenaTest_t::test<1>()
+    {
+        set_test_name("allocations are aligned and scopes rewind");
+
+        LLVolumeArena& arena = LLVolumeArena::instance();
+        U8* first = NULL;
+        {
+            LLVolumeArena::Scope scope;
+            first = (U8*) arena.allocate(3);
+            U8* second = (U8*) arena.allocate(100);
+            ensure("aligned", ((uintptr_t) first % LLVolumeArena::ALIGNMENT) == 0);
+            ensure("aligned after odd size", ((uintptr_t) second % LLVolumeArena::ALIGNMENT) == 0);
+            ensure("distinct", second >= first + 3);
+
+            U8* inner = NULL;
+            {
+                LLVolumeArena::Scope nested;
+                inner = (U8*) arena.allocate(64);
+            }
+            ensure("nested scope gives its memory back", arena.allocate(64) == inner);
+        }
+
+        LLVolumeArena::Scope scope;
+        ensure("outer scope gives its memory back", arena.allocate(16) == first);
+    }
+
+    template<> template<>
+    void LLVolumeArenaTest_t::test<2>()
+    {
+        set_test_name("blocks are reused and trimmed");
+
+        LLVolumeArena& arena = LLVolumeArena::instance();
+        {
+            LLVolumeArena::Scope scope;
+            arena.allocate(16);
+        }
+        U32 heap = arena.getHeapAllocations();
+        for (S32 i = 0; i < 10; ++i)
+        {
+            LLVolumeArena::Scope scope;
+            arena.allocate(LLVolumeArena::BLOCK_SIZE / 2);
+            arena.allocate(LLVolumeArena::BLOCK_SIZE / 4);
+        }
+        ensure_equals("warm arena stays off the heap", arena.getHeapAllocations(), heap);
+
+        {
+            LLVolumeArena::Scope scope;
+            U8* big = (U8*) arena.allocate(LLVolumeArena::MAX_RETAINED * 2);
+            // touch both ends
+            big[0] = 1;
+            big[LLVolumeArena::MAX_RETAINED * 2 - 1] = 1;
+            ensure("oversized request reserved", arena.getReserved() > LLVolumeArena::MAX_RETAINED);
+        }
+        ensure("trimmed", arena.getReserved() <= LLVolumeArena::MAX_RETAINED);
+    }
+
+    template<> template<>
+    void LLVolumeArenaTest_t::test<3>()
+    {
+        set_test_name("stl allocator and per-thread arenas");
+
+        LLVolumeArena::Scope scope;
+        std::vector<U32, LLVolumeArena::Allocator<U32> > v;
+        for (U32 i = 0; i < 10000; ++i)
+        {
+            v.push_back(i);
+        }
+        U64 sum = 0;
+        for (U32 i : v)
+        {
+            sum += i;
+        }
+        ensure_equals("contents", sum, (U64) 10000 * 9999 / 2);
+
+        LLVolumeArena* other = NULL;
+        std::thread worker([&other]()
+        {
+            other = &LLVolumeArena::instance();
+            LLVolumeArena::Scope scope;
+            other->allocate(1024);
+        });
+        worker.join();
+        ensure("each thread has its own arena", other != &LLVolumeArena::instance());
+    }
+
+    template<> template<>
+    void LLVolumeArenaTest_t::test<4>()
+    {
+        set_test_name("cacheOptimize scratch allocations");
+
+        // A 64x64 grid unwelds to ~24k vertices for tangent generation,
+        // which used to cost six vector allocations plus a replacement
+        // index buffer per face.
+        const S32 GRID = 64;
+        meshopt_setAllocator(meshopt_counting_allocate, free);
+
+        {
+            // warm up this thread's arena
+            LLVolumeFace face;
+            makeGrid(face, GRID);
+            face.cacheOptimize(true);
+        }
+
+        LLVolumeArena& arena = LLVolumeArena::instance();
+        const S32 FACES = 20;
+        U32 heap = arena.getHeapAllocations();
+        std::chrono::steady_clock::duration elapsed(0);
+        for (S32 i = 0; i < FACES; ++i)
+        {
+            LLVolumeFace face;
+            makeGrid(face, GRID);
+
+            auto start = std::chrono::steady_clock::now();
+            sCountAllocations = true;
+            face.cacheOptimize(true);
+            sCountAllocations = false;
+            elapsed += std::chrono::steady_clock::now() - start;
+
+            ensure("tangents generated", face.mTangents != NULL);
+            for (S32 j = 0; j < face.mNumIndices; ++j)
+            {
+                ensure("valid index", face.mIndices[j] < face.mNumVertices);
+            }
+        }
+
+        meshopt_setAllocator(operator new, operator delete);
+
+        typedef std::chrono::duration<double, std::milli> ms_t;
+        LL_INFOS() << FACES << " faces: " << sNewCalls << " operator new calls, "
+                   << sMeshoptCalls << " meshoptimizer allocations, "
+                   << arena.getHeapAllocations() - heap << " arena blocks, "
+                   << ms_t(elapsed).count() / FACES << " ms per face" << LL_ENDL;
+
+        ensure_equals("no vector or new'd temporaries", (U32) sNewCalls, 0u);
+        ensure_equals("warm arena stays off the heap", arena.getHeapAllocations(), heap);
+    }
+}
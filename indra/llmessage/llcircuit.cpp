@@ -61,8 +61,8 @@ const S32 PING_START_BLOCK = 3;		// How many pings behind we have to be to consi
 const S32 PING_RELEASE_BLOCK = 2;	// How many pings behind we have to be to consider ourself unblocked.
 
 const F32Seconds TARGET_PERIOD_LENGTH(5.f);
-const F32Seconds LL_DUPLICATE_SUPPRESSION_TIMEOUT(60.f); //this can be long, as time-based cleanup is
-													// only done when wrapping packetids, now...
+const U32 LL_MAX_TRACKED_IN_PACKET_IDS = 65536;	// Most incoming IDs held for duplicate suppression or loss
+													// accounting, those further behind the newest are forgotten.
 
 LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id, 
 							 const F32Seconds circuit_heartbeat_interval, const F32Seconds circuit_timeout)
@@ -85,6 +85,8 @@ LLCircuitData::LLCircuitData(const LLHost &host, TPACKETID in_id,
 	mLastPingID(0),
 	mPingDelay(INITIAL_PING_VALUE_MSEC), 
 	mPingDelayAveraged(INITIAL_PING_VALUE_MSEC), 
+	mPotentialLostPackets(LL_MAX_TRACKED_IN_PACKET_IDS),
+	mRecentlyReceivedReliablePackets(LL_MAX_TRACKED_IN_PACKET_IDS),
 	mUnackedPacketCount(0),
 	mUnackedPacketBytes(0),
 	mLastPacketInTime(0.0),
@@ -133,11 +135,10 @@ LLCircuitData::~LLCircuitData()
 
 	// remove all pending reliable messages on this circuit
 	std::vector<TPACKETID> doomed;
-	reliable_iter iter;
-	reliable_iter end = mUnackedPackets.end();
-	for(iter = mUnackedPackets.begin(); iter != end; ++iter)
+	TPACKETID id;
+	for (bool more = mUnackedPackets.first(id); more; more = mUnackedPackets.next(++id))
 	{
-		packetp = iter->second;
+		packetp = mUnackedPackets.get(id);
 		gMessageSystem->mFailedResendPackets++;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -156,10 +157,9 @@ LLCircuitData::~LLCircuitData()
 	}
 
 	// remove all pending final retry reliable messages on this circuit
-	end = mFinalRetryPackets.end();
-	for(iter = mFinalRetryPackets.begin(); iter != end; ++iter)
+	for (bool more = mFinalRetryPackets.first(id); more; more = mFinalRetryPackets.next(++id))
 	{
-		packetp = iter->second;
+		packetp = mFinalRetryPackets.get(id);
 		gMessageSystem->mFailedResendPackets++;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -191,13 +191,13 @@ LLCircuitData::~LLCircuitData()
 
 void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 {
-	reliable_iter iter;
+	LLReliablePacket **entryp;
 	LLReliablePacket *packetp;
 
-	iter = mUnackedPackets.find(packet_num);
-	if (iter != mUnackedPackets.end())
+	entryp = mUnackedPackets.find(packet_num);
+	if (entryp)
 	{
-		packetp = iter->second;
+		packetp = *entryp;
 
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -224,14 +224,14 @@ void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 
 		// Cleanup
 		delete packetp;
-		mUnackedPackets.erase(iter);
+		mUnackedPackets.erase(packet_num);
 		return;
 	}
 
-	iter = mFinalRetryPackets.find(packet_num);
-	if (iter != mFinalRetryPackets.end())
+	entryp = mFinalRetryPackets.find(packet_num);
+	if (entryp)
 	{
-		packetp = iter->second;
+		packetp = *entryp;
 		// LL_INFOS() << "Packet " << packet_num << " removed from the pending list" << LL_ENDL;
 		if(gMessageSystem->mVerboseLog)
 		{
@@ -258,7 +258,7 @@ void LLCircuitData::ackReliablePacket(TPACKETID packet_num)
 
 		// Cleanup
 		delete packetp;
-		mFinalRetryPackets.erase(iter);
+		mFinalRetryPackets.erase(packet_num);
 	}
 	else
 	{
@@ -275,17 +275,15 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 
 
 	//
-	// Theoretically we should search through the list for the packet with the oldest
-	// packet ID, as otherwise when we WRAP we will resend reliable packets out of order.
-	// Since resends are ALREADY out of order, and wrapping is highly rare (16+million packets),
-	// I'm not going to worry about this for now - djs
+	// The rings are walked oldest packet ID first, allowing for wrapping, so
+	// resends go out in the order the packets were first sent.
 	//
 
-	reliable_iter iter;
+	TPACKETID id;
 	BOOL have_resend_overflow = FALSE;
-	for (iter = mUnackedPackets.begin(); iter != mUnackedPackets.end();)
+	for (bool more = mUnackedPackets.first(id); more; more = mUnackedPackets.next(++id))
 	{
-		packetp = iter->second;
+		packetp = mUnackedPackets.get(id);
 
 		// Only check overflow if we haven't had one yet.
 		if (!have_resend_overflow)
@@ -306,12 +304,8 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 					// This circuit has overflowed.  Do not retry.  Do not pass go.
 					packetp->mRetries = 0;
 					// Remove it from this list and add it to the final list.
-					mUnackedPackets.erase(iter++);
-					mFinalRetryPackets[packetp->mPacketID] = packetp;
-				}
-				else
-				{
-					++iter;
+					mUnackedPackets.erase(id);
+					mFinalRetryPackets.insert(id, packetp);
 				}
 				// Move on to the next unacked packet.
 				continue;
@@ -366,26 +360,17 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 			if (!packetp->mRetries)
 			{
 				// Last resend, remove it from this list and add it to the final list.
-				mUnackedPackets.erase(iter++);
-				mFinalRetryPackets[packetp->mPacketID] = packetp;
-			}
-			else
-			{
-				// Don't remove it yet, it still gets to try to resend at least once.
-				++iter;
+				// Otherwise it still gets to try to resend at least once.
+				mUnackedPackets.erase(id);
+				mFinalRetryPackets.insert(id, packetp);
 			}
 		}
-		else
-		{
-			// Don't need to do anything with this packet, keep iterating.
-			++iter;
-		}
 	}
 
 
-	for (iter = mFinalRetryPackets.begin(); iter != mFinalRetryPackets.end();)
+	for (bool more = mFinalRetryPackets.first(id); more; more = mFinalRetryPackets.next(++id))
 	{
-		packetp = iter->second;
+		packetp = mFinalRetryPackets.get(id);
 		if (now > packetp->mExpirationTime)
 		{
 			// fail (too many retries)
@@ -413,13 +398,9 @@ S32 LLCircuitData::resendUnackedPackets(const F64Seconds now)
 			mUnackedPacketCount--;
 			mUnackedPacketBytes -= packetp->mBufferLength;
 
-			mFinalRetryPackets.erase(iter++);
+			mFinalRetryPackets.erase(id);
 			delete packetp;
 		}
-		else
-		{
-			++iter;
-		}
 	}
 
 	return mUnackedPacketCount;
@@ -573,11 +554,11 @@ void LLCircuitData::addReliablePacket(S32 mSocket, U8 *buf_ptr, S32 buf_len, LLR
 
 	if (params && params->mRetries)
 	{
-		mUnackedPackets[packet_info->mPacketID] = packet_info;
+		mUnackedPackets.insert(packet_info->mPacketID, packet_info);
 	}
 	else
 	{
-		mFinalRetryPackets[packet_info->mPacketID] = packet_info;
+		mFinalRetryPackets.insert(packet_info->mPacketID, packet_info);
 	}
 }
 
@@ -601,7 +582,7 @@ void LLCircuit::resendUnackedPackets(S32& unacked_list_length, S32& unacked_list
 
 BOOL LLCircuitData::isDuplicateResend(TPACKETID packetnum)
 {
-	return (mRecentlyReceivedReliablePackets.find(packetnum) != mRecentlyReceivedReliablePackets.end());
+	return mRecentlyReceivedReliablePackets.contains(packetnum);
 }
 
 
@@ -713,7 +694,7 @@ void LLCircuitData::checkPacketInID(TPACKETID id, BOOL receive_resent)
 		const U8 width = 24;
 		gap = LLModularMath::subtract<width>(mPacketsInID, id);
 
-		if (mPotentialLostPackets.find(id) != mPotentialLostPackets.end())
+		if (mPotentialLostPackets.contains(id))
 		{
 			if(gMessageSystem->mVerboseLog)
 			{
@@ -742,7 +723,7 @@ void LLCircuitData::checkPacketInID(TPACKETID id, BOOL receive_resent)
 					}
 
 //						LL_INFOS() << "adding potential lost: " << index << LL_ENDL;
-					mPotentialLostPackets[index] = time;
+					mPotentialLostPackets.insert(index, time);
 					index++;
 					index = index % LL_MAX_OUT_PACKET_ID;
 					gap_count++;
@@ -862,92 +843,28 @@ BOOL LLCircuitData::updateWatchDogTimers(LLMessageSystem *msgsys)
 	// for the packet that it was out of order with was received BEFORE
 	// the ping was sent.
 
-	// Find the current oldest reliable packetID
-	// This is to handle the case if we actually manage to wrap our
-	// packet IDs - the oldest will actually have a higher packet ID
-	// than the current.
-	BOOL wrapped = FALSE;
-	reliable_iter iter;
-	iter = mUnackedPackets.upper_bound(getPacketOutID());
-	if (iter == mUnackedPackets.end())
-	{
-		// Nothing AFTER this one, so we want the lowest packet ID
-		// then.
-		iter = mUnackedPackets.begin();
-		wrapped = TRUE;
-	}
-
+	// Find the current oldest reliable packetID.  The rings walk in
+	// sending order, so this handles the case where we actually manage to
+	// wrap our packet IDs and the oldest has a higher packet ID than the
+	// current.
 	TPACKETID packet_id = 0;
-
-	// Check against the "final" packets
-	BOOL wrapped_final = FALSE;
-	reliable_iter iter_final;
-	iter_final = mFinalRetryPackets.upper_bound(getPacketOutID());
-	if (iter_final == mFinalRetryPackets.end())
+	TPACKETID oldest_final = 0;
+	BOOL have_unacked = mUnackedPackets.first(packet_id);
+	if (mFinalRetryPackets.first(oldest_final))
 	{
-		iter_final = mFinalRetryPackets.begin();
-		wrapped_final = TRUE;
-	}
-
-	//LL_INFOS() << mHost << " - unacked count " << mUnackedPackets.size() << LL_ENDL;
-	//LL_INFOS() << mHost << " - final count " << mFinalRetryPackets.size() << LL_ENDL;
-	if (wrapped != wrapped_final)
-	{
-		// One of the "unacked" or "final" lists hasn't wrapped.  Whichever one
-		// hasn't has the oldest packet.
-		if (!wrapped)
+		// Use the oldest of the unacked list and the final list
+		if (!have_unacked || LLPacketIDSet::isBefore(oldest_final, packet_id))
 		{
-			// Hasn't wrapped, so the one on the
-			// unacked packet list is older
-			packet_id = iter->first;
-			//LL_INFOS() << mHost << ": nowrapped unacked" << LL_ENDL;
-		}
-		else
-		{
-			packet_id = iter_final->first;
-			//LL_INFOS() << mHost << ": nowrapped final" << LL_ENDL;
+			packet_id = oldest_final;
 		}
 	}
-	else
+	else if (!have_unacked)
 	{
-		// They both wrapped, we can just use the minimum of the two.
-		if ((iter == mUnackedPackets.end()) && (iter_final == mFinalRetryPackets.end()))
-		{
-			// Wow!  No unacked packets at all!
-			// Send the ID of the last packet we sent out.
-			// This will flush all of the destination's
-			// unacked packets, theoretically.
-			//LL_INFOS() << mHost << ": No unacked!" << LL_ENDL;
-			packet_id = getPacketOutID();
-		}
-		else
-		{
-			BOOL had_unacked = FALSE;
-			if (iter != mUnackedPackets.end())
-			{
-				// Unacked list has the lowest so far
-				packet_id = iter->first;
-				had_unacked = TRUE;
-				//LL_INFOS() << mHost << ": Unacked" << LL_ENDL;
-			}
-
-			if (iter_final != mFinalRetryPackets.end())
-			{
-				// Use the lowest of the unacked list and the final list
-				if (had_unacked)
-				{
-					// Both had a packet, use the lowest.
-					packet_id = llmin(packet_id, iter_final->first);
-					//LL_INFOS() << mHost << ": Min of unacked/final" << LL_ENDL;
-				}
-				else
-				{
-					// Only the final had a packet, use it.
-					packet_id = iter_final->first;
-					//LL_INFOS() << mHost << ": Final!" << LL_ENDL;
-				}
-			}
-		}
+		// Wow!  No unacked packets at all!
+		// Send the ID of the last packet we sent out.
+		// This will flush all of the destination's
+		// unacked packets, theoretically.
+		packet_id = getPacketOutID();
 	}
 
 	// Send off the another ping.
@@ -962,13 +879,13 @@ BOOL LLCircuitData::updateWatchDogTimers(LLMessageSystem *msgsys)
 	// Check to see if anything on our lost list is old enough to
 	// be considered lost
 
-	LLCircuitData::packet_time_map::iterator it;
 	U64Microseconds timeout = llmin(LL_MAX_LOST_TIMEOUT, F32Seconds(getPingDelayAveraged()) * LL_LOST_TIMEOUT_FACTOR);
 
 	U64Microseconds mt_usec = LLMessageSystem::getMessageTimeUsecs();
-	for (it = mPotentialLostPackets.begin(); it != mPotentialLostPackets.end(); )
+	TPACKETID id;
+	for (bool more = mPotentialLostPackets.first(id); more; more = mPotentialLostPackets.next(++id))
 	{
-		U64Microseconds delta_t_usec = mt_usec - (*it).second;
+		U64Microseconds delta_t_usec = mt_usec - mPotentialLostPackets.get(id);
 		if (delta_t_usec > timeout)
 		{
 			// let's call this one a loss!
@@ -978,14 +895,10 @@ BOOL LLCircuitData::updateWatchDogTimers(LLMessageSystem *msgsys)
 			{
 				std::ostringstream str;
 				str << "MSG: <- " << mHost << "\tLOST PACKET:\t"
-					<< (*it).first;
+					<< id;
 				LL_INFOS() << str.str() << LL_ENDL;
 			}
-			mPotentialLostPackets.erase(it++);
-		}
-		else
-		{
-			++it;
+			mPotentialLostPackets.erase(id);
 		}
 	}
 
@@ -998,45 +911,13 @@ void LLCircuitData::clearDuplicateList(TPACKETID oldest_id)
 	// purge old data from the duplicate suppression queue
 
 	// we want to KEEP all x where oldest_id <= x <= last incoming packet, and delete everything else.
+	// IDs from before a wrap are older than oldest_id by the set's reckoning, so they go too.
 
 	//LL_INFOS() << mHost << ": clearing before oldest " << oldest_id << LL_ENDL;
 	//LL_INFOS() << "Recent list before: " << mRecentlyReceivedReliablePackets.size() << LL_ENDL;
-	if (oldest_id < mHighestPacketID)
+	if (!LLPacketIDSet::isBefore(mHighestPacketID, oldest_id))
 	{
-		// Clean up everything with a packet ID less than oldest_id.
-		packet_time_map::iterator pit_start;
-		packet_time_map::iterator pit_end;
-		pit_start = mRecentlyReceivedReliablePackets.begin();
-		pit_end = mRecentlyReceivedReliablePackets.lower_bound(oldest_id);
-		mRecentlyReceivedReliablePackets.erase(pit_start, pit_end);
-	}
-
-	// Do timeout checks on everything with an ID > mHighestPacketID.
-	// This should be empty except for wrapping IDs.  Thus, this should be
-	// highly rare.
-	U64Microseconds mt_usec = LLMessageSystem::getMessageTimeUsecs();
-
-	packet_time_map::iterator pit;
-	for(pit = mRecentlyReceivedReliablePackets.upper_bound(mHighestPacketID);
-		pit != mRecentlyReceivedReliablePackets.end(); )
-	{
-		// Validate that the packet ID seems far enough away
-		if ((pit->first - mHighestPacketID) < 100)
-		{
-			LL_WARNS() << "Probably incorrectly timing out non-wrapped packets!" << LL_ENDL;
-		}
-		U64Microseconds delta_t_usec = mt_usec - (*pit).second;
-		F64Seconds delta_t_sec = delta_t_usec;
-		if (delta_t_sec > LL_DUPLICATE_SUPPRESSION_TIMEOUT)
-		{
-			// enough time has elapsed we're not likely to get a duplicate on this one
-			LL_INFOS() << "Clearing " << pit->first << " from recent list" << LL_ENDL;
-			mRecentlyReceivedReliablePackets.erase(pit++);
-		}
-		else
-		{
-			++pit;
-		}
+		mRecentlyReceivedReliablePackets.eraseBefore(oldest_id);
 	}
 	//LL_INFOS() << "Recent list after: " << mRecentlyReceivedReliablePackets.size() << LL_ENDL;
 }
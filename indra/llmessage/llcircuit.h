@@ -37,6 +37,7 @@
 #include "net.h"
 #include "llhost.h"
 #include "llpacketack.h"
+#include "llpacketidring.h"
 #include "lluuid.h"
 #include "llthrottle.h"
 
@@ -49,7 +50,6 @@ const F32Milliseconds LL_AVERAGED_PING_MIN(100);    // increased to avoid retran
 
 const U32Milliseconds INITIAL_PING_VALUE_MSEC(1000); // initial value for the ping delay, or for ping delay for an unknown circuit
 
-const TPACKETID LL_MAX_OUT_PACKET_ID = 0x01000000;
 const int LL_ERR_CIRCUIT_GONE   = -23017;
 const int LL_ERR_TCP_TIMEOUT    = -23016;
 
@@ -233,18 +233,19 @@ protected:
 	U32Milliseconds		mPingDelay;             // raw ping delay
 	F32Milliseconds		mPingDelayAveraged;     // averaged ping delay (fast attack/slow decay)
 
-	typedef std::map<TPACKETID, U64Microseconds> packet_time_map;
+	// Indexed by packet ID rather than kept in maps, as these see a
+	// node allocated and freed for nearly every packet under loss.
+	typedef LLPacketIDRing<U64Microseconds> packet_time_ring;
 
-	packet_time_map							mPotentialLostPackets;
-	packet_time_map							mRecentlyReceivedReliablePackets;
+	packet_time_ring						mPotentialLostPackets;		// gaps, with when they were noticed
+	LLPacketIDSet							mRecentlyReceivedReliablePackets;	// for duplicate suppression
 	std::vector<TPACKETID> mAcks;
 	F32 mAckCreationTime; // first ack creation time
 
-	typedef std::map<TPACKETID, LLReliablePacket *> reliable_map;
-	typedef reliable_map::iterator					reliable_iter;
+	typedef LLPacketIDRing<LLReliablePacket *> reliable_ring;
 
-	reliable_map							mUnackedPackets;
-	reliable_map							mFinalRetryPackets;
+	reliable_ring							mUnackedPackets;
+	reliable_ring							mFinalRetryPackets;
 
 	S32										mUnackedPacketCount;
 	S32										mUnackedPacketBytes;
@@ -35,8 +35,6 @@
 #include "llsd.h"
 #include "llsdjson.h"
 #include "llsdserialize.h"
-#include "json/reader.h" // JSON
-#include "json/writer.h" // JSON
 #include "llfilesystem.h"
 
 #include "message.h" // for getting the port
@@ -63,6 +61,14 @@ namespace
         return mBoolSettingGet(HTTP_LOGBODY_KEY);
     }
 
+    // Parses a JSON reply body straight into LLSD, without going through
+    // a Json::Value tree.
+    bool jsonBodyToLLSD(BufferArray * body, LLSD & result, std::string & error)
+    {
+        std::string flat(body->size(), '\0');
+        body->read(0, &flat[0], flat.size());
+        return LlsdFromJson(flat.data(), flat.size(), result, &error);
+    }
 }
 
 void setPropertyMethods(BoolSettingQuery_t queryfn, BoolSettingUpdate_t updatefn)
@@ -118,9 +124,12 @@ bool responseToLLSD(HttpResponse * response, bool log, LLSD & out_llsd)
         return false;
     }
 
-    LLCore::BufferArrayStream bas(body);
+    // Parse from one contiguous copy of the body rather than through
+    // a stream, which lets the XML parser scan the buffer directly.
+    std::string flat(body->size(), '\0');
+    body->read(0, &flat[0], flat.size());
     LLSD body_llsd;
-    S32 parse_status(LLSDSerialize::fromXML(body_llsd, bas, log));
+    S32 parse_status(LLSDSerialize::fromXML(body_llsd, flat.data(), flat.size(), log));
     if (LLSDParser::PARSE_FAILURE == parse_status){
         return false;
     }
@@ -584,23 +593,15 @@ LLSD HttpCoroJSONHandler::handleSuccess(LLCore::HttpResponse * response, LLCore:
         return result;
     }
 
-    LLCore::BufferArrayStream bas(body);
-    Json::Value jsonRoot;
-
-    try
-    {
-        bas >> jsonRoot;
-    }
-    catch (std::runtime_error& e)
+    LLSD body_llsd;
+    std::string error;
+    if (!jsonBodyToLLSD(body, body_llsd, error))
     {   // deserialization failed.  Record the reason and pass back an empty map for markup.
-        status = LLCore::HttpStatus(499, std::string(e.what()));
+        status = LLCore::HttpStatus(499, error);
         return result;
     }
 
-    // Convert the JSON structure to LLSD
-    result = LlsdFromJson(jsonRoot);
-
-    return result;
+    return body_llsd;
 }
 
 LLSD HttpCoroJSONHandler::parseBody(LLCore::HttpResponse *response, bool &success)
@@ -612,21 +613,15 @@ LLSD HttpCoroJSONHandler::parseBody(LLCore::HttpResponse *response, bool &succes
         return LLSD();
     }
 
-    LLCore::BufferArrayStream bas(body);
-    Json::Value jsonRoot;
-
-    try
-    {
-        bas >> jsonRoot;
-    }
-    catch (std::runtime_error&)
+    LLSD body_llsd;
+    std::string error;
+    if (!jsonBodyToLLSD(body, body_llsd, error))
     {   
         success = false;
         return LLSD();
     }
 
-    // Convert the JSON structure to LLSD
-    return LlsdFromJson(jsonRoot);
+    return body_llsd;
 }
 
 //========================================================================
@@ -802,13 +797,9 @@ LLSD HttpCoroutineAdapter::postJsonAndSuspend(LLCore::HttpRequest::ptr_t request
 
     {
         LLCore::BufferArrayStream outs(rawbody.get());
-        Json::Value root = LlsdToJson(body);
-        Json::FastWriter writer;
-
-        LL_WARNS("Http::post") << "JSON Generates: \"" << writer.write(root) << "\"" << LL_ENDL;
-
-        outs << writer.write(root);
+        LlsdToJson(body, outs);
     }
+    LL_DEBUGS("Http::post") << "JSON Generates " << rawbody->size() << " bytes" << LL_ENDL;
 
     return postAndSuspend_(request, url, rawbody, options, headers, httpHandler);
 }
@@ -861,12 +852,9 @@ LLSD HttpCoroutineAdapter::putJsonAndSuspend(LLCore::HttpRequest::ptr_t request,
 
     {
         LLCore::BufferArrayStream outs(rawbody.get());
-        Json::Value root = LlsdToJson(body);
-        Json::FastWriter writer;
-
-        LL_WARNS("Http::put") << "JSON Generates: \"" << writer.write(root) << "\"" << LL_ENDL;
-        outs << writer.write(root);
+        LlsdToJson(body, outs);
     }
+    LL_DEBUGS("Http::put") << "JSON Generates " << rawbody->size() << " bytes" << LL_ENDL;
 
     return putAndSuspend_(request, url, rawbody, options, headers, httpHandler);
 }
@@ -0,0 +1,206 @@
+/**
+ * @file llmessagedecoder.h
+ * @brief Support for the decoders generated from message_template.msg
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESSAGEDECODER_H
+#define LL_LLMESSAGEDECODER_H
+
+#include <string>
+
+#include "llmath.h"
+#include "llquaternion.h"
+#include "message.h"
+#include "v3math.h"
+
+// A Variable field of a decoded message. Points into the buffer the
+// message was decoded from, so only valid while that is, which for a
+// message handler means until it returns.
+struct LLDecodedBytes
+{
+    LLDecodedBytes() : mData(NULL), mSize(0) {}
+
+    // As LLMessageSystem::getString(): up to the first nul, at most
+    // MTUBYTES long
+    std::string asString() const
+    {
+        S32 length = 0;
+        const S32 max_length = llmin(mSize, (S32) MTUBYTES);
+        while (length < max_length && mData[length])
+        {
+            ++length;
+        }
+        return std::string((const char*) mData, length);
+    }
+
+    const U8* mData;
+    S32 mSize;
+};
+
+// Walks a message the way LLTemplateMessageReader::decodeData() does.
+// Used by the generated decoders, which do the per field work with
+// offsets known at compile time. Multi-byte values are little endian on
+// the wire, as htolememcpy() expects, and copied as is.
+class LLMessageDecodeCursor
+{
+public:
+    LLMessageDecodeCursor(const U8* buffer, S32 size)
+    :   mBuffer(buffer),
+        mSize(size),
+        mPos(0)
+    {
+    }
+
+    // Checks the message number, frequency_size bytes of it as in the
+    // template, and skips to the first block past any extra header
+    bool begin(U32 number, S32 frequency_size)
+    {
+        const S32 number_pos = LL_PACKET_ID_SIZE;
+        if (mSize < number_pos + frequency_size)
+        {
+            return false;
+        }
+
+        const U8* header = mBuffer + number_pos;
+        switch (frequency_size)
+        {
+        case 1:
+            if (header[0] != number)
+            {
+                return false;
+            }
+            break;
+        case 2:
+            if (header[0] != 255 || header[1] != (number & 0xFF))
+            {
+                return false;
+            }
+            break;
+        default:
+            // low and fixed frequency numbers are in network byte order
+            if (header[0] != 255 || header[1] != 255
+                || header[2] != ((number >> 8) & 0xFF) || header[3] != (number & 0xFF))
+            {
+                return false;
+            }
+            break;
+        }
+
+        mPos = number_pos + frequency_size + mBuffer[PHL_OFFSET];
+        return mPos <= mSize;
+    }
+
+    // The next bytes of fixed size fields, NULL if the message is short
+    const U8* take(S32 bytes)
+    {
+        if (mPos + bytes > mSize)
+        {
+            return NULL;
+        }
+        const U8* data = mBuffer + mPos;
+        mPos += bytes;
+        return data;
+    }
+
+    // Repeat count of a Variable block. Missing ones at the end of a
+    // message are legal and mean none.
+    U8 takeCount()
+    {
+        return (mPos < mSize) ? mBuffer[mPos++] : 0;
+    }
+
+    // A Variable field with a length_size byte length in front of it
+    bool takeVariable(S32 length_size, LLDecodedBytes& bytes)
+    {
+        const U8* length_data = take(length_size);
+        if (!length_data)
+        {
+            return false;
+        }
+
+        S32 length = 0;
+        switch (length_size)
+        {
+        case 1:
+            length = length_data[0];
+            break;
+        case 2:
+            length = length_data[0] | (length_data[1] << 8);
+            break;
+        default:
+            length = (S32) (length_data[0] | (length_data[1] << 8)
+                            | (length_data[2] << 16) | ((U32) length_data[3] << 24));
+            break;
+        }
+
+        bytes.mData = take(length);
+        bytes.mSize = length;
+        return bytes.mData != NULL;
+    }
+
+private:
+    const U8* mBuffer;
+    S32 mSize;
+    S32 mPos;
+};
+
+// IPPORT fields are the one type sent in network byte order
+inline U16 ll_decode_ip_port(const U8* data)
+{
+    return (U16) ((data[0] << 8) | data[1]);
+}
+
+// LLQuaternion fields are sent as their vector part, as getQuat() reads
+inline void ll_decode_quat(const U8* data, LLQuaternion& q)
+{
+    LLVector3 vec;
+    memcpy(vec.mV, data, sizeof(vec.mV));
+    if (vec.isFinite())
+    {
+        q.unpackFromVector3(vec);
+    }
+    else
+    {
+        q.loadIdentity();
+    }
+}
+
+// The message LLMessageSystem is currently handling, when it came in
+// over UDP. Messages delivered as LLSD have no template encoding to
+// decode.
+inline bool ll_get_decodable_message(LLMessageSystem* msg, const U8*& buffer, S32& size)
+{
+    return msg && msg->getReceiveBuffer(buffer, size);
+}
+
+// Reports a packet its decoder couldn't make sense of, as the template
+// reader does when it runs off the end of one
+inline void ll_decode_failed(LLMessageSystem* msg)
+{
+    LL_WARNS("Messaging") << "Couldn't decode " << msg->getMessageName()
+                          << " from " << msg->getSender() << LL_ENDL;
+    msg->callExceptionFunc(MX_RAN_OFF_END_OF_PACKET);
+}
+
+#endif // LL_LLMESSAGEDECODER_H
@@ -286,6 +286,7 @@ public:
 		mMaxDecodeTimePerMsg(0.f),
 		mBanFromTrusted(false),
 		mBanFromUntrusted(false),
+		mHandlerDecodes(false),
 		mHandlerFunc(NULL), 
 		mUserData(NULL)
 	{ 
@@ -412,6 +413,10 @@ public:
 	bool									mBanFromTrusted;
 	bool									mBanFromUntrusted;
 
+	// The handler reads the packet with its generated decoder, so the
+	// template reader needn't build LLMsgData for it
+	bool									mHandlerDecodes;
+
 private:
 	// message handler function (this is set by each application)
 	void									(*mHandlerFunc)(LLMessageSystem *msgsystem, void **user_data);
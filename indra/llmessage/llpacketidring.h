@@ -0,0 +1,359 @@
+/**
+ * @file llpacketidring.h
+ * @brief Packet ID indexed sets and rings used for reliable packet tracking
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETIDRING_H
+#define LL_LLPACKETIDRING_H
+
+#include <algorithm>
+#include <vector>
+
+#include "llcharscan.h"
+#include "llerror.h"
+#include "stdtypes.h"
+
+// Packet IDs are 24 bits and wrap
+const TPACKETID LL_MAX_OUT_PACKET_ID = 0x01000000;
+
+// A set of packet IDs that lie close together, as the IDs in flight on a
+// circuit do. Each ID has a bit in a ring indexed by the ID itself, so
+// lookups, inserts and erases are a mask and a bit test. The ring covers
+// the IDs from the oldest held to the newest and doubles when they no
+// longer fit, up to max_capacity if one is given, past which the oldest
+// IDs are forgotten. "Older" is modulo LL_MAX_OUT_PACKET_ID, so the set
+// carries on working as IDs wrap.
+class LLPacketIDSet
+{
+public:
+    LLPacketIDSet(U32 max_capacity = 0)
+    :   mBits(MIN_CAPACITY / 32, 0),
+        mMask(MIN_CAPACITY - 1),
+        mMaxCapacity(max_capacity),
+        mBase(0),
+        mSpan(0),
+        mCount(0)
+    {
+    }
+
+    bool empty() const { return !mCount; }
+    U32 size() const { return mCount; }
+
+    bool contains(TPACKETID id) const
+    {
+        return offsetOf(id) < mSpan && testSlot(id & mMask);
+    }
+
+    // False if id was already there or is too far behind the newest
+    // to be held
+    bool insert(TPACKETID id)
+    {
+        const S32 slot = reserve(id);
+        if (slot < 0 || testSlot(slot))
+        {
+            return false;
+        }
+        setSlot(slot);
+        return true;
+    }
+
+    bool erase(TPACKETID id)
+    {
+        if (!contains(id))
+        {
+            return false;
+        }
+        clearSlot(id & mMask);
+        if (id == mBase)
+        {
+            advanceBase();
+        }
+        return true;
+    }
+
+    // Forgets every ID older than id
+    void eraseBefore(TPACKETID id)
+    {
+        const U32 offset = offsetOf(id);
+        if (!mCount || offset == 0 || offset >= HALF_RANGE)
+        {
+            return;
+        }
+        if (offset >= mSpan)
+        {
+            clear();
+            return;
+        }
+
+        TPACKETID present = mBase;
+        while (next(present) && offsetOf(present) < offset)
+        {
+            clearSlot(present & mMask);
+            ++present;
+        }
+        advanceBase();
+    }
+
+    void clear()
+    {
+        std::fill(mBits.begin(), mBits.end(), 0);
+        mSpan = 0;
+        mCount = 0;
+    }
+
+    // Oldest ID held, false if empty. With next(), walks the set in
+    // order:
+    //   for (bool more = set.first(id); more; more = set.next(++id))
+    // Erasing the current ID inside the loop is safe.
+    bool first(TPACKETID& id) const
+    {
+        id = mBase;
+        return mCount != 0;
+    }
+
+    // Moves id on to the first ID held at or after it, false if there
+    // are none
+    bool next(TPACKETID& id) const
+    {
+        U32 offset = offsetOf(id);
+        if (offset >= mSpan)
+        {
+            if (!mCount || offset < HALF_RANGE)
+            {
+                return false;
+            }
+            // behind the oldest, which has been erased since
+            offset = 0;
+        }
+
+        while (offset < mSpan)
+        {
+            const U32 slot = (mBase + offset) & mMask;
+            const U32 word = mBits[slot >> 5] >> (slot & 31);
+            if (word)
+            {
+                // Only IDs in the window have bits set, but the word can
+                // run on past the newest into slots of the oldest
+                offset += LL::lowest_bit(word);
+                if (offset >= mSpan)
+                {
+                    return false;
+                }
+                id = (mBase + offset) & ID_MASK;
+                return true;
+            }
+            offset += 32 - (slot & 31);
+        }
+        return false;
+    }
+
+    // Whether a comes before b, allowing for wrapping
+    static bool isBefore(TPACKETID a, TPACKETID b)
+    {
+        const U32 distance = (b - a) & ID_MASK;
+        return distance && distance < HALF_RANGE;
+    }
+
+protected:
+    static const U32 MIN_CAPACITY = 64;
+    static const U32 ID_MASK = LL_MAX_OUT_PACKET_ID - 1;
+    static const U32 HALF_RANGE = LL_MAX_OUT_PACKET_ID / 2;
+
+    U32 offsetOf(TPACKETID id) const { return (id - mBase) & ID_MASK; }
+
+    bool testSlot(U32 slot) const { return (mBits[slot >> 5] >> (slot & 31)) & 1; }
+
+    void setSlot(U32 slot)
+    {
+        mBits[slot >> 5] |= 1U << (slot & 31);
+        ++mCount;
+    }
+
+    void clearSlot(U32 slot)
+    {
+        mBits[slot >> 5] &= ~(1U << (slot & 31));
+        --mCount;
+    }
+
+    // Widens the window to take id, growing the ring if it has to.
+    // Returns id's slot, or -1 if it's too old to be held.
+    S32 reserve(TPACKETID id)
+    {
+        id &= ID_MASK;
+        if (!mCount)
+        {
+            mBase = id;
+            mSpan = 1;
+            return id & mMask;
+        }
+
+        U32 offset = offsetOf(id);
+        if (offset < mSpan)
+        {
+            return id & mMask;
+        }
+
+        TPACKETID base = mBase;
+        U32 span = offset + 1;
+        if (offset >= HALF_RANGE)
+        {
+            // older than anything held
+            base = id;
+            span = mSpan + (LL_MAX_OUT_PACKET_ID - offset);
+            if (span > HALF_RANGE || (mMaxCapacity && span > mMaxCapacity))
+            {
+                return -1;
+            }
+        }
+        else if (mMaxCapacity && span > mMaxCapacity)
+        {
+            // slide the window on, forgetting the oldest
+            eraseBefore((id - mMaxCapacity + 1) & ID_MASK);
+            if (!mCount)
+            {
+                mBase = id;
+                mSpan = 1;
+                return id & mMask;
+            }
+            base = mBase;
+            span = offsetOf(id) + 1;
+        }
+
+        if (span > mMask + 1)
+        {
+            grow(span);
+        }
+        mBase = base;
+        mSpan = span;
+        return id & mMask;
+    }
+
+    // Moves the bits for the IDs held into a ring of at least span
+    void grow(U32 span)
+    {
+        U32 capacity = mMask + 1;
+        while (capacity < span)
+        {
+            capacity <<= 1;
+        }
+
+        const U32 mask = capacity - 1;
+        std::vector<U32> bits(capacity / 32, 0);
+        TPACKETID id;
+        for (bool more = first(id); more; more = next(++id))
+        {
+            const U32 slot = id & mask;
+            bits[slot >> 5] |= 1U << (slot & 31);
+        }
+        mBits.swap(bits);
+        mMask = mask;
+    }
+
+private:
+    // The oldest ID has gone, start the window at the next one
+    void advanceBase()
+    {
+        if (!mCount)
+        {
+            mSpan = 0;
+            return;
+        }
+        TPACKETID base = mBase;
+        next(base);
+        mSpan -= offsetOf(base);
+        mBase = base;
+    }
+
+protected:
+    std::vector<U32> mBits;
+    U32 mMask;
+    U32 mMaxCapacity;
+
+    TPACKETID mBase;    // oldest ID held
+    U32 mSpan;          // IDs from the oldest up to past the newest
+    U32 mCount;
+};
+
+// An LLPacketIDSet with a value for each ID, kept in a second ring
+// alongside the bits. Values are plain data; erasing an ID doesn't touch
+// its value.
+template<class T>
+class LLPacketIDRing : public LLPacketIDSet
+{
+public:
+    LLPacketIDRing(U32 max_capacity = 0)
+    :   LLPacketIDSet(max_capacity),
+        mValues(mMask + 1)
+    {
+    }
+
+    T* find(TPACKETID id)
+    {
+        return contains(id) ? &mValues[id & mMask] : NULL;
+    }
+
+    // Value of an ID known to be held
+    T& get(TPACKETID id)
+    {
+        llassert(contains(id));
+        return mValues[id & mMask];
+    }
+
+    // Adds or replaces id's value, false if it's too old to be held
+    bool insert(TPACKETID id, const T& value)
+    {
+        const U32 old_mask = mMask;
+        const S32 slot = reserve(id);
+        if (slot < 0)
+        {
+            return false;
+        }
+        if (mMask != old_mask)
+        {
+            relocate(old_mask);
+        }
+        mValues[slot] = value;
+        if (!testSlot(slot))
+        {
+            setSlot(slot);
+        }
+        return true;
+    }
+
+private:
+    void relocate(U32 old_mask)
+    {
+        std::vector<T> values(mMask + 1);
+        TPACKETID id;
+        for (bool more = first(id); more; more = next(++id))
+        {
+            values[id & mMask] = mValues[id & old_mask];
+        }
+        mValues.swap(values);
+    }
+
+    std::vector<T> mValues;
+};
+
+#endif // LL_LLPACKETIDRING_H
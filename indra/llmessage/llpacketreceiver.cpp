@@ -0,0 +1,262 @@
+/**
+ * @file llpacketreceiver.cpp
+ * @brief Thread draining the message system's UDP socket in batches
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketreceiver.h"
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+typedef int socklen_t;
+#else
+	#include <sys/types.h>
+	#include <sys/socket.h>
+	#include <sys/select.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+#endif
+
+#include "lltimer.h"
+#include "message.h"
+
+namespace
+{
+    // Most datagrams read by one system call
+    const U32 MAX_BATCH = 32;
+
+    // How long the thread blocks on an idle socket before checking
+    // whether it's been asked to quit
+    const S32 WAIT_MS = 50;
+}
+
+LLPacketReceiver::LLPacketReceiver(S32 socket, U32 capacity)
+:   LLThread("PacketReceiver"),
+    mSocket(socket),
+    mHead(0),
+    mTail(0)
+{
+    U32 size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    mPackets.resize(size);
+    mMask = size - 1;
+}
+
+LLPacketReceiver::~LLPacketReceiver()
+{
+    shutdown();
+}
+
+LLPacketReceiver::Packet* LLPacketReceiver::front()
+{
+    const U32 tail = mTail.load(std::memory_order_relaxed);
+    if (tail == mHead.load(std::memory_order_acquire))
+    {
+        return NULL;
+    }
+    return &mPackets[tail & mMask];
+}
+
+void LLPacketReceiver::pop()
+{
+    const U32 tail = mTail.load(std::memory_order_relaxed);
+    llassert(tail != mHead.load(std::memory_order_acquire));
+    mTail.store(tail + 1, std::memory_order_release);
+}
+
+U32 LLPacketReceiver::getCount() const
+{
+    return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_relaxed);
+}
+
+void LLPacketReceiver::run()
+{
+    const U32 capacity = (U32) mPackets.size();
+    while (!isQuitting())
+    {
+        const U32 head = mHead.load(std::memory_order_relaxed);
+        const U32 free_slots = capacity - (head - mTail.load(std::memory_order_acquire));
+        if (!free_slots)
+        {
+            // Consumer is behind, leave the rest in the socket buffer
+            ms_sleep(1);
+            continue;
+        }
+
+        if (!waitReadable(WAIT_MS))
+        {
+            continue;
+        }
+
+        // Slots up to the end of the ring are contiguous
+        const U32 first = head & mMask;
+        const U32 count = llmin(llmin(free_slots, capacity - first), MAX_BATCH);
+        const U32 received = receiveBatch(first, count);
+        for (U32 i = 0; i < received; ++i)
+        {
+            prepare(mPackets[first + i]);
+        }
+        if (received)
+        {
+            mHead.store(head + received, std::memory_order_release);
+        }
+    }
+}
+
+bool LLPacketReceiver::waitReadable(S32 timeout_ms) const
+{
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET(mSocket, &read_fds);
+
+    timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    return select(mSocket + 1, &read_fds, NULL, NULL, &timeout) > 0;
+}
+
+U32 LLPacketReceiver::receiveBatch(U32 first, U32 count)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+
+    sockaddr_in addrs[MAX_BATCH];
+#if LL_LINUX
+    // One recvmmsg() for the lot, with the address each datagram was
+    // sent to so the receiving interface can be reported as
+    // receive_packet() does
+    mmsghdr msgs[MAX_BATCH];
+    iovec iovs[MAX_BATCH];
+    char controls[MAX_BATCH][CMSG_SPACE(sizeof(in_pktinfo))];
+
+    memset(msgs, 0, sizeof(msgs[0]) * count);
+    for (U32 i = 0; i < count; ++i)
+    {
+        iovs[i].iov_base = mPackets[first + i].mData;
+        iovs[i].iov_len = MAX_DATAGRAM_SIZE;
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = controls[i];
+        msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+    }
+
+    int received = recvmmsg(mSocket, msgs, count, MSG_DONTWAIT, NULL);
+    if (received <= 0)
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < received; ++i)
+    {
+        Packet& packet = mPackets[first + i];
+        packet.mSize = (S32) msgs[i].msg_len;
+        packet.mHost = LLHost(addrs[i].sin_addr.s_addr, ntohs(addrs[i].sin_port));
+
+        U32 receiving_ip = INVALID_HOST_IP_ADDRESS;
+        for (cmsghdr* cmsgp = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsgp; cmsgp = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsgp))
+        {
+            if (cmsgp->cmsg_level == SOL_IP && cmsgp->cmsg_type == IP_PKTINFO)
+            {
+                receiving_ip = ((in_pktinfo*) CMSG_DATA(cmsgp))->ipi_spec_dst.s_addr;
+            }
+        }
+        packet.mReceivingIF = LLHost(receiving_ip, INVALID_PORT);
+    }
+    return (U32) received;
+#else
+    // Read until the socket is drained or the batch is full
+    U32 received = 0;
+    for (; received < count; ++received)
+    {
+        Packet& packet = mPackets[first + received];
+        socklen_t addr_size = sizeof(addrs[received]);
+        int size = recvfrom(mSocket, (char*) packet.mData, MAX_DATAGRAM_SIZE, 0,
+                            (sockaddr*) &addrs[received], &addr_size);
+        if (size <= 0)
+        {
+            break;
+        }
+        packet.mSize = size;
+        packet.mHost = LLHost(addrs[received].sin_addr.s_addr, ntohs(addrs[received].sin_port));
+        packet.mReceivingIF = LLHost(INVALID_HOST_IP_ADDRESS, INVALID_PORT);
+    }
+    return received;
+#endif
+}
+
+void LLPacketReceiver::prepare(Packet& packet) const
+{
+    if (LLProxy::isSOCKSProxyEnabled())
+    {
+        // *FIX As in LLPacketRing, assumes ATYP is 0x01 (IPv4)
+        if (packet.mSize > SOCKS_HEADER_SIZE)
+        {
+            proxywrap_t header;
+            memcpy(&header, packet.mData, sizeof(header));
+            packet.mHost = LLHost(header.addr, ntohs(header.port));
+            packet.mSize -= SOCKS_HEADER_SIZE;
+            memmove(packet.mData, packet.mData + SOCKS_HEADER_SIZE, packet.mSize);
+        }
+        else
+        {
+            packet.mSize = 0;
+        }
+    }
+
+    // receive_packet() never returns more than this
+    packet.mSize = llmin(packet.mSize, NET_BUFFER_SIZE);
+
+    // Same split of message and appended acks as checkMessages()
+    packet.mBodySize = 0;
+    packet.mExpandedSize = 0;
+    packet.mExpandOverflowed = false;
+    if (packet.mSize < LL_MINIMUM_VALID_PACKET_SIZE)
+    {
+        return;
+    }
+
+    S32 body_size = packet.mSize;
+    if (packet.mData[0] & LL_ACK_FLAG)
+    {
+        const S32 acks = packet.mData[--body_size];
+        if (body_size < (S32) (acks * sizeof(TPACKETID) + LL_MINIMUM_VALID_PACKET_SIZE))
+        {
+            // malformed, left for checkMessages() to report
+            return;
+        }
+        body_size -= acks * sizeof(TPACKETID);
+    }
+    packet.mBodySize = body_size;
+
+    if (packet.mData[0] & LL_ZERO_CODE_FLAG)
+    {
+        packet.mExpandedSize = LLMessageSystem::zeroCodeExpand(packet.mData, body_size,
+                                                               packet.mExpanded, packet.mExpandOverflowed);
+    }
+}
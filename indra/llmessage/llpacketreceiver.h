@@ -0,0 +1,104 @@
+/**
+ * @file llpacketreceiver.h
+ * @brief Thread draining the message system's UDP socket in batches
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETRECEIVER_H
+#define LL_LLPACKETRECEIVER_H
+
+#include <atomic>
+#include <vector>
+
+#include "llhost.h"
+#include "llproxy.h"
+#include "llthread.h"
+#include "net.h"
+
+// Reads datagrams off a socket on its own thread, as many per system call
+// as the platform allows (recvmmsg on Linux), and zero-code expands the
+// message body of each so the thread calling LLMessageSystem::checkMessages()
+// only has circuit handling and template decoding left to do.
+//
+// Packets are handed over through a fixed size single producer, single
+// consumer ring. When the ring is full the thread stops reading and lets
+// the socket's own buffer take up the slack, so nothing is dropped here
+// that the kernel wouldn't have dropped anyway.
+class LLPacketReceiver : public LLThread
+{
+public:
+    // Room for a SOCKS 5 UDP header in front of a full size datagram
+    static const S32 MAX_DATAGRAM_SIZE = NET_BUFFER_SIZE + SOCKS_HEADER_SIZE;
+
+    struct Packet
+    {
+        U8      mData[MAX_DATAGRAM_SIZE];   // as received, less any SOCKS header
+        S32     mSize;
+        LLHost  mHost;
+        LLHost  mReceivingIF;
+
+        // Size of the message itself, without the appended acks
+        S32     mBodySize;
+        // The message zero-code expanded, if it was zero coded and
+        // well formed
+        U8      mExpanded[NET_BUFFER_SIZE];
+        S32     mExpandedSize;              // 0 if not expanded
+        bool    mExpandOverflowed;          // expansion ran past NET_BUFFER_SIZE
+    };
+
+    // capacity is rounded up to a power of two
+    LLPacketReceiver(S32 socket, U32 capacity = 256);
+    ~LLPacketReceiver();
+
+    // Consumer thread only. Oldest packet not yet popped, NULL if there
+    // are none. Stays valid until pop().
+    Packet* front();
+    void pop();
+
+    // Consumer thread only. Number of packets waiting.
+    U32 getCount() const;
+
+protected:
+    void run() override;
+
+private:
+    // Waits for the socket to be readable for up to timeout_ms
+    bool waitReadable(S32 timeout_ms) const;
+
+    // Fills up to count slots starting at mHead, returns the number read.
+    // The slots are contiguous in mPackets.
+    U32 receiveBatch(U32 first, U32 count);
+
+    void prepare(Packet& packet) const;
+
+    S32 mSocket;
+    std::vector<Packet> mPackets;
+    U32 mMask;
+
+    // Free running counters, masked on use. The receive thread only
+    // writes mHead and the consumer only mTail.
+    std::atomic<U32> mHead;
+    std::atomic<U32> mTail;
+};
+
+#endif // LL_LLPACKETRECEIVER_H
@@ -55,7 +55,9 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	mReceiver(NULL),
+	mHoldingReceived(false)
 {
 }
 
@@ -68,6 +70,8 @@ LLPacketRing::~LLPacketRing ()
 ///////////////////////////////////////////////////////////
 void LLPacketRing::cleanup ()
 {
+	stopReceiveThread();
+
 	LLPacketBuffer *packetp;
 
 	while (!mReceiveQueue.empty())
@@ -99,9 +103,65 @@ void LLPacketRing::setDropPercentage (F32 percent_to_drop)
 
 void LLPacketRing::setUseInThrottle(const BOOL use_throttle)
 {
+	if (use_throttle && mReceiver)
+	{
+		// The throttle reads the socket itself
+		LL_INFOS("Messaging") << "Incoming throttle enabled, stopping receive thread" << LL_ENDL;
+		stopReceiveThread();
+	}
 	mUseInThrottle = use_throttle;
 }
 
+///////////////////////////////////////////////////////////
+void LLPacketRing::startReceiveThread(S32 socket)
+{
+	if (mReceiver || mUseInThrottle)
+	{
+		return;
+	}
+	mReceiver = new LLPacketReceiver(socket);
+	mReceiver->start();
+}
+
+void LLPacketRing::stopReceiveThread()
+{
+	if (mReceiver)
+	{
+		// Anything still queued is lost, as it would be if the socket
+		// were closed with it unread.
+		delete mReceiver;
+		mReceiver = NULL;
+		mHoldingReceived = false;
+	}
+}
+
+S32 LLPacketRing::receiveFromThread(char *datap)
+{
+	if (mHoldingReceived)
+	{
+		mReceiver->pop();
+		mHoldingReceived = false;
+	}
+
+	// Skip anything that was only a SOCKS header
+	LLPacketReceiver::Packet* packetp = mReceiver->front();
+	while (packetp && !packetp->mSize)
+	{
+		mReceiver->pop();
+		packetp = mReceiver->front();
+	}
+	if (!packetp)
+	{
+		return 0;
+	}
+
+	memcpy(datap, packetp->mData, packetp->mSize);	/*Flawfinder: ignore*/
+	mLastSender = packetp->mHost;
+	mLastReceivingIF = packetp->mReceivingIF;
+	mHoldingReceived = true;
+	return packetp->mSize;
+}
+
 void LLPacketRing::setUseOutThrottle(const BOOL use_throttle)
 {
 	mUseOutThrottle = use_throttle;
@@ -224,7 +284,11 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 	else
 	{
 		// no delay, pull straight from net
-		if (LLProxy::isSOCKSProxyEnabled())
+		if (mReceiver)
+		{
+			packet_size = receiveFromThread(datap);
+		}
+		else if (LLProxy::isSOCKSProxyEnabled())
 		{
 			U8 buffer[NET_BUFFER_SIZE + SOCKS_HEADER_SIZE];
 			packet_size = receive_packet(socket, static_cast<char*>(static_cast<void*>(buffer)));
@@ -250,7 +314,10 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 			mLastSender = ::get_sender();
 		}
 
-		mLastReceivingIF = ::get_receiving_interface();
+		if (!mReceiver)
+		{
+			mLastReceivingIF = ::get_receiving_interface();
+		}
 
 		if (packet_size)  // did we actually get a packet?
 		{
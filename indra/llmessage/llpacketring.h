@@ -32,6 +32,7 @@
 
 #include "llhost.h"
 #include "llpacketbuffer.h"
+#include "llpacketreceiver.h"
 #include "llproxy.h"
 #include "llthrottle.h"
 #include "net.h"
@@ -53,6 +54,15 @@ public:
 	S32  receivePacket (S32 socket, char *datap);
 	S32  receiveFromRing (S32 socket, char *datap);
 
+	// Read the socket on a thread of its own from now on, see
+	// LLPacketReceiver.  Not while the incoming throttle is in use.
+	void startReceiveThread(S32 socket);
+	void stopReceiveThread();
+
+	// The packet receivePacket() last returned if it came from the
+	// receive thread, NULL otherwise.  Valid until the next call.
+	LLPacketReceiver::Packet* getLastReceived()	{ return mHoldingReceived ? mReceiver->front() : NULL; }
+
 	BOOL sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host);
 
 	inline LLHost getLastSender();
@@ -83,7 +93,11 @@ protected:
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
 
+	LLPacketReceiver* mReceiver;
+	bool mHoldingReceived;			// front of mReceiver was last returned
+
 private:
+	S32  receiveFromThread(char *datap);
 	BOOL sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
 };
 
@@ -41,6 +41,7 @@
 LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
 												 number_template_map) :
 	mReceiveSize(0),
+	mReceiveBuffer(NULL),
 	mCurrentRMessageTemplate(NULL),
 	mCurrentRMessageData(NULL),
 	mMessageNumbers(number_template_map)
@@ -58,6 +59,7 @@ LLTemplateMessageReader::~LLTemplateMessageReader()
 void LLTemplateMessageReader::clearMessage()
 {
 	mReceiveSize = -1;
+	mReceiveBuffer = NULL;
 	mCurrentRMessageTemplate = NULL;
 	delete mCurrentRMessageData;
 	mCurrentRMessageData = NULL;
@@ -72,6 +74,8 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
 		return;
 	}
 
+	decodeOnDemand();
+
 	if (!mCurrentRMessageData)
 	{
 		LL_ERRS() << "Invalid mCurrentMessageData in getData!" << LL_ENDL;
@@ -157,6 +161,8 @@ S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
 		return -1;
 	}
 
+	decodeOnDemand();
+
 	if (!mCurrentRMessageData)
 	{
 		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
@@ -184,6 +190,8 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
 		return LL_MESSAGE_ERROR;
 	}
 
+	decodeOnDemand();
+
 	if (!mCurrentRMessageData)
 	{	// This is a serious error - crash
 		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
@@ -232,6 +240,8 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const
 		return LL_MESSAGE_ERROR;
 	}
 
+	decodeOnDemand();
+
 	if (!mCurrentRMessageData)
 	{	// This is a serious error - crash
 		LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
@@ -530,16 +540,9 @@ void LLTemplateMessageReader::logRanOffEndOfPacket( const LLHost& host, const S3
 
 static LLTrace::BlockTimerStatHandle FTM_PROCESS_MESSAGES("Process Messages");
 
-// decode a given message
-BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender )
+// build mCurrentRMessageData from the packet
+BOOL LLTemplateMessageReader::decodeBlocks(const U8* buffer, const LLHost& sender)
 {
-    LL_RECORD_BLOCK_TIME(FTM_PROCESS_MESSAGES);
-
-	llassert( mReceiveSize >= 0 );
-	llassert( mCurrentRMessageTemplate);
-	llassert( !mCurrentRMessageData );
-	delete mCurrentRMessageData; // just to make sure
-
 	// The offset tells us how may bytes to skip after the end of the
 	// message name.
 	U8 offset = buffer[PHL_OFFSET];
@@ -700,6 +703,39 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 		LL_DEBUGS() << "Empty message '" << mCurrentRMessageTemplate->mName << "' (no blocks)" << LL_ENDL;
 		return FALSE;
 	}
+	return TRUE;
+}
+
+// A handler with a generated decoder skips building mCurrentRMessageData,
+// but other handlers, logging and forwarding may still read the message
+// through the getters, so build it for them the first time they ask
+void LLTemplateMessageReader::decodeOnDemand()
+{
+	if (!mCurrentRMessageData && mCurrentRMessageTemplate && mReceiveBuffer
+		&& mCurrentRMessageTemplate->mHandlerDecodes)
+	{
+		// The handler's decoder has already reported a bad packet, and
+		// whatever decodeBlocks() managed is better than no data at all
+		decodeBlocks(mReceiveBuffer, mReceiveSender);
+	}
+}
+
+// decode a given message
+BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender )
+{
+    LL_RECORD_BLOCK_TIME(FTM_PROCESS_MESSAGES);
+
+	llassert( mReceiveSize >= 0 );
+	llassert( mCurrentRMessageTemplate);
+	llassert( !mCurrentRMessageData );
+	delete mCurrentRMessageData; // just to make sure
+
+	// Handlers with a generated decoder read the packet themselves
+	if (!mCurrentRMessageTemplate->mHandlerDecodes
+		&& !decodeBlocks(buffer, sender))
+	{
+		return FALSE;
+	}
 
 	{
 		static LLTimer decode_timer;
@@ -789,6 +825,8 @@ BOOL LLTemplateMessageReader::validateMessage(const U8* buffer,
 BOOL LLTemplateMessageReader::readMessage(const U8* buffer, 
 										  const LLHost& sender)
 {
+	mReceiveBuffer = buffer;
+	mReceiveSender = sender;
 	return decodeData(buffer, sender);
 }
 
@@ -826,5 +864,6 @@ void LLTemplateMessageReader::copyToBuilder(LLMessageBuilder& builder) const
     {
         return;
     }
+	const_cast<LLTemplateMessageReader*>(this)->decodeOnDemand();
 	builder.copyFromMessageData(*mCurrentRMessageData);
 }
@@ -27,6 +27,7 @@
 #ifndef LL_LLTEMPLATEMESSAGEREADER_H
 #define LL_LLTEMPLATEMESSAGEREADER_H
 
+#include "llhost.h"
 #include "llmessagereader.h"
 
 #include <map>
@@ -102,6 +103,10 @@ public:
 						 const LLHost& sender, bool trusted = false);
 	BOOL readMessage(const U8* buffer, const LLHost& sender);
 
+	// The message being read, as passed to readMessage(). Valid until
+	// the handler returns.
+	const U8* getReceiveBuffer() const { return mReceiveBuffer; }
+
 	bool isTrusted() const;
 	bool isBanned(bool trusted_source) const;
 	bool isUdpBanned() const;
@@ -117,8 +122,12 @@ private:
 	void logRanOffEndOfPacket( const LLHost& host, const S32 where, const S32 wanted );
 
 	BOOL decodeData(const U8* buffer, const LLHost& sender );
+	BOOL decodeBlocks(const U8* buffer, const LLHost& sender);
+	void decodeOnDemand();
 
 	S32	mReceiveSize;
+	const U8* mReceiveBuffer;
+	LLHost mReceiveSender;
 	LLMessageTemplate* mCurrentRMessageTemplate;
 	LLMsgData* mCurrentRMessageData;
 	message_template_number_map_t& mMessageNumbers;
@@ -322,6 +322,9 @@ LLMessageSystem::~LLMessageSystem()
 	for_each(mMessageNumbers.begin(), mMessageNumbers.end(), DeletePairedPointer());
 	mMessageNumbers.clear();
 	
+	// before the socket goes away under it
+	mPacketRing.stopReceiveThread();
+
 	if (!mbError)
 	{
 		end_net(mSocket);
@@ -697,7 +700,7 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 				if (cdp && recv_reliable)
 				{
 					// Add to the recently received list for duplicate suppression
-					cdp->mRecentlyReceivedReliablePackets[mCurrentRecvPacketID] = getMessageTimeUsecs();
+					cdp->mRecentlyReceivedReliablePackets.insert(mCurrentRecvPacketID);
 
 					// Put it onto the list of packets to be acked
 					cdp->collectRAck(mCurrentRecvPacketID);
@@ -2835,13 +2838,43 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 	S32 in_size = *data_size;
 	mCompressedPacketsIn++;
 	mCompressedBytesIn += *data_size;
-	
-	*data[0] &= (~LL_ZERO_CODE_FLAG);
 
-	S32 count = (*data_size);  
-	
-	U8 *inptr = (U8 *)*data;
-	U8 *outptr = (U8 *)mEncodedRecvBuffer;
+	bool overflowed = false;
+	LLPacketReceiver::Packet* packetp = mPacketRing.getLastReceived();
+	if (packetp && packetp->mExpandedSize
+		&& *data == mTrueReceiveBuffer && in_size == packetp->mBodySize)
+	{
+		// Already expanded on the receive thread
+		*data[0] &= (~LL_ZERO_CODE_FLAG);
+		*data = packetp->mExpanded;
+		*data_size = packetp->mExpandedSize;
+		overflowed = packetp->mExpandOverflowed;
+	}
+	else
+	{
+		*data_size = zeroCodeExpand(*data, in_size, mEncodedRecvBuffer, overflowed);
+		*data[0] &= (~LL_ZERO_CODE_FLAG);
+		*data = mEncodedRecvBuffer;
+	}
+
+	if (overflowed)
+	{
+		LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size" << LL_ENDL;
+		callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
+	}
+	mUncompressedBytesIn += *data_size;
+
+	return(in_size);
+}
+
+// static
+S32 LLMessageSystem::zeroCodeExpand(const U8* in, S32 in_size, U8* out, bool& overflowed)
+{
+	overflowed = false;
+
+	S32 count = in_size;
+	const U8 *inptr = in;
+	U8 *outptr = out;
 
 // skip the packet id field
 
@@ -2850,6 +2883,7 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 		count--;
 		*outptr++ = *inptr++;
 	}
+	out[0] &= (~LL_ZERO_CODE_FLAG);
 
 // reconstruct encoded packet, keeping track of net size gain
 
@@ -2858,11 +2892,10 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 
 	while (count--)
 	{
-		if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-1]))
+		if (outptr > (&out[MAX_BUFFER_SIZE-1]))
 		{
-			LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 1" << LL_ENDL;
-			callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-			outptr = mEncodedRecvBuffer;					
+			overflowed = true;
+			outptr = out;
 			break;
 		}
 		if (!((*outptr++ = *inptr++)))
@@ -2870,11 +2903,10 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 			while (((count--)) && (!(*inptr)))
 			{
 				*outptr++ = *inptr++;
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-256]))
+  				if (outptr > (&out[MAX_BUFFER_SIZE-256]))
   				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 2" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;
+					overflowed = true;
+					outptr = out;
 					count = -1;
 					break;
   				}
@@ -2889,11 +2921,10 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 
 			else
 			{
-  				if (outptr > (&mEncodedRecvBuffer[MAX_BUFFER_SIZE-(*inptr)]))
+  				if (outptr > (&out[MAX_BUFFER_SIZE-(*inptr)]))
 				{
-  					LL_WARNS("Messaging") << "attempt to write past reasonable encoded buffer size 3" << LL_ENDL;
-					callExceptionFunc(MX_WROTE_PAST_BUFFER_SIZE);
-					outptr = mEncodedRecvBuffer;					
+					overflowed = true;
+					outptr = out;
 				}
 				memset(outptr,0,(*inptr) - 1);
 				outptr += ((*inptr) - 1);
@@ -2901,12 +2932,8 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
 			}
 		}		
 	}
-	
-	*data = mEncodedRecvBuffer;
-	*data_size = (S32)(outptr - mEncodedRecvBuffer);
-	mUncompressedBytesIn += *data_size;
 
-	return(in_size);
+	return (S32)(outptr - out);
 }
 
 
@@ -2935,6 +2962,16 @@ void LLMessageSystem::setHandlerFuncFast(const char *name, void (*handler_func)(
 	}
 }
 
+void LLMessageSystem::setDecodingHandlerFuncFast(const char *name, void (*handler_func)(LLMessageSystem *msgsystem, void **user_data), void **user_data)
+{
+	setHandlerFuncFast(name, handler_func, user_data);
+	LLMessageTemplate* msgtemplate = get_ptr_in_map(mMessageTemplates, name);
+	if (msgtemplate)
+	{
+		msgtemplate->mHandlerDecodes = true;
+	}
+}
+
 bool LLMessageSystem::callHandler(const char *name,
 		bool trustedSource, LLMessageSystem* msg)
 {
@@ -3965,6 +4002,17 @@ S32 LLMessageSystem::getReceiveSize() const
 	return mMessageReader->getMessageSize();
 }
 
+bool LLMessageSystem::getReceiveBuffer(const U8*& buffer, S32& size) const
+{
+	if (mMessageReader != mTemplateMessageReader)
+	{
+		return false;
+	}
+	buffer = mTemplateMessageReader->getReceiveBuffer();
+	size = mTemplateMessageReader->getMessageSize();
+	return buffer && size > 0;
+}
+
 //static 
 void LLMessageSystem::setTimeDecodes( BOOL b )
 {
@@ -386,6 +386,11 @@ public:
 		setHandlerFuncFast(LLMessageStringTable::getInstance()->getString(name), handler_func, user_data);
 	}
 
+	// As setHandlerFuncFast(), for a handler that reads the message only
+	// through its decoder in llmessagedecoders.h and never with get*().
+	// The template reader then skips decoding it into LLMsgData.
+	void	setDecodingHandlerFuncFast(const char *name, void (*handler_func)(LLMessageSystem *msgsystem, void **user_data), void **user_data = NULL);
+
 	// Set a callback function for a message system exception.
 	void setExceptionFunc(EMessageException exception, msg_exception_callback func, void* data = NULL);
 	// Call the specified exception func, and return TRUE if a
@@ -537,6 +542,10 @@ public:
 
 	S32     zeroCode(U8 **data, S32 *data_size);
 	S32		zeroCodeExpand(U8 **data, S32 *data_size);
+
+	// Expand a zero coded message of in_size bytes into out, which must
+	// hold MAX_BUFFER_SIZE.  Returns the expanded size.  Thread safe.
+	static S32 zeroCodeExpand(const U8* in, S32 in_size, U8* out, bool& overflowed);
 	S32		zeroCodeAdjustCurrentSendTotal();
 
 	// Uses ping-based retry
@@ -748,6 +757,10 @@ public:
 	void summarizeLogs(std::ostream& str);	// log statistics
 
 	S32		getReceiveSize() const;
+	// The current message as received, for the decoders generated into
+	// llmessagedecoders.h. False if it didn't come through the template
+	// reader.
+	bool	getReceiveBuffer(const U8*& buffer, S32& size) const;
 	S32		getReceiveCompressedSize() const { return mIncomingCompressedSize; }
 	S32		getReceiveBytes() const;
 
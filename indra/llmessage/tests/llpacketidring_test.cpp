@@ -0,0 +1,392 @@
+/**
+ * @file llpacketidring_test.cpp
+ * @brief Tests and loss simulation for LLPacketIDSet and LLPacketIDRing
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketidring.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "../llpacketring.h"
+#include "../net.h"
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	const TPACKETID LAST_ID = LL_MAX_OUT_PACKET_ID - 1;
+
+	std::vector<TPACKETID> walk(const LLPacketIDSet& set)
+	{
+		std::vector<TPACKETID> ids;
+		TPACKETID id;
+		for (bool more = set.first(id); more; more = set.next(++id))
+		{
+			ids.push_back(id);
+		}
+		return ids;
+	}
+
+	// What happened to one packet in a lossy exchange, replayed against
+	// each way of tracking it
+	struct Event
+	{
+		enum Type { SENT, RECEIVED, ACKED, PING };
+		Type mType;
+		TPACKETID mID;
+	};
+
+	// Reliable packet tracking as LLCircuitData did it with maps
+	struct MapTracker
+	{
+		std::map<TPACKETID, void*> mUnacked;
+		std::map<TPACKETID, U64> mRecent;
+		std::map<TPACKETID, U64> mLost;
+		TPACKETID mNextIn;
+		S32 mDuplicates;
+
+		MapTracker() : mNextIn(0), mDuplicates(0) {}
+
+		void sent(TPACKETID id) { mUnacked[id] = this; }
+		void acked(TPACKETID id) { mUnacked.erase(id); }
+
+		void received(TPACKETID id, U64 now)
+		{
+			if (mRecent.find(id) != mRecent.end())
+			{
+				++mDuplicates;
+				return;
+			}
+			mRecent[id] = now;
+			if (id == mNextIn)
+			{
+				++mNextIn;
+			}
+			else if (!mLost.erase(id) && id > mNextIn)
+			{
+				for (; mNextIn != id; ++mNextIn)
+				{
+					mLost[mNextIn] = now;
+				}
+				++mNextIn;
+			}
+		}
+
+		// As a ping does: the oldest unacked clears the duplicate list
+		void ping()
+		{
+			TPACKETID oldest = mUnacked.empty() ? mNextIn : mUnacked.begin()->first;
+			mRecent.erase(mRecent.begin(), mRecent.lower_bound(oldest));
+			mLost.clear();
+		}
+	};
+
+	// The same with the rings LLCircuitData uses now
+	struct RingTracker
+	{
+		LLPacketIDRing<void*> mUnacked;
+		LLPacketIDSet mRecent;
+		LLPacketIDRing<U64> mLost;
+		TPACKETID mNextIn;
+		S32 mDuplicates;
+
+		RingTracker() : mRecent(65536), mLost(65536), mNextIn(0), mDuplicates(0) {}
+
+		void sent(TPACKETID id) { mUnacked.insert(id, this); }
+		void acked(TPACKETID id) { mUnacked.erase(id); }
+
+		void received(TPACKETID id, U64 now)
+		{
+			if (!mRecent.insert(id))
+			{
+				++mDuplicates;
+				return;
+			}
+			if (id == mNextIn)
+			{
+				++mNextIn;
+			}
+			else if (!mLost.erase(id) && id > mNextIn)
+			{
+				for (; mNextIn != id; ++mNextIn)
+				{
+					mLost.insert(mNextIn, now);
+				}
+				++mNextIn;
+			}
+		}
+
+		void ping()
+		{
+			TPACKETID oldest = mNextIn;
+			mUnacked.first(oldest);
+			mRecent.eraseBefore(oldest);
+			mLost.clear();
+		}
+	};
+
+	template<class TRACKER>
+	F64 replay(const std::vector<Event>& events, S32 repeats, TRACKER& result)
+	{
+		LLTimer timer;
+		for (S32 i = 0; i < repeats; ++i)
+		{
+			TRACKER tracker;
+			U64 now = 0;
+			for (std::vector<Event>::const_iterator it = events.begin(); it != events.end(); ++it)
+			{
+				switch (it->mType)
+				{
+				case Event::SENT:
+					tracker.sent(it->mID);
+					break;
+				case Event::RECEIVED:
+					tracker.received(it->mID, ++now);
+					break;
+				case Event::ACKED:
+					tracker.acked(it->mID);
+					break;
+				case Event::PING:
+					tracker.ping();
+					break;
+				}
+			}
+			if (i == repeats - 1)
+			{
+				result.mDuplicates = tracker.mDuplicates;
+				result.mNextIn = tracker.mNextIn;
+			}
+		}
+		return timer.getElapsedTimeF64();
+	}
+}
+
+namespace tut
+{
+	struct packetidring_data
+	{
+	};
+	typedef test_group<packetidring_data> packetidring_test;
+	typedef packetidring_test::object packetidring_object;
+	tut::packetidring_test packetidring("LLPacketIDRing");
+
+	template<> template<>
+	void packetidring_object::test<1>()
+	{
+		set_test_name("IDs are held in order across a wrap");
+
+		LLPacketIDSet set;
+		ensure("empty", set.empty());
+		for (TPACKETID id = LAST_ID - 99; id != 100; id = (id + 1) % LL_MAX_OUT_PACKET_ID)
+		{
+			if (id % 3)
+			{
+				ensure("inserted", set.insert(id));
+			}
+		}
+		ensure("duplicate", !set.insert(1));
+		ensure("held", set.contains(LAST_ID - 1));
+		ensure("held after wrap", set.contains(98));
+		ensure("not held", !set.contains(LAST_ID));
+		ensure("beyond", !set.contains(100));
+
+		std::vector<TPACKETID> ids = walk(set);
+		ensure_equals("count", ids.size(), (size_t) set.size());
+		ensure_equals("oldest", ids.front(), LAST_ID - 98);
+		ensure_equals("newest", ids.back(), (TPACKETID) 98);
+		for (size_t i = 1; i < ids.size(); ++i)
+		{
+			ensure("ordered", LLPacketIDSet::isBefore(ids[i - 1], ids[i]));
+		}
+
+		set.eraseBefore(50);
+		ensure("erased before", !set.contains(LAST_ID - 1) && !set.contains(49));
+		ensure("kept", set.contains(50));
+		ensure_equals("oldest kept", walk(set).front(), (TPACKETID) 50);
+
+		set.eraseBefore(LAST_ID);
+		ensure("older than the oldest does nothing", set.contains(50));
+	}
+
+	template<> template<>
+	void packetidring_object::test<2>()
+	{
+		set_test_name("ring values match a map under churn");
+
+		LLPacketIDRing<S32> ring;
+		std::map<TPACKETID, S32> model;
+		TPACKETID newest = LAST_ID - 2000;
+		for (S32 i = 0; i < 20000; ++i)
+		{
+			const S32 op = ll_rand(4);
+			if (op < 2)
+			{
+				newest = (newest + 1) % LL_MAX_OUT_PACKET_ID;
+				ring.insert(newest, i);
+				model[newest] = i;
+			}
+			else if (op == 2 && !model.empty())
+			{
+				std::map<TPACKETID, S32>::iterator it = model.begin();
+				std::advance(it, ll_rand((S32) model.size()));
+				ensure("erased", ring.erase(it->first));
+				model.erase(it);
+			}
+			else
+			{
+				const TPACKETID id = (newest + LL_MAX_OUT_PACKET_ID - ll_rand(200)) % LL_MAX_OUT_PACKET_ID;
+				S32* valuep = ring.find(id);
+				std::map<TPACKETID, S32>::iterator it = model.find(id);
+				ensure_equals("found", valuep != NULL, it != model.end());
+				if (valuep)
+				{
+					ensure_equals("value", *valuep, it->second);
+				}
+			}
+		}
+		ensure_equals("size", ring.size(), (U32) model.size());
+	}
+
+	template<> template<>
+	void packetidring_object::test<3>()
+	{
+		set_test_name("capped sets forget the oldest");
+
+		LLPacketIDSet set(256);
+		for (TPACKETID id = 0; id < 1000; ++id)
+		{
+			set.insert(id);
+		}
+		ensure_equals("size", set.size(), (U32) 256);
+		ensure("oldest forgotten", !set.contains(743));
+		ensure("newest kept", set.contains(744) && set.contains(999));
+		ensure("too old", !set.insert(10));
+	}
+
+	template<> template<>
+	void packetidring_object::test<4>()
+	{
+		set_test_name("loss simulation");
+
+		// Reliable packets over loopback through an LLPacketRing dropping
+		// a fifth of them, with a fifth of acks lost as well so resends
+		// turn up as duplicates. What happens is recorded and replayed
+		// against map and ring tracking to compare the time each spends
+		// per packet.
+		const S32 COUNT = 20000;
+		const S32 BURST = 64;
+		const F32 DROP_PERCENT = 20.f;
+
+		int receive_port = NET_USE_OS_ASSIGNED_PORT;
+		int send_port = NET_USE_OS_ASSIGNED_PORT;
+		S32 receive_socket = -1;
+		S32 send_socket = -1;
+		ensure_equals("receive socket", start_net(receive_socket, receive_port), 0);
+		ensure_equals("send socket", start_net(send_socket, send_port), 0);
+		const U32 loopback = ip_string_to_u32(LOOPBACK_ADDRESS_STRING);
+
+		LLPacketRing ring;
+		ring.setDropPercentage(DROP_PERCENT);
+
+		std::vector<Event> events;
+		std::vector<TPACKETID> unacked;
+		TPACKETID next_out = 0;
+		S32 rounds = 0;
+		while ((next_out < (TPACKETID) COUNT || !unacked.empty()) && rounds < 10000)
+		{
+			++rounds;
+
+			// Resend everything outstanding, then a burst of new packets
+			std::vector<TPACKETID> sending;
+			sending.swap(unacked);
+			for (S32 i = 0; i < BURST && next_out < (TPACKETID) COUNT; ++i)
+			{
+				events.push_back(Event { Event::SENT, next_out });
+				sending.push_back(next_out++);
+			}
+			for (std::vector<TPACKETID>::iterator it = sending.begin(); it != sending.end(); ++it)
+			{
+				TPACKETID id = *it;
+				send_packet(send_socket, (const char*) &id, sizeof(id), loopback, receive_port);
+			}
+
+			// One receive per datagram, dropped ones come back empty
+			std::vector<bool> arrived(sending.size(), false);
+			char buffer[NET_BUFFER_SIZE];
+			for (size_t i = 0; i < sending.size(); ++i)
+			{
+				if (ring.receivePacket(receive_socket, buffer) == sizeof(TPACKETID))
+				{
+					TPACKETID id;
+					memcpy(&id, buffer, sizeof(id));
+					events.push_back(Event { Event::RECEIVED, id });
+					if (ll_frand(100.f) >= DROP_PERCENT)
+					{
+						events.push_back(Event { Event::ACKED, id });
+						std::vector<TPACKETID>::iterator found = std::find(sending.begin(), sending.end(), id);
+						if (found != sending.end())
+						{
+							arrived[found - sending.begin()] = true;
+						}
+					}
+				}
+			}
+			for (size_t i = 0; i < sending.size(); ++i)
+			{
+				if (!arrived[i])
+				{
+					unacked.push_back(sending[i]);
+				}
+			}
+
+			if (rounds % 16 == 0)
+			{
+				events.push_back(Event { Event::PING, 0 });
+			}
+		}
+		end_net(receive_socket);
+		end_net(send_socket);
+		ensure("all acked", unacked.empty());
+
+		const S32 REPEATS = 20;
+		MapTracker map_result;
+		RingTracker ring_result;
+		const F64 map_time = replay(events, REPEATS, map_result);
+		const F64 ring_time = replay(events, REPEATS, ring_result);
+
+		ensure_equals("same duplicates", ring_result.mDuplicates, map_result.mDuplicates);
+		ensure_equals("everything received", ring_result.mNextIn, (TPACKETID) COUNT);
+
+		const F64 packets = (F64) events.size() * REPEATS;
+		LL_INFOS() << "Replayed " << events.size() << " events, " << ring_result.mDuplicates
+				   << " duplicates. Maps: " << map_time * 1e9 / packets << " ns each. Rings: "
+				   << ring_time * 1e9 / packets << " ns each." << LL_ENDL;
+	}
+}
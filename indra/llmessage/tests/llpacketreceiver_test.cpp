@@ -0,0 +1,286 @@
+/**
+ * @file llpacketreceiver_test.cpp
+ * @brief Tests and replay benchmark for LLPacketReceiver
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketreceiver.h"
+
+#include <vector>
+
+#include "../message.h"
+#include "../net.h"
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	// A datagram as a region would send it and the message it carries
+	struct Recorded
+	{
+		std::vector<U8> mDatagram;
+		std::vector<U8> mMessage;
+	};
+
+	// Zero code body bytes the way the simulator does
+	std::vector<U8> zero_code(const std::vector<U8>& message)
+	{
+		std::vector<U8> coded(message.begin(), message.begin() + LL_PACKET_ID_SIZE);
+		coded[0] |= LL_ZERO_CODE_FLAG;
+		for (size_t i = LL_PACKET_ID_SIZE; i < message.size(); )
+		{
+			if (message[i])
+			{
+				coded.push_back(message[i++]);
+				continue;
+			}
+			U8 run = 0;
+			while (i < message.size() && !message[i] && run < 255)
+			{
+				++run;
+				++i;
+			}
+			coded.push_back(0);
+			coded.push_back(run);
+		}
+		return coded;
+	}
+
+	// Object update sized messages, mostly zero coded, some with acks
+	// appended as they would be to reliable traffic
+	std::vector<Recorded> record(S32 count)
+	{
+		std::vector<Recorded> recorded(count);
+		for (S32 i = 0; i < count; ++i)
+		{
+			std::vector<U8>& message = recorded[i].mMessage;
+			message.resize(LL_PACKET_ID_SIZE + 100 + ll_rand(1000));
+			message[0] = LL_RELIABLE_FLAG;
+			message[4] = (U8) i;
+			for (size_t b = LL_PACKET_ID_SIZE; b < message.size(); ++b)
+			{
+				// runs of zeros, as in the unused fields of an update
+				message[b] = (ll_rand(3) == 0) ? (U8) ll_rand(256) : 0;
+			}
+
+			std::vector<U8>& datagram = recorded[i].mDatagram;
+			datagram = (i % 4) ? zero_code(message) : message;
+			if (i % 3 == 0)
+			{
+				const U8 acks = 1 + (U8) ll_rand(4);
+				datagram[0] |= LL_ACK_FLAG;
+				datagram.insert(datagram.end(), acks * sizeof(TPACKETID), 0xAB);
+				datagram.push_back(acks);
+			}
+		}
+		return recorded;
+	}
+}
+
+namespace tut
+{
+	struct packetreceiver_data
+	{
+		packetreceiver_data()
+		:	mReceivePort(NET_USE_OS_ASSIGNED_PORT),
+			mSendPort(NET_USE_OS_ASSIGNED_PORT),
+			mReceiveSocket(-1),
+			mSendSocket(-1)
+		{
+			ensure_equals("receive socket", start_net(mReceiveSocket, mReceivePort), 0);
+			ensure_equals("send socket", start_net(mSendSocket, mSendPort), 0);
+			mLoopback = ip_string_to_u32(LOOPBACK_ADDRESS_STRING);
+		}
+
+		~packetreceiver_data()
+		{
+			end_net(mReceiveSocket);
+			end_net(mSendSocket);
+		}
+
+		void send(const Recorded& recorded)
+		{
+			send_packet(mSendSocket, (const char*) &recorded.mDatagram[0],
+						(int) recorded.mDatagram.size(), mLoopback, mReceivePort);
+		}
+
+		int mReceivePort;
+		int mSendPort;
+		S32 mReceiveSocket;
+		S32 mSendSocket;
+		U32 mLoopback;
+	};
+	typedef test_group<packetreceiver_data> packetreceiver_test;
+	typedef packetreceiver_test::object packetreceiver_object;
+	tut::packetreceiver_test packetreceiver("LLPacketReceiver");
+
+	template<> template<>
+	void packetreceiver_object::test<1>()
+	{
+		set_test_name("datagrams arrive in order with their messages expanded");
+
+		const S32 COUNT = 500;
+		std::vector<Recorded> recorded = record(COUNT);
+
+		// a ring smaller than the replay, so it wraps and fills
+		LLPacketReceiver receiver(mReceiveSocket, 16);
+		receiver.start();
+
+		S32 sent = 0;
+		S32 received = 0;
+		LLTimer timeout;
+		while (received < COUNT && timeout.getElapsedTimeF32() < 30.f)
+		{
+			while (sent < COUNT && sent - received < 32)
+			{
+				send(recorded[sent++]);
+			}
+
+			LLPacketReceiver::Packet* packetp = receiver.front();
+			if (!packetp)
+			{
+				ms_sleep(1);
+				continue;
+			}
+
+			const Recorded& expected = recorded[received];
+			ensure_equals("size", packetp->mSize, (S32) expected.mDatagram.size());
+			ensure("datagram", !memcmp(packetp->mData, &expected.mDatagram[0], packetp->mSize));
+			ensure_equals("sender port", (S32) packetp->mHost.getPort(), mSendPort);
+
+			if (expected.mDatagram[0] & LL_ZERO_CODE_FLAG)
+			{
+				ensure_equals("expanded size", packetp->mExpandedSize, (S32) expected.mMessage.size());
+				ensure("not overflowed", !packetp->mExpandOverflowed);
+				// The expanded header keeps the datagram's flags, less the
+				// zero code one, so acks appended show up there too.
+				const U8 flags = LL_ZERO_CODE_FLAG | LL_ACK_FLAG;
+				ensure_equals("expanded flags", (S32) (packetp->mExpanded[0] & ~flags),
+							  (S32) (expected.mMessage[0] & ~flags));
+				ensure("expanded", !memcmp(packetp->mExpanded + 1, &expected.mMessage[1], packetp->mExpandedSize - 1));
+			}
+			else
+			{
+				ensure_equals("not expanded", packetp->mExpandedSize, 0);
+				ensure_equals("body size", packetp->mBodySize, (S32) expected.mMessage.size());
+			}
+
+			receiver.pop();
+			++received;
+		}
+		ensure_equals("all received", received, COUNT);
+	}
+
+	template<> template<>
+	void packetreceiver_object::test<2>()
+	{
+		set_test_name("replay benchmark");
+
+		// Time spent on the thread that would be checking messages, per
+		// datagram, reading and expanding everything itself against
+		// taking it from the receive thread.
+		const S32 COUNT = 2000;
+		const S32 REPLAYS = 10;
+		const S32 BURST = 64;
+		std::vector<Recorded> recorded = record(COUNT);
+
+		U8 buffer[NET_BUFFER_SIZE];
+		U8 expanded[NET_BUFFER_SIZE];
+		bool overflowed;
+
+		LLTimer timer;
+		F64 direct_time = 0.0;
+		S32 direct_count = 0;
+		for (S32 replay = 0; replay < REPLAYS; ++replay)
+		{
+			for (S32 first = 0; first < COUNT; first += BURST)
+			{
+				const S32 last = llmin(first + BURST, COUNT);
+				for (S32 i = first; i < last; ++i)
+				{
+					send(recorded[i]);
+				}
+
+				timer.reset();
+				S32 size;
+				while ((size = receive_packet(mReceiveSocket, (char*) buffer)) > 0)
+				{
+					if (buffer[0] & LL_ZERO_CODE_FLAG)
+					{
+						LLMessageSystem::zeroCodeExpand(buffer, size, expanded, overflowed);
+					}
+					++direct_count;
+				}
+				direct_time += timer.getElapsedTimeF64();
+			}
+		}
+
+		LLPacketReceiver receiver(mReceiveSocket);
+		receiver.start();
+
+		F64 threaded_time = 0.0;
+		S32 threaded_count = 0;
+		for (S32 replay = 0; replay < REPLAYS; ++replay)
+		{
+			for (S32 first = 0; first < COUNT; first += BURST)
+			{
+				const S32 last = llmin(first + BURST, COUNT);
+				for (S32 i = first; i < last; ++i)
+				{
+					send(recorded[i]);
+				}
+
+				// Wait for the burst so only the hand over is timed
+				LLTimer timeout;
+				while (receiver.getCount() < (U32) (last - first) && timeout.getElapsedTimeF32() < 1.f)
+				{
+					ms_sleep(1);
+				}
+
+				timer.reset();
+				while (LLPacketReceiver::Packet* packetp = receiver.front())
+				{
+					memcpy(buffer, packetp->mData, packetp->mSize);
+					receiver.pop();
+					++threaded_count;
+				}
+				threaded_time += timer.getElapsedTimeF64();
+			}
+		}
+
+		LL_INFOS() << "Replayed " << COUNT * REPLAYS << " datagrams. Direct: " << direct_count
+				   << " in " << direct_time * 1000.0 << " ms, "
+				   << (direct_count ? direct_time * 1e9 / direct_count : 0.0) << " ns each. Threaded: "
+				   << threaded_count << " in " << threaded_time * 1000.0 << " ms, "
+				   << (threaded_count ? threaded_time * 1e9 / threaded_count : 0.0) << " ns each."
+				   << LL_ENDL;
+
+		// Loopback may still drop under load, only insist on most of them
+		ensure("direct received", direct_count > COUNT * REPLAYS / 2);
+		ensure("threaded received", threaded_count > COUNT * REPLAYS / 2);
+	}
+}
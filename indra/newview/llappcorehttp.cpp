@@ -59,57 +59,58 @@ static const struct
 	U32							mMax;
 	U32							mRate;
 	bool						mPipelined;
+	U32							mStreams;
 	std::string					mKey;
 	const char *				mUsage;
 } init_data[LLAppCoreHttp::AP_COUNT] =
 {
 	{ // AP_DEFAULT
-		8,		8,		8,		0,		false,
+		8,		8,		8,		0,		false,	0,
 		"",
 		"other"
 	},
 	{ // AP_TEXTURE
-		8,		1,		12,		0,		true,
+		8,		1,		12,		0,		true,	32,
 		"TextureFetchConcurrency",
 		"texture fetch"
 	},
 	{ // AP_MESH1
-		32,		1,		128,	0,		false,
+		32,		1,		128,	0,		false,	0,
 		"MeshMaxConcurrentRequests",
 		"mesh fetch"
 	},
 	{ // AP_MESH2
-		8,		1,		32,		0,		true,	
+		8,		1,		32,		0,		true,	16,	
 		"Mesh2MaxConcurrentRequests",
 		"mesh2 fetch"
 	},
 	{ // AP_LARGE_MESH
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,	0,
 		"",
 		"large mesh fetch"
 	},
 	{ // AP_UPLOADS 
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,	0,
 		"",
 		"asset upload"
 	},
 	{ // AP_LONG_POLL
-		32,		32,		32,		0,		false,
+		32,		32,		32,		0,		false,	0,
 		"",
 		"long poll"
 	},
 	{ // AP_INVENTORY
-		4,		1,		4,		0,		false,
+		4,		1,		4,		0,		false,	0,
 		"",
 		"inventory"
 	},
 	{ // AP_MATERIALS
-		2,		1,		8,		0,		false,
+		2,		1,		8,		0,		false,	0,
 		"RenderMaterials",
 		"material manager requests"
 	},
 	{ // AP_AGENT
-		2,		1,		32,		0,		false,
+		2,		1,		32,		0,		false,	0,
 		"Agent",
 		"Agent requests"
 	}
@@ -122,7 +123,8 @@ static void ssl_verification_changed();
 LLAppCoreHttp::HttpClass::HttpClass()
 	: mPolicy(LLCore::HttpRequest::DEFAULT_POLICY_ID),
 	  mConnLimit(0U),
-	  mPipelined(false)
+	  mPipelined(false),
+	  mStreams(0U)
 {}
 
 
@@ -131,7 +133,8 @@ LLAppCoreHttp::LLAppCoreHttp()
 	  mStopHandle(LLCORE_HTTP_HANDLE_INVALID),
 	  mStopRequested(0.0),
 	  mStopped(false),
-	  mPipelined(true)
+	  mPipelined(true),
+	  mMultiplexed(false)
 {}
 
 
@@ -280,6 +283,15 @@ void LLAppCoreHttp::init()
 		LL_INFOS("Init") << "HTTP Pipelining " << (mPipelined ? "enabled" : "disabled") << "!" << LL_ENDL;
 	}
 
+	// Global HTTP/2 setting
+	static const std::string http_multiplexing("HttpMultiplexing");
+	if (gSavedSettings.controlExists(http_multiplexing))
+	{
+		// Default to false (in ctor) if absent.
+		mMultiplexed = gSavedSettings.getBOOL(http_multiplexing);
+		LL_INFOS("Init") << "HTTP/2 Multiplexing " << (mMultiplexed ? "enabled" : "disabled") << "!" << LL_ENDL;
+	}
+
 	// Register signals for settings and state changes
 	for (int i(0); i < LL_ARRAY_SIZE(init_data); ++i)
 	{
@@ -448,6 +460,31 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 					mHttpClasses[app_policy].mPipelined = to_pipeline;
 				}
 			}
+
+			// HTTP/2 multiplexing, also init-time only
+			const U32 new_streams(mMultiplexed ? init_data[i].mStreams : 0U);
+			if (new_streams != mHttpClasses[app_policy].mStreams)
+			{
+				LLCore::HttpHandle handle;
+				handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_HTTP2_STREAMS,
+												   mHttpClasses[app_policy].mPolicy,
+												   long(new_streams),
+												   LLCore::HttpHandler::ptr_t());
+				if (LLCORE_HTTP_HANDLE_INVALID == handle)
+				{
+					status = mRequest->getStatus();
+					LL_WARNS("Init") << "Unable to set " << init_data[i].mUsage
+									 << " multiplexing.  Reason:  " << status.toString()
+									 << LL_ENDL;
+				}
+				else
+				{
+					LL_DEBUGS("Init") << "Changed " << init_data[i].mUsage
+									  << " multiplexing.  New streams:  " << new_streams
+									  << LL_ENDL;
+					mHttpClasses[app_policy].mStreams = new_streams;
+				}
+			}
 		}
 		
 		// Get target connection concurrency value
@@ -478,10 +515,16 @@ void LLAppCoreHttp::refreshSettings(bool initial)
 			// avatars, etc.) can request additional outbound connections
 			// to other servers via 2X total connection limit.
 			//
+			// Multiplexing.  As with pipelining.  Requests wait for a
+			// stream on an open connection first so the per-host limit
+			// is rarely reached against an HTTP/2 server.
+			//
+			const bool curl_managed(mHttpClasses[app_policy].mPipelined
+									|| mHttpClasses[app_policy].mStreams > 1);
 			LLCore::HttpHandle handle;
 			handle = mRequest->setPolicyOption(LLCore::HttpRequest::PO_CONNECTION_LIMIT,
 											   mHttpClasses[app_policy].mPolicy,
-											   (mHttpClasses[app_policy].mPipelined ? 2 * setting : setting),
+											   (curl_managed ? 2 * setting : setting),
                                                LLCore::HttpHandler::ptr_t());
 			if (LLCORE_HTTP_HANDLE_INVALID == handle)
 			{
@@ -228,6 +228,13 @@ public:
 			return mHttpClasses[policy].mPipelined;
 		}
 
+	// Return whether a policy multiplexes requests over HTTP/2
+	// where the server offers it.
+	bool isMultiplexed(EAppPolicy policy) const
+		{
+			return mHttpClasses[policy].mStreams > 1;
+		}
+
 	// Apply initial or new settings from the environment.
 	void refreshSettings(bool initial);
 	
@@ -246,6 +253,7 @@ private:
 		policy_t					mPolicy;			// Policy class id for the class
 		U32							mConnLimit;
 		bool						mPipelined;
+		U32							mStreams;			// HTTP/2 streams per connection, 0 if not multiplexed
 		boost::signals2::connection mSettingsSignal;	// Signal to global setting that affect this class (if any)
 	};
 		
@@ -256,6 +264,7 @@ private:
 	HttpClass					mHttpClasses[AP_COUNT];
 	bool						mPipelined;				// Global setting
 	boost::signals2::connection	mPipelinedSignal;		// Signal for 'HttpPipelining' setting
+	bool						mMultiplexed;			// Global 'HttpMultiplexing' setting
 	boost::signals2::connection	mSSLNoVerifySignal;		// Signal for 'NoVerifySSLCert' setting
 
 	static LLCore::HttpStatus	sslVerify(const std::string &uri, const LLCore::HttpHandler::ptr_t &handler, void *appdata);
@@ -2908,6 +2908,7 @@ bool LLAppViewer::initConfiguration()
 	//LLVolumeMgr::initClass();
 	LLVolumeMgr* volume_manager = new LLVolumeMgr();
 	volume_manager->useMutex();	// LLApp and LLMutex magic must be manually enabled
+	volume_manager->useWorkQueues("mainloop", "General"); // for LOD changes, see LLVOVolume::setVolume()
 	LLPrimitive::setVolumeManager(volume_manager);
 
 	// Note: this is where we used to initialize gFeatureManagerp.
@@ -4170,7 +4171,7 @@ U32 LLAppViewer::getObjectCacheVersion()
 {
 	// Viewer object cache version, change if object update
 	// format changes. JC
-	const U32 INDRA_OBJECT_CACHE_VERSION = 17;
+	const U32 INDRA_OBJECT_CACHE_VERSION = 18;
 
 	return INDRA_OBJECT_CACHE_VERSION;
 }
@@ -4754,6 +4755,11 @@ void LLAppViewer::idle()
 
 		//  Update statistics for this frame
 		update_statistics();
+
+		if (LLVOCache::instanceExists())
+		{
+			LLVOCache::getInstance()->idleCompactPack();
+		}
 	}
 
 	////////////////////////////////////////
@@ -371,6 +371,10 @@ void LLControlAvatar::idleUpdate(LLAgent &agent, const F64 &time)
         markDead();
         mMarkedForDeath = false;
     }
+    else if (getAttachedAvatar() && LLVOAvatar::postponeIdleUpdate(this))
+    {
+        // follows the wearer's attachment point, which isn't posed yet
+    }
     else
     {
         LLVOAvatar::idleUpdate(agent,time);
@@ -3344,12 +3344,10 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
 
 	//U64 lines_count = 0U;
 	std::string line;
-	LLPointer<LLSDParser> parser = new LLSDNotationParser();
 	while (std::getline(file, line)) 
 	{
 		LLSD s_item;
-		std::istringstream iss(line);
-		if (parser->parse(iss, s_item, line.length()) == LLSDParser::PARSE_FAILURE)
+		if (LLSDSerialize::fromNotation(s_item, line.data(), line.length()) == LLSDParser::PARSE_FAILURE)
 		{
 			LL_WARNS(LOG_INV)<< "Parsing inventory cache failed" << LL_ENDL;
 			break;
@@ -78,8 +78,6 @@
 #include "lluploaddialog.h"
 #include "llfloaterreg.h"
 
-#include "boost/iostreams/device/array.hpp"
-#include "boost/iostreams/stream.hpp"
 #include "boost/lexical_cast.hpp"
 
 #ifndef LL_WINDOWS
@@ -1871,9 +1869,8 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 
 		data_size = dsize;
 
-		boost::iostreams::stream<boost::iostreams::array_source> stream(result_ptr, data_size);
-
-		if (!LLSDSerialize::fromBinary(header_data, stream, data_size))
+		size_t header_llsd_size = 0;
+		if (LLSDSerialize::fromBinary(header_data, (const U8*)result_ptr, data_size, -1, &header_llsd_size) <= 0)
 		{
 			LL_WARNS(LOG_MESH) << "Mesh header parse error.  Not a valid mesh asset!  ID:  " << mesh_id
 							   << LL_ENDL;
@@ -1896,7 +1893,7 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 		// make sure there is at least one lod, function returns -1 and marks as 404 otherwise
 		else if (LLMeshRepository::getActualMeshLOD(header, 0) >= 0)
 		{
-			header_size += stream.tellg();
+			header_size += header_llsd_size;
 		}
 	}
 	else
@@ -3744,6 +3741,7 @@ void LLMeshRepository::notifyLoadedMeshes()
     // discussion on connection strategies.
     LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
     S32 scale(app_core_http.isPipelined(LLAppCoreHttp::AP_MESH2)
+              || app_core_http.isMultiplexed(LLAppCoreHttp::AP_MESH2)
               ? (2 * LLAppCoreHttp::PIPELINING_DEPTH)
               : 5);
 
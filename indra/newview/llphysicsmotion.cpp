@@ -217,6 +217,8 @@ default_controller_map_t initDefaultController()
 
 default_controller_map_t LLPhysicsMotion::sDefaultController = initDefaultController();
 
+bool LLPhysicsMotionController::sAvatarPhysics = true;
+
 BOOL LLPhysicsMotion::initialize()
 {
         if (!mJointState->setJoint(mCharacter->getJoint(mJointName.c_str())))
@@ -451,11 +453,18 @@ F32 LLPhysicsMotion::calculateAcceleration_local(const F32 velocity_local, const
         return smoothed_acceleration_local;
 }
 
+// static
+void LLPhysicsMotionController::cacheSettings()
+{
+        static LLCachedControl<bool> avatar_physics(gSavedSettings, "AvatarPhysics");
+        sAvatarPhysics = avatar_physics;
+}
+
 BOOL LLPhysicsMotionController::onUpdate(F32 time, U8* joint_mask)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
         // Skip if disabled globally.
-        if (!gSavedSettings.getBOOL("AvatarPhysics"))
+        if (!sAvatarPhysics)
         {
                 return TRUE;
         }
@@ -60,6 +60,10 @@ public:
 	// all subclasses must implement such a function and register it
 	static LLMotion *create(const LLUUID &id) { return new LLPhysicsMotionController(id); }
 
+	// Reads the settings the motions use on the main thread, since they may
+	// be updated on worker threads. Called once per frame.
+	static void cacheSettings();
+
 public:
 	//-------------------------------------------------------------------------
 	// animation callbacks to be implemented by subclasses
@@ -112,6 +116,8 @@ private:
 
 	typedef std::vector<LLPhysicsMotion *> motion_vec_t;
 	motion_vec_t mMotions;
+
+	static bool sAvatarPhysics;
 };
 
 #endif // LL_LLPHYSICSMOTION_H
@@ -113,19 +113,41 @@ void LLReflectionMap::autoAdjustOrigin()
             extents[1].setSub(bounds[0], bounds[1]);
 
             bool hit = false;
-            for (int i = 0; i < 8; ++i)
+            static LLCachedControl<bool> packet_trace(gSavedSettings, "RenderReflectionProbePacketTrace", false);
+            if (packet_trace)
             {
-                int face = -1;
-                LLVector4a intersection;
-                LLDrawable* drawable = mGroup->lineSegmentIntersect(bounds[0], corners[i], false, false, true, true, &face, &intersection);
-                if (drawable != nullptr)
+                // all 8 rays go down the octree together, ends stop at whatever they hit
+                LLVector4a starts[8];
+                LLVector4a ends[8];
+                BOOL hits[8];
+                for (int i = 0; i < 8; ++i)
+                {
+                    starts[i] = bounds[0];
+                    ends[i] = corners[i];
+                }
+
+                hit = mGroup->lineSegmentsIntersect(starts, ends, 8, false, false, true, true, hits);
+                for (int i = 0; i < 8; ++i)
                 {
-                    hit = true;
-                    update_min_max(extents[0], extents[1], intersection);
+                    update_min_max(extents[0], extents[1], ends[i]);
                 }
-                else
+            }
+            else
+            {
+                for (int i = 0; i < 8; ++i)
                 {
-                    update_min_max(extents[0], extents[1], corners[i]);
+                    int face = -1;
+                    LLVector4a intersection;
+                    LLDrawable* drawable = mGroup->lineSegmentIntersect(bounds[0], corners[i], false, false, true, true, &face, &intersection);
+                    if (drawable != nullptr)
+                    {
+                        hit = true;
+                        update_min_max(extents[0], extents[1], intersection);
+                    }
+                    else
+                    {
+                        update_min_max(extents[0], extents[1], corners[i]);
+                    }
                 }
             }
 
@@ -0,0 +1,243 @@
+/**
+ * @file llrigginginfocache.cpp
+ * @brief Per-face rigging info of mesh assets, kept across volume reloads
+ *        and sessions.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llrigginginfocache.h"
+
+#include "llfilesystem.h"
+#include "lljoint.h"
+#include "llmodel.h"
+#include "llrigginginfo.h"
+#include "llvolume.h"
+
+namespace
+{
+    // bump when the layout or the way extents are computed changes
+    const U32 RIGGING_INFO_CACHE_VERSION = 1;
+
+    // Combined with a mesh id to give the id of its rigging info in the
+    // disk cache, which names files by id alone.
+    const LLUUID RIGGING_INFO_CACHE_SALT("8f0c4b5e-2a7d-4c61-9e3f-5b1d7a9c2e48");
+
+    // Meshes kept in memory; past this the map is dropped and refilled
+    // from disk as meshes are asked for again.
+    const size_t MAX_CACHED_MESHES = 4096;
+
+    LLUUID get_cache_id(const LLUUID& mesh_id)
+    {
+        return mesh_id.combine(RIGGING_INFO_CACHE_SALT);
+    }
+
+    template<typename T>
+    void append(std::vector<U8>& buffer, const T& value)
+    {
+        const U8* bytes = reinterpret_cast<const U8*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    bool extract(const std::vector<U8>& buffer, size_t& pos, T& value)
+    {
+        if (pos + sizeof(T) > buffer.size())
+        {
+            return false;
+        }
+        memcpy(&value, &buffer[pos], sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+}
+
+bool LLRiggingInfoCache::fetch(const LLUUID& mesh_id, S32 lod, S32 face, const LLMeshSkinInfo* skin, LLVolumeFace& vol_face)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    MeshEntry& mesh = getMesh(mesh_id, skin);
+    auto it = mesh.mFaces.find(std::make_pair(lod, face));
+    if (it == mesh.mFaces.end() || it->second.mNumVertices != vol_face.mNumVertices)
+    {
+        return false;
+    }
+
+    LLJointRiggingInfoTab& rig_info_tab = vol_face.mJointRiggingInfoTab;
+    rig_info_tab.clear();
+    rig_info_tab.resize(LL_CHARACTER_MAX_ANIMATED_JOINTS);
+    for (const JointExtents& joint : it->second.mJoints)
+    {
+        LLJointRiggingInfo& info = rig_info_tab[joint.mJointNum];
+        info.setIsRiggedTo(true);
+        info.getRiggedExtents()[0].load3(joint.mMin);
+        info.getRiggedExtents()[1].load3(joint.mMax);
+    }
+    rig_info_tab.setNeedsUpdate(false);
+    return true;
+}
+
+void LLRiggingInfoCache::store(const LLUUID& mesh_id, S32 lod, S32 face, const LLMeshSkinInfo* skin, const LLVolumeFace& vol_face)
+{
+    const LLJointRiggingInfoTab& rig_info_tab = vol_face.mJointRiggingInfoTab;
+    if (rig_info_tab.size() == 0)
+    {
+        return;
+    }
+
+    FaceEntry entry;
+    entry.mNumVertices = vol_face.mNumVertices;
+    for (S32 joint_num = 0; joint_num < rig_info_tab.size(); ++joint_num)
+    {
+        const LLJointRiggingInfo& info = rig_info_tab[joint_num];
+        if (info.isRiggedTo())
+        {
+            JointExtents joint;
+            joint.mJointNum = joint_num;
+            memcpy(joint.mMin, info.getRiggedExtents()[0].getF32ptr(), sizeof(joint.mMin));
+            memcpy(joint.mMax, info.getRiggedExtents()[1].getF32ptr(), sizeof(joint.mMax));
+            entry.mJoints.push_back(joint);
+        }
+    }
+
+    MeshEntry& mesh = getMesh(mesh_id, skin);
+    mesh.mFaces[std::make_pair(lod, face)] = std::move(entry);
+    mesh.mDirty = true;
+}
+
+void LLRiggingInfoCache::save(const LLUUID& mesh_id)
+{
+    auto it = mMeshes.find(mesh_id);
+    if (it != mMeshes.end() && it->second.mDirty)
+    {
+        write(mesh_id, it->second);
+        it->second.mDirty = false;
+    }
+}
+
+LLRiggingInfoCache::MeshEntry& LLRiggingInfoCache::getMesh(const LLUUID& mesh_id, const LLMeshSkinInfo* skin)
+{
+    auto it = mMeshes.find(mesh_id);
+    if (it == mMeshes.end())
+    {
+        if (mMeshes.size() >= MAX_CACHED_MESHES)
+        {
+            // everything stored has been saved by now
+            mMeshes.clear();
+        }
+        it = mMeshes.emplace(mesh_id, MeshEntry()).first;
+        if (!read(mesh_id, it->second))
+        {
+            it->second = MeshEntry();
+        }
+    }
+
+    MeshEntry& mesh = it->second;
+    if (mesh.mSkinHash != skin->mHash)
+    {
+        // not what these extents were computed from
+        mesh.mFaces.clear();
+        mesh.mSkinHash = skin->mHash;
+    }
+    return mesh;
+}
+
+// static
+bool LLRiggingInfoCache::read(const LLUUID& mesh_id, MeshEntry& mesh)
+{
+    LLFileSystem file(get_cache_id(mesh_id), LLAssetType::AT_MESH);
+    S32 size = file.getSize();
+    if (size <= 0)
+    {
+        return false;
+    }
+
+    std::vector<U8> buffer(size);
+    if (!file.read(buffer.data(), size) || file.getLastBytesRead() != size)
+    {
+        return false;
+    }
+
+    size_t pos = 0;
+    U32 version = 0;
+    U32 face_count = 0;
+    if (!extract(buffer, pos, version) || version != RIGGING_INFO_CACHE_VERSION ||
+        !extract(buffer, pos, mesh.mSkinHash) ||
+        !extract(buffer, pos, face_count))
+    {
+        return false;
+    }
+
+    for (U32 i = 0; i < face_count; ++i)
+    {
+        S32 lod, face;
+        U32 joint_count;
+        FaceEntry entry;
+        if (!extract(buffer, pos, lod) ||
+            !extract(buffer, pos, face) ||
+            !extract(buffer, pos, entry.mNumVertices) ||
+            !extract(buffer, pos, joint_count) ||
+            joint_count > LL_CHARACTER_MAX_ANIMATED_JOINTS)
+        {
+            return false;
+        }
+        entry.mJoints.resize(joint_count);
+        for (JointExtents& joint : entry.mJoints)
+        {
+            if (!extract(buffer, pos, joint) ||
+                joint.mJointNum < 0 || joint.mJointNum >= (S32)LL_CHARACTER_MAX_ANIMATED_JOINTS)
+            {
+                return false;
+            }
+        }
+        mesh.mFaces[std::make_pair(lod, face)] = std::move(entry);
+    }
+    return true;
+}
+
+// static
+void LLRiggingInfoCache::write(const LLUUID& mesh_id, const MeshEntry& mesh)
+{
+    std::vector<U8> buffer;
+    append(buffer, RIGGING_INFO_CACHE_VERSION);
+    append(buffer, mesh.mSkinHash);
+    append(buffer, (U32) mesh.mFaces.size());
+    for (const auto& face : mesh.mFaces)
+    {
+        append(buffer, face.first.first);
+        append(buffer, face.first.second);
+        append(buffer, face.second.mNumVertices);
+        append(buffer, (U32) face.second.mJoints.size());
+        for (const JointExtents& joint : face.second.mJoints)
+        {
+            append(buffer, joint);
+        }
+    }
+
+    LLFileSystem file(get_cache_id(mesh_id), LLAssetType::AT_MESH, LLFileSystem::WRITE);
+    if (!file.write(buffer.data(), (S32) buffer.size()))
+    {
+        LL_WARNS("Mesh") << "Failed to cache rigging info for mesh " << mesh_id << LL_ENDL;
+    }
+}
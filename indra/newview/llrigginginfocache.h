@@ -0,0 +1,93 @@
+/**
+ * @file llrigginginfocache.h
+ * @brief Per-face rigging info of mesh assets, kept across volume reloads
+ *        and sessions.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLRIGGINGINFOCACHE_H
+#define LL_LLRIGGINGINFOCACHE_H
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "llsingleton.h"
+#include "lluuid.h"
+
+class LLMeshSkinInfo;
+class LLVolumeFace;
+
+// The joint extents LLSkinningUtil::updateRiggingInfo() works out for a
+// rigged face depend only on the mesh asset, so they're the same for every
+// avatar wearing it. This keeps them by mesh id, LOD and face, and writes
+// them to the disk cache next to the mesh itself, so a face only ever has
+// its vertices scanned once rather than every time its volume is loaded.
+//
+// Entries are checked against the skin's hash and the face's vertex count
+// before use, and a mesh is only read from disk the first time it's asked
+// for in a session.
+class LLRiggingInfoCache : public LLSingleton<LLRiggingInfoCache>
+{
+    LLSINGLETON_EMPTY_CTOR(LLRiggingInfoCache);
+public:
+    // Fill in vol_face.mJointRiggingInfoTab from the cache. False if there's
+    // nothing cached for this face and skin.
+    bool fetch(const LLUUID& mesh_id, S32 lod, S32 face, const LLMeshSkinInfo* skin, LLVolumeFace& vol_face);
+
+    // Remember the rigging info just computed for vol_face, until save().
+    void store(const LLUUID& mesh_id, S32 lod, S32 face, const LLMeshSkinInfo* skin, const LLVolumeFace& vol_face);
+
+    // Write whatever store() added for mesh_id to the disk cache.
+    void save(const LLUUID& mesh_id);
+
+private:
+    struct JointExtents
+    {
+        S32 mJointNum;
+        F32 mMin[3];
+        F32 mMax[3];
+    };
+
+    struct FaceEntry
+    {
+        S32 mNumVertices;
+        std::vector<JointExtents> mJoints;
+    };
+
+    struct MeshEntry
+    {
+        U64 mSkinHash = 0;
+        bool mDirty = false;
+        // by LOD and face
+        std::map<std::pair<S32, S32>, FaceEntry> mFaces;
+    };
+
+    MeshEntry& getMesh(const LLUUID& mesh_id, const LLMeshSkinInfo* skin);
+    static bool read(const LLUUID& mesh_id, MeshEntry& mesh);
+    static void write(const LLUUID& mesh_id, const MeshEntry& mesh);
+
+    std::unordered_map<LLUUID, MeshEntry> mMeshes;
+};
+
+#endif // LL_LLRIGGINGINFOCACHE_H
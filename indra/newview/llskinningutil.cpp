@@ -36,6 +36,73 @@
 
 #define DEBUG_SKINNING  LL_DEBUG
 
+namespace
+{
+    // Split weights packed as joint index + weight fraction into indices
+    // clamped to [0, max_index] and weights normalized to sum to 1, like
+    // getPerVertexSkinMatrix() does one component at a time. A vertex with
+    // no weight at all comes out with NaN weights.
+    LL_FORCE_INLINE void unpack_skin_weights(const LLVector4a& packed, const __m128& max_index, S32* idx, LLVector4a& weights)
+    {
+        __m128 whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(packed));
+        // truncation rounds negative values up, floor them
+        whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmpgt_ps(whole, packed), _mm_set1_ps(1.f)));
+        __m128 frac = _mm_sub_ps(packed, whole);
+
+        __m128 sum = _mm_add_ps(frac, _mm_shuffle_ps(frac, frac, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        weights = _mm_div_ps(frac, sum);
+
+        whole = _mm_min_ps(_mm_max_ps(whole, _mm_setzero_ps()), max_index);
+        _mm_storeu_si128((__m128i*) idx, _mm_cvttps_epi32(whole));
+    }
+
+    // Same for four vertices at once, idx getting four indices per vertex.
+    // The weight sums come out of a transpose, so the four vertices share
+    // one divide.
+    LL_FORCE_INLINE void unpack_skin_weights4(const LLVector4a* packed, const __m128& max_index, S32* idx, LLVector4a* weights)
+    {
+        __m128 frac[4];
+        for (U32 v = 0; v < 4; ++v)
+        {
+            __m128 whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(packed[v]));
+            whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmpgt_ps(whole, packed[v]), _mm_set1_ps(1.f)));
+            frac[v] = _mm_sub_ps(packed[v], whole);
+
+            whole = _mm_min_ps(_mm_max_ps(whole, _mm_setzero_ps()), max_index);
+            _mm_storeu_si128((__m128i*) (idx + v * 4), _mm_cvttps_epi32(whole));
+        }
+
+        __m128 w0 = frac[0], w1 = frac[1], w2 = frac[2], w3 = frac[3];
+        _MM_TRANSPOSE4_PS(w0, w1, w2, w3);
+        __m128 inv_sum = _mm_div_ps(_mm_set1_ps(1.f), _mm_add_ps(_mm_add_ps(w0, w1), _mm_add_ps(w2, w3)));
+
+        weights[0] = _mm_mul_ps(frac[0], _mm_shuffle_ps(inv_sum, inv_sum, _MM_SHUFFLE(0, 0, 0, 0)));
+        weights[1] = _mm_mul_ps(frac[1], _mm_shuffle_ps(inv_sum, inv_sum, _MM_SHUFFLE(1, 1, 1, 1)));
+        weights[2] = _mm_mul_ps(frac[2], _mm_shuffle_ps(inv_sum, inv_sum, _MM_SHUFFLE(2, 2, 2, 2)));
+        weights[3] = _mm_mul_ps(frac[3], _mm_shuffle_ps(inv_sum, inv_sum, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+
+    // All four influences, unused ones included: they're packed with zero
+    // weight, and a branch per influence costs more than the transform.
+    LL_FORCE_INLINE void skin_position(const LLVector4a& v, const LLVector4a& wght, const S32* idx,
+                                       const LLMatrix4a* bound, LLVector4a& out)
+    {
+        LLVector4a t0, t1, t2, t3;
+        bound[idx[0]].affineTransform(v, t0);
+        bound[idx[1]].affineTransform(v, t1);
+        bound[idx[2]].affineTransform(v, t2);
+        bound[idx[3]].affineTransform(v, t3);
+        t0.mul(_mm_shuffle_ps(wght, wght, _MM_SHUFFLE(0, 0, 0, 0)));
+        t1.mul(_mm_shuffle_ps(wght, wght, _MM_SHUFFLE(1, 1, 1, 1)));
+        t2.mul(_mm_shuffle_ps(wght, wght, _MM_SHUFFLE(2, 2, 2, 2)));
+        t3.mul(_mm_shuffle_ps(wght, wght, _MM_SHUFFLE(3, 3, 3, 3)));
+        t0.add(t1);
+        t2.add(t3);
+        out.setAdd(t0, t2);
+    }
+}
+
 void dump_avatar_and_skin_state(const std::string& reason, LLVOAvatar *avatar, const LLMeshSkinInfo *skin)
 {
 #if DEBUG_SKINNING
@@ -249,7 +316,12 @@ void LLSkinningUtil::getPerVertexSkinMatrix(
     {
         // This is enforced  in unpackVolumeFaces()
         llassert(scale>0.f);
-        wght *= 1.f/scale;
+        // not wght *= 1.f/scale, LLVector4 scales xyz only
+        F32 inv_scale = 1.f/scale;
+        for (U32 k = 0; k < 4; k++)
+        {
+            wght[k] *= inv_scale;
+        }
     }
 
     for (U32 k = 0; k < 4; k++)
@@ -269,6 +341,48 @@ void LLSkinningUtil::getPerVertexSkinMatrix(
     (void)valid_weights;
 }
 
+void LLSkinningUtil::bindSkinningMatrixPalette(
+    LLMatrix4a* bound,
+    const LLMatrix4a* mat,
+    U32 count,
+    const LLMatrix4a& bind_shape)
+{
+    for (U32 j = 0; j < count; ++j)
+    {
+        matMul(bind_shape, mat[j], bound[j]);
+    }
+}
+
+void LLSkinningUtil::skinPositions(
+    const LLVector4a* positions,
+    const LLVector4a* weights,
+    U32 count,
+    const LLMatrix4a* bound,
+    U32 bound_count,
+    LLVector4a* out)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    const __m128 max_index = _mm_set1_ps((F32) bound_count - 1.f);
+    LL_ALIGN_16(S32 idx[16]);
+    LLVector4a wght[4];
+
+    U32 i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        unpack_skin_weights4(weights + i, max_index, idx, wght);
+        skin_position(positions[i], wght[0], idx, bound, out[i]);
+        skin_position(positions[i + 1], wght[1], idx + 4, bound, out[i + 1]);
+        skin_position(positions[i + 2], wght[2], idx + 8, bound, out[i + 2]);
+        skin_position(positions[i + 3], wght[3], idx + 12, bound, out[i + 3]);
+    }
+    for (; i < count; ++i)
+    {
+        unpack_skin_weights(weights[i], max_index, idx, wght[0]);
+        skin_position(positions[i], wght[0], idx, bound, out[i]);
+    }
+}
+
 void LLSkinningUtil::initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar)
 {
     if (!skin->mJointNumsInitialized)
@@ -328,28 +442,19 @@ void LLSkinningUtil::updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *a
                 //S32 active_verts = 0;
                 vol_face.mJointRiggingInfoTab.resize(LL_CHARACTER_MAX_ANIMATED_JOINTS);
                 LLJointRiggingInfoTab &rig_info_tab = vol_face.mJointRiggingInfoTab;
+
+                // bind shape and inverse bind per joint, once per face
+                LLMatrix4a bound[LL_CHARACTER_MAX_ANIMATED_JOINTS];
+                S32 bound_joints = llmin(num_joints, (S32) LL_CHARACTER_MAX_ANIMATED_JOINTS);
+                bindSkinningMatrixPalette(bound, &skin->mInvBindMatrix[0], bound_joints, skin->mBindShapeMatrix);
+                const __m128 max_index = _mm_set1_ps((F32) LL_CHARACTER_MAX_ANIMATED_JOINTS - 1.f);
+
                 for (S32 i=0; i<vol_face.mNumVertices; i++)
                 {
                     LLVector4a& pos = vol_face.mPositions[i];
-                    F32 *weights = vol_face.mWeights[i].getF32ptr();
-                    LLVector4 wght;
+                    LLVector4a wght;
                     S32 idx[4];
-                    F32 scale = 0.0f;
-                    // FIXME unpacking of weights should be pulled into a common function and optimized if possible.
-                    for (U32 k = 0; k < 4; k++)
-                    {
-                        F32 w = weights[k];
-                        idx[k] = llclamp((S32) floorf(w), (S32)0, (S32)LL_CHARACTER_MAX_ANIMATED_JOINTS-1);
-                        wght[k] = w - idx[k];
-                        scale += wght[k];
-                    }
-                    if (scale > 0.0f)
-                    {
-                        for (U32 k=0; k<4; ++k)
-                        {
-                            wght[k] /= scale;
-                        }
-                    }
+                    unpack_skin_weights(vol_face.mWeights[i], max_index, idx, wght);
                     for (U32 k=0; k<4; ++k)
                     {
 						S32 joint_index = idx[k];
@@ -360,15 +465,8 @@ void LLSkinningUtil::updateRiggingInfo(const LLMeshSkinInfo* skin, LLVOAvatar *a
                             {
                                 rig_info_tab[joint_num].setIsRiggedTo(true);
 
-                                // FIXME could precompute these matMuls.
-                                const LLMatrix4a& bind_shape = skin->mBindShapeMatrix;
-                                const LLMatrix4a& inv_bind = skin->mInvBindMatrix[joint_index];
-                                LLMatrix4a mat;
                                 LLVector4a pos_joint_space;
-
-                                matMul(bind_shape, inv_bind, mat);
-
-                                mat.affineTransform(pos, pos_joint_space);
+                                bound[joint_index].affineTransform(pos, pos_joint_space);
                                 pos_joint_space.mul(wght[k]);
 
                                 LLVector4a *extents = rig_info_tab[joint_num].getRiggedExtents();
@@ -47,6 +47,16 @@ namespace LLSkinningUtil
     void scrubSkinWeights(LLVector4a* weights, U32 num_vertices, const LLMeshSkinInfo* skin);
     void getPerVertexSkinMatrix(F32* weights, const LLMatrix4a* mat, bool handle_bad_scale, LLMatrix4a& final_mat, U32 max_joints);
 
+    // Fold the bind shape matrix into count palette entries, for
+    // skinPositions().
+    void bindSkinningMatrixPalette(LLMatrix4a* bound, const LLMatrix4a* mat, U32 count, const LLMatrix4a& bind_shape);
+    // Skin count positions against a palette from bindSkinningMatrixPalette().
+    // Same result as getPerVertexSkinMatrix() and the two transforms per
+    // vertex, but transforms each vertex by its four joints and blends the
+    // results, unpacking weights four vertices at a time.
+    void skinPositions(const LLVector4a* positions, const LLVector4a* weights, U32 count,
+                       const LLMatrix4a* bound, U32 bound_count, LLVector4a* out);
+
     LL_FORCE_INLINE void getPerVertexSkinMatrixWithIndices(
         F32*        weights,
         U8*         idx,
@@ -881,6 +881,7 @@ LLSpatialPartition::LLSpatialPartition(U32 data_mask, BOOL render_by_group, LLVi
 	mDepthMask = FALSE;
 	mSlopRatio = 0.25f;
 	mInfiniteFarClip = FALSE;
+	mStaticBVH.setDirty();
 
 	new LLSpatialGroup(mOctree, this);
 }
@@ -895,6 +896,7 @@ LLSpatialGroup *LLSpatialPartition::put(LLDrawable *drawablep, BOOL was_visible)
 {
     LL_PROFILE_ZONE_SCOPED;
 	drawablep->updateSpatialExtents();
+	mStaticBVH.setDirty();
 
 	//keep drawable from being garbage collected
 	LLPointer<LLDrawable> ptr = drawablep;
@@ -920,6 +922,7 @@ LLSpatialGroup *LLSpatialPartition::put(LLDrawable *drawablep, BOOL was_visible)
 BOOL LLSpatialPartition::remove(LLDrawable *drawablep, LLSpatialGroup *curp)
 {
     LL_PROFILE_ZONE_SCOPED;
+	mStaticBVH.setDirty();
 	if (!curp->removeObject(drawablep))
 	{
 		OCT_ERRS << "Failed to remove drawable from octree!" << LL_ENDL;
@@ -944,6 +947,9 @@ void LLSpatialPartition::move(LLDrawable *drawablep, LLSpatialGroup *curp, BOOL
 		OCT_ERRS << "LLSpatialPartition::move was passed a bad drawable." << LL_ENDL;
 		return;
 	}
+
+	// extents change even when the drawable stays in its group
+	mStaticBVH.setDirty();
 		
 	BOOL was_visible = curp ? curp->isVisible() : FALSE;
 
@@ -995,6 +1001,52 @@ void LLSpatialPartition::shift(const LLVector4a &offset)
 { //shift octree node bounding boxes by offset
 	LLSpatialShift shifter(offset);
 	shifter.traverse(mOctree);
+	mStaticBVH.setDirty();
+}
+
+class LLOctreeGatherEntries : public OctreeTraveler
+{
+public:
+	LLOctreeGatherEntries(std::vector<LLViewerOctreeEntry*>& entries) : mEntries(entries) { }
+	virtual void visit(const OctreeNode* branch)
+	{
+		for (OctreeNode::const_element_iter i = branch->getDataBegin(); i != branch->getDataEnd(); ++i)
+		{
+			mEntries.push_back(*i);
+		}
+	}
+
+	std::vector<LLViewerOctreeEntry*>& mEntries;
+};
+
+bool LLSpatialPartition::useStaticBVH()
+{
+	// Only the region's own volume partition is static content, anything
+	// that moves is put in a bridge of its own
+	static LLCachedControl<bool> static_bvh(gSavedSettings, "RenderStaticBVH", false);
+	return static_bvh && !isBridge() && mPartitionType == LLViewerRegion::PARTITION_VOLUME;
+}
+
+void LLSpatialPartition::updateStaticBVH()
+{
+	if (!mStaticBVH.isDirty())
+	{
+		return;
+	}
+
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+	mStaticBVHEntries.clear();
+	LLOctreeGatherEntries gather(mStaticBVHEntries);
+	gather.traverse(mOctree);
+
+	std::vector<LLVector4a> bounds(mStaticBVHEntries.size() * 2);
+	for (size_t i = 0; i < mStaticBVHEntries.size(); ++i)
+	{
+		const LLVector4a* extents = mStaticBVHEntries[i]->getSpatialExtents();
+		bounds[i * 2] = extents[0];
+		bounds[i * 2 + 1] = extents[1];
+	}
+	mStaticBVH.build(bounds.data(), (U32) mStaticBVHEntries.size());
 }
 
 class LLOctreeCull : public LLViewerOctreeCull
@@ -1199,6 +1251,22 @@ public:
 	BOOL mResult;
 };
 
+static void select_entry(LLViewerOctreeEntry* entry, LLCamera& camera, std::vector<LLDrawable*>* results)
+{
+	LLDrawable* drawable = (LLDrawable*)entry->getDrawable();
+	if (drawable && !drawable->isDead())
+	{
+		if (drawable->isSpatialBridge())
+		{
+			drawable->setVisible(camera, results, TRUE);
+		}
+		else
+		{
+			results->push_back(drawable);
+		}
+	}
+}
+
 class LLOctreeSelect : public LLOctreeCull
 {
 public:
@@ -1215,22 +1283,7 @@ public:
 
 		for (OctreeNode::const_element_iter i = branch->getDataBegin(); i != branch->getDataEnd(); ++i)
 		{
-			LLDrawable* drawable = (LLDrawable*)(*i)->getDrawable();
-			if(!drawable)
-		{
-				continue;
-			}
-			if (!drawable->isDead())
-			{
-				if (drawable->isSpatialBridge())
-				{
-					drawable->setVisible(*mCamera, mResults, TRUE);
-				}
-				else
-				{
-					mResults->push_back(drawable);
-				}
-			}		
+			select_entry(*i, *mCamera, mResults);
 		}
 	}
 	
@@ -1391,6 +1444,32 @@ S32 LLSpatialPartition::cull(LLCamera &camera, std::vector<LLDrawable *>* result
 	((LLSpatialGroup*)mOctree->getListener(0))->validate();
 #endif
 
+	if (useStaticBVH())
+	{
+		updateStaticBVH();
+
+		// the checks LLOctreeSelect makes of groups, made of each drawable
+		const LLVector3& origin = camera.getOrigin();
+		const F32 radius = camera.mFrustumCornerDist;
+		mStaticBVH.cull([&](const LLVector4a& center, const LLVector4a& size)
+			{
+				S32 res = camera.AABBInFrustumNoFarClip(center, size);
+				if (res != 0)
+				{
+					LLVector4a min, max;
+					min.setSub(center, size);
+					max.setAdd(center, size);
+					res = llmin(res, AABBSphereIntersect(min, max, origin, radius));
+				}
+				return res;
+			},
+			[&](U32 element)
+			{
+				select_entry(mStaticBVHEntries[element], camera, results);
+			});
+		return 0;
+	}
+
 		LLOctreeSelect selecter(&camera, results);
 		selecter.traverse(mOctree);
 	
@@ -1412,19 +1491,35 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
 	((LLSpatialGroup*)mOctree->getListener(0))->validate();
 #endif
 
+    //frustum checks of these cullers only read bounds, so they can be done
+    //on the thread pool ahead of the traversal
+    static LLCachedControl<bool> parallel_cull(gSavedSettings, "RenderParallelCull", true);
+
     if (LLPipeline::sShadowRender)
     {
         LLOctreeCullShadow culler(&camera);
+        if (parallel_cull)
+        {
+            culler.precull(mOctree);
+        }
         culler.traverse(mOctree);
     }
     else if (mInfiniteFarClip || (!LLPipeline::sUseFarClip && !gCubeSnapshot))
     {
         LLOctreeCullNoFarClip culler(&camera);
+        if (parallel_cull)
+        {
+            culler.precull(mOctree);
+        }
         culler.traverse(mOctree);
     }
     else
     {
         LLOctreeCull culler(&camera);
+        if (parallel_cull)
+        {
+            culler.precull(mOctree);
+        }
         culler.traverse(mOctree);
     }
 	
@@ -3701,6 +3796,136 @@ public:
 	}
 } LL_ALIGN_POSTFIX(16);
 
+// LLOctreeIntersect for several segments at once, each only wanting the
+// point it hits.  Objects get all the segments in one call so volumes
+// can trace them together.
+class LLOctreeIntersectSegments : public LLOctreeTraveler<LLViewerOctreeEntry, LLPointer<LLViewerOctreeEntry>>
+{
+public:
+	const LLVector4a* mStart;
+	LLVector4a* mEnd;
+	U32 mCount;
+	BOOL* mHit;
+	BOOL mPickTransparent;
+	BOOL mPickRigged;
+	BOOL mPickUnselectable;
+	BOOL mPickReflectionProbe;
+
+	LLOctreeIntersectSegments(const LLVector4a* start, LLVector4a* end, U32 count,
+							  BOOL pick_transparent, BOOL pick_rigged, BOOL pick_unselectable, BOOL pick_reflection_probe,
+							  BOOL* hit)
+		: mStart(start),
+		  mEnd(end),
+		  mCount(count),
+		  mHit(hit),
+		  mPickTransparent(pick_transparent),
+		  mPickRigged(pick_rigged),
+		  mPickUnselectable(pick_unselectable),
+		  mPickReflectionProbe(pick_reflection_probe)
+	{
+	}
+
+	virtual void visit(const OctreeNode* branch) 
+	{	
+		for (OctreeNode::const_element_iter i = branch->getDataBegin(); i != branch->getDataEnd(); ++i)
+		{
+			check(*i);
+		}
+	}
+
+	void check(const OctreeNode* node)
+	{
+		node->accept(this);
+	
+		for (U32 i = 0; i < node->getChildCount(); i++)
+		{
+			const OctreeNode* child = node->getChild(i);
+			LLSpatialGroup* group = (LLSpatialGroup*) child->getListener(0);
+			const LLVector4a* bounds = group->getBounds();
+
+			LLMatrix4a local_matrix4a;
+			bool bridge = group->getSpatialPartition()->isBridge();
+			if (bridge)
+			{
+				LLMatrix4 local_matrix = group->getSpatialPartition()->asBridge()->mDrawable->getRenderMatrix();
+				local_matrix.invert();
+				local_matrix4a.loadu(local_matrix);
+			}
+
+			for (U32 s = 0; s < mCount; ++s)
+			{
+				LLVector4a local_start = mStart[s];
+				LLVector4a local_end   = mEnd[s];
+				if (bridge)
+				{
+					local_matrix4a.affineTransform(mStart[s], local_start);
+					local_matrix4a.affineTransform(mEnd[s], local_end);
+				}
+
+				if (LLLineSegmentBoxIntersect(local_start, local_end, bounds[0], bounds[1]))
+				{
+					check(child);
+					break;
+				}
+			}
+		}	
+	}
+
+	void check(LLViewerOctreeEntry* entry)
+	{	
+		LLDrawable* drawable = (LLDrawable*)entry->getDrawable();
+	
+		if (!drawable || !gPipeline.hasRenderType(drawable->getRenderType()) || !drawable->isVisible())
+		{
+			return;
+		}
+
+		if (drawable->isSpatialBridge())
+		{
+			LLSpatialPartition *part = drawable->asPartition();
+			LLSpatialBridge* bridge = part->asBridge();
+			if (bridge && gPipeline.hasRenderType(bridge->mDrawableType))
+			{
+				check(part->mOctree);
+			}
+			return;
+		}
+
+		LLViewerObject* vobj = drawable->getVObj();
+		if (!vobj || (vobj->isReflectionProbe() && !mPickReflectionProbe))
+		{
+			return;
+		}
+
+		if (vobj->isAvatar())
+		{ //rigged attachments come in through the avatar, leave them to the single segment path
+			for (U32 s = 0; s < mCount; ++s)
+			{
+				S32 face_hit = -1;
+				LLVector4a intersection;
+				LLOctreeIntersect intersect(mStart[s], mEnd[s], mPickTransparent, mPickRigged, mPickUnselectable, mPickReflectionProbe,
+											&face_hit, &intersection, NULL, NULL, NULL);
+				intersect.check(entry);
+				if (intersect.mHit)
+				{
+					mEnd[s] = intersection;
+					mHit[s] = TRUE;
+				}
+			}
+			return;
+		}
+
+		if (vobj->getClickAction() == CLICK_ACTION_IGNORE && !LLFloater::isVisible(gFloaterTools))
+		{
+			return;
+		}
+
+		vobj->lineSegmentsIntersect(mStart, mEnd, mCount,
+			(mPickReflectionProbe && vobj->isReflectionProbe()) ? TRUE : mPickTransparent, // always pick transparent when picking selection probe
+			mPickRigged, mPickUnselectable, mHit);
+	}
+};
+
 LLDrawable* LLSpatialPartition::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& end,
 													 BOOL pick_transparent,
 													 BOOL pick_rigged,
@@ -3715,6 +3940,28 @@ LLDrawable* LLSpatialPartition::lineSegmentIntersect(const LLVector4a& start, co
 
 {
 	LLOctreeIntersect intersect(start, end, pick_transparent, pick_rigged, pick_unselectable, pick_reflection_probe, face_hit, intersection, tex_coord, normal, tangent);
+
+	if (useStaticBVH())
+	{
+		updateStaticBVH();
+
+		// nearest drawables first, and none further than the last hit
+		LLVector4a dir;
+		dir.setSub(end, start);
+		const F32 length_squared = dir.dot3(dir).getF32();
+		mStaticBVH.raycast(start, end, [&](U32 element, F32& closest)
+			{
+				intersect.check(mStaticBVHEntries[element]);
+				if (length_squared > 0.f)
+				{
+					LLVector4a along;
+					along.setSub(intersect.mEnd, start);
+					closest = llclamp(along.dot3(dir).getF32() / length_squared, 0.f, closest);
+				}
+			});
+		return intersect.mHit;
+	}
+
 	LLDrawable* drawable = intersect.check(mOctree);
 
 	return drawable;
@@ -3739,6 +3986,31 @@ LLDrawable* LLSpatialGroup::lineSegmentIntersect(const LLVector4a& start, const
     return drawable;
 }
 
+BOOL LLSpatialGroup::lineSegmentsIntersect(const LLVector4a* start, LLVector4a* end, U32 count,
+    BOOL pick_transparent,
+    BOOL pick_rigged,
+    BOOL pick_unselectable,
+    BOOL pick_reflection_probe,
+    BOOL* hit)
+{
+    for (U32 i = 0; i < count; ++i)
+    {
+        hit[i] = FALSE;
+    }
+
+    LLOctreeIntersectSegments intersect(start, end, count, pick_transparent, pick_rigged, pick_unselectable, pick_reflection_probe, hit);
+    intersect.check(getOctreeNode());
+
+    for (U32 i = 0; i < count; ++i)
+    {
+        if (hit[i])
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 LLDrawInfo::LLDrawInfo(U16 start, U16 end, U32 count, U32 offset, 
 					   LLViewerTexture* texture, LLVertexBuffer* buffer,
 					   bool fullbright, U8 bump)
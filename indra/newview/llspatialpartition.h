@@ -29,6 +29,7 @@
 
 #define SG_MIN_DIST_RATIO 0.00001f
 
+#include "llbvh.h"
 #include "lldrawable.h"
 #include "lloctree.h"
 #include "llpointer.h"
@@ -324,6 +325,15 @@ public:
         LLVector4a* tangent = NULL             // return the surface tangent at the intersection point
     );
 
+    // As above for count segments that only want the point they hit.
+    // Sets hit[i] and moves end[i] to the nearest hit of each segment that hits.
+    BOOL lineSegmentsIntersect(const LLVector4a* start, LLVector4a* end, U32 count,
+        BOOL pick_transparent,
+        BOOL pick_rigged,
+        BOOL pick_unselectable,
+        BOOL pick_reflection_probe,
+        BOOL* hit);
+
 
 	LLSpatialPartition* getSpatialPartition() {return (LLSpatialPartition*)mSpatialPartition;}
 
@@ -427,6 +437,17 @@ public:
 
 	BOOL getVisibleExtents(LLCamera& camera, LLVector3& visMin, LLVector3& visMax);
 
+protected:
+	// Static content can be mirrored in an LLLinearBVH for raycasts and
+	// select culls, see RenderStaticBVH. It is rebuilt on the next query
+	// after anything is added, removed or moved.
+	bool useStaticBVH();
+	void updateStaticBVH();
+
+	LLLinearBVH mStaticBVH;
+	// entries in the order the BVH refers to them, only valid while it isn't dirty
+	std::vector<LLViewerOctreeEntry*> mStaticBVHEntries;
+
 public:
 	LLSpatialBridge* mBridge; // NULL for non-LLSpatialBridge instances, otherwise, mBridge == this
 							// use a pointer instead of making "isBridge" and "asBridge" virtual so it's safe
@@ -797,6 +797,7 @@ LLTextureCache::LLTextureCache(bool threaded)
 	  mFastCacheMutex(),
 	  mHeaderAPRFile(NULL),
 	  mReadOnly(TRUE), //do not allow to change the texture cache until setReadOnly() is called.
+	  mLRUTime(0),
 	  mTexturesSizeTotal(0),
 	  mDoPurge(FALSE),
 	  mFastCachep(NULL),
@@ -810,6 +811,7 @@ LLTextureCache::~LLTextureCache()
 {
 	clearDeleteList() ;
 	writeUpdatedEntries() ;
+	closeHeaderEntriesMap();
 	delete mFastCachep;
 	delete mFastCachePoolp;
 	delete mHeaderAPRFilePoolp;
@@ -875,10 +877,7 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
 //debug
 BOOL LLTextureCache::isInCache(const LLUUID& id) 
 {
-	LLMutexLock lock(&mHeaderMutex);
-	id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-	
-	return (iter != mHeaderIDMap.end()) ;
+	return mHeaderIDMap.find(id) >= 0;
 }
 
 //debug
@@ -1044,6 +1043,89 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
 //----------------------------------------------------------------------------
 // mHeaderMutex must be locked for the following functions!
 
+void LLTextureCache::lockEntryMutexes()
+{
+	for (U32 i = 0; i < NUM_ENTRY_MUTEXES; ++i)
+	{
+		mEntryMutex[i].lock();
+	}
+}
+
+void LLTextureCache::unlockEntryMutexes()
+{
+	for (U32 i = 0; i < NUM_ENTRY_MUTEXES; ++i)
+	{
+		mEntryMutex[i].unlock();
+	}
+}
+
+void LLTextureCache::openHeaderEntriesMap()
+{
+	llassert_always(mHeaderAPRFile == NULL);
+	// Size the file for the maximum number of entries up front so that the
+	// mapping never has to move while workers are reading from it.
+	size_t map_size = sizeof(EntriesInfo) + (size_t)sCacheMaxEntries * sizeof(Entry);
+
+	lockEntryMutexes();
+	if (!mHeaderEntriesMap.open(mHeaderEntriesFileName, map_size, !mReadOnly))
+	{
+		LL_WARNS("TextureCache") << "Could not map " << mHeaderEntriesFileName << ", using file access for header entries." << LL_ENDL;
+	}
+	unlockEntryMutexes();
+}
+
+void LLTextureCache::closeHeaderEntriesMap()
+{
+	lockEntryMutexes();
+	mHeaderEntriesMap.flush();
+	mHeaderEntriesMap.close();
+	unlockEntryMutexes();
+}
+
+bool LLTextureCache::readMappedEntry(S32 idx, Entry& entry)
+{
+	if (idx < 0)
+	{
+		return false;
+	}
+	// The mapping is opened and closed with every entry mutex held, so its
+	// size is only stable under the lock
+	size_t offset = sizeof(EntriesInfo) + (size_t)idx * sizeof(Entry);
+	LLMutexLock lock(&getEntryMutex(idx));
+	if (offset + sizeof(Entry) > mHeaderEntriesMap.getSize())
+	{
+		return false;
+	}
+	memcpy((void*)&entry, mHeaderEntriesMap.getData() + offset, sizeof(Entry));
+	return true;
+}
+
+bool LLTextureCache::writeMappedEntry(S32 idx, const Entry& entry)
+{
+	if (idx < 0)
+	{
+		return false;
+	}
+	size_t offset = sizeof(EntriesInfo) + (size_t)idx * sizeof(Entry);
+	LLMutexLock lock(&getEntryMutex(idx));
+	if (offset + sizeof(Entry) > mHeaderEntriesMap.getSize() || !mHeaderEntriesMap.isWritable())
+	{
+		return false;
+	}
+	memcpy(mHeaderEntriesMap.getData() + offset, (const void*)&entry, sizeof(Entry));
+	return true;
+}
+
+bool LLTextureCache::writeMappedEntriesInfo()
+{
+	if (mHeaderEntriesMap.getSize() < sizeof(EntriesInfo) || !mHeaderEntriesMap.isWritable())
+	{
+		return false;
+	}
+	memcpy(mHeaderEntriesMap.getData(), (const void*)&mHeaderEntriesInfo, sizeof(EntriesInfo));
+	return true;
+}
+
 LLAPRFile* LLTextureCache::openHeaderEntriesFile(bool readonly, S32 offset)
 {
 	llassert_always(mHeaderAPRFile == NULL);
@@ -1075,12 +1157,15 @@ void LLTextureCache::readEntriesHeader()
 	{
 		LLAPRFile::readEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
 						  mHeaderAPRFilePoolp);
+		// Size the id map for the entries about to be read
+		mHeaderIDMap.reserve(llmin(mHeaderEntriesInfo.mEntries, sCacheMaxEntries));
 	}
 	else //create an empty entries header.
 	{
 		setEntriesHeader();
 		writeEntriesHeader() ;
 	}
+	openHeaderEntriesMap();
 }
 
 void LLTextureCache::setEntriesHeader()
@@ -1103,7 +1188,7 @@ void LLTextureCache::setEntriesHeader()
 void LLTextureCache::writeEntriesHeader()
 {
 	llassert_always(mHeaderAPRFile == NULL);
-	if (!mReadOnly)
+	if (!mReadOnly && !writeMappedEntriesInfo())
 	{
 		LLAPRFile::writeEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
 						   mHeaderAPRFilePoolp);
@@ -1113,13 +1198,7 @@ void LLTextureCache::writeEntriesHeader()
 //mHeaderMutex is locked before calling this.
 S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create)
 {
-	S32 idx = -1;
-	
-	id_map_t::iterator iter1 = mHeaderIDMap.find(id);
-	if (iter1 != mHeaderIDMap.end())
-	{
-		idx = iter1->second;
-	}
+	S32 idx = mHeaderIDMap.find(id);
 
 	if (idx < 0)
 	{
@@ -1146,10 +1225,16 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 					// Erase entry from LRU regardless
 					mLRU.erase(curiter2);
 					// Look up entry and use it if it is valid
-					id_map_t::iterator iter3 = mHeaderIDMap.find(oldid);
-					if (iter3 != mHeaderIDMap.end() && iter3->second >= 0)
+					S32 old_idx = mHeaderIDMap.find(oldid);
+					if (old_idx >= 0)
 					{
-						idx = iter3->second;
+						// Workers do not remove entries they read from mLRU, skip the ones used since it was built
+						Entry old_entry;
+						if (readMappedEntry(old_idx, old_entry) && old_entry.mID == oldid && old_entry.mTime > mLRUTime)
+						{
+							continue;
+						}
+						idx = old_idx;
 						removeCachedTexture(oldid) ;//remove the existing cached texture to release the entry index.
 						break;
 					}
@@ -1197,6 +1282,18 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 //mHeaderMutex is locked before calling this.
 void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header)
 {	
+	if (mHeaderEntriesMap.isOpen())
+	{
+		if ((write_header && !writeMappedEntriesInfo()) || !writeMappedEntry(idx, entry))
+		{
+			clearCorruptedCache() ; //clear the cache.
+			idx = -1 ;//mark the idx invalid.
+			return ;
+		}
+		mUpdatedEntryMap.erase(idx) ;
+		return ;
+	}
+
 	LLAPRFile* aprfile ;
 	S32 bytes_written ;
 	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
@@ -1233,6 +1330,16 @@ void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool
 //mHeaderMutex is locked before calling this.
 void LLTextureCache::readEntryFromHeaderImmediately(S32& idx, Entry& entry)
 {
+	if (mHeaderEntriesMap.isOpen())
+	{
+		if (!readMappedEntry(idx, entry))
+		{
+			clearCorruptedCache() ; //clear the cache.
+			idx = -1 ;//mark the idx invalid.
+		}
+		return ;
+	}
+
 	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
 	LLAPRFile* aprfile = openHeaderEntriesFile(true, offset);
 	S32 bytes_read = aprfile->read((void*)&entry, (S32)sizeof(Entry));
@@ -1245,7 +1352,7 @@ void LLTextureCache::readEntryFromHeaderImmediately(S32& idx, Entry& entry)
 	}
 }
 
-//mHeaderMutex is locked before calling this.
+//mHeaderMutex is locked before calling this, or only the entry mutex when mapped.
 //update an existing entry time stamp, delay writing.
 void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
 {
@@ -1260,8 +1367,16 @@ void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
 	{
 		if (!mReadOnly)
 		{
-			entry.mTime = time(NULL);			
-			mUpdatedEntryMap[idx] = entry ;
+			entry.mTime = time(NULL);
+			if (mHeaderEntriesMap.isOpen())
+			{
+				// the mapped file is written back by the OS, no need to delay
+				writeMappedEntry(idx, entry);
+			}
+			else
+			{
+				mUpdatedEntryMap[idx] = entry ;
+			}
 		}
 	}
 }
@@ -1285,7 +1400,7 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 		bool update_header = false ;
 		if(entry.mImageSize < 0) //is a brand-new entry
 		{
-			mHeaderIDMap[entry.mID] = idx;
+			mHeaderIDMap.insert(entry.mID, idx);
 			mTexturesSizeMap[entry.mID] = new_body_size ;
 			mTexturesSizeTotal += new_body_size ;
 			
@@ -1325,11 +1440,50 @@ U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
 {
 	U32 num_entries = mHeaderEntriesInfo.mEntries;
 
-	mHeaderIDMap.clear();
+	// Workers look textures up in mHeaderIDMap without mHeaderMutex, so
+	// rather than clearing it, entries are updated in place below.
 	mTexturesSizeMap.clear();
 	mFreeList.clear();
 	mTexturesSizeTotal = 0;
 
+	if (mHeaderEntriesMap.isOpen())
+	{
+		if ((size_t)sizeof(EntriesInfo) + (size_t)num_entries * sizeof(Entry) > mHeaderEntriesMap.getSize())
+		{
+			LL_WARNS() << "Corrupted header entries, " << num_entries << " entries do not fit in " << mHeaderEntriesFileName << LL_ENDL;
+			purgeAllTextures(false);
+			return 0;
+		}
+
+		// Nothing is left in mUpdatedEntryMap once mapped, the entries are
+		// copied out of the mapping in one go.
+		const Entry* mapped_entries = (const Entry*)(mHeaderEntriesMap.getData() + sizeof(EntriesInfo));
+		lockEntryMutexes();
+		entries.assign(mapped_entries, mapped_entries + num_entries);
+		unlockEntryMutexes();
+		for (U32 idx=0; idx<num_entries; idx++)
+		{
+			const Entry& entry = entries[idx];
+			if(entry.mImageSize > entry.mBodySize)
+			{
+				mHeaderIDMap.insert(entry.mID, idx);
+				mTexturesSizeMap[entry.mID] = entry.mBodySize;
+				mTexturesSizeTotal += entry.mBodySize;
+			}
+			else
+			{
+				if (mHeaderIDMap.find(entry.mID) == (S32)idx)
+				{
+					mHeaderIDMap.erase(entry.mID);
+				}
+				mFreeList.insert(idx);
+			}
+		}
+		return num_entries;
+	}
+
+	mHeaderIDMap.clear();
+
 	LLAPRFile* aprfile = NULL; 
 	if(mUpdatedEntryMap.empty())
 	{
@@ -1360,7 +1514,7 @@ U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
 // 		LL_INFOS() << "ENTRY: " << entry.mTime << " TEX: " << entry.mID << " IDX: " << idx << " Size: " << entry.mImageSize << LL_ENDL;
 		if(entry.mImageSize > entry.mBodySize)
 		{
-			mHeaderIDMap[entry.mID] = idx;
+			mHeaderIDMap.insert(entry.mID, idx);
 			mTexturesSizeMap[entry.mID] = entry.mBodySize;
 			mTexturesSizeTotal += entry.mBodySize;
 		}
@@ -1378,7 +1532,20 @@ void LLTextureCache::writeEntriesAndClose(const std::vector<Entry>& entries)
 	S32 num_entries = entries.size();
 	llassert_always(num_entries == mHeaderEntriesInfo.mEntries);
 	
-	if (!mReadOnly)
+	if (!mReadOnly && mHeaderEntriesMap.isOpen())
+	{
+		if ((size_t)sizeof(EntriesInfo) + (size_t)num_entries * sizeof(Entry) > mHeaderEntriesMap.getSize()
+			|| !mHeaderEntriesMap.isWritable())
+		{
+			clearCorruptedCache() ; //clear the cache.
+			return ;
+		}
+		lockEntryMutexes();
+		memcpy(mHeaderEntriesMap.getData() + sizeof(EntriesInfo), (const void*)entries.data(), num_entries * sizeof(Entry));
+		unlockEntryMutexes();
+		mHeaderEntriesMap.flush();
+	}
+	else if (!mReadOnly)
 	{
 		LLAPRFile* aprfile = openHeaderEntriesFile(false, (S32)sizeof(EntriesInfo));
 		for (S32 idx=0; idx<num_entries; idx++)
@@ -1397,7 +1564,12 @@ void LLTextureCache::writeEntriesAndClose(const std::vector<Entry>& entries)
 void LLTextureCache::writeUpdatedEntries()
 {
 	lockHeaders() ;
-	if (!mReadOnly && !mUpdatedEntryMap.empty())
+	if (mHeaderEntriesMap.isOpen())
+	{
+		// entries are already in the mapping, just schedule the write back
+		mHeaderEntriesMap.flush();
+	}
+	else if (!mReadOnly && !mUpdatedEntryMap.empty())
 	{
 		openHeaderEntriesFile(false, 0);
 		updatedHeaderEntriesFile() ;
@@ -1451,6 +1623,7 @@ void LLTextureCache::readHeaderCache()
 	mHeaderMutex.lock();
 
 	mLRU.clear(); // always clear the LRU
+	mLRUTime = time(NULL);
 
 	readEntriesHeader();
 	
@@ -1575,6 +1748,10 @@ void LLTextureCache::clearCorruptedCache()
 
 void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
+	// the entries file is about to be deleted, do not keep it mapped
+	bool was_mapped = mHeaderEntriesMap.isOpen();
+	closeHeaderEntriesMap();
+
 	if (!mReadOnly)
 	{
 		const char* subdirs = "0123456789abcdef";
@@ -1615,6 +1792,10 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 	// Info with 0 entries
 	setEntriesHeader();
 	writeEntriesHeader();
+	if (was_mapped)
+	{
+		openHeaderEntriesMap();
+	}
 
 	LL_INFOS() << "The entire texture cache is cleared." << LL_ENDL ;
 }
@@ -1652,10 +1833,9 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 		{
 			if (iter1->second > 0)
 			{
-				id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-				if (iter2 != mHeaderIDMap.end())
+				S32 idx = mHeaderIDMap.find(iter1->first);
+				if (idx >= 0)
 				{
-					S32 idx = iter2->second;
 					time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
 				}
 				else
@@ -1693,8 +1873,7 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 			Entry entry = mPurgeEntryList.back().second;
 			mPurgeEntryList.pop_back();
 			// make sure record is still valid
-			id_map_t::iterator iter_header = mHeaderIDMap.find(entry.mID);
-			if (iter_header != mHeaderIDMap.end() && iter_header->second == idx)
+			if (mHeaderIDMap.find(entry.mID) == idx)
 			{
 				std::string tex_filename = getTextureFileName(entry.mID);
 				removeEntry(idx, entry, tex_filename);
@@ -1737,10 +1916,9 @@ void LLTextureCache::purgeTextures(bool validate)
 	{
 		if (iter1->second > 0)
 		{
-			id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-			if (iter2 != mHeaderIDMap.end())
+			S32 idx = mHeaderIDMap.find(iter1->first);
+			if (idx >= 0)
 			{
-				S32 idx = iter2->second;
 				time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
 // 				LL_INFOS() << "TIME: " << entries[idx].mTime << " TEX: " << entries[idx].mID << " IDX: " << idx << " Size: " << entries[idx].mImageSize << LL_ENDL;
 			}
@@ -1854,8 +2032,29 @@ LLTextureCacheWorker* LLTextureCache::getWriter(handle_t handle)
 S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+	S32 idx = mHeaderIDMap.find(id);
+	if (idx < 0)
+	{
+		return -1; // not cached, no need to go further
+	}
+
+	{
+		// Textures already cached are read straight from the mapped entries,
+		// only holding the mutex of that entry.
+		LLMutexLock entry_lock(&getEntryMutex(idx));
+		if (mHeaderEntriesMap.isOpen()
+			&& readMappedEntry(idx, entry)
+			&& entry.mID == id
+			&& entry.mImageSize > entry.mBodySize)
+		{
+			updateEntryTimeStamp(idx, entry);
+			return idx;
+		}
+	}
+
+	// Entry got recycled or needs fixing, go through the locked path
 	LLMutexLock lock(&mHeaderMutex);	
-	S32 idx = openAndReadEntry(id, entry, false);
+	idx = openAndReadEntry(id, entry, false);
 	if (idx >= 0)
 	{		
 		updateEntryTimeStamp(idx, entry); // updates time
@@ -1989,18 +2188,12 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id,
 //called in the main thread
 LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& discardlevel)
 {
-	U32 offset;
+	S32 idx = mHeaderIDMap.find(id);
+	if(idx < 0)
 	{
-		LLMutexLock lock(&mHeaderMutex);
-		id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-		if(iter == mHeaderIDMap.end())
-		{
-			return NULL; //not in the cache
-		}
-
-		offset = iter->second;
+		return NULL; //not in the cache
 	}
-	offset *= TEXTURE_FAST_CACHE_ENTRY_SIZE;
+	U32 offset = (U32)idx * TEXTURE_FAST_CACHE_ENTRY_SIZE;
 
 	U8* data;
 	S32 head[4];
@@ -28,11 +28,13 @@
 #define LL_LLTEXTURECACHE_H
 
 #include "lldir.h"
+#include "llmappedfile.h"
 #include "llstl.h"
 #include "llstring.h"
 #include "lluuid.h"
 
 #include "llworkerthread.h"
+#include "lltexturecacheindex.h"
 
 class LLImageFormatted;
 class LLTextureCacheWorker;
@@ -174,6 +176,14 @@ private:
 	bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_body_size);
 	void updateEntryTimeStamp(S32 idx, Entry& entry) ;
 	U32 openAndReadEntries(std::vector<Entry>& entries);
+	void openHeaderEntriesMap();
+	void closeHeaderEntriesMap();
+	void lockEntryMutexes();
+	void unlockEntryMutexes();
+	LLMutex& getEntryMutex(S32 idx) { return mEntryMutex[idx & (NUM_ENTRY_MUTEXES - 1)]; }
+	bool readMappedEntry(S32 idx, Entry& entry);
+	bool writeMappedEntry(S32 idx, const Entry& entry);
+	bool writeMappedEntriesInfo();
 	void writeEntriesAndClose(const std::vector<Entry>& entries);
 	void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
 	void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
@@ -197,6 +207,15 @@ private:
 	LLMutex mListMutex;
 	LLMutex mFastCacheMutex;
 	LLAPRFile* mHeaderAPRFile;
+
+	// When mapped, header entries are read and written in place rather than
+	// through mHeaderAPRFile.  Individual entries are guarded by a striped
+	// mutex picked from the entry index, so that workers reading entries of
+	// textures already in the cache do not need mHeaderMutex.  Mapping or
+	// unmapping the file requires all the entry mutexes.
+	static const U32 NUM_ENTRY_MUTEXES = 32; // power of two
+	LLMutex mEntryMutex[NUM_ENTRY_MUTEXES];
+	LLMappedFile mHeaderEntriesMap;
 	LLVolatileAPRPool* mFastCachePoolp;
 
 	// mLocalAPRFilePoolp is not thread safe and is meant only for workers
@@ -223,8 +242,8 @@ private:
 	EntriesInfo mHeaderEntriesInfo;
 	std::set<S32> mFreeList; // deleted entries
 	std::set<LLUUID> mLRU;
-	typedef std::map<LLUUID, S32> id_map_t;
-	id_map_t mHeaderIDMap;
+	U32 mLRUTime; // entries accessed after that time are skipped when recycling mLRU
+	LLTextureCacheIndex mHeaderIDMap;
 
 	LLAPRFile*   mFastCachep;
 	LLFrameTimer mFastCacheTimer;
@@ -0,0 +1,183 @@
+/**
+ * @file lltexturecacheindex.cpp
+ * @brief Lock striped UUID -> header entry index table for LLTextureCache.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturecacheindex.h"
+
+static const U32 SLOT_NOT_FOUND = U32_MAX;
+
+LLTextureCacheIndex::LLTextureCacheIndex()
+:   mSize(0)
+{
+    reserve(0);
+}
+
+void LLTextureCacheIndex::reserve(U32 max_entries)
+{
+    // Keep each stripe at most half full when the cache is full
+    U32 per_stripe = (U32)(((U64)max_entries * 2) / NUM_STRIPES);
+    U32 num_slots = MIN_STRIPE_SLOTS;
+    while (num_slots < per_stripe)
+    {
+        num_slots <<= 1;
+    }
+
+    for (U32 i = 0; i < NUM_STRIPES; ++i)
+    {
+        Stripe& stripe = mStripes[i];
+        LLMutexLock lock(&stripe.mMutex);
+        if (stripe.mSlots.size() < num_slots)
+        {
+            rehash(stripe, num_slots);
+        }
+    }
+}
+
+void LLTextureCacheIndex::clear()
+{
+    for (U32 i = 0; i < NUM_STRIPES; ++i)
+    {
+        Stripe& stripe = mStripes[i];
+        LLMutexLock lock(&stripe.mMutex);
+        std::fill(stripe.mSlots.begin(), stripe.mSlots.end(), Slot());
+        stripe.mUsed = 0;
+        stripe.mDeleted = 0;
+    }
+    mSize = 0;
+}
+
+//static
+U32 LLTextureCacheIndex::findSlot(const Stripe& stripe, const LLUUID& id, U64 hash)
+{
+    const U32 mask = (U32)stripe.mSlots.size() - 1;
+    U32 pos = (U32)(hash / NUM_STRIPES) & mask;
+    for (U32 probe = 0; probe <= mask; ++probe)
+    {
+        const Slot& slot = stripe.mSlots[pos];
+        if (slot.mIndex == SLOT_EMPTY)
+        {
+            break;
+        }
+        if (slot.mIndex != SLOT_DELETED && slot.mID == id)
+        {
+            return pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return SLOT_NOT_FOUND;
+}
+
+//static
+void LLTextureCacheIndex::rehash(Stripe& stripe, U32 num_slots)
+{
+    std::vector<Slot> old_slots;
+    old_slots.swap(stripe.mSlots);
+    stripe.mSlots.assign(num_slots, Slot());
+    stripe.mDeleted = 0;
+
+    const U32 mask = num_slots - 1;
+    for (const Slot& slot : old_slots)
+    {
+        if (slot.mIndex >= 0)
+        {
+            U32 pos = (U32)(hash(slot.mID) / NUM_STRIPES) & mask;
+            while (stripe.mSlots[pos].mIndex != SLOT_EMPTY)
+            {
+                pos = (pos + 1) & mask;
+            }
+            stripe.mSlots[pos] = slot;
+        }
+    }
+}
+
+S32 LLTextureCacheIndex::find(const LLUUID& id) const
+{
+    U64 h = hash(id);
+    const Stripe& stripe = getStripe(h);
+    LLMutexLock lock(&stripe.mMutex);
+    U32 pos = findSlot(stripe, id, h);
+    return pos == SLOT_NOT_FOUND ? -1 : stripe.mSlots[pos].mIndex;
+}
+
+void LLTextureCacheIndex::insert(const LLUUID& id, S32 idx)
+{
+    llassert(idx >= 0);
+    U64 h = hash(id);
+    Stripe& stripe = getStripe(h);
+    LLMutexLock lock(&stripe.mMutex);
+
+    U32 pos = findSlot(stripe, id, h);
+    if (pos != SLOT_NOT_FOUND)
+    {
+        stripe.mSlots[pos].mIndex = idx;
+        return;
+    }
+
+    // Keep the load factor (tombstones included) under 3/4 so probes stay short
+    U32 num_slots = (U32)stripe.mSlots.size();
+    if ((stripe.mUsed + stripe.mDeleted + 1) * 4 > num_slots * 3)
+    {
+        if ((stripe.mUsed + 1) * 2 > num_slots)
+        {
+            num_slots <<= 1;
+        }
+        rehash(stripe, num_slots);
+    }
+
+    const U32 mask = num_slots - 1;
+    pos = (U32)(h / NUM_STRIPES) & mask;
+    while (stripe.mSlots[pos].mIndex >= 0)
+    {
+        pos = (pos + 1) & mask;
+    }
+    if (stripe.mSlots[pos].mIndex == SLOT_DELETED)
+    {
+        --stripe.mDeleted;
+    }
+    stripe.mSlots[pos].mID = id;
+    stripe.mSlots[pos].mIndex = idx;
+    ++stripe.mUsed;
+    ++mSize;
+}
+
+bool LLTextureCacheIndex::erase(const LLUUID& id)
+{
+    U64 h = hash(id);
+    Stripe& stripe = getStripe(h);
+    LLMutexLock lock(&stripe.mMutex);
+
+    U32 pos = findSlot(stripe, id, h);
+    if (pos == SLOT_NOT_FOUND)
+    {
+        return false;
+    }
+    stripe.mSlots[pos].mIndex = SLOT_DELETED;
+    --stripe.mUsed;
+    ++stripe.mDeleted;
+    --mSize;
+    return true;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file lltexturecacheindex.h
+ * @brief Lock striped UUID -> header entry index table for LLTextureCache.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTURECACHEINDEX_H
+#define LL_LLTEXTURECACHEINDEX_H
+
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <atomic>
+#include <vector>
+
+// Maps texture ids to their slot in texture.entries.
+//
+// The table is split in NUM_STRIPES independent open addressing (linear
+// probing) tables, each guarded by its own mutex, so that lookups from the
+// texture cache worker threads only contend when they hash to the same
+// stripe.  Texture ids are random, so the low bits of the UUID digest are
+// used directly to pick the stripe and the slot.
+class LLTextureCacheIndex
+{
+public:
+    LLTextureCacheIndex();
+
+    // Grows every stripe to take max_entries ids in total without further
+    // rehashing.  Never shrinks, ids already in the table are kept.
+    void reserve(U32 max_entries);
+    void clear();
+
+    // Returns the entry index for id, or -1 when id is not in the table.
+    S32 find(const LLUUID& id) const;
+    // Adds id or replaces its entry index.
+    void insert(const LLUUID& id, S32 idx);
+    // Returns false if id was not in the table.
+    bool erase(const LLUUID& id);
+
+    U32 size() const { return mSize; }
+
+private:
+    enum : S32
+    {
+        SLOT_EMPTY = -1,
+        SLOT_DELETED = -2
+    };
+
+    struct Slot
+    {
+        Slot() : mIndex(SLOT_EMPTY) {}
+        LLUUID mID;
+        S32 mIndex;
+    };
+
+    struct Stripe
+    {
+        Stripe() : mUsed(0), mDeleted(0) {}
+        mutable LLMutex mMutex;
+        std::vector<Slot> mSlots; // size is a power of two
+        U32 mUsed;
+        U32 mDeleted;
+    };
+
+    static const U32 NUM_STRIPES = 64; // power of two
+    static const U32 MIN_STRIPE_SLOTS = 16;
+
+    static U64 hash(const LLUUID& id) { return id.getDigest64(); }
+    Stripe& getStripe(U64 hash) const { return mStripes[hash & (NUM_STRIPES - 1)]; }
+
+    // mMutex of stripe must be held for the following functions
+    static U32 findSlot(const Stripe& stripe, const LLUUID& id, U64 hash);
+    static void rehash(Stripe& stripe, U32 num_slots);
+
+private:
+    mutable Stripe mStripes[NUM_STRIPES];
+    std::atomic<U32> mSize;
+};
+
+#endif // LL_LLTEXTURECACHEINDEX_H
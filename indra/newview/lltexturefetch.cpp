@@ -230,6 +230,8 @@ static const S32 HTTP_PIPE_REQUESTS_HIGH_WATER = 100;		// Maximum requests to ha
 static const S32 HTTP_PIPE_REQUESTS_LOW_WATER = 50;			// Active level at which to refill
 static const S32 HTTP_NONPIPE_REQUESTS_HIGH_WATER = 40;
 static const S32 HTTP_NONPIPE_REQUESTS_LOW_WATER = 20;
+static const S32 HTTP_MUX_REQUESTS_HIGH_WATER = 200;		// Maximum requests to have active in HTTP (HTTP/2)
+static const S32 HTTP_MUX_REQUESTS_LOW_WATER = 100;
 
 // BUG-3323/SH-4375
 // *NOTE:  This is a heuristic value.  Texture fetches have a habit of using a
@@ -257,6 +259,16 @@ namespace
     // "delete" derives from Latin "deletus"
     void NoOpDeletor(LLCore::HttpHandler *)
     { /*NoOp*/ }
+
+    // Image priorities are virtual sizes and drift a little every frame.
+    // A pending decode is only reprioritized when its power of two changes,
+    // which is all the decode queue's ordering needs.
+    S32 decode_priority_bucket(F32 priority)
+    {
+        int exponent = 0;
+        std::frexp(priority, &exponent);
+        return exponent;
+    }
 }
 
 static const char* e_state_name[] =
@@ -570,7 +582,8 @@ private:
 								mFileSize,
 								mCachedSize;
 	e_request_state mSentRequest;
-	handle_t mDecodeHandle;
+	LLImageDecodeThread::handle_t mDecodeHandle;
+	F32 mDecodePriority; // mImagePriority as last given to the decode
 	BOOL mLoaded;
 	BOOL mDecoded;
 	BOOL mWritten;
@@ -912,6 +925,7 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
 	  mLoaded(FALSE),
 	  mSentRequest(UNSENT),
 	  mDecodeHandle(0),
+	  mDecodePriority(0.f),
 	  mDecoded(FALSE),
 	  mWritten(FALSE),
 	  mNeedsAux(FALSE),
@@ -1038,6 +1052,12 @@ void LLTextureFetchWorker::setDesiredDiscard(S32 discard, S32 size)
 void LLTextureFetchWorker::setImagePriority(F32 priority)
 {
 	mImagePriority = priority; //should map to max virtual size, abort if zero
+	if (mDecodeHandle != 0 && decode_priority_bucket(priority) != decode_priority_bucket(mDecodePriority))
+	{
+		// keep a pending decode in step, no-op once it started
+		mDecodePriority = priority;
+		LLAppViewer::getImageDecodeThread()->setPriority(mDecodeHandle, priority);
+	}
 }
 
 // Locks:  Mw
@@ -1800,8 +1820,10 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		setState(DECODE_IMAGE_UPDATE);
 		LL_DEBUGS(LOG_TXT) << mID << ": Decoding. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard
 						   << " All Data: " << mHaveAllData << LL_ENDL;
+		mDecodePriority = mImagePriority;
 		mDecodeHandle = LLAppViewer::getImageDecodeThread()->decodeImage(mFormattedImage, discard, mNeedsAux,
-																  new DecodeResponder(mFetcher, mID, this));
+																  new DecodeResponder(mFetcher, mID, this),
+																  mImagePriority);
 		// fall though
 	}
 	
@@ -2048,7 +2070,8 @@ void LLTextureFetchWorker::endWork(S32 param, bool aborted)
 	LL_PROFILE_ZONE_SCOPED;
 	if (mDecodeHandle != 0)
 	{
-		// LL::ThreadPool has no operation to cancel a particular work item
+		// drop the decode if it has not started, else its callback is ignored
+		LLAppViewer::getImageDecodeThread()->cancel(mDecodeHandle);
 		mDecodeHandle = 0;
 	}
 	mFormattedImage = NULL;
@@ -2919,7 +2942,13 @@ void LLTextureFetch::commonUpdate()
 	// Update low/high water levels based on pipelining.  We pick
 	// up setting eventually, so the semaphore/request level can
 	// fall outside the [0..HIGH_WATER] range.  Expect that.
-	if (LLAppViewer::instance()->getAppCoreHttp().isPipelined(LLAppCoreHttp::AP_TEXTURE))
+	LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
+	if (app_core_http.isMultiplexed(LLAppCoreHttp::AP_TEXTURE))
+	{
+		mHttpHighWater = HTTP_MUX_REQUESTS_HIGH_WATER;
+		mHttpLowWater = HTTP_MUX_REQUESTS_LOW_WATER;
+	}
+	else if (app_core_http.isPipelined(LLAppCoreHttp::AP_TEXTURE))
 	{
 		mHttpHighWater = HTTP_PIPE_REQUESTS_HIGH_WATER;
 		mHttpLowWater = HTTP_PIPE_REQUESTS_LOW_WATER;
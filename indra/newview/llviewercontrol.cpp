@@ -41,6 +41,7 @@
 #include "lldrawpoolterrain.h"
 #include "llflexibleobject.h"
 #include "llfeaturemanager.h"
+#include "llkeyframemotion.h"
 #include "llviewershadermgr.h"
 
 #include "llsky.h"
@@ -131,6 +132,12 @@ static bool handleDebugAvatarJointsChanged(const LLSD& newvalue)
     return true;
 }
 
+static bool handleAnimationBakeKeyframesChanged(const LLSD& newvalue)
+{
+    LLKeyframeMotion::setBakeKeyframes(newvalue.asBoolean());
+    return true;
+}
+
 static bool handleAvatarHoverOffsetChanged(const LLSD& newvalue)
 {
 	if (isAgentAvatarValid())
@@ -820,6 +827,7 @@ void settings_setup_listeners()
     setting_setup_signal_listener(gSavedSettings, "SpellCheckDictionary", handleSpellCheckChanged);
     setting_setup_signal_listener(gSavedSettings, "LoginLocation", handleLoginLocationChanged);
     setting_setup_signal_listener(gSavedSettings, "DebugAvatarJoints", handleDebugAvatarJointsChanged);
+    setting_setup_signal_listener(gSavedSettings, "AnimationBakeKeyframes", handleAnimationBakeKeyframesChanged);
 
     setting_setup_signal_listener(gSavedSettings, "TargetFPS", handleTargetFPSChanged);
     setting_setup_signal_listener(gSavedSettings, "AutoTuneFPS", handleAutoTuneFPSChanged);
@@ -40,6 +40,7 @@
 #include "llinventorydefines.h"
 #include "lllslconstants.h"
 #include "llmaterialtable.h"
+#include "llmessagedecoders.h"
 #include "llregionhandle.h"
 #include "llsd.h"
 #include "llsdserialize.h"
@@ -478,26 +479,24 @@ void process_layer_data(LLMessageSystem *mesgsys, void **user_data)
 		LL_WARNS() << "Invalid region for layer data." << LL_ENDL;
 		return;
 	}
-	S32 size;
-	S8 type;
 
-	mesgsys->getS8Fast(_PREHASH_LayerID, _PREHASH_Type, type);
-	size = mesgsys->getSizeFast(_PREHASH_LayerData, _PREHASH_Data);
-	if (0 == size)
+	// Terrain patches stream in by the hundred while a region loads, so
+	// read straight from the packet. Registered with setDecodingHandlerFuncFast().
+	LLDecodedLayerData layer;
+	if (!layer.decode(mesgsys))
 	{
-		LL_WARNS("Messaging") << "Layer data has zero size." << LL_ENDL;
 		return;
 	}
-	if (size < 0)
+
+	S8 type = (S8)layer.mLayerID.mType;
+	S32 size = layer.mLayerData.mData.mSize;
+	if (0 == size)
 	{
-		// getSizeFast() is probably trying to tell us about an error
-		LL_WARNS("Messaging") << "getSizeFast() returned negative result: "
-			<< size
-			<< LL_ENDL;
+		LL_WARNS("Messaging") << "Layer data has zero size." << LL_ENDL;
 		return;
 	}
 	U8 *datap = new U8[size];
-	mesgsys->getBinaryDataFast(_PREHASH_LayerData, _PREHASH_Data, datap, size);
+	memcpy(datap, layer.mLayerData.mData.mData, size);
 	LLVLData *vl_datap = new LLVLData(regionp, type, datap, size);
 	if (mesgsys->getReceiveCompressedSize())
 	{
@@ -4099,8 +4098,16 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 	LLUUID	uuid;
 	S32		anim_sequence_id;
 	LLVOAvatar *avatarp = NULL;
+
+	// Sent for every avatar in view whenever its animations change, so
+	// read straight from the packet. Registered with setDecodingHandlerFuncFast().
+	LLDecodedAvatarAnimation update;
+	if (!update.decode(mesgsys))
+	{
+		return;
+	}
 	
-	mesgsys->getUUIDFast(_PREHASH_Sender, _PREHASH_ID, uuid);
+	uuid = update.mSender.mID;
 
 	LLViewerObject *objp = gObjectList.findObject(uuid);
     if (objp)
@@ -4115,8 +4122,8 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 		return;
 	}
 
-	S32 num_blocks = mesgsys->getNumberOfBlocksFast(_PREHASH_AnimationList);
-	S32 num_source_blocks = mesgsys->getNumberOfBlocksFast(_PREHASH_AnimationSourceList);
+	S32 num_blocks = (S32)update.mAnimationList.size();
+	S32 num_source_blocks = (S32)update.mAnimationSourceList.size();
 
 	LL_DEBUGS("Messaging", "Motion") << "Processing " << num_blocks << " Animations" << LL_ENDL;
 
@@ -4129,8 +4136,8 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 
 		for( S32 i = 0; i < num_blocks; i++ )
 		{
-			mesgsys->getUUIDFast(_PREHASH_AnimationList, _PREHASH_AnimID, animation_id, i);
-			mesgsys->getS32Fast(_PREHASH_AnimationList, _PREHASH_AnimSequenceID, anim_sequence_id, i);
+			animation_id = update.mAnimationList[i].mAnimID;
+			anim_sequence_id = update.mAnimationList[i].mAnimSequenceID;
 
 			avatarp->mSignaledAnimations[animation_id] = anim_sequence_id;
 
@@ -4147,7 +4154,7 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 
 			if (i < num_source_blocks)
 			{
-				mesgsys->getUUIDFast(_PREHASH_AnimationSourceList, _PREHASH_ObjectID, object_id, i);
+				object_id = update.mAnimationSourceList[i].mObjectID;
 			
 				LLViewerObject* object = gObjectList.findObject(object_id);
 				if (object)
@@ -4185,9 +4192,7 @@ void process_avatar_animation(LLMessageSystem *mesgsys, void **user_data)
 	{
 		for( S32 i = 0; i < num_blocks; i++ )
 		{
-			mesgsys->getUUIDFast(_PREHASH_AnimationList, _PREHASH_AnimID, animation_id, i);
-			mesgsys->getS32Fast(_PREHASH_AnimationList, _PREHASH_AnimSequenceID, anim_sequence_id, i);
-			avatarp->mSignaledAnimations[animation_id] = anim_sequence_id;
+			avatarp->mSignaledAnimations[update.mAnimationList[i].mAnimID] = update.mAnimationList[i].mAnimSequenceID;
 		}
 	}
 
@@ -4684,6 +4684,26 @@ BOOL LLViewerObject::lineSegmentIntersect(const LLVector4a& start, const LLVecto
 	return false;
 }
 
+BOOL LLViewerObject::lineSegmentsIntersect(const LLVector4a* start, LLVector4a* end, U32 count,
+										   BOOL pick_transparent,
+										   BOOL pick_rigged,
+										   BOOL pick_unselectable,
+										   BOOL* hit)
+{
+	BOOL ret = FALSE;
+	for (U32 i = 0; i < count; ++i)
+	{
+		LLVector4a intersection;
+		if (lineSegmentIntersect(start[i], end[i], -1, pick_transparent, pick_rigged, pick_unselectable, NULL, &intersection))
+		{
+			end[i] = intersection;
+			hit[i] = TRUE;
+			ret = TRUE;
+		}
+	}
+	return ret;
+}
+
 BOOL LLViewerObject::lineSegmentBoundingBox(const LLVector4a& start, const LLVector4a& end)
 {
 	if (mDrawable.isNull() || mDrawable->isDead())
@@ -305,6 +305,16 @@ public:
 									  LLVector4a* normal = NULL,               // return the surface normal at the intersection point
 									  LLVector4a* tangent = NULL             // return the surface tangent at the intersection point
 		);
+
+	//as above for count segments that only want the point they hit
+	//sets hit[i] and moves end[i] to the hit point for each segment that hits this object,
+	//leaves the others alone
+	//returns TRUE if any segment hit
+	virtual BOOL lineSegmentsIntersect(const LLVector4a* start, LLVector4a* end, U32 count,
+									   BOOL pick_transparent,
+									   BOOL pick_rigged,
+									   BOOL pick_unselectable,
+									   BOOL* hit);
 	
 	virtual BOOL lineSegmentBoundingBox(const LLVector4a& start, const LLVector4a& end);
 
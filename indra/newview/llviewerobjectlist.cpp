@@ -919,6 +919,8 @@ void LLViewerObjectList::update(LLAgent &agent)
 
 	std::vector<LLViewerObject*>::iterator idle_end = idle_list.begin()+idle_count;
 
+	// avatars leave their animation to LLVOAvatar::finishStagedUpdate()
+	LLVOAvatar::beginStagedUpdate();
 	if (gSavedSettings.getBOOL("FreezeTime"))
 	{
 		
@@ -931,6 +933,7 @@ void LLViewerObjectList::update(LLAgent &agent)
 				objectp->idleUpdate(agent, frame_time);
 			}
 		}
+		LLVOAvatar::finishStagedUpdate(agent, frame_time);
 	}
 	else
 	{
@@ -941,6 +944,7 @@ void LLViewerObjectList::update(LLAgent &agent)
 			llassert(objectp->isActive());
                 objectp->idleUpdate(agent, frame_time);
 		}
+		LLVOAvatar::finishStagedUpdate(agent, frame_time);
 
 		//update flexible objects
 		LLVolumeImplFlexible::updateClass();
@@ -33,6 +33,7 @@
 #include "llglslshader.h"
 #include "llviewershadermgr.h"
 #include "lldrawpoolwater.h"
+#include "parallelfor.h"
 
 //-----------------------------------------------------------------------------------
 //static variables definitions
@@ -460,7 +461,10 @@ LLViewerOctreeGroup::~LLViewerOctreeGroup()
 LLViewerOctreeGroup::LLViewerOctreeGroup(OctreeNode* node)
 :	mOctreeNode(node),
 	mAnyVisible(0),
-	mState(CLEAN)
+	mState(CLEAN),
+	mCullSerial(0),
+	mCullRes(0),
+	mCullObjectsRes(-1)
 {
 	LLVector4a tmp;
 	tmp.splat(0.f);
@@ -1334,6 +1338,16 @@ BOOL LLViewerOctreePartition::isOcclusionEnabled()
 //class LLViewerOctreeCull definitions
 //-----------------------------------------------------------------------------------
 
+//levels precull() checks itself before handing the branches below to the
+//thread pool, and how many branches it takes to be worth doing so
+const U32 PRECULL_SPLIT_DEPTH = 2;
+const size_t PRECULL_MIN_BRANCHES = 8;
+
+const char* PRECULL_PARALLEL_QUEUE = "General";
+const size_t PRECULL_PARALLEL_HELPERS = 2;
+
+U32 LLViewerOctreeCull::sCullSerial = 0;
+
 //virtual 
 bool LLViewerOctreeCull::earlyFail(LLViewerOctreeGroup* group)
 {	
@@ -1357,7 +1371,7 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
 	}
 	else
 	{
-		mRes = frustumCheck(group);
+		mRes = getFrustumCheck(group);
 				
 		if (mRes)
 		{ //at least partially in, run on down
@@ -1367,6 +1381,108 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
 		mRes = 0;
 	}
 }
+
+bool LLViewerOctreeCull::precull(const OctreeNode* root)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+
+	//new serial for this cull, 0 is never valid
+	mCullSerial = ++sCullSerial;
+	if (!mCullSerial)
+	{
+		mCullSerial = ++sCullSerial;
+	}
+
+	std::vector<std::pair<const OctreeNode*, S32> > branches;
+	collectPrecullBranches(root, 0, 0, branches);
+	if (branches.size() < PRECULL_MIN_BRANCHES)
+	{
+		mCullSerial = 0;
+		return false;
+	}
+
+	//each branch only touches its own groups
+	LL::parallelFor(PRECULL_PARALLEL_QUEUE, branches.size(), PRECULL_PARALLEL_HELPERS,
+		[this, &branches](size_t i)
+		{
+			precullBranch(branches[i].first, branches[i].second);
+		});
+	return true;
+}
+
+//Check the group the way traverse() will and return the result its children
+//should be checked against. Extra checks are harmless, traverse() falls back
+//on frustumCheck() for any group left out.
+S32 LLViewerOctreeCull::precullGroup(const OctreeNode* branch, S32 parent_res)
+{
+	LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) branch->getListener(0);
+
+	S32 res = frustumCheck(group);
+	group->mCullRes = res;
+	group->mCullObjectsRes = -1;
+
+	if (parent_res && group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK))
+	{ //traverse() may go on what the parent found instead, so be ready either way
+		res = 1;
+	}
+
+	if (res == 1 && branch->getElementCount() && branch->getChildCount())
+	{ //checkObjects() will want this
+		group->mCullObjectsRes = frustumCheckObjects(group);
+	}
+
+	group->mCullSerial = mCullSerial;
+	return res;
+}
+
+void LLViewerOctreeCull::precullBranch(const OctreeNode* branch, S32 parent_res)
+{
+	S32 res = precullGroup(branch, parent_res);
+	if (res == 1)
+	{ //0 is out and 2 is all in, nothing more to check below either
+		for (U32 i = 0; i < branch->getChildCount(); i++)
+		{
+			precullBranch(branch->getChild(i), res);
+		}
+	}
+}
+
+void LLViewerOctreeCull::collectPrecullBranches(const OctreeNode* branch, S32 parent_res, U32 depth,
+												std::vector<std::pair<const OctreeNode*, S32> >& branches)
+{
+	if (depth == PRECULL_SPLIT_DEPTH)
+	{
+		branches.push_back(std::make_pair(branch, parent_res));
+		return;
+	}
+
+	S32 res = precullGroup(branch, parent_res);
+	if (res == 1)
+	{
+		for (U32 i = 0; i < branch->getChildCount(); i++)
+		{
+			collectPrecullBranches(branch->getChild(i), res, depth + 1, branches);
+		}
+	}
+}
+
+S32 LLViewerOctreeCull::getFrustumCheck(const LLViewerOctreeGroup* group)
+{
+	if (mCullSerial && group->mCullSerial == mCullSerial)
+	{
+		return group->mCullRes;
+	}
+	return frustumCheck(group);
+}
+
+S32 LLViewerOctreeCull::getFrustumCheckObjects(const LLViewerOctreeGroup* group)
+{
+	if (mCullSerial && group->mCullSerial == mCullSerial && group->mCullObjectsRes >= 0)
+	{
+		return group->mCullObjectsRes;
+	}
+	return frustumCheckObjects(group);
+}
 	
 //------------------------------------------
 //agent space group culling
@@ -1474,7 +1590,7 @@ bool LLViewerOctreeCull::checkObjects(const OctreeNode* branch, const LLViewerOc
 	{
 		return true;
 	}
-	else if (mRes == 1 && !frustumCheckObjects(group)) //no objects in frustum
+	else if (mRes == 1 && !getFrustumCheckObjects(group)) //no objects in frustum
 	{
 		return false;
 	}
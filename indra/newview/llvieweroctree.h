@@ -267,6 +267,12 @@ protected:
 	S32         mAnyVisible; //latest visible to any camera
 	S32         mVisible[LLViewerCamera::NUM_CAMERAS];	
 
+	// frustum checks done ahead of a cull by LLViewerOctreeCull::precull(),
+	// valid while mCullSerial matches the culler's
+	U32         mCullSerial;
+	S32         mCullRes;
+	S32         mCullObjectsRes;
+
 };//LL_ALIGN_POSTFIX(16);
 
 //octree group which has capability to support occlusion culling
@@ -370,10 +376,18 @@ class LLViewerOctreeCull : public OctreeTraveler
 {
 public:
 	LLViewerOctreeCull(LLCamera* camera)
-		: mCamera(camera), mRes(0) { }
+		: mCamera(camera), mRes(0), mCullSerial(0) { }
 	
 	virtual void traverse(const OctreeNode* n);
 
+	// Work out the frustum checks traverse() will ask for on the General
+	// thread pool, one task per subtree a few levels down, so traverse()
+	// only has to look them up. Only for cullers whose frustumCheck() and
+	// frustumCheckObjects() read nothing but the camera and group bounds.
+	// Returns false, leaving traverse() to do its own checks, when the tree
+	// is too small to be worth splitting.
+	bool precull(const OctreeNode* root);
+
 protected:
 	virtual bool earlyFail(LLViewerOctreeGroup* group);	
 	
@@ -400,15 +414,29 @@ protected:
 	virtual S32 frustumCheck(const LLViewerOctreeGroup* group) = 0;
 	virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group) = 0;
 
+	//frustumCheck()/frustumCheckObjects(), or what precull() found for them
+	S32 getFrustumCheck(const LLViewerOctreeGroup* group);
+	S32 getFrustumCheckObjects(const LLViewerOctreeGroup* group);
+
 	bool checkProjectionArea(const LLVector4a& center, const LLVector4a& size, const LLVector3& shift, F32 pixel_threshold, F32 near_radius);
 	virtual bool checkObjects(const OctreeNode* branch, const LLViewerOctreeGroup* group);
 	virtual void preprocess(LLViewerOctreeGroup* group);
 	virtual void processGroup(LLViewerOctreeGroup* group);
 	virtual void visit(const OctreeNode* branch);
 	
+private:
+	S32  precullGroup(const OctreeNode* branch, S32 parent_res);
+	void precullBranch(const OctreeNode* branch, S32 parent_res);
+	void collectPrecullBranches(const OctreeNode* branch, S32 parent_res, U32 depth,
+								std::vector<std::pair<const OctreeNode*, S32> >& branches);
+
 protected:
 	LLCamera *mCamera;
 	S32 mRes;
+
+private:
+	U32 mCullSerial;
+	static U32 sCullSerial;
 };
 
 //scan the octree, output the info of each node for debug use.
@@ -43,6 +43,10 @@
 #include "llvoavatarself.h"
 #include "llvovolume.h"
 
+#include "llalignedarray.h"
+#include "llvector4a.h"
+#include "parallelfor.h"
+
 const F32 PART_SIM_BOX_SIDE = 16.f;
 
 //static
@@ -65,9 +69,16 @@ const F32 LLViewerPartSim::PART_ADAPT_RATE_MULT_RECIP = 1.0f/PART_ADAPT_RATE_MUL
 
 U32 LLViewerPart::sNextPartID = 1;
 
-F32 calc_desired_size(LLViewerCamera* camera, LLVector3 pos, LLVector2 scale)
+// Below this many particles in the groups due for an update, handing groups
+// to other threads costs more than it saves.
+const S32 PART_SIM_PARALLEL_MIN_PARTICLES = 1024;
+// WorkQueue lending threads to the particle update, and how many of them
+const char* PART_SIM_PARALLEL_QUEUE = "General";
+const size_t PART_SIM_PARALLEL_HELPERS = 2;
+
+F32 calc_desired_size(const LLVector3& camera_origin, LLVector3 pos, LLVector2 scale)
 {
-	F32 desired_size = (pos - camera->getOrigin()).magVec();
+	F32 desired_size = (pos - camera_origin).magVec();
 	desired_size /= 4;
 	return llclamp(desired_size, scale.magVec()*0.5f, PART_SIM_BOX_SIDE*2);
 }
@@ -134,7 +145,8 @@ void LLViewerPart::init(LLPointer<LLViewerPartSource> sourcep, LLViewerTexture *
 
 
 LLViewerPartGroup::LLViewerPartGroup(const LLVector3 &center_agent, const F32 box_side, bool hud)
- : mHud(hud)
+ : mHud(hud),
+   mCallbackParticles(0)
 {
 	mVOPartGroupp = NULL;
 	mUniformParticles = TRUE;
@@ -268,34 +280,200 @@ BOOL LLViewerPartGroup::addPart(LLViewerPart* part, F32 desired_size)
 	
 	mParticles.push_back(part);
 	part->mSkipOffset=mSkippedTime;
+	if (part->mVPCallback)
+	{
+		++mCallbackParticles;
+	}
 	LLViewerPartSim::incPartCount(1);
 	return TRUE;
 }
 
 
-void LLViewerPartGroup::updateParticles(const F32 lastdt)
+namespace
 {
-	F32 dt;
-	
-	LLVector3 gravity(0.f, 0.f, GRAVITY);
+	// Structure-of-arrays copy of the particle state the integrator works
+	// on: one channel per component, each padded to whole cache lines, so
+	// the kernel advances four particles per SSE operation. Interpolated
+	// color, scale and glow are written over their start values.
+	class LLViewerPartBatch
+	{
+	public:
+		enum EChannel
+		{
+			POS_X, POS_Y, POS_Z,
+			VEL_X, VEL_Y, VEL_Z,
+			ACCEL_X, ACCEL_Y, ACCEL_Z,
+			DT, AGE, MAX_AGE,
+			COLOR_R, COLOR_G, COLOR_B, COLOR_A,
+			END_COLOR_R, END_COLOR_G, END_COLOR_B, END_COLOR_A,
+			SCALE_X, SCALE_Y,
+			END_SCALE_X, END_SCALE_Y,
+			GLOW, END_GLOW,
+			CHANNEL_COUNT
+		};
+
+		void resize(S32 count)
+		{
+			mCount = count;
+			mStride = (count + 15) & ~15;
+			mData.resize(mStride * CHANNEL_COUNT);
+		}
 
-	LLViewerPartSim::checkParticleCount(mParticles.size());
+		F32* channel(S32 c)				{ return mData.mArray + c * mStride; }
+		const F32* channel(S32 c) const	{ return mData.mArray + c * mStride; }
+
+		void gather(S32 i, const LLViewerPart& part, F32 dt)
+		{
+			set(POS_X, i, part.mPosAgent.mV, 3);
+			set(VEL_X, i, part.mVelocity.mV, 3);
+			set(ACCEL_X, i, part.mAccel.mV, 3);
+			channel(DT)[i] = dt;
+			channel(AGE)[i] = part.mLastUpdateTime;
+			channel(MAX_AGE)[i] = part.mMaxAge;
+			set(COLOR_R, i, part.mStartColor.mV, 4);
+			set(END_COLOR_R, i, part.mEndColor.mV, 4);
+			set(SCALE_X, i, part.mStartScale.mV, 2);
+			set(END_SCALE_X, i, part.mEndScale.mV, 2);
+			channel(GLOW)[i] = part.mStartGlow;
+			channel(END_GLOW)[i] = part.mEndGlow;
+		}
+
+		// p += v*dt + a*dt*dt/2, v += a*dt, age += dt, and every
+		// interpolated value becomes start*(1 - frac) + end*frac
+		void integrate()
+		{
+			// harmless values in the lanes past the last particle
+			S32 padded = (mCount + 3) & ~3;
+			for (S32 c = 0; c < CHANNEL_COUNT; ++c)
+			{
+				std::fill(channel(c) + mCount, channel(c) + padded, c == MAX_AGE ? 1.f : 0.f);
+			}
+
+			static const S32 lerped[][2] =
+			{
+				{ COLOR_R, END_COLOR_R }, { COLOR_G, END_COLOR_G }, { COLOR_B, END_COLOR_B }, { COLOR_A, END_COLOR_A },
+				{ SCALE_X, END_SCALE_X }, { SCALE_Y, END_SCALE_Y },
+				{ GLOW, END_GLOW }
+			};
+
+			LLVector4a half;
+			half.splat(0.5f);
+			LLVector4a one;
+			one.splat(1.f);
+
+			for (S32 i = 0; i < padded; i += 4)
+			{
+				LLVector4a dt;
+				dt.load4a(channel(DT) + i);
+				LLVector4a age;
+				age.load4a(channel(AGE) + i);
+				LLVector4a max_age;
+				max_age.load4a(channel(MAX_AGE) + i);
+
+				age.add(dt);
+				age.store4a(channel(AGE) + i);
+
+				LLVector4a frac;
+				frac.setDiv(age, max_age);
+				LLVector4a inv_frac;
+				inv_frac.setSub(one, frac);
+
+				LLVector4a half_dt2;
+				half_dt2.setMul(dt, dt);
+				half_dt2.mul(half);
+
+				for (S32 axis = 0; axis < 3; ++axis)
+				{
+					F32* pos = channel(POS_X + axis) + i;
+					F32* vel = channel(VEL_X + axis) + i;
+					LLVector4a p, v, a, t;
+					p.load4a(pos);
+					v.load4a(vel);
+					a.load4a(channel(ACCEL_X + axis) + i);
+					t.setMul(v, dt);
+					p.add(t);
+					t.setMul(a, half_dt2);
+					p.add(t);
+					t.setMul(a, dt);
+					v.add(t);
+					p.store4a(pos);
+					v.store4a(vel);
+				}
+
+				for (const S32* pair : lerped)
+				{
+					F32* start = channel(pair[0]) + i;
+					LLVector4a value, end;
+					value.load4a(start);
+					end.load4a(channel(pair[1]) + i);
+					value.mul(inv_frac);
+					end.mul(frac);
+					value.add(end);
+					value.store4a(start);
+				}
+			}
+		}
+
+		void scatter(S32 i, LLViewerPart& part) const
+		{
+			part.mPosAgent.set(channel(POS_X)[i], channel(POS_Y)[i], channel(POS_Z)[i]);
+			part.mVelocity.set(channel(VEL_X)[i], channel(VEL_Y)[i], channel(VEL_Z)[i]);
+			part.mLastUpdateTime = channel(AGE)[i];
+
+			if (part.mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
+			{
+				part.mColor.set(channel(COLOR_R)[i], channel(COLOR_G)[i], channel(COLOR_B)[i], channel(COLOR_A)[i]);
+			}
+
+			if (part.mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+			{
+				part.mScale.set(channel(SCALE_X)[i], channel(SCALE_Y)[i]);
+			}
+
+			part.mGlow.mV[3] = (U8) ll_round(channel(GLOW)[i]*255.f);
+		}
+
+	private:
+		void set(S32 c, S32 i, const F32* values, S32 count)
+		{
+			for (S32 j = 0; j < count; ++j)
+			{
+				channel(c + j)[i] = values[j];
+			}
+		}
+
+		LLAlignedArray<F32, 64> mData;
+		S32 mCount = 0;
+		S32 mStride = 0;
+	};
+}
+
+void LLViewerPartGroup::simulateParticles(const F32 lastdt, const LLVector3& camera_origin)
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	const S32 count = (S32) mParticles.size();
+	mUpdateResults.assign(count, PART_KEEP);
+	if (!count)
+	{
+		return;
+	}
+
+	// one batch per thread simulating groups
+	static thread_local LLViewerPartBatch batch;
+	batch.resize(count);
 
-	LLViewerCamera* camera = LLViewerCamera::getInstance();
 	LLViewerRegion *regionp = getRegion();
-	S32 end = (S32) mParticles.size();
-	for (S32 i = 0 ; i < (S32)mParticles.size();)
+
+	// Behaviors that depend on the source, region or a callback run per
+	// particle before integration
+	for (S32 i = 0; i < count; i++)
 	{
-		LLVector3 a(0.f, 0.f, 0.f);
-		LLViewerPart* part = mParticles[i] ;
+		LLViewerPart* part = mParticles[i];
 
-		dt = lastdt + mSkippedTime - part->mSkipOffset;
+		F32 dt = lastdt + mSkippedTime - part->mSkipOffset;
 		part->mSkipOffset = 0.f;
 
-		// Update current time
-		const F32 cur_time = part->mLastUpdateTime + dt;
-		const F32 frac = cur_time / part->mMaxAge;
-
 		// "Drift" the object based on the source object
 		if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
 		{
@@ -333,21 +511,26 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 			part->mVelocity += step*delta_pos;
 		}
 
+		batch.gather(i, *part, dt);
+	}
+
+	// Velocity, age, color, scale and glow interpolation
+	batch.integrate();
+
+	for (S32 i = 0; i < count; i++)
+	{
+		LLViewerPart* part = mParticles[i];
+		batch.scatter(i, *part);
 
 		if (part->mFlags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
 		{
+			// replaces the integrated position and velocity
+			const F32 frac = part->mLastUpdateTime / part->mMaxAge;
 			LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPartSourcep->mPosAgent;			
 			part->mPosAgent = part->mPartSourcep->mPosAgent;
 			part->mPosAgent += frac*delta_pos;
 			part->mVelocity = delta_pos;
 		}
-		else
-		{
-			// Do velocity interpolation
-			part->mPosAgent += dt*part->mVelocity;
-			part->mPosAgent += 0.5f*dt*dt*part->mAccel;
-			part->mVelocity += part->mAccel*dt;
-		}
 
 		// Do a bounce test
 		if (part->mFlags & LLPartData::LL_PART_BOUNCE_MASK)
@@ -362,7 +545,6 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 			}
 		}
 
-
 		// Reset the offset from the source position
 		if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
 		{
@@ -370,57 +552,65 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 			part->mPosOffset -= part->mPartSourcep->mPosAgent;
 		}
 
-		// Do color interpolation
-		if (part->mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
+		// Kill dead particles (either flagged dead, or too old)
+		if ((part->mLastUpdateTime > part->mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part->mFlags))
 		{
-			part->mColor.setVec(part->mStartColor);
-			// note: LLColor4's v%k means multiply-alpha-only,
-			//       LLColor4's v*k means multiply-rgb-only
-			part->mColor *= 1.f - frac; // rgb*k
-			part->mColor %= 1.f - frac; // alpha*k
-			part->mColor += frac%(frac*part->mEndColor); // rgb,alpha
+			mUpdateResults[i] = PART_DEAD;
 		}
-
-		// Do scale interpolation
-		if (part->mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+		else
 		{
-			part->mScale.setVec(part->mStartScale);
-			part->mScale *= 1.f - frac;
-			part->mScale += frac*part->mEndScale;
+			F32 desired_size = calc_desired_size(camera_origin, part->mPosAgent, part->mScale);
+			if (!posInGroup(part->mPosAgent, desired_size))
+			{
+				mUpdateResults[i] = PART_MOVED;
+			}
 		}
+	}
+}
 
-		// Do glow interpolation
-		part->mGlow.mV[3] = (U8) ll_round(lerp(part->mStartGlow, part->mEndGlow, frac)*255.f);
+void LLViewerPartGroup::finishUpdate()
+{
+	LLViewerPartSim::checkParticleCount(mParticles.size());
 
-		// Set the last update time to now.
-		part->mLastUpdateTime = cur_time;
+	// particles put here by other groups' updates since simulateParticles()
+	// come after the simulated ones and are kept as they are
+	S32 end = (S32) mUpdateResults.size();
+	llassert(end <= (S32) mParticles.size());
 
+	// compact the survivors, keeping their order
+	S32 kept = 0;
+	for (S32 i = 0; i < end; i++)
+	{
+		LLViewerPart* part = mParticles[i];
+		if (mUpdateResults[i] == PART_KEEP)
+		{
+			mParticles[kept++] = part;
+			continue;
+		}
 
-		// Kill dead particles (either flagged dead, or too old)
-		if ((part->mLastUpdateTime > part->mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part->mFlags))
+		if (part->mVPCallback)
+		{
+			--mCallbackParticles;
+		}
+
+		if (mUpdateResults[i] == PART_DEAD)
 		{
-			mParticles[i] = mParticles.back() ;
-			mParticles.pop_back() ;
 			delete part ;
 		}
-		else 
+		else
 		{
-			F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
-			if (!posInGroup(part->mPosAgent, desired_size))
-			{
-				// Transfer particles between groups
-				LLViewerPartSim::getInstance()->put(part) ;
-				mParticles[i] = mParticles.back() ;
-				mParticles.pop_back() ;
-			}
-			else
-			{
-				i++ ;
-			}
+			// Transfer particles between groups
+			LLViewerPartSim::getInstance()->put(part) ;
 		}
 	}
+	S32 removed = end - kept;
+	for (S32 i = end; i < (S32) mParticles.size(); i++)
+	{
+		mParticles[kept++] = mParticles[i];
+	}
+	mParticles.resize(kept);
+	mUpdateResults.clear();
 
-	S32 removed = end - (S32)mParticles.size();
 	if (removed > 0)
 	{
 		// we removed one or more particles, so flag this group for update
@@ -430,13 +620,6 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 		}
 		LLViewerPartSim::decPartCount(removed);
 	}
-	
-	// Kill the viewer object if this particle group is empty
-	if (mParticles.empty())
-	{
-		gObjectList.killObject(mVOPartGroupp);
-		mVOPartGroupp = NULL;
-	}
 
 	LLViewerPartSim::checkParticleCount() ;
 }
@@ -582,8 +765,7 @@ LLViewerPartGroup *LLViewerPartSim::put(LLViewerPart* part)
 	}
 	else
 	{	
-		LLViewerCamera* camera = LLViewerCamera::getInstance();
-		F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
+		F32 desired_size = calc_desired_size(LLViewerCamera::getInstance()->getOrigin(), part->mPosAgent, part->mScale);
 
 		S32 count = (S32) mViewerPartGroups.size();
 		for (S32 i = 0; i < count; i++)
@@ -747,6 +929,10 @@ void LLViewerPartSim::updateSimulation()
 		num_updates++;
 	}
 
+	// Groups due for an update this frame and how far each one advances
+	std::vector<std::pair<LLViewerPartGroup*, F32> > due;
+	S32 due_particles = 0;
+
 	count = (S32) mViewerPartGroups.size();
 	for (i = 0; i < count; i++)
 	{
@@ -768,15 +954,8 @@ void LLViewerPartSim::updateSimulation()
 			{
 				gPipeline.markRebuild(vobj->mDrawable, LLDrawable::REBUILD_ALL);
 			}
-			mViewerPartGroups[i]->updateParticles(dt * visirate);
-			mViewerPartGroups[i]->mSkippedTime=0.0f;
-			if (!mViewerPartGroups[i]->getCount())
-			{
-				delete mViewerPartGroups[i];
-				mViewerPartGroups.erase(mViewerPartGroups.begin() + i);
-				i--;
-				count--;
-			}
+			due.push_back(std::make_pair(mViewerPartGroups[i], dt * visirate));
+			due_particles += mViewerPartGroups[i]->getCount();
 		}
 		else
 		{	
@@ -784,6 +963,59 @@ void LLViewerPartSim::updateSimulation()
 		}
 
 	}
+
+	const LLVector3 camera_origin = LLViewerCamera::getInstance()->getOrigin();
+	static LLCachedControl<bool> parallel_update(gSavedSettings, "ParticleParallelUpdate", true);
+	if (parallel_update && due.size() > 1 && due_particles >= PART_SIM_PARALLEL_MIN_PARTICLES)
+	{
+		// callbacks may read other objects, leave those groups to this thread
+		LL::parallelFor(PART_SIM_PARALLEL_QUEUE, due.size(), PART_SIM_PARALLEL_HELPERS,
+			[&due, &camera_origin](size_t g)
+			{
+				if (!due[g].first->hasCallbackParticles())
+				{
+					due[g].first->simulateParticles(due[g].second, camera_origin);
+				}
+			});
+		for (auto& entry : due)
+		{
+			if (entry.first->hasCallbackParticles())
+			{
+				entry.first->simulateParticles(entry.second, camera_origin);
+			}
+		}
+	}
+	else
+	{
+		for (auto& entry : due)
+		{
+			entry.first->simulateParticles(entry.second, camera_origin);
+		}
+	}
+
+	// before any transfers, so particles moving into a group that was just
+	// simulated don't carry its skipped time with them
+	for (auto& entry : due)
+	{
+		entry.first->mSkippedTime = 0.0f;
+	}
+
+	// Deaths and transfers between groups, which may create new groups
+	for (auto& entry : due)
+	{
+		entry.first->finishUpdate();
+	}
+
+	// Kill the groups that were emptied, along with their viewer objects
+	for (auto& entry : due)
+	{
+		LLViewerPartGroup* groupp = entry.first;
+		if (!groupp->getCount())
+		{
+			mViewerPartGroups.erase(std::find(mViewerPartGroups.begin(), mViewerPartGroups.end(), groupp));
+			delete groupp;
+		}
+	}
 	if (LLDrawable::getCurrentFrame()%16==0)
 	{
 		if (sParticleCount > sMaxParticleCount * 0.875f
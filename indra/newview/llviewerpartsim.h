@@ -97,7 +97,14 @@ public:
 
 	BOOL addPart(LLViewerPart* part, const F32 desired_size = -1.f);
 	
-	void updateParticles(const F32 lastdt);
+	// Advances every particle by lastdt and notes which ones died or left
+	// the group. Touches nothing but this group's particles, so groups
+	// without callback driven particles can be simulated concurrently.
+	void simulateParticles(const F32 lastdt, const LLVector3& camera_origin);
+	// Removes the particles the last simulateParticles() call dropped.
+	// Main thread only.
+	void finishUpdate();
+	bool hasCallbackParticles() const		{ return mCallbackParticles > 0; }
 
 	BOOL posInGroup(const LLVector3 &pos, const F32 desired_size = -1.f);
 
@@ -131,6 +138,17 @@ protected:
 	LLVector3 mMaxObjPos;
 
 	LLViewerRegion *mRegionp;
+
+	enum EUpdateResult
+	{
+		PART_KEEP,
+		PART_DEAD,
+		PART_MOVED
+	};
+	// what simulateParticles() decided for each particle
+	std::vector<U8> mUpdateResults;
+	// particles with an mVPCallback, which may read other objects
+	S32 mCallbackParticles;
 };
 
 class LLViewerPartSim : public LLSingleton<LLViewerPartSim>
@@ -34,6 +34,7 @@
 #include "llavatarnamecache.h"		// name lookup cap url
 #include "llfloaterreg.h"
 #include "llmath.h"
+#include "llmessagedecoders.h"
 #include "llregionflags.h"
 #include "llregionhandle.h"
 #include "llsurface.h"
@@ -2283,28 +2284,30 @@ void LLViewerRegion::updateCoarseLocations(LLMessageSystem* msg)
 	mMapAvatars.clear();
 	mMapAvatarIDs.clear(); // only matters in a rare case but it's good to be safe.
 
-	U8 x_pos = 0;
-	U8 y_pos = 0;
-	U8 z_pos = 0;
+	// Sent every second by every region, so read straight from the
+	// packet. Registered with setDecodingHandlerFuncFast().
+	LLDecodedCoarseLocationUpdate update;
+	if (!update.decode(msg))
+	{
+		return;
+	}
 
 	U32 pos = 0x0;
 
-	S16 agent_index;
-	S16 target_index;
-	msg->getS16Fast(_PREHASH_Index, _PREHASH_You, agent_index);
-	msg->getS16Fast(_PREHASH_Index, _PREHASH_Prey, target_index);
+	S16 agent_index = update.mIndex.mYou;
+	S16 target_index = update.mIndex.mPrey;
 
-	BOOL has_agent_data = msg->has(_PREHASH_AgentData);
-	S32 count = msg->getNumberOfBlocksFast(_PREHASH_Location);
+	BOOL has_agent_data = !update.mAgentData.empty();
+	S32 count = (S32)update.mLocation.size();
 	for(S32 i = 0; i < count; i++)
 	{
-		msg->getU8Fast(_PREHASH_Location, _PREHASH_X, x_pos, i);
-		msg->getU8Fast(_PREHASH_Location, _PREHASH_Y, y_pos, i);
-		msg->getU8Fast(_PREHASH_Location, _PREHASH_Z, z_pos, i);
+		U8 x_pos = update.mLocation[i].mX;
+		U8 y_pos = update.mLocation[i].mY;
+		U8 z_pos = update.mLocation[i].mZ;
 		LLUUID agent_id = LLUUID::null;
-		if(has_agent_data)
+		if(has_agent_data && i < (S32)update.mAgentData.size())
 		{
-			msg->getUUIDFast(_PREHASH_AgentData, _PREHASH_AgentID, agent_id, i);
+			agent_id = update.mAgentData[i].mAgentID;
 		}
 
 		//LL_INFOS() << "  object X: " << (S32)x_pos << " Y: " << (S32)y_pos
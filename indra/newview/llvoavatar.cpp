@@ -114,7 +114,9 @@
 #include "llskinningutil.h"
 
 #include "llperfstats.h"
+#include "parallelfor.h"
 
+#include <algorithm>
 #include <boost/lexical_cast.hpp>
 
 extern F32 SPEED_ADJUST_MAX;
@@ -135,6 +137,10 @@ const F32 DEFAULT_MAX_ATTACHMENT_COMPLEXITY = 1.0e6f;
 const F32 FIRST_APPEARANCE_CLOUD_MIN_DELAY = 3.f; // seconds
 const F32 FIRST_APPEARANCE_CLOUD_MAX_DELAY = 45.f;
 
+// WorkQueue lending threads to the staged avatar update, and how many of them
+const char* AVATAR_PARALLEL_QUEUE = "General";
+const size_t AVATAR_PARALLEL_HELPERS = 2;
+
 using namespace LLAvatarAppearanceDefines;
 
 //-----------------------------------------------------------------------------
@@ -615,6 +621,10 @@ BOOL LLVOAvatar::sVisibleInFirstPerson = FALSE;
 F32 LLVOAvatar::sLODFactor = 1.f;
 F32 LLVOAvatar::sPhysicsLODFactor = 1.f;
 BOOL LLVOAvatar::sJointDebug = FALSE;
+bool LLVOAvatar::sStagingUpdate = false;
+bool LLVOAvatar::sPostponingUpdates = false;
+std::vector<LLPointer<LLVOAvatar> > LLVOAvatar::sStagedAvatars;
+std::vector<LLPointer<LLVOAvatar> > LLVOAvatar::sPostponedAvatars;
 F32 LLVOAvatar::sUnbakedTime = 0.f;
 F32 LLVOAvatar::sUnbakedUpdateTime = 0.f;
 F32 LLVOAvatar::sGreyTime = 0.f;
@@ -1151,6 +1161,7 @@ void LLVOAvatar::initClass()
 
     // Where should this be set initially?
     LLJoint::setDebugJointNames(gSavedSettings.getString("DebugAvatarJoints"));
+    LLKeyframeMotion::setBakeKeyframes(gSavedSettings.getBOOL("AnimationBakeKeyframes"));
 
 	LLControlAvatar::sRegionChangedSlot = gAgent.addRegionChangedCallback(&LLControlAvatar::onRegionChanged);
 
@@ -2648,8 +2659,26 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
 	// animate the character
 	// store off last frame's root position to be consistent with camera position
 	mLastRootPos = mRoot->getWorldPosition();
-	BOOL detailed_update = updateCharacter(agent);
+	mStageCharacterUpdate = canStageCharacterUpdate();
+	bool detailed_update = updateCharacter(agent);
+	mStageCharacterUpdate = false;
+	if (mStagedSkeletonUpdate)
+	{
+		// the rest of the update happens in finishStagedUpdate()
+		mStagedDetailedUpdate = detailed_update;
+		sStagedAvatars.push_back(this);
+		return;
+	}
 
+	finishIdleUpdate(detailed_update);
+}
+
+//-----------------------------------------------------------------------------
+// finishIdleUpdate()
+// Everything in idleUpdate() that needs this frame's pose.
+//-----------------------------------------------------------------------------
+void LLVOAvatar::finishIdleUpdate(bool detailed_update)
+{
 	static LLUICachedControl<bool> visualizers_in_calls("ShowVoiceVisualizersInCalls", false);
 	bool voice_enabled = (visualizers_in_calls || LLVoiceClient::getInstance()->inProximalChannel()) &&
 						 LLVoiceClient::getInstance()->getVoiceEnabled(mID);
@@ -2705,6 +2734,129 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
     idleUpdateDebugInfo();
 }
 
+//-----------------------------------------------------------------------------
+// canStageCharacterUpdate()
+//-----------------------------------------------------------------------------
+bool LLVOAvatar::canStageCharacterUpdate() const
+{
+	static LLCachedControl<bool> parallel_update(gSavedSettings, "AvatarParallelUpdate", false);
+	// Own avatar's motions talk to the agent and UI, and per avatar joint
+	// counts don't mean much when skeletons are updated all at once.
+	return sStagingUpdate && parallel_update && !isSelf() && !sJointDebug;
+}
+
+// static
+void LLVOAvatar::beginStagedUpdate()
+{
+	llassert(!sStagingUpdate && sStagedAvatars.empty() && sPostponedAvatars.empty());
+	// Motions evaluated on workers must not go to the settings themselves.
+	LLPhysicsMotionController::cacheSettings();
+	sStagingUpdate = true;
+	sPostponingUpdates = true;
+}
+
+// static
+void LLVOAvatar::finishStagedUpdate(LLAgent &agent, const F64 &time)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	updateStagedAvatars();
+
+	// Animesh attachments follow their wearer's attachment points, which
+	// are only known now.
+	sPostponingUpdates = false;
+	std::vector<LLPointer<LLVOAvatar> > postponed;
+	postponed.swap(sPostponedAvatars);
+	for (LLVOAvatar* avatar : postponed)
+	{
+		if (!avatar->isDead())
+		{
+			avatar->idleUpdate(agent, time);
+		}
+	}
+	updateStagedAvatars();
+
+	sStagingUpdate = false;
+}
+
+// static
+bool LLVOAvatar::postponeIdleUpdate(LLVOAvatar* avatar)
+{
+	if (!sPostponingUpdates)
+	{
+		return false;
+	}
+	sPostponedAvatars.push_back(avatar);
+	return true;
+}
+
+// static
+void LLVOAvatar::updateStagedAvatars()
+{
+	if (sStagedAvatars.empty())
+	{
+		return;
+	}
+
+	std::vector<LLPointer<LLVOAvatar> > staged;
+	staged.swap(sStagedAvatars);
+	// Something later in the idle pass may have killed one of them.
+	staged.erase(std::remove_if(staged.begin(), staged.end(),
+								[](const LLPointer<LLVOAvatar>& avatar) { return avatar->isDead(); }),
+				 staged.end());
+
+	// Avatars share nothing while evaluating, any order will do...
+	LL::parallelFor(AVATAR_PARALLEL_QUEUE, staged.size(), AVATAR_PARALLEL_HELPERS,
+		[&staged](size_t i)
+		{
+			LLVOAvatar* avatar = staged[i];
+			avatar->mEvaluatingStaged = true;
+			avatar->evaluateCharacter();
+			avatar->mEvaluatingStaged = false;
+		});
+
+	// ...but finish them in the order they were queued, they trigger sounds
+	// and effects and read each other's attachments.
+	for (LLVOAvatar* avatar : staged)
+	{
+		avatar->mStagedSkeletonUpdate = false;
+		avatar->applyDeferredCharacterRequests();
+		avatar->finishCharacter(avatar->mStagedDetailedUpdate);
+		avatar->finishIdleUpdate(avatar->mStagedDetailedUpdate);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// applyDeferredCharacterRequests()
+// Carries out, on the main thread, what motions asked for while this avatar
+// was evaluated on a worker.
+//-----------------------------------------------------------------------------
+void LLVOAvatar::applyDeferredCharacterRequests()
+{
+	llassert(!mEvaluatingStaged);
+	std::vector<DeferredMotionRequest> requests;
+	requests.swap(mDeferredMotionRequests);
+	for (const DeferredMotionRequest& request : requests)
+	{
+		if (request.mStart)
+		{
+			startMotion(request.mID, request.mTimeOffset);
+		}
+		else
+		{
+			stopMotion(request.mID, request.mStopImmediate);
+		}
+	}
+
+	if (mDeferredVisualParamUpdate)
+	{
+		mDeferredVisualParamUpdate = false;
+		updateVisualParams();
+		// Skeletal params may have moved joints since the skeleton was
+		// propagated.
+		mRoot->updateWorldMatrixChildren();
+	}
+}
+
 void LLVOAvatar::idleUpdateVoiceVisualizer(bool voice_enabled)
 {
 	bool render_visualizer = voice_enabled;
@@ -4580,6 +4732,8 @@ bool LLVOAvatar::computeNeedsUpdate()
 //------------------------------------------------------------------------
 bool LLVOAvatar::updateCharacter(LLAgent &agent)
 {	
+	mStagedSkeletonUpdate = false;
+
 	updateDebugText();
 	
 	if (!mIsBuilt)
@@ -4683,20 +4837,49 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
 	// update animations
 	if (!visible)
 	{
-		updateMotions(LLCharacter::HIDDEN_UPDATE);
+		mStagedUpdateType = LLCharacter::HIDDEN_UPDATE;
 	}
 	else if (mSpecialRenderMode == 1) // Animation Preview
 	{
-		updateMotions(LLCharacter::FORCE_UPDATE);
+		mStagedUpdateType = LLCharacter::FORCE_UPDATE;
 	}
 	else
 	{
 		// Might be better to do HIDDEN_UPDATE if cloud
-		updateMotions(LLCharacter::NORMAL_UPDATE);
+		mStagedUpdateType = LLCharacter::NORMAL_UPDATE;
+	}
+	mStagedMotionUpdate = beginMotionUpdate(mStagedUpdateType);
+	mStagedSitGroundConstrained = was_sit_ground_constrained;
+
+	if (mStageCharacterUpdate)
+	{
+		// finishStagedUpdate() takes it from here
+		mStagedSkeletonUpdate = true;
+		return visible;
+	}
+
+	evaluateCharacter();
+	finishCharacter(visible);
+
+	return visible;
+}
+
+//-----------------------------------------------------------------------------
+// evaluateCharacter()
+// Second stage of updateCharacter(): evaluates motions and propagates the
+// skeleton. Only touches this avatar, so it may run on a worker thread.
+//-----------------------------------------------------------------------------
+void LLVOAvatar::evaluateCharacter()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+	if (mStagedMotionUpdate)
+	{
+		evaluateMotions(mStagedUpdateType);
+		mStagedMotionUpdate = false;
 	}
 
 	// Special handling for sitting on ground.
-	if (!getParent() && (isSitting() || was_sit_ground_constrained))
+	if (!getParent() && (isSitting() || mStagedSitGroundConstrained))
 	{
 		
 		F32 off_z = LLVector3d(getHoverOffset()).mdV[VZ];
@@ -4710,22 +4893,27 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
 		}
 	}
 
+	// Update child joints as needed.
+	mRoot->updateWorldMatrixChildren();
+}
+
+//-----------------------------------------------------------------------------
+// finishCharacter()
+// Last stage of updateCharacter(), back on the main thread.
+//-----------------------------------------------------------------------------
+void LLVOAvatar::finishCharacter(bool visible)
+{
 	// update head position
 	updateHeadOffset();
 
 	// Generate footstep sounds when feet hit the ground
     updateFootstepSounds();
 
-	// Update child joints as needed.
-	mRoot->updateWorldMatrixChildren();
-
     if (visible)
     {
 		// System avatar mesh vertices need to be reskinned.
 		mNeedsSkin = TRUE;
     }
-
-	return visible;
 }
 
 //-----------------------------------------------------------------------------
@@ -6074,6 +6262,13 @@ LLUUID LLVOAvatar::remapMotionID(const LLUUID& id)
 //-----------------------------------------------------------------------------
 BOOL LLVOAvatar::startMotion(const LLUUID& id, F32 time_offset)
 {
+	if (mEvaluatingStaged)
+	{
+		// Motion registry and shared animation caches, see updateStagedAvatars()
+		mDeferredMotionRequests.push_back({ id, time_offset, FALSE, true });
+		return TRUE;
+	}
+
 	LL_DEBUGS("Motion") << "motion requested " << id.asString() << " " << gAnimLibrary.animationName(id) << LL_ENDL;
 
 	LLUUID remap_id = remapMotionID(id);
@@ -6096,6 +6291,12 @@ BOOL LLVOAvatar::startMotion(const LLUUID& id, F32 time_offset)
 //-----------------------------------------------------------------------------
 BOOL LLVOAvatar::stopMotion(const LLUUID& id, BOOL stop_immediate)
 {
+	if (mEvaluatingStaged)
+	{
+		mDeferredMotionRequests.push_back({ id, 0.f, stop_immediate, false });
+		return TRUE;
+	}
+
 	LL_DEBUGS("Motion") << "Motion requested " << id.asString() << " " << gAnimLibrary.animationName(id) << LL_ENDL;
 
 	LLUUID remap_id = remapMotionID(id);
@@ -7008,6 +7209,13 @@ void LLVOAvatar::initAttachmentPoints(bool ignore_hud_joints)
 //-----------------------------------------------------------------------------
 void LLVOAvatar::updateVisualParams()
 {
+	if (mEvaluatingStaged)
+	{
+		// Can start and stop motions and dirty the mesh, see updateStagedAvatars()
+		mDeferredVisualParamUpdate = true;
+		return;
+	}
+
 	ESex avatar_sex = (getVisualParamWeight("male") > 0.5f) ? SEX_MALE : SEX_FEMALE;
 	if (getSex() != avatar_sex)
 	{
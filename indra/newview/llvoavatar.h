@@ -276,6 +276,53 @@ public:
     void			updateOrientation(LLAgent &agent, F32 speed, F32 delta_time);
     void			updateTimeStep();
     void			updateRootPositionAndRotation(LLAgent &agent, F32 speed, bool was_sit_ground_constrained);
+
+    // Staged update of the avatars in the object list's idle pass. Between
+    // beginStagedUpdate() and finishStagedUpdate(), idleUpdate() of avatars
+    // other than self stops once their motions are prepared.
+    // finishStagedUpdate() then evaluates the motions and skeletons of all
+    // of them in parallel, and finishes their idle updates on the main
+    // thread in the order they were queued.
+    static void		beginStagedUpdate();
+    static void		finishStagedUpdate(LLAgent &agent, const F64 &time);
+    // Holds back the idle update of an avatar that follows another one's
+    // pose (animesh attachments) until the staged avatars are done. Returns
+    // false if there is no staged update to wait for.
+    static bool		postponeIdleUpdate(LLVOAvatar* avatar);
+private:
+    bool			canStageCharacterUpdate() const;
+    void			evaluateCharacter();
+    void			finishCharacter(bool visible);
+    void			finishIdleUpdate(bool detailed_update);
+    void			applyDeferredCharacterRequests();
+    static void		updateStagedAvatars();
+
+    bool			mStageCharacterUpdate = false;		// updateCharacter() should stop once motions are prepared
+    bool			mStagedSkeletonUpdate = false;		// ...and it did, evaluateCharacter() and finishCharacter() are due
+    bool			mStagedMotionUpdate = false;		// evaluateMotions() is due
+    bool			mStagedSitGroundConstrained = false;
+    bool			mStagedDetailedUpdate = false;
+    LLCharacter::e_update_t mStagedUpdateType = LLCharacter::NORMAL_UPDATE;
+
+    // While evaluateCharacter() runs on a worker, motions that start or stop
+    // other motions or update visual params only leave a note here.
+    // applyDeferredCharacterRequests() carries them out on the main thread.
+    struct DeferredMotionRequest
+    {
+        LLUUID	mID;
+        F32		mTimeOffset;
+        BOOL	mStopImmediate;
+        bool	mStart;
+    };
+    bool			mEvaluatingStaged = false;
+    bool			mDeferredVisualParamUpdate = false;
+    std::vector<DeferredMotionRequest> mDeferredMotionRequests;
+
+    static bool		sStagingUpdate;
+    static bool		sPostponingUpdates;
+    static std::vector<LLPointer<LLVOAvatar> > sStagedAvatars;
+    static std::vector<LLPointer<LLVOAvatar> > sPostponedAvatars;
+public:
     
 	void 			idleUpdateVoiceVisualizer(bool voice_enabled);
 	void 			idleUpdateMisc(bool detailed_update);
@@ -32,6 +32,7 @@
 #include "lldrawable.h"
 #include "llviewerregion.h"
 #include "llagentcamera.h"
+#include "llmemorystream.h"
 #include "llsdserialize.h"
 
 //static variables
@@ -188,7 +189,9 @@ LLVOCacheEntry::LLVOCacheEntry()
 	mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+// Reads an entry written by writeToBuffer() from data, bytes_read is set
+// to the number of bytes consumed.
+LLVOCacheEntry::LLVOCacheEntry(const U8* data, S32 data_size, S32& bytes_read)
 :	LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY), 
 	mBuffer(NULL),
 	mUpdateFlags(-1),
@@ -200,11 +203,12 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
 {
 	S32 size = -1;
 	BOOL success;
-    static U8 data_buffer[ENTRY_HEADER_SIZE];
+	const U8* data_buffer = data;
 
 	mDP.assignBuffer(mBuffer, 0);
+	bytes_read = 0;
 
-    success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
+    success = data_size >= ENTRY_HEADER_SIZE;
     if (success)
     {
         memcpy(&mLocalID, data_buffer, sizeof(U32));
@@ -226,17 +230,15 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
 	}
 	if(success && size > 0)
 	{
-		mBuffer = new U8[size];
-		success = check_read(apr_file, mBuffer, size);
+		success = data_size - ENTRY_HEADER_SIZE >= size;
 
 		if(success)
 		{
+			// the entry outlives the cache pack mapping, keep a copy of the body
+			mBuffer = new U8[size];
+			memcpy(mBuffer, data + ENTRY_HEADER_SIZE, size);
 			mDP.assignBuffer(mBuffer, size);
-		}
-		else
-		{
-			delete[] mBuffer ;
-			mBuffer = NULL ;
+			bytes_read = ENTRY_HEADER_SIZE + size;
 		}
 	}
 
@@ -1111,15 +1113,15 @@ void LLVOCachePartition::removeOccluder(LLVOCacheGroup* group)
 //-------------------------------------------------------------------
 //LLVOCache
 //-------------------------------------------------------------------
-// Format strings used to construct filename for the object cache
-static const char OBJECT_CACHE_FILENAME[] = "objects_%d_%d.slc";
-static const char OBJECT_CACHE_EXTRAS_FILENAME[] = "objects_%d_%d_extras.slec";
-
 const U32 MAX_NUM_OBJECT_ENTRIES = 128 ;
 const U32 MIN_ENTRIES_TO_PURGE = 16 ;
 const U32 INVALID_TIME = 0 ;
 const char* object_cache_dirname = "objectcache";
 const char* header_filename = "object.cache";
+const char* pack_filename = "objects.slcpack";
+
+const U64 PACK_MIN_DEAD_BYTES_TO_COMPACT = 8 * 1024 * 1024;
+const F32 PACK_COMPACT_IDLE_TIME = 30.f; // seconds without writes
 
 
 LLVOCache::LLVOCache(bool read_only) :
@@ -1127,6 +1129,7 @@ LLVOCache::LLVOCache(bool read_only) :
 	mReadOnly(read_only),
 	mNumEntries(0),
 	mCacheSize(1),
+	mPackWritten(false),
     mEnabled(true)
 {
 #ifndef LL_TEST
@@ -1139,15 +1142,18 @@ LLVOCache::~LLVOCache()
 {
 	if(mEnabled)
 	{
+		compactPack();
 		writeCacheHeader();
 		clearCacheInMemory();
 	}
+	closePack();
 	delete mLocalAPRFilePoolp;
 }
 
 void LLVOCache::setDirNames(ELLPath location)
 {
 	mHeaderFileName = gDirUtilp->getExpandedFilename(location, object_cache_dirname, header_filename);
+	mPackFileName = gDirUtilp->getExpandedFilename(location, object_cache_dirname, pack_filename);
 	mObjectCacheDirName = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
 }
 
@@ -1200,6 +1206,13 @@ void LLVOCache::initCache(ELLPath location, U32 size, U32 cache_version)
 			removeCache();
 		}
 	}	
+
+	if (!openPack() && !mReadOnly)
+	{
+		LL_INFOS() << "Viewer Object Cache pack unusable.  clearing cache." << LL_ENDL;
+		removeCache();
+	}
+	compactPack();
 }
 	
 void LLVOCache::removeCache(ELLPath location, bool started) 
@@ -1218,6 +1231,8 @@ void LLVOCache::removeCache(ELLPath location, bool started)
 
 	LL_INFOS() << "about to remove the object cache due to settings." << LL_ENDL ;
 
+	closePack();
+
 	std::string mask = "*";
 	std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
 	LL_INFOS() << "Removing cache at " << cache_dir << LL_ENDL;
@@ -1242,12 +1257,18 @@ void LLVOCache::removeCache()
 		return ;
 	}
 
+	closePack();
+
 	std::string mask = "*";
 	LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
 	gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask); 
 
 	clearCacheInMemory() ;
 	writeCacheHeader();
+	if (mInitialized)
+	{
+		openPack();
+	}
 }
 
 void LLVOCache::removeEntry(HeaderEntryInfo* entry) 
@@ -1271,6 +1292,8 @@ void LLVOCache::removeEntry(HeaderEntryInfo* entry)
 		delete entry;
 
 		mNumEntries = mHandleEntryMap.size() ;
+		mPackWritten = true;
+		mPackWriteTimer.reset();
 	}
 }
 
@@ -1300,24 +1323,85 @@ void LLVOCache::clearCacheInMemory()
 
 }
 
-void LLVOCache::getObjectCacheFilename(U64 handle, std::string& filename) 
+bool LLVOCache::openPack()
 {
-	U32 region_x, region_y;
+	if (mPack.isOpen())
+	{
+		return true;
+	}
+	if (!mPack.open(mPackFileName, mMetaInfo.mVersion, !mReadOnly))
+	{
+		LL_WARNS() << "Could not open object cache pack " << mPackFileName << LL_ENDL;
+		return false;
+	}
+	return true;
+}
 
-	grid_from_region_handle(handle, &region_x, &region_y);
-	filename = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, object_cache_dirname,
-			   llformat(OBJECT_CACHE_FILENAME, region_x, region_y));
+void LLVOCache::closePack()
+{
+	mPack.close();
+}
 
-	return ;
+void LLVOCache::idleCompactPack()
+{
+	// Regions are written in bursts when leaving them, don't rewrite the
+	// whole pack in the middle of one.
+	if (!mPackWritten || mPackWriteTimer.getElapsedTimeF32() < PACK_COMPACT_IDLE_TIME)
+	{
+		return;
+	}
+	mPackWritten = false;
+	compactPack();
 }
 
-std::string LLVOCache::getObjectCacheExtrasFilename(U64 handle)
+// Rewrites the pack with only the segments regions still refer to, once
+// dead segments take more room than live ones.  Checked at startup, on idle
+// after writes and at shutdown.
+void LLVOCache::compactPack()
 {
-    U32 region_x, region_y;
+	if (mReadOnly || !mPack.isOpen())
+	{
+		return;
+	}
+
+	// two segments per region, objects then extras
+	LLSegmentPack::segment_list_t live;
+	live.reserve(mHeaderEntryQueue.size() * 2);
+	for (header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin(); iter != mHeaderEntryQueue.end(); ++iter)
+	{
+		HeaderEntryInfo* entry = *iter;
+		live.push_back({ entry->mHandle, entry->mObjectsOffset, entry->mObjectsSize });
+		live.push_back({ entry->mHandle, entry->mExtrasOffset, entry->mExtrasSize });
+	}
+
+	U64 live_size = LLSegmentPack::getPackedSize(live);
+	U64 end = mPack.getUsedSize();
+	U64 dead_size = end > live_size ? end - live_size : 0;
+	if (dead_size < PACK_MIN_DEAD_BYTES_TO_COMPACT || dead_size < live_size)
+	{
+		return;
+	}
+
+	LL_INFOS() << "Compacting object cache pack, live: " << live_size << " dead: " << dead_size << LL_ENDL;
+
+	if (!mPack.compact(live))
+	{
+		removeCache();
+		return;
+	}
 
-    grid_from_region_handle(handle, &region_x, &region_y);
-    return gDirUtilp->getExpandedFilename(LL_PATH_CACHE, object_cache_dirname,
-               llformat(OBJECT_CACHE_EXTRAS_FILENAME, region_x, region_y));
+	LLSegmentPack::segment_list_t::const_iterator segment = live.begin();
+	for (header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin(); iter != mHeaderEntryQueue.end(); ++iter)
+	{
+		HeaderEntryInfo* entry = *iter;
+		entry->mObjectsOffset = segment->mOffset;
+		entry->mObjectsSize = segment->mSize;
+		++segment;
+		entry->mExtrasOffset = segment->mOffset;
+		entry->mExtrasSize = segment->mSize;
+		++segment;
+	}
+	writeCacheHeader();
 }
 
 void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
@@ -1328,9 +1412,11 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
 		return ;
 	}
 
-	std::string filename;
-	getObjectCacheFilename(entry->mHandle, filename);
-	LLAPRFile::remove(filename, mLocalAPRFilePoolp);
+	// the segments become dead space in the pack
+	entry->mObjectsOffset = 0;
+	entry->mObjectsSize = 0;
+	entry->mExtrasOffset = 0;
+	entry->mExtrasSize = 0;
 	entry->mTime = INVALID_TIME ;
 	updateEntry(entry) ; //update the head file.
 }
@@ -1496,15 +1582,17 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 
 	bool success = true ;
 	{
-		std::string filename;
+		// entries are parsed straight out of the mapped pack
+		HeaderEntryInfo* header_entry = iter->second;
+		const U8* data = mPack.get(handle, header_entry->mObjectsOffset, header_entry->mObjectsSize);
+		S32 data_size = (S32)header_entry->mObjectsSize;
 		LLUUID cache_id;
-		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
-	
-		success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
+
+		success = data && data_size >= UUID_BYTES + (S32)sizeof(S32);
 	
 		if(success)
 		{		
+			memcpy(cache_id.mData, data, UUID_BYTES);
 			if(cache_id != id)
 			{
 				LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
@@ -1514,21 +1602,21 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 			if(success)
 			{
 				S32 num_entries;  // if removal was enabled during write num_entries might be wrong
-				success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
-	
-				if(success)
+				memcpy(&num_entries, data + UUID_BYTES, sizeof(S32));
+				S32 offset = UUID_BYTES + sizeof(S32);
+
+				for (S32 i = 0; i < num_entries && offset < data_size; i++)
 				{
-					for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
+					S32 bytes_read = 0;
+					LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(data + offset, data_size - offset, bytes_read);
+					if (!entry->getLocalID())
 					{
-						LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
-						if (!entry->getLocalID())
-						{
-							LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-							success = false ;
-							break ;
-						}
-						cache_entry_map[entry->getLocalID()] = entry;
+						LL_WARNS() << "Aborting cache file load for region " << handle << ", cache file corruption!" << LL_ENDL;
+						success = false ;
+						break ;
 					}
+					cache_entry_map[entry->getLocalID()] = entry;
+					offset += bytes_read;
 				}
 			}
 		}		
@@ -1561,8 +1649,14 @@ void LLVOCache::readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCac
         return;
     }
 
-    std::string filename(getObjectCacheExtrasFilename(handle));
-    llifstream in(filename, std::ios::in | std::ios::binary);
+    HeaderEntryInfo* header_entry = iter->second;
+    const U8* data = mPack.get(handle, header_entry->mExtrasOffset, header_entry->mExtrasSize);
+    if (!data)
+    {
+        LL_DEBUGS("GLTF") << "No extras cache for handle " << handle << LL_ENDL;
+        return;
+    }
+    LLMemoryStream in(data, (S32)header_entry->mExtrasSize);
 
     std::string line;
     std::getline(in, line);
@@ -1631,7 +1725,6 @@ void LLVOCache::purgeEntries(U32 size)
 		mHeaderEntryQueue.erase(iter) ;
 		removeFromCache(entry) ;
 		delete entry;
-        // TODO also delete extras
 	}
 	mNumEntries = mHandleEntryMap.size() ;
 }
@@ -1679,83 +1772,73 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 		mHeaderEntryQueue.insert(entry) ;
 	}
 
-	//update cache header
-	if(!updateEntry(entry))
-	{
-		LL_WARNS() << "Failed to update cache header index " << entry->mIndex << ". handle = " << handle << LL_ENDL;
-		return ; //update failed.
-	}
-
 	if(!dirty_cache)
 	{
+		//update cache header
+		if(!updateEntry(entry))
+		{
+			LL_WARNS() << "Failed to update cache header index " << entry->mIndex << ". handle = " << handle << LL_ENDL;
+		}
 		LL_WARNS() << "Skipping write to cache for handle " << handle << ": cache not dirty" << LL_ENDL;
 		return ; //nothing changed, no need to update.
 	}
 
-	//write to cache file
+	//serialize the region in one buffer and append it to the pack in one go
 	bool success = true ;
+	std::vector<U8> data_buffer;
+	data_buffer.reserve(UUID_BYTES + sizeof(S32) + cache_entry_map.size() * 256);
+	data_buffer.resize(UUID_BYTES + sizeof(S32));
 	{
-		std::string filename;
-		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE, mLocalAPRFilePoolp);
-	
-		success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
-	
-		if(success)
+		memcpy(data_buffer.data(), id.mData, UUID_BYTES);
+		S32 num_entries = cache_entry_map.size(); // if removal is enabled num_entries might be wrong
+		memcpy(data_buffer.data() + UUID_BYTES, &num_entries, sizeof(S32));
+
+		for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
 		{
-			S32 num_entries = cache_entry_map.size(); // if removal is enabled num_entries might be wrong
-			success = check_write(&apr_file, &num_entries, sizeof(S32));
-            if (success)
-            {
-                const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
-                U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
-                S32 size_in_buffer = 0;
-
-                // This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-                for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
-                {
-                    if (!removal_enabled || iter->second->isValid())
-                    {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
-
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
-                        {
-                            size_in_buffer += size;
-                        }
-                        else
-                        {
-                            success = false;
-                            break;
-                        }
-
-                        // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
-                        {
-                            success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                            size_in_buffer = 0;
-                            if (!success)
-                            {
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                if (success && size_in_buffer > 0)
-                {
-                    // final write
-                    success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                    size_in_buffer = 0;
-                }
-            }
+			if (!removal_enabled || iter->second->isValid())
+			{
+				// Make sure we have space in buffer for the element
+				size_t size_in_buffer = data_buffer.size();
+				data_buffer.resize(size_in_buffer + MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE);
+				S32 size = iter->second->writeToBuffer(data_buffer.data() + size_in_buffer);
+
+				if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
+				{
+					data_buffer.resize(size_in_buffer + size);
+				}
+				else
+				{
+					success = false;
+					break;
+				}
+			}
 		}
 	}
 
+	U64 offset = 0;
+	if (success)
+	{
+		success = mPack.append(handle, data_buffer.data(), (U32)data_buffer.size(), offset);
+	}
+
 	if(!success)
 	{
 		removeEntry(entry) ;
+		return ;
+	}
+
+	// the previous segment of the region, if any, is now dead
+	entry->mObjectsOffset = offset;
+	entry->mObjectsSize = (U32)data_buffer.size();
+
+	//update cache header
+	if(!updateEntry(entry))
+	{
+		LL_WARNS() << "Failed to update cache header index " << entry->mIndex << ". handle = " << handle << LL_ENDL;
 	}
 
+	mPackWritten = true;
+	mPackWriteTimer.reset();
 	return ;
 }
 
@@ -1774,31 +1857,18 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
         return;
     }
 
-    std::string filename(getObjectCacheExtrasFilename(handle));
-    llofstream out(filename, std::ios::out | std::ios::binary);
-    if(!out.good())
+    handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle);
+    if (iter == mHandleEntryMap.end())
     {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
+        LL_WARNS() << "No handle map entry for " << handle << ", not writing extras cache" << LL_ENDL;
         return;
-        // TODO - clean up broken cache file
     }
 
-    out << id << '\n';
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        return;
-        // TODO - clean up broken cache file
-    }
+    std::ostringstream out(std::ios::out | std::ios::binary);
 
+    out << id << '\n';
     U32 num_entries = cache_extras_entry_map.size();
     out << num_entries << '\n';
-    if(!out.good())
-    {
-        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-        return;
-        // TODO - clean up broken cache file
-    }
 
     for (auto const & entry : cache_extras_entry_map)
     {
@@ -1807,13 +1877,22 @@ void LLVOCache::writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LL
         entry_llsd["local_id"] = local_id;
         LLSDSerialize::serialize(entry_llsd, out, LLSDSerialize::LLSD_XML);
         out << '\n';
-        if(!out.good())
-        {
-            LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
-            return;
-            // TODO - clean up broken cache file
-        }
     }
 
+    const std::string& extras = out.str();
+    U64 offset = 0;
+    if (!out.good() || !mPack.append(handle, (const U8*)extras.data(), (U32)extras.size(), offset))
+    {
+        LL_WARNS() << "Failed writing extras cache for handle " << handle << LL_ENDL;
+        return;
+    }
+
+    HeaderEntryInfo* entry = iter->second;
+    entry->mExtrasOffset = offset;
+    entry->mExtrasSize = (U32)extras.size();
+    updateEntry(entry);
+    mPackWritten = true;
+    mPackWriteTimer.reset();
+
     LL_DEBUGS("GLTF") << "Completed writing extras cache for handle " << handle << ", " << num_entries << " entries" << LL_ENDL;
 }
@@ -33,6 +33,8 @@
 #include "llvieweroctree.h"
 #include "llapr.h"
 #include "llgltfmaterial.h"
+#include "llframetimer.h"
+#include "llsegmentpack.h"
 
 #include <unordered_map>
 
@@ -106,7 +108,7 @@ protected:
 	~LLVOCacheEntry();
 public:
 	LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-	LLVOCacheEntry(LLAPRFile* apr_file);
+	LLVOCacheEntry(const U8* data, S32 data_size, S32& bytes_read);
 	LLVOCacheEntry();	
 
 	void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -255,12 +257,21 @@ class LLVOCache : public LLParamSingleton<LLVOCache>
 private:
 	struct HeaderEntryInfo
 	{
-		HeaderEntryInfo() : mIndex(0), mHandle(0), mTime(0) {}
+		HeaderEntryInfo() : mIndex(0), mHandle(0), mTime(0), mObjectsOffset(0), mObjectsSize(0), mExtrasOffset(0), mExtrasSize(0) {}
 		S32 mIndex;
 		U64 mHandle ;
 		U32 mTime ;
+		// segments of the region in the object cache pack, size is 0 when not written
+		U64 mObjectsOffset;
+		U32 mObjectsSize;
+		U64 mExtrasOffset;
+		U32 mExtrasSize;
 	};
 
+	// Region objects and extras are appended as segments to a single pack
+	// file rather than rewritten in one file per region.  Rewriting a region
+	// leaves its previous segment dead until the pack is compacted, which
+	// happens once writes have stopped for a while or at shutdown.
 	struct HeaderMetaInfo
 	{
 		HeaderMetaInfo() : mVersion(0), mAddressSize(0) {}
@@ -296,14 +307,15 @@ public:
     void writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map, BOOL dirty_cache, bool removal_enabled);
 	void removeEntry(U64 handle) ;
 
+	// Compacts the pack if it has not been written to for a while and dead
+	// segments outweigh live ones.  Called on idle.
+	void idleCompactPack();
+
 	U32 getCacheEntries() { return mNumEntries; }
 	U32 getCacheEntriesMax() { return mCacheSize; }
 
 private:
 	void setDirNames(ELLPath location);	
-	// determine the cache filename for the region from the region handle	
-	void getObjectCacheFilename(U64 handle, std::string& filename);
-    std::string getObjectCacheExtrasFilename(U64 handle);
 	void removeFromCache(HeaderEntryInfo* entry);
 	void readCacheHeader();
 	void writeCacheHeader();
@@ -312,6 +324,10 @@ private:
 	void removeEntry(HeaderEntryInfo* entry) ;
 	void purgeEntries(U32 size);
 	BOOL updateEntry(const HeaderEntryInfo* entry);
+
+	bool openPack();
+	void closePack();
+	void compactPack();
 	
 private:
 	bool                 mEnabled;
@@ -321,7 +337,11 @@ private:
 	U32                  mCacheSize;
 	U32                  mNumEntries;
 	std::string          mHeaderFileName ;
+	std::string          mPackFileName ;
 	std::string          mObjectCacheDirName;
+	LLSegmentPack        mPack;
+	bool                 mPackWritten;	// since the last compaction check
+	LLFrameTimer         mPackWriteTimer;
 	LLVolatileAPRPool*   mLocalAPRFilePoolp ; 	
 	header_entry_queue_t mHeaderEntryQueue;
 	handle_entry_map_t   mHandleEntryMap;	
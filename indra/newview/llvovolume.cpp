@@ -54,6 +54,7 @@
 #include "llspatialpartition.h"
 #include "llhudmanager.h"
 #include "llflexibleobject.h"
+#include "llrigginginfocache.h"
 #include "llskinningutil.h"
 #include "llsky.h"
 #include "lltexturefetch.h"
@@ -1066,6 +1067,12 @@ BOOL LLVOVolume::setVolume(const LLVolumeParams &params_in, const S32 detail, bo
 
 	}
 
+	if (NO_LOD != lod && !mSculptChanged && requestVolume(volume_params, lod))
+	{
+		// keep drawing the current detail until the new one is built
+		return FALSE;
+	}
+
 	if ((LLPrimitive::setVolume(volume_params, lod, (mVolumeImpl && mVolumeImpl->isVolumeUnique()))) || mSculptChanged)
 	{
 		mFaceMappingChanged = TRUE;
@@ -1138,6 +1145,70 @@ BOOL LLVOVolume::setVolume(const LLVolumeParams &params_in, const S32 detail, bo
 	return FALSE;
 }
 
+bool LLVOVolume::requestVolume(const LLVolumeParams& volume_params, S32 lod)
+{
+	static LLCachedControl<bool> async_volumes(gSavedSettings, "RenderAsyncVolumeGeneration", true);
+
+	// Only level of detail changes: anything else would show the old shape
+	// while the new one is built. Flexis are unique and meshes come from the
+	// mesh repository, neither goes through the volume manager.
+	LLVolume* volumep = getVolume();
+	if (!async_volumes || !volumep || mVolumeImpl || isMesh() ||
+		volume_params != volumep->getParams() ||
+		LLVolumeLODGroup::getVolumeScaleFromDetail(lod) == volumep->getDetail())
+	{
+		return false;
+	}
+
+	LLVolumeMgr::volume_finish_t finish;
+	if (isSculpted())
+	{
+		// sculpt() on the worker from a copy of what sculpt() here would use,
+		// so that it finds nothing left to do once the volume is in
+		LLImageRaw* raw_image = mSculptTexture.notNull() ? mSculptTexture->getCachedRawImage() : NULL;
+		if (!raw_image)
+		{
+			return false;
+		}
+		S32 discard_level = llmin(mSculptTexture->getCachedRawImageLevel(), (S32) mSculptTexture->getMaxDiscardLevel());
+		if (discard_level > MAX_DISCARD_LEVEL)
+		{
+			return false;
+		}
+
+		U16 width = raw_image->getWidth();
+		U16 height = raw_image->getHeight();
+		S8 components = raw_image->getComponents();
+		bool missing = mSculptTexture->isMissingAsset();
+		auto data = std::make_shared<std::vector<U8> >(raw_image->getData(), raw_image->getData() + raw_image->getDataSize());
+		finish = [data, width, height, components, discard_level, missing](LLVolume* new_volumep)
+		{
+			new_volumep->sculpt(width, height, components, data->data(), discard_level, missing);
+		};
+	}
+
+	LLUUID object_id = getID();
+	return LLPrimitive::getVolumeManager()->requestVolume(volume_params, lod,
+		[object_id]()
+		{
+			onVolumeGenerated(object_id);
+		},
+		finish);
+}
+
+// static
+void LLVOVolume::onVolumeGenerated(const LLUUID& object_id)
+{
+	LLViewerObject* objectp = gObjectList.findObject(object_id);
+	if (objectp && !objectp->isDead() && objectp->getPCode() == LL_PCODE_VOLUME && objectp->mDrawable.notNull())
+	{
+		// updateGeometry() picks it up as for any other change of detail
+		LLVOVolume* volobjp = (LLVOVolume*) objectp;
+		volobjp->mLODChanged = TRUE;
+		gPipeline.markRebuild(volobjp->mDrawable, LLDrawable::REBUILD_VOLUME);
+	}
+}
+
 void LLVOVolume::updateSculptTexture()
 {
 	LLPointer<LLViewerFetchedTexture> old_sculpt = mSculptTexture;
@@ -3793,15 +3864,36 @@ void LLVOVolume::updateRiggingInfo()
             {
                 // Rigging info may need update
                 mJointRiggingInfoTab.clear();
+
+                // Faces of a shared volume keep their rigging info, the
+                // cache covers faces of volumes loaded again since.
+                // Placeholder faces of meshes still loading aren't cached.
+                LLRiggingInfoCache* cache = volume->isMeshAssetLoaded() ? LLRiggingInfoCache::getInstance() : NULL;
+                const LLUUID& mesh_id = volume->getParams().getSculptID();
+                S32 volume_lod = LLVolumeLODGroup::getVolumeDetailFromScale(volume->getDetail());
+                bool computed = false;
                 for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
                 {
                     LLVolumeFace& vol_face = volume->getVolumeFace(f);
-                    LLSkinningUtil::updateRiggingInfo(skin, avatar, vol_face);
+                    if (vol_face.mJointRiggingInfoTab.needsUpdate()
+                        && !(cache && cache->fetch(mesh_id, volume_lod, f, skin, vol_face)))
+                    {
+                        LLSkinningUtil::updateRiggingInfo(skin, avatar, vol_face);
+                        if (cache && !vol_face.mJointRiggingInfoTab.needsUpdate())
+                        {
+                            cache->store(mesh_id, volume_lod, f, skin, vol_face);
+                            computed = true;
+                        }
+                    }
                     if (vol_face.mJointRiggingInfoTab.size()>0)
                     {
                         mJointRiggingInfoTab.merge(vol_face.mJointRiggingInfoTab);
                     }
                 }
+                if (computed)
+                {
+                    cache->save(mesh_id);
+                }
                 // Keep the highest LOD info available.
                 mLastRiggingInfoLOD = getLOD();
                 LL_DEBUGS("RigSpammish") << "updated rigging info for LLVOVolume " 
@@ -4556,6 +4648,29 @@ LLVector3 LLVOVolume::volumeDirectionToAgent(const LLVector3& dir) const
 }
 
 
+// true if a pick on this face stands without looking at its texture's alpha mask
+static bool pick_ignores_alpha_mask(LLFace* face)
+{
+	const LLTextureEntry* te = face->getTextureEntry();
+	if (te)
+	{
+		LLMaterial* mat = te->getMaterialParams();
+		if (mat)
+		{
+			U8 mode = mat->getDiffuseAlphaMode();
+
+			if (mode == LLMaterial::DIFFUSE_ALPHA_MODE_EMISSIVE
+				|| mode == LLMaterial::DIFFUSE_ALPHA_MODE_NONE
+				|| (mode == LLMaterial::DIFFUSE_ALPHA_MODE_MASK && mat->getAlphaMaskCutoff() == 0))
+			{
+				return true;
+			}
+		}
+	}
+
+	return !face->getTexture() || !face->getTexture()->hasGLTexture();
+}
+
 BOOL LLVOVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& end, S32 face, BOOL pick_transparent, BOOL pick_rigged, BOOL pick_unselectable, S32 *face_hitp,
 									  LLVector4a* intersection,LLVector2* tex_coord, LLVector4a* normal, LLVector4a* tangent)
 	
@@ -4675,29 +4790,9 @@ BOOL LLVOVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a&
 			{
 				LLFace* face = mDrawable->getFace(face_hit);				
 
-				bool ignore_alpha = false;
-
-				const LLTextureEntry* te = face->getTextureEntry();
-				if (te)
-				{
-					LLMaterial* mat = te->getMaterialParams();
-					if (mat)
-					{
-						U8 mode = mat->getDiffuseAlphaMode();
-
-						if (mode == LLMaterial::DIFFUSE_ALPHA_MODE_EMISSIVE
-							|| mode == LLMaterial::DIFFUSE_ALPHA_MODE_NONE
-							|| (mode == LLMaterial::DIFFUSE_ALPHA_MODE_MASK && mat->getAlphaMaskCutoff() == 0))
-						{
-							ignore_alpha = true;
-						}
-					}
-				}
-
-                BOOL no_texture = !face->getTexture() || !face->getTexture()->hasGLTexture();
-                BOOL mask       = no_texture ? FALSE : face->getTexture()->getMask(face->surfaceToTexture(tc, p, n));
 				if (face &&
-					(ignore_alpha || pick_transparent || no_texture || mask))
+					(pick_transparent || pick_ignores_alpha_mask(face)
+					 || face->getTexture()->getMask(face->surfaceToTexture(tc, p, n))))
 				{
 					local_end = p;
 					if (face_hitp != NULL)
@@ -4769,6 +4864,100 @@ BOOL LLVOVolume::lineSegmentIntersect(const LLVector4a& start, const LLVector4a&
 	return ret;
 }
 
+BOOL LLVOVolume::lineSegmentsIntersect(const LLVector4a* start, LLVector4a* end, U32 count,
+										BOOL pick_transparent,
+										BOOL pick_rigged,
+										BOOL pick_unselectable,
+										BOOL* hit)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+	LLVolume* volume = getVolume();
+	if (!volume || mDrawable->isState(LLDrawable::RIGGED) || getSkinInfo())
+	{ //rigged volumes are posed for each pick, trace them one segment at a time
+		return LLViewerObject::lineSegmentsIntersect(start, end, count, pick_transparent, pick_rigged, pick_unselectable, hit);
+	}
+
+	if (!mbCanSelect 
+		|| mDrawable->isDead() 
+		|| !gPipeline.hasRenderType(mDrawable->getRenderType()))
+	{
+		return FALSE;
+	}
+
+	if (!pick_unselectable && !LLSelectMgr::instance().canSelectObject(this, TRUE))
+	{
+		return FALSE;
+	}
+
+	pick_transparent |= isHiglightedOrBeacon();
+	bool special_cursor = mReflectionProbe.isNull() && specialHoverCursor();
+
+	BOOL ret = FALSE;
+
+	const U32 BATCH_SIZE = 8;
+	for (U32 first = 0; first < count; first += BATCH_SIZE)
+	{
+		const U32 batch = llmin(count - first, BATCH_SIZE);
+
+		LLVector4a local_start[BATCH_SIZE];
+		LLVector4a local_end[BATCH_SIZE];
+		for (U32 i = 0; i < batch; ++i)
+		{
+			LLVector3 v_start(start[first + i].getF32ptr());
+			LLVector3 v_end(end[first + i].getF32ptr());
+			local_start[i].load3(agentPositionToVolume(v_start).mV);
+			local_end[i].load3(agentPositionToVolume(v_end).mV);
+		}
+
+		for (S32 f = 0; f < volume->getNumVolumeFaces(); ++f)
+		{
+			if (!special_cursor && !pick_transparent && getTE(f) && getTE(f)->getColor().mV[3] == 0.f)
+			{ //don't attempt to pick completely transparent faces unless
+				//pick_transparent is true
+				continue;
+			}
+
+			S32 face_hit[BATCH_SIZE];
+			LLVector4a p[BATCH_SIZE];
+			volume->lineSegmentIntersect(local_start, local_end, batch, f, face_hit, p);
+
+			LLFace* face = f < mDrawable->getNumFaces() ? mDrawable->getFace(f) : NULL;
+			for (U32 i = 0; i < batch; ++i)
+			{
+				if (face_hit[i] != f || !face)
+				{
+					continue;
+				}
+
+				if (pick_transparent || pick_ignores_alpha_mask(face))
+				{
+					local_end[i] = p[i];
+					LLVector3 v_p(p[i].getF32ptr());
+					end[first + i].load3(volumePositionToAgent(v_p).mV);
+				}
+				else
+				{ //the alpha mask needs texture coordinates, only the single segment trace has them
+					LLVector4a intersection;
+					if (!lineSegmentIntersect(start[first + i], end[first + i], f, pick_transparent, pick_rigged, pick_unselectable,
+											  NULL, &intersection))
+					{
+						continue;
+					}
+					end[first + i] = intersection;
+					LLVector3 v_p(intersection.getF32ptr());
+					local_end[i].load3(agentPositionToVolume(v_p).mV);
+				}
+
+				hit[first + i] = TRUE;
+				ret = TRUE;
+			}
+		}
+	}
+
+	return ret;
+}
+
 bool LLVOVolume::treatAsRigged()
 {
 	return isSelected() &&
@@ -4880,6 +5069,9 @@ void LLRiggedVolume::update(
 	U32 maxJoints = LLSkinningUtil::getMeshJointCount(skin);
     LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar);
     const LLMatrix4a bind_shape_matrix = skin->mBindShapeMatrix;
+    // bind shape folded in, for LLSkinningUtil::skinPositions()
+    LLMatrix4a bound_mat[kMaxJoints];
+    LLSkinningUtil::bindSkinningMatrixPalette(bound_mat, mat, maxJoints, bind_shape_matrix);
 
     S32 rigged_vert_count = 0;
     S32 rigged_face_count = 0;
@@ -4917,7 +5109,6 @@ void LLRiggedVolume::update(
 
 			if (pos && dst_face.mExtents)
 			{
-                U32 max_joints = LLSkinningUtil::getMaxJointCount();
                 rigged_vert_count += dst_face.mNumVertices;
                 rigged_face_count++;
 
@@ -4945,18 +5136,7 @@ void LLRiggedVolume::update(
                 else
             #endif
                 {
-				    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
-				    {
-					    LLMatrix4a final_mat;
-                        LLSkinningUtil::getPerVertexSkinMatrix(weight[j].getF32ptr(), mat, false, final_mat, max_joints);
-				
-					    LLVector4a& v = vol_face.mPositions[j];
-					    LLVector4a t;
-					    LLVector4a dst;
-					    bind_shape_matrix.affineTransform(v, t);
-					    final_mat.affineTransform(t, dst);
-					    pos[j] = dst;
-				    }
+                    LLSkinningUtil::skinPositions(vol_face.mPositions, weight, dst_face.mNumVertices, bound_mat, maxJoints, pos);
                 }
 
 				//update bounding box
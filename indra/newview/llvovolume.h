@@ -167,6 +167,12 @@ public:
 										  LLVector4a* normal = NULL,             // return the surface normal at the intersection point
 										  LLVector4a* tangent = NULL           // return the surface tangent at the intersection point
 		) override;
+	// Traces the segments of unrigged volumes together against each face's triangle BVH
+	/*virtual*/ BOOL lineSegmentsIntersect(const LLVector4a* start, LLVector4a* end, U32 count,
+										   BOOL pick_transparent,
+										   BOOL pick_rigged,
+										   BOOL pick_unselectable,
+										   BOOL* hit) override;
 	
 				LLVector3 agentPositionToVolume(const LLVector3& pos) const;
 				LLVector3 agentDirectionToVolume(const LLVector3& dir) const;
@@ -435,6 +441,10 @@ protected:
 
 private:
     bool lodOrSculptChanged(LLDrawable *drawable, BOOL &compiled, BOOL &shouldUpdateOctreeBounds);
+    // Have the volume manager build lod of volume_params in the background.
+    // True if it's on its way and the current volume should stay meanwhile.
+    bool requestVolume(const LLVolumeParams& volume_params, S32 lod);
+    static void onVolumeGenerated(const LLUUID& object_id);
 
 public:
 
@@ -0,0 +1,273 @@
+/**
+ * @file llskinningutil_test.cpp
+ * @brief Skinning kernel tests and benchmark
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llskinningutil.h"
+#include "../llvoavatar.h"
+#include "llmodel.h"
+#include "llrand.h"
+#include "llvolume.h"
+
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Stubs: every test skin has its joint numbers initialized, so no avatar is
+// ever asked for a joint.
+
+LLJoint* LLVOAvatar::getJoint(S32 num) { return NULL; }
+
+//----------------------------------------------------------------------------
+
+namespace
+{
+    typedef std::vector<LLMatrix4a, boost::alignment::aligned_allocator<LLMatrix4a, 16> > matrix_list_t;
+    typedef std::vector<LLVector4a, boost::alignment::aligned_allocator<LLVector4a, 16> > vector_list_t;
+
+    // a rotation, a translation and a little scale, like a posed joint
+    LLMatrix4a random_transform()
+    {
+        LLVector3 axis(ll_frand() - 0.5f, ll_frand() - 0.5f, ll_frand() - 0.5f);
+        axis.normVec();
+        LLMatrix4 mat4(LLQuaternion(ll_frand(F_TWO_PI), axis),
+                       LLVector4(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f));
+        LLMatrix4a mat;
+        mat.loadu(mat4);
+        mat.mMatrix[0].mul(0.9f + ll_frand(0.2f));
+        return mat;
+    }
+
+    LLMeshSkinInfo* make_skin(S32 joints)
+    {
+        LLMeshSkinInfo* skin = new LLMeshSkinInfo();
+        for (S32 j = 0; j < joints; ++j)
+        {
+            skin->mJointNames.push_back(llformat("mJoint%d", j));
+            skin->mJointNums.push_back(j);
+            skin->mInvBindMatrix.push_back(random_transform());
+        }
+        skin->mJointNumsInitialized = true;
+        skin->mBindShapeMatrix = random_transform();
+        return skin;
+    }
+
+    // Mostly one or two joints per vertex, like exported meshes, with the
+    // rest of the four slots packed as joint 0 with no weight, the way
+    // LLVolume::unpackVolumeFaces() leaves them.
+    LLVector4a random_weights(S32 joints)
+    {
+        S32 influences = ll_frand() < 0.6f ? 1 + (ll_rand() % 2) : 3 + (ll_rand() % 2);
+        F32 packed[4] = { 0.f, 0.f, 0.f, 0.f };
+        for (S32 k = 0; k < influences; ++k)
+        {
+            packed[k] = (F32) (ll_rand() % joints) + 0.05f + ll_frand(0.9f);
+        }
+        LLVector4a weights;
+        weights.loadua(packed);
+        return weights;
+    }
+
+    void make_vertices(S32 count, S32 joints, vector_list_t& positions, vector_list_t& weights)
+    {
+        positions.resize(count);
+        weights.resize(count);
+        for (S32 i = 0; i < count; ++i)
+        {
+            positions[i].set(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f);
+            weights[i] = random_weights(joints);
+        }
+    }
+
+    // what updateRiggedVolume() used to do for every vertex
+    void skin_reference(const vector_list_t& positions, vector_list_t& weights, const LLMatrix4a* mat,
+                        U32 joints, const LLMatrix4a& bind_shape, vector_list_t& out)
+    {
+        out.resize(positions.size());
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            LLMatrix4a final_mat;
+            LLSkinningUtil::getPerVertexSkinMatrix(weights[i].getF32ptr(), mat, false, final_mat, joints);
+            LLVector4a t;
+            bind_shape.affineTransform(positions[i], t);
+            final_mat.affineTransform(t, out[i]);
+        }
+    }
+}
+
+namespace tut
+{
+    struct LLSkinningUtilTest
+    {
+    };
+    typedef test_group<LLSkinningUtilTest> LLSkinningUtilTest_factory;
+    typedef LLSkinningUtilTest_factory::object LLSkinningUtilTest_t;
+    LLSkinningUtilTest_factory tf("LLSkinningUtil");
+
+    template<> template<>
+    void LLSkinningUtilTest_t::test<1>()
+    {
+        set_test_name("skinPositions matches blended skin matrices");
+
+        const S32 JOINTS = 40;
+        LLPointer<LLMeshSkinInfo> skin = make_skin(JOINTS);
+        matrix_list_t mat(JOINTS);
+        for (S32 j = 0; j < JOINTS; ++j)
+        {
+            mat[j] = random_transform();
+        }
+
+        vector_list_t positions, weights, expected;
+        make_vertices(1000, JOINTS, positions, weights);
+        skin_reference(positions, weights, &mat[0], JOINTS, skin->mBindShapeMatrix, expected);
+
+        matrix_list_t bound(JOINTS);
+        LLSkinningUtil::bindSkinningMatrixPalette(&bound[0], &mat[0], JOINTS, skin->mBindShapeMatrix);
+        vector_list_t skinned(positions.size());
+        LLSkinningUtil::skinPositions(&positions[0], &weights[0], positions.size(), &bound[0], JOINTS, &skinned[0]);
+
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            LLVector4a diff;
+            diff.setSub(skinned[i], expected[i]);
+            ensure("vertex " + std::to_string(i), diff.getLength3().getF32() < 1.e-4f);
+        }
+    }
+
+    template<> template<>
+    void LLSkinningUtilTest_t::test<2>()
+    {
+        set_test_name("updateRiggingInfo extents");
+
+        const S32 JOINTS = 20;
+        const S32 VERTICES = 500;
+        LLPointer<LLMeshSkinInfo> skin = make_skin(JOINTS);
+        vector_list_t positions, weights;
+        make_vertices(VERTICES, JOINTS, positions, weights);
+
+        LLVolumeFace face;
+        face.resizeVertices(VERTICES);
+        face.allocateWeights(VERTICES);
+        std::copy(positions.begin(), positions.end(), face.mPositions);
+        std::copy(weights.begin(), weights.end(), face.mWeights);
+        LLSkinningUtil::updateRiggingInfo(skin, NULL, face);
+        ensure("updated", !face.mJointRiggingInfoTab.needsUpdate());
+
+        // each weighted vertex, in the space of each joint it's weighted to
+        LLVector4a extents[JOINTS][2];
+        bool rigged[JOINTS] = { false };
+        for (S32 j = 0; j < JOINTS; ++j)
+        {
+            extents[j][0].clear();
+            extents[j][1].clear();
+        }
+        for (S32 i = 0; i < VERTICES; ++i)
+        {
+            F32* packed = weights[i].getF32ptr();
+            F32 sum = 0.f;
+            for (S32 k = 0; k < 4; ++k)
+            {
+                sum += packed[k] - floorf(packed[k]);
+            }
+            for (S32 k = 0; k < 4; ++k)
+            {
+                S32 j = (S32) floorf(packed[k]);
+                F32 w = (packed[k] - j) / sum;
+                if (w > 0.f)
+                {
+                    LLMatrix4a mat;
+                    matMul(skin->mBindShapeMatrix, skin->mInvBindMatrix[j], mat);
+                    LLVector4a p;
+                    mat.affineTransform(positions[i], p);
+                    p.mul(w);
+                    update_min_max(extents[j][0], extents[j][1], p);
+                    rigged[j] = true;
+                }
+            }
+        }
+
+        for (S32 j = 0; j < JOINTS; ++j)
+        {
+            const LLJointRiggingInfo& info = face.mJointRiggingInfoTab[j];
+            ensure_equals("rigged to joint " + std::to_string(j), info.isRiggedTo(), rigged[j]);
+            for (S32 e = 0; e < 2; ++e)
+            {
+                LLVector4a diff;
+                diff.setSub(info.getRiggedExtents()[e], extents[j][e]);
+                ensure("extents of joint " + std::to_string(j), diff.getLength3().getF32() < 1.e-4f);
+            }
+        }
+    }
+
+    template<> template<>
+    void LLSkinningUtilTest_t::test<3>()
+    {
+        set_test_name("skin a 100k vertex avatar, blended matrices vs skinPositions");
+
+        const S32 JOINTS = 110;
+        const S32 VERTICES = 100000;
+        const S32 PASSES = 20;
+        LLPointer<LLMeshSkinInfo> skin = make_skin(JOINTS);
+        matrix_list_t mat(JOINTS);
+        for (S32 j = 0; j < JOINTS; ++j)
+        {
+            mat[j] = random_transform();
+        }
+        vector_list_t positions, weights, expected, skinned(VERTICES);
+        make_vertices(VERTICES, JOINTS, positions, weights);
+
+        typedef std::chrono::duration<double, std::milli> ms_t;
+        auto start = std::chrono::steady_clock::now();
+        for (S32 pass = 0; pass < PASSES; ++pass)
+        {
+            skin_reference(positions, weights, &mat[0], JOINTS, skin->mBindShapeMatrix, expected);
+        }
+        ms_t reference = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        matrix_list_t bound(JOINTS);
+        for (S32 pass = 0; pass < PASSES; ++pass)
+        {
+            LLSkinningUtil::bindSkinningMatrixPalette(&bound[0], &mat[0], JOINTS, skin->mBindShapeMatrix);
+            LLSkinningUtil::skinPositions(&positions[0], &weights[0], VERTICES, &bound[0], JOINTS, &skinned[0]);
+        }
+        ms_t kernel = std::chrono::steady_clock::now() - start;
+
+        LL_INFOS() << VERTICES << " vertices: " << reference.count() / PASSES << " ms blending matrices, "
+                   << kernel.count() / PASSES << " ms with skinPositions" << LL_ENDL;
+
+        F32 max_error = 0.f;
+        for (S32 i = 0; i < VERTICES; ++i)
+        {
+            LLVector4a diff;
+            diff.setSub(skinned[i], expected[i]);
+            max_error = llmax(max_error, diff.getLength3().getF32());
+        }
+        ensure("same positions", max_error < 1.e-4f);
+    }
+}
@@ -0,0 +1,282 @@
+/**
+ * @file llvieweroctree_test.cpp
+ * @brief Tests and timing of LLViewerOctreeCull::precull()
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "../llviewerprecompiledheaders.h"
+#include "../test/lltut.h"
+
+#include "../llvieweroctree.h"
+
+#include "llcontrol.h"
+#include "llgl.h"
+#include "llglslshader.h"
+#include "llrand.h"
+#include "lltimer.h"
+#include "llvertexbuffer.h"
+#include "threadpool.h"
+
+//----------------------------------------------------------------------------
+// Mock objects for the dependencies of the code we're testing, only the
+// occlusion queries use them
+class LLPipeline
+{
+public:
+    static S32 sUseOcclusion;
+};
+S32 LLPipeline::sUseOcclusion = 0;
+LLPipeline gPipeline;
+
+LLControlGroup gSavedSettings("Global");
+U32 gFrameCount = 0;
+LLViewerCamera::eCameraID LLViewerCamera::sCurCameraID = LLViewerCamera::CAMERA_WORLD;
+
+LLGLManager::LLGLManager() {}
+LLGLManager gGLManager;
+LLGLState::LLGLState(LLGLenum state, S32 enabled) {}
+LLGLState::~LLGLState() {}
+LLGLSquashToFarClip::LLGLSquashToFarClip() {}
+LLGLSquashToFarClip::~LLGLSquashToFarClip() {}
+
+LLGLSLShader* LLGLSLShader::sCurBoundShaderPtr = NULL;
+void LLGLSLShader::uniform3f(U32 index, GLfloat x, GLfloat y, GLfloat z) {}
+void LLGLSLShader::uniform3fv(U32 index, U32 count, const GLfloat* v) {}
+
+LLVertexBuffer::LLVertexBuffer(U32 typemask) : LLRefCount(), mTypeMask(typemask) {}
+LLVertexBuffer::~LLVertexBuffer() {}
+bool LLVertexBuffer::allocateBuffer(U32 nverts, U32 nindices) { return false; }
+bool LLVertexBuffer::getVertexStrider(LLStrider<LLVector3>& strider, U32 index, S32 count) { return false; }
+bool LLVertexBuffer::getIndexStrider(LLStrider<U16>& strider, U32 index, S32 count) { return false; }
+void LLVertexBuffer::unmapBuffer() {}
+void LLVertexBuffer::drawRange(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset) const {}
+
+namespace
+{
+    class TestEntryData : public LLViewerOctreeEntryData
+    {
+    public:
+        TestEntryData() : LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY) {}
+    };
+
+    // Culls to an axis aligned box, which like the camera checks of the
+    // partition cullers only reads group bounds
+    class BoxCull : public LLViewerOctreeCull
+    {
+    public:
+        BoxCull(LLCamera* camera, const LLVector4a& center, const LLVector4a& size)
+        :   LLViewerOctreeCull(camera),
+            mCenter(center),
+            mSize(size)
+        {
+        }
+
+        std::vector<LLViewerOctreeGroup*> mVisited;
+
+    protected:
+        S32 check(const LLVector4a* bounds) const
+        {
+            LLVector4a offset;
+            offset.setSub(bounds[0], mCenter);
+            offset.setAbs(offset);
+
+            LLVector4a reach;
+            reach.setAdd(mSize, bounds[1]);
+            if (offset.greaterThan(reach).areAnySet(LLVector4Logical::MASK_XYZ))
+            {
+                return 0;
+            }
+
+            LLVector4a inner;
+            inner.setSub(mSize, bounds[1]);
+            return offset.lessEqual(inner).areAllSet(LLVector4Logical::MASK_XYZ) ? 2 : 1;
+        }
+
+        S32 frustumCheck(const LLViewerOctreeGroup* group) override
+        {
+            return check(group->getBounds());
+        }
+
+        S32 frustumCheckObjects(const LLViewerOctreeGroup* group) override
+        {
+            return check(group->getObjectBounds());
+        }
+
+        void processGroup(LLViewerOctreeGroup* group) override
+        {
+            mVisited.push_back(group);
+        }
+
+    private:
+        LLVector4a mCenter;
+        LLVector4a mSize;
+    };
+
+    LLVector4a random_point(F32 range)
+    {
+        LLVector4a point;
+        point.set(ll_frand(range), ll_frand(range), ll_frand(range) * 0.25f);
+        return point;
+    }
+}
+
+namespace tut
+{
+    struct viewerOctreeData
+    {
+        viewerOctreeData()
+        {
+            gOctreeMaxCapacity = 128;
+            gOctreeMinSize = 0.01f;
+
+            LLVector4a center, size;
+            center.splat(0.f);
+            size.splat(1.f);
+            mOctree = new OctreeRoot(center, size, NULL);
+            new LLViewerOctreeGroup(mOctree);
+        }
+
+        ~viewerOctreeData()
+        {
+            // the groups let go of the entries as the tree goes
+            delete mOctree;
+            mData.clear();
+        }
+
+        // count objects scattered over a region, mostly small and near the
+        // ground like region content
+        void fill(U32 count)
+        {
+            mData.reserve(count);
+            for (U32 i = 0; i < count; ++i)
+            {
+                LLVector4a center = random_point(256.f);
+                const F32 radius = ll_frand() < 0.95f ? 0.25f + ll_frand(2.f) : 4.f + ll_frand(16.f);
+                LLVector4a half;
+                half.splat(radius);
+                LLVector4a min, max;
+                min.setSub(center, half);
+                max.setAdd(center, half);
+
+                LLPointer<TestEntryData> data = new TestEntryData();
+                data->setOctreeEntry(NULL);
+                data->setSpatialExtents(min, max);
+                data->setPositionGroup(center);
+                data->setBinRadius(radius);
+                mOctree->insert(data->getEntry());
+                mData.push_back(data);
+            }
+            ((LLViewerOctreeGroup*) mOctree->getListener(0))->rebound();
+        }
+
+        OctreeRoot* mOctree;
+        std::vector<LLPointer<TestEntryData> > mData;
+        LLCamera mCamera;
+    };
+    typedef test_group<viewerOctreeData> viewer_octree_t;
+    typedef viewer_octree_t::object viewer_octree_object_t;
+    tut::viewer_octree_t tut_viewer_octree("LLViewerOctree");
+
+    template<> template<>
+    void viewer_octree_object_t::test<1>()
+    {
+        set_test_name("precull visits the same groups as a serial cull");
+
+        LL::ThreadPool pool("General", 3);
+        pool.start();
+
+        fill(20000);
+
+        S32 split = 0;
+        for (S32 i = 0; i < 200; ++i)
+        {
+            LLVector4a center = random_point(256.f);
+            LLVector4a size;
+            size.set(8.f + ll_frand(120.f), 8.f + ll_frand(120.f), 8.f + ll_frand(64.f));
+
+            BoxCull serial(&mCamera, center, size);
+            serial.traverse(mOctree);
+
+            BoxCull parallel(&mCamera, center, size);
+            if (parallel.precull(mOctree))
+            {
+                ++split;
+            }
+            parallel.traverse(mOctree);
+
+            ensure_equals("same number of groups", parallel.mVisited.size(), serial.mVisited.size());
+            ensure("same groups in the same order", parallel.mVisited == serial.mVisited);
+        }
+        ensure("tree was split for the thread pool", split > 0);
+
+        pool.close();
+    }
+
+    template<> template<>
+    void viewer_octree_object_t::test<2>()
+    {
+        set_test_name("precull timing");
+
+        const S32 CULLS = 200;
+
+        LL::ThreadPool pool("General", 3);
+        pool.start();
+
+        fill(200000);
+
+        std::vector<std::pair<LLVector4a, LLVector4a> > boxes;
+        for (S32 i = 0; i < CULLS; ++i)
+        {
+            LLVector4a size;
+            size.set(32.f + ll_frand(96.f), 32.f + ll_frand(96.f), 16.f + ll_frand(48.f));
+            boxes.push_back(std::make_pair(random_point(256.f), size));
+        }
+
+        size_t serial_groups = 0;
+        LLTimer timer;
+        for (S32 i = 0; i < CULLS; ++i)
+        {
+            BoxCull culler(&mCamera, boxes[i].first, boxes[i].second);
+            culler.traverse(mOctree);
+            serial_groups += culler.mVisited.size();
+        }
+        const F64 serial_time = timer.getElapsedTimeAndResetF64();
+
+        size_t parallel_groups = 0;
+        for (S32 i = 0; i < CULLS; ++i)
+        {
+            BoxCull culler(&mCamera, boxes[i].first, boxes[i].second);
+            culler.precull(mOctree);
+            culler.traverse(mOctree);
+            parallel_groups += culler.mVisited.size();
+        }
+        const F64 parallel_time = timer.getElapsedTimeF64();
+
+        ensure_equals("same groups", parallel_groups, serial_groups);
+
+        LL_INFOS() << CULLS << " culls of " << mData.size() << " entries visiting " << serial_groups / CULLS
+                   << " groups each. Serial: " << serial_time * 1000.0 / CULLS << " ms each. With precull on "
+                   << pool.getWidth() << " threads: " << parallel_time * 1000.0 / CULLS << " ms each." << LL_ENDL;
+
+        pool.close();
+    }
+}
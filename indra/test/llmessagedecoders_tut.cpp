@@ -0,0 +1,421 @@
+/**
+ * @file llmessagedecoders_tut.cpp
+ * @brief Tests and benchmark of the generated message decoders
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "llapr.h"
+#include "llmessagedecoders.h"
+#include "llmessagetestdecoders.h"
+#include "llmessagetemplate.h"
+#include "llmessagetemplateparser.h"
+#include "llrand.h"
+#include "lltemplatemessagebuilder.h"
+#include "lltemplatemessagereader.h"
+#include "lltimer.h"
+#include "message_prehash.h"
+
+namespace tut
+{
+	static LLTemplateMessageBuilder::message_template_name_map_t decoderNameMap;
+	static LLTemplateMessageReader::message_template_number_map_t decoderNumberMap;
+
+	static void null_handler(LLMessageSystem*, void**)
+	{
+	}
+
+	// A message as the template reader is handed it
+	struct LLBuiltMessage
+	{
+		U8 mBuffer[MAX_BUFFER_SIZE];
+		S32 mSize;
+	};
+
+	struct LLMessageDecodersTestData
+	{
+		LLMessageDecodersTestData()
+		{
+			static bool init = false;
+			if (!init)
+			{
+				// the reader reports through gMessageSystem
+				if (!gMessageSystem)
+				{
+					ll_init_apr();
+					start_messaging_system("notafile", 13035,
+										   1,
+										   0,
+										   0,
+										   FALSE,
+										   "notasharedsecret",
+										   NULL,
+										   false,
+										   5,
+										   100);
+				}
+
+				std::ifstream file(MESSAGE_TEMPLATE_FILE);
+				std::stringstream contents;
+				contents << file.rdbuf();
+				LLTemplateTokenizer tokens(contents.str());
+				LLTemplateParser parser(tokens);
+				for (LLTemplateParser::message_iterator iter = parser.getMessagesBegin();
+					 iter != parser.getMessagesEnd(); ++iter)
+				{
+					LLMessageTemplate* templatep = *iter;
+					templatep->setHandlerFunc(null_handler, NULL);
+					decoderNameMap[templatep->mName] = templatep;
+					decoderNumberMap[templatep->mMessageNumber] = templatep;
+				}
+				init = true;
+			}
+		}
+
+		static LLMessageTemplate* getTemplate(const char* name)
+		{
+			LLMessageTemplate* templatep = decoderNameMap[name];
+			ensure(std::string("template for ") + name, templatep != NULL);
+			return templatep;
+		}
+
+		// Fills every variable of the message, with Variable blocks
+		// repeated block_count times and Variable fields variable_size
+		// long, with made up but well formed values
+		static void build(const char* name, S32 block_count, S32 variable_size, LLBuiltMessage& built)
+		{
+			LLMessageTemplate* templatep = getTemplate(name);
+			LLTemplateMessageBuilder builder(decoderNameMap);
+			builder.newMessage(name);
+
+			U8 data[MAX_BUFFER_SIZE];
+			for (LLMessageTemplate::message_block_map_t::const_iterator block_iter = templatep->mMemberBlocks.begin();
+				 block_iter != templatep->mMemberBlocks.end(); ++block_iter)
+			{
+				const LLMessageBlock* blockp = *block_iter;
+				S32 repeats = 1;
+				if (blockp->mType == MBT_MULTIPLE)
+				{
+					repeats = blockp->mNumber;
+				}
+				else if (blockp->mType == MBT_VARIABLE)
+				{
+					repeats = block_count;
+				}
+
+				for (S32 i = 0; i < repeats; ++i)
+				{
+					builder.nextBlock(blockp->mName);
+					for (LLMessageBlock::message_variable_map_t::const_iterator var_iter = blockp->mMemberVariables.begin();
+						 var_iter != blockp->mMemberVariables.end(); ++var_iter)
+					{
+						const LLMessageVariable* varp = *var_iter;
+						S32 size = varp->getSize();
+						if (varp->getType() == MVT_VARIABLE)
+						{
+							size = (size == 1) ? llmin(variable_size, 255) : variable_size;
+						}
+
+						switch (varp->getType())
+						{
+						case MVT_F32:
+						case MVT_LLVector3:
+						case MVT_LLVector4:
+						case MVT_LLQuaternion:
+							// finite floats, so a quaternion round trips
+							for (S32 f = 0; f < size / (S32)sizeof(F32); ++f)
+							{
+								F32 value = ll_frand(0.5f);
+								memcpy(data + f * sizeof(F32), &value, sizeof(F32));
+							}
+							break;
+						case MVT_F64:
+						case MVT_LLVector3d:
+							for (S32 f = 0; f < size / (S32)sizeof(F64); ++f)
+							{
+								F64 value = ll_drand(256.0);
+								memcpy(data + f * sizeof(F64), &value, sizeof(F64));
+							}
+							break;
+						default:
+							for (S32 b = 0; b < size; ++b)
+							{
+								data[b] = (U8)ll_rand(256);
+							}
+							break;
+						}
+						builder.addBinaryData(varp->getName(), data, size);
+					}
+				}
+			}
+
+			memset(built.mBuffer, 0, LL_PACKET_ID_SIZE);
+			built.mSize = builder.buildMessage(built.mBuffer, MAX_BUFFER_SIZE, 0);
+		}
+
+		// What a handler pays with the template reader: decodeData()
+		// building LLMsgData, then a lookup by name for every variable
+		static void readAll(LLTemplateMessageReader& reader, const LLBuiltMessage& built)
+		{
+			reader.validateMessage(built.mBuffer, built.mSize, LLHost());
+			reader.readMessage(built.mBuffer, LLHost());
+
+			const LLMessageTemplate* templatep = getTemplate(reader.getMessageName());
+			U8 data[MAX_BUFFER_SIZE];
+			for (LLMessageTemplate::message_block_map_t::const_iterator block_iter = templatep->mMemberBlocks.begin();
+				 block_iter != templatep->mMemberBlocks.end(); ++block_iter)
+			{
+				const LLMessageBlock* blockp = *block_iter;
+				const S32 repeats = reader.getNumberOfBlocks(blockp->mName);
+				for (S32 i = 0; i < repeats; ++i)
+				{
+					for (LLMessageBlock::message_variable_map_t::const_iterator var_iter = blockp->mMemberVariables.begin();
+						 var_iter != blockp->mMemberVariables.end(); ++var_iter)
+					{
+						const LLMessageVariable* varp = *var_iter;
+						const S32 size = reader.getSize(blockp->mName, i, varp->getName());
+						if (size > 0)
+						{
+							reader.getBinaryData(blockp->mName, varp->getName(), data, size, i);
+						}
+					}
+				}
+			}
+			reader.clearMessage();
+		}
+
+		// Replays built through both, returns nanoseconds per message
+		template<class DECODED>
+		static void benchmark(const char* name, const LLBuiltMessage& built, F64& read_ns, F64& decode_ns)
+		{
+			const S32 REPEATS = 20000;
+			LLTemplateMessageReader reader(decoderNumberMap);
+			LLMessageTemplate* templatep = getTemplate(name);
+			LLTimer timer;
+
+			timer.reset();
+			for (S32 i = 0; i < REPEATS; ++i)
+			{
+				readAll(reader, built);
+			}
+			read_ns = timer.getElapsedTimeF64() * 1e9 / REPEATS;
+
+			// as registered with setDecodingHandlerFuncFast()
+			templatep->mHandlerDecodes = true;
+			DECODED decoded;
+			bool decoded_all = true;
+			timer.reset();
+			for (S32 i = 0; i < REPEATS; ++i)
+			{
+				reader.validateMessage(built.mBuffer, built.mSize, LLHost());
+				reader.readMessage(built.mBuffer, LLHost());
+				decoded_all &= decoded.decode(built.mBuffer, built.mSize);
+				reader.clearMessage();
+			}
+			decode_ns = timer.getElapsedTimeF64() * 1e9 / REPEATS;
+			templatep->mHandlerDecodes = false;
+
+			ensure(std::string("decoded ") + name, decoded_all);
+			LL_INFOS() << name << " (" << built.mSize << " bytes): template reader "
+					   << read_ns << " ns, generated decoder " << decode_ns << " ns" << LL_ENDL;
+		}
+	};
+	typedef test_group<LLMessageDecodersTestData> LLMessageDecodersTestGroup;
+	typedef LLMessageDecodersTestGroup::object LLMessageDecodersTestObject;
+	LLMessageDecodersTestGroup messageDecodersTestGroup("LLMessageDecoders");
+
+	template<> template<>
+	void LLMessageDecodersTestObject::test<1>()
+		// CoarseLocationUpdate decodes to what the template reader reads
+	{
+		LLBuiltMessage built;
+		build(_PREHASH_CoarseLocationUpdate, 50, 0, built);
+
+		LLDecodedCoarseLocationUpdate decoded;
+		ensure("decode", decoded.decode(built.mBuffer, built.mSize));
+
+		LLTemplateMessageReader reader(decoderNumberMap);
+		reader.validateMessage(built.mBuffer, built.mSize, LLHost());
+		reader.readMessage(built.mBuffer, LLHost());
+
+		S16 you, prey;
+		reader.getS16(_PREHASH_Index, _PREHASH_You, you);
+		reader.getS16(_PREHASH_Index, _PREHASH_Prey, prey);
+		ensure_equals("You", decoded.mIndex.mYou, you);
+		ensure_equals("Prey", decoded.mIndex.mPrey, prey);
+
+		ensure_equals("Location count", (S32)decoded.mLocation.size(), reader.getNumberOfBlocks(_PREHASH_Location));
+		ensure_equals("AgentData count", (S32)decoded.mAgentData.size(), reader.getNumberOfBlocks(_PREHASH_AgentData));
+		for (S32 i = 0; i < (S32)decoded.mLocation.size(); ++i)
+		{
+			U8 x, y, z;
+			reader.getU8(_PREHASH_Location, _PREHASH_X, x, i);
+			reader.getU8(_PREHASH_Location, _PREHASH_Y, y, i);
+			reader.getU8(_PREHASH_Location, _PREHASH_Z, z, i);
+			ensure_equals("X", decoded.mLocation[i].mX, x);
+			ensure_equals("Y", decoded.mLocation[i].mY, y);
+			ensure_equals("Z", decoded.mLocation[i].mZ, z);
+
+			LLUUID agent_id;
+			reader.getUUID(_PREHASH_AgentData, _PREHASH_AgentID, agent_id, i);
+			ensure_equals("AgentID", decoded.mAgentData[i].mAgentID, agent_id);
+		}
+	}
+
+	template<> template<>
+	void LLMessageDecodersTestObject::test<2>()
+		// ObjectUpdate, with Variable fields between fixed ones
+	{
+		LLBuiltMessage built;
+		build(_PREHASH_ObjectUpdate, 3, 40, built);
+
+		LLDecodedObjectUpdate decoded;
+		ensure("decode", decoded.decode(built.mBuffer, built.mSize));
+
+		LLTemplateMessageReader reader(decoderNumberMap);
+		reader.validateMessage(built.mBuffer, built.mSize, LLHost());
+		reader.readMessage(built.mBuffer, LLHost());
+
+		U64 region_handle;
+		U16 time_dilation;
+		reader.getU64(_PREHASH_RegionData, _PREHASH_RegionHandle, region_handle);
+		reader.getU16(_PREHASH_RegionData, _PREHASH_TimeDilation, time_dilation);
+		ensure_equals("RegionHandle", decoded.mRegionData.mRegionHandle, region_handle);
+		ensure_equals("TimeDilation", decoded.mRegionData.mTimeDilation, time_dilation);
+
+		ensure_equals("ObjectData count", (S32)decoded.mObjectData.size(), 3);
+		for (S32 i = 0; i < 3; ++i)
+		{
+			const LLDecodedObjectUpdate::ObjectData& object = decoded.mObjectData[i];
+
+			U32 id;
+			LLUUID full_id;
+			LLVector3 scale, axis;
+			U8 text_color[4];
+			reader.getU32(_PREHASH_ObjectData, _PREHASH_ID, id, i);
+			reader.getUUID(_PREHASH_ObjectData, _PREHASH_FullID, full_id, i);
+			reader.getVector3(_PREHASH_ObjectData, _PREHASH_Scale, scale, i);
+			reader.getVector3(_PREHASH_ObjectData, _PREHASH_JointAxisOrAnchor, axis, i);
+			reader.getBinaryData(_PREHASH_ObjectData, _PREHASH_TextColor, text_color, sizeof(text_color), i);
+			ensure_equals("ID", object.mID, id);
+			ensure_equals("FullID", object.mFullID, full_id);
+			ensure_equals("Scale", object.mScale, scale);
+			ensure_equals("JointAxisOrAnchor", object.mJointAxisOrAnchor, axis);
+			ensure("TextColor", !memcmp(object.mTextColor, text_color, sizeof(text_color)));
+
+			U8 texture_entry[MAX_BUFFER_SIZE];
+			S32 size = reader.getSize(_PREHASH_ObjectData, i, _PREHASH_TextureEntry);
+			reader.getBinaryData(_PREHASH_ObjectData, _PREHASH_TextureEntry, texture_entry, size, i);
+			ensure_equals("TextureEntry size", object.mTextureEntry.mSize, size);
+			ensure("TextureEntry", !memcmp(object.mTextureEntry.mData, texture_entry, size));
+		}
+	}
+
+	template<> template<>
+	void LLMessageDecodersTestObject::test<3>()
+		// short and mismatched messages
+	{
+		LLBuiltMessage built;
+		build(_PREHASH_CoarseLocationUpdate, 4, 0, built);
+
+		LLDecodedCoarseLocationUpdate coarse;
+		ensure("cut short", !coarse.decode(built.mBuffer, built.mSize - 1));
+
+		LLDecodedLayerData layer;
+		ensure("another message", !layer.decode(built.mBuffer, built.mSize));
+
+		// Variable blocks missing from the end mean none, as for the
+		// template reader
+		build(_PREHASH_CoarseLocationUpdate, 0, 0, built);
+		ensure("missing trailing block", coarse.decode(built.mBuffer, built.mSize - 1));
+		ensure("no locations", coarse.mLocation.empty());
+		ensure("no agents", coarse.mAgentData.empty());
+	}
+
+	template<> template<>
+	void LLMessageDecodersTestObject::test<4>()
+		// benchmark against the template reader
+	{
+		LLBuiltMessage built;
+		F64 read_ns, decode_ns;
+
+		build(_PREHASH_ObjectUpdate, 4, 40, built);
+		benchmark<LLDecodedObjectUpdate>(_PREHASH_ObjectUpdate, built, read_ns, decode_ns);
+
+		build(_PREHASH_ImprovedTerseObjectUpdate, 15, 60, built);
+		benchmark<LLDecodedImprovedTerseObjectUpdate>(_PREHASH_ImprovedTerseObjectUpdate, built, read_ns, decode_ns);
+
+		build(_PREHASH_LayerData, 1, 900, built);
+		benchmark<LLDecodedLayerData>(_PREHASH_LayerData, built, read_ns, decode_ns);
+
+		build(_PREHASH_CoarseLocationUpdate, 50, 0, built);
+		benchmark<LLDecodedCoarseLocationUpdate>(_PREHASH_CoarseLocationUpdate, built, read_ns, decode_ns);
+
+		build(_PREHASH_AvatarAnimation, 8, 0, built);
+		benchmark<LLDecodedAvatarAnimation>(_PREHASH_AvatarAnimation, built, read_ns, decode_ns);
+	}
+
+	template<> template<>
+	void LLMessageDecodersTestObject::test<5>()
+		// getters still work after a handler decoded the message itself
+	{
+		LLBuiltMessage built;
+		build(_PREHASH_CoarseLocationUpdate, 10, 0, built);
+
+		LLMessageTemplate* templatep = getTemplate(_PREHASH_CoarseLocationUpdate);
+		templatep->mHandlerDecodes = true;
+
+		LLTemplateMessageReader reader(decoderNumberMap);
+		reader.validateMessage(built.mBuffer, built.mSize, LLHost());
+		reader.readMessage(built.mBuffer, LLHost());
+
+		LLDecodedCoarseLocationUpdate decoded;
+		ensure("decode", decoded.decode(built.mBuffer, built.mSize));
+
+		// as another listener, logging or forwarding would
+		ensure_equals("Location count", reader.getNumberOfBlocks(_PREHASH_Location), (S32)decoded.mLocation.size());
+		U8 x;
+		reader.getU8(_PREHASH_Location, _PREHASH_X, x, 9);
+		ensure_equals("X", x, decoded.mLocation[9].mX);
+		S16 you;
+		reader.getS16(_PREHASH_Index, _PREHASH_You, you);
+		ensure_equals("You", you, decoded.mIndex.mYou);
+
+		LLTemplateMessageBuilder builder(decoderNameMap);
+		reader.copyToBuilder(builder);
+		U8 copied[MAX_BUFFER_SIZE];
+		memset(copied, 0, LL_PACKET_ID_SIZE);
+		ensure_equals("copied size", builder.buildMessage(copied, MAX_BUFFER_SIZE, 0), built.mSize);
+		ensure("copied", !memcmp(copied + LL_PACKET_ID_SIZE, built.mBuffer + LL_PACKET_ID_SIZE,
+								 built.mSize - LL_PACKET_ID_SIZE));
+
+		reader.clearMessage();
+		templatep->mHandlerDecodes = false;
+	}
+}
@@ -0,0 +1,322 @@
+#!/usr/bin/env python3
+"""\
+@file generate_message_decoders.py
+@brief Generates typed C++ decoders for messages in message_template.msg.
+
+$LicenseInfo:firstyear=2024&license=viewerlgpl$
+Second Life Viewer Source Code
+Copyright (C) 2024, Linden Research, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+$/LicenseInfo$
+"""
+
+"""generate_message_decoders writes a header with a struct per named
+message, LLDecoded<Message>, holding the message's blocks and variables as
+plain members, and an inline decode() that fills it straight from the
+packet. Runs of fixed size variables are bounds checked once and read at
+offsets worked out here, so handlers never go through the string keyed
+lookups of LLTemplateMessageReader.
+
+usage: generate_message_decoders.py TEMPLATE OUTPUT MESSAGE [MESSAGE ...]
+"""
+
+import sys
+import os.path
+
+def add_indra_lib_path():
+    root = os.path.realpath(__file__)
+    dir = os.path.dirname(root)
+    if dir not in sys.path:
+        sys.path.insert(0, dir)
+
+    # look for indra/lib/python in the parent directories
+    while root != os.path.sep:
+        root = os.path.dirname(root)
+        dir = os.path.join(root, 'indra', 'lib', 'python')
+        if os.path.isdir(dir):
+            if dir not in sys.path:
+                sys.path.insert(0, dir)
+            break
+    else:
+        print("This script is not inside a valid installation.", file=sys.stderr)
+        sys.exit(1)
+
+add_indra_lib_path()
+
+from indra.ipc import llmessage
+from indra.ipc.llmessage import Message, Block, Variable
+
+# bytes of message number for each frequency
+FREQUENCY_SIZES = {
+    Message.HIGH: 1,
+    Message.MEDIUM: 2,
+    Message.LOW: 4,
+    Message.FIXED: 4,
+    }
+
+# C++ type and wire size of each fixed size variable type
+FIXED_TYPES = {
+    Variable.U8: ('U8', 1),
+    Variable.U16: ('U16', 2),
+    Variable.U32: ('U32', 4),
+    Variable.U64: ('U64', 8),
+    Variable.S8: ('S8', 1),
+    Variable.S16: ('S16', 2),
+    Variable.S32: ('S32', 4),
+    Variable.S64: ('S64', 8),
+    Variable.F32: ('F32', 4),
+    Variable.F64: ('F64', 8),
+    Variable.LLVECTOR3: ('LLVector3', 12),
+    Variable.LLVECTOR3D: ('LLVector3d', 24),
+    Variable.LLVECTOR4: ('LLVector4', 16),
+    Variable.LLQUATERNION: ('LLQuaternion', 12),
+    Variable.LLUUID: ('LLUUID', 16),
+    Variable.BOOL: ('BOOL', 1),
+    Variable.IPADDR: ('U32', 4),
+    Variable.IPPORT: ('U16', 2),
+    }
+
+HEADER = """\
+/**
+ * @file %(file)s
+ * @brief Decoders for %(messages)s
+ *
+ * Generated by scripts/generate_message_decoders.py from
+ * %(template)s. Do not edit.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef %(guard)s
+#define %(guard)s
+
+#include <vector>
+
+#include "llmessagedecoder.h"
+#include "lluuid.h"
+#include "v3dmath.h"
+#include "v4math.h"
+"""
+
+FOOTER = """
+#endif // %(guard)s
+"""
+
+def message_number(message):
+    if message.priority == Message.HIGH:
+        return message.number
+    if message.priority == Message.MEDIUM:
+        return 0xFF00 | message.number
+    return 0xFFFF0000 | (message.number & 0xFFFF)
+
+def member(name):
+    return 'm' + name
+
+def declare_variable(variable):
+    if variable.type == Variable.FIXED:
+        return 'U8 %s[%s];' % (member(variable.name), variable.size)
+    if variable.type == Variable.VARIABLE:
+        return 'LLDecodedBytes %s;' % member(variable.name)
+    return '%s %s;' % (FIXED_TYPES[variable.type][0], member(variable.name))
+
+def fixed_size(variable):
+    if variable.type == Variable.FIXED:
+        return int(variable.size)
+    return FIXED_TYPES[variable.type][1]
+
+def read_fixed(variable, offset):
+    target = 'block.' + member(variable.name)
+    source = 'data + %d' % offset
+    if variable.type == Variable.FIXED:
+        return 'memcpy(%s, %s, %d);' % (target, source, fixed_size(variable))
+    if variable.type == Variable.BOOL:
+        return '%s = (BOOL) data[%d];' % (target, offset)
+    if variable.type == Variable.IPPORT:
+        return '%s = ll_decode_ip_port(%s);' % (target, source)
+    if variable.type == Variable.LLQUATERNION:
+        return 'll_decode_quat(%s, %s);' % (source, target)
+    if variable.type in (Variable.LLVECTOR3, Variable.LLVECTOR4):
+        return 'memcpy(%s.mV, %s, %d);' % (target, source, fixed_size(variable))
+    if variable.type == Variable.LLVECTOR3D:
+        return 'memcpy(%s.mdV, %s, %d);' % (target, source, fixed_size(variable))
+    if variable.type == Variable.LLUUID:
+        return 'memcpy(%s.mData, %s, %d);' % (target, source, fixed_size(variable))
+    return 'memcpy(&%s, %s, %d);' % (target, source, fixed_size(variable))
+
+def decode_block_body(block, indent):
+    """Statements reading one repeat of block into 'block' from 'cursor'"""
+    lines = [ ]
+    run = [ ]
+
+    def flush():
+        if not run:
+            return
+        size = sum(fixed_size(v) for v in run)
+        lines.append('{')
+        lines.append('    const U8* data = cursor.take(%d);' % size)
+        lines.append('    if (!data)')
+        lines.append('    {')
+        lines.append('        return false;')
+        lines.append('    }')
+        offset = 0
+        for v in run:
+            lines.append('    ' + read_fixed(v, offset))
+            offset += fixed_size(v)
+        lines.append('}')
+        del run[:]
+
+    for v in block.variables:
+        if v.type == Variable.VARIABLE:
+            flush()
+            lines.append('if (!cursor.takeVariable(%s, block.%s))' % (v.size, member(v.name)))
+            lines.append('{')
+            lines.append('    return false;')
+            lines.append('}')
+        else:
+            run.append(v)
+    flush()
+    return [ indent + l for l in lines ]
+
+def generate_message(message, out):
+    name = 'LLDecoded' + message.name
+    w = out.append
+
+    w('')
+    w('// %s, %s frequency %d, %s' % (message.name, message.priority,
+                                      message.number & 0xFFFF, message.coding))
+    w('struct %s' % name)
+    w('{')
+    w('    static const U32 NUMBER = 0x%X;' % message_number(message))
+    w('')
+    for block in message.blocks:
+        w('    struct %s' % block.name)
+        w('    {')
+        for v in block.variables:
+            w('        ' + declare_variable(v))
+        w('    };')
+    w('')
+    for block in message.blocks:
+        if block.repeat == Block.SINGLE:
+            w('    %s %s;' % (block.name, member(block.name)))
+        elif block.repeat == Block.MULTIPLE:
+            w('    %s %s[%s];' % (block.name, member(block.name), block.count))
+        else:
+            w('    std::vector<%s> %s;' % (block.name, member(block.name)))
+    w('')
+    w('    // Fills this in from a message as received, packet header and')
+    w('    // all, already zero-code expanded. Variable fields point into')
+    w('    // buffer. False if it isn\'t this message or is cut short, in which')
+    w('    // case the members are left part decoded.')
+    w('    bool decode(const U8* buffer, S32 size)')
+    w('    {')
+    w('        LLMessageDecodeCursor cursor(buffer, size);')
+    w('        if (!cursor.begin(NUMBER, %d))' % FREQUENCY_SIZES[message.priority])
+    w('        {')
+    w('            return false;')
+    w('        }')
+    for block in message.blocks:
+        w('')
+        if block.repeat == Block.SINGLE:
+            w('        {')
+            w('            %s& block = %s;' % (block.name, member(block.name)))
+            for l in decode_block_body(block, '            '):
+                w(l)
+            w('        }')
+        else:
+            if block.repeat == Block.MULTIPLE:
+                w('        for (S32 i = 0; i < %s; ++i)' % block.count)
+            else:
+                w('        %s.resize(cursor.takeCount());' % member(block.name))
+                w('        for (size_t i = 0; i < %s.size(); ++i)' % member(block.name))
+            w('        {')
+            w('            %s& block = %s[i];' % (block.name, member(block.name)))
+            for l in decode_block_body(block, '            '):
+                w(l)
+            w('        }')
+    w('        return true;')
+    w('    }')
+    w('')
+    w('    // The message msg is handling, if it came in over UDP. Reports it')
+    w('    // if it\'s malformed.')
+    w('    bool decode(LLMessageSystem* msg)')
+    w('    {')
+    w('        const U8* buffer;')
+    w('        S32 size;')
+    w('        if (!ll_get_decodable_message(msg, buffer, size))')
+    w('        {')
+    w('            return false;')
+    w('        }')
+    w('        if (!decode(buffer, size))')
+    w('        {')
+    w('            ll_decode_failed(msg);')
+    w('            return false;')
+    w('        }')
+    w('        return true;')
+    w('    }')
+    w('};')
+
+def main(argv):
+    if len(argv) < 4:
+        print(__doc__.split('\n\n')[-1].strip(), file=sys.stderr)
+        return 1
+
+    template_file, output_file, names = argv[1], argv[2], argv[3:]
+    with open(template_file) as f:
+        template = llmessage.parseTemplateFile(f)
+
+    out = [ ]
+    for name in names:
+        message = template.messages.get(name)
+        if not message:
+            print("%s: no message %s" % (template_file, name), file=sys.stderr)
+            return 1
+        generate_message(message, out)
+
+    file = os.path.basename(output_file)
+    guard = 'LL_' + os.path.splitext(file)[0].upper() + '_H'
+    text = HEADER % { 'file': file,
+                      'guard': guard,
+                      'messages': ', '.join(names),
+                      'template': os.path.basename(template_file) }
+    text += '\n'.join(out) + '\n' + FOOTER % { 'guard': guard }
+
+    with open(output_file, 'w') as f:
+        f.write(text)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))